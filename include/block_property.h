@@ -0,0 +1,81 @@
+#ifndef STORAGE_LEVELDB_INCLUDE_BLOCK_PROPERTY_H_
+#define STORAGE_LEVELDB_INCLUDE_BLOCK_PROPERTY_H_
+
+#include <cstdint>
+#include <string>
+
+#include "export.h"
+#include "slice.h"
+
+namespace leveldb {
+
+    // 数据块属性：建表时为每个 data block 汇总一段摘要(比如某个字段的最小/最大值)，
+    // 和 block handle 一起存在 index block 里，扫描时用谓词跳过不可能匹配的块
+    //
+    // A BlockPropertyCollector sees every entry TableBuilder::Add() writes and
+    // summarizes each data block in a few bytes.  The summary is stored next
+    // to the block's handle in the index block, so a reader with a matching
+    // BlockPropertyFilter (see ReadOptions::block_property_filter) can skip
+    // the block without reading it.
+    class LEVELDB_EXPORT BlockPropertyCollector {
+    public:
+        virtual ~BlockPropertyCollector();
+
+        // Called for every entry of the data block being built, in order.
+        // "value" is the value passed to TableBuilder::Add().
+        virtual void Add(const Slice &key, const Slice &value) = 0;
+
+        // Appends the summary of the entries added since the last call to
+        // *dst and starts over for the next data block.
+        virtual void FinishBlock(std::string *dst) = 0;
+    };
+
+    // Makes the collectors of a table; each TableBuilder gets its own.
+    // Implementations must be thread-safe.
+    class LEVELDB_EXPORT BlockPropertyCollectorFactory {
+    public:
+        virtual ~BlockPropertyCollectorFactory();
+
+        // The name of the property.  Tables record it, and filters find their
+        // property by it; change it whenever the summary encoding changes.
+        virtual const char *Name() const = 0;
+
+        // Returns a new collector.  The caller deletes it.
+        virtual BlockPropertyCollector *NewCollector() const = 0;
+    };
+
+    // A predicate on the summaries of one property.  Implementations must be
+    // thread-safe.
+    class LEVELDB_EXPORT BlockPropertyFilter {
+    public:
+        virtual ~BlockPropertyFilter();
+
+        // The name of the property it reads (see
+        // BlockPropertyCollectorFactory::Name()).
+        virtual const char *Name() const = 0;
+
+        // Returns false if no entry of a data block with summary "property"
+        // can satisfy the predicate.  False positives are allowed.
+        virtual bool MayMatch(const Slice &property) const = 0;
+    };
+
+    // Extracts a field from an entry.  Returns false if the entry has none.
+    typedef bool (*BlockFieldExtractor)(const Slice &key, const Slice &value, uint64_t *field);
+
+    // Returns a factory whose collectors record the smallest and largest
+    // "extractor" field of each data block, e.g. a timestamp in the key
+    // suffix.  A block in which no entry has the field gets an empty
+    // summary.  The caller must delete it.
+    LEVELDB_EXPORT const BlockPropertyCollectorFactory *NewMinMaxPropertyCollectorFactory(
+            const char *name, BlockFieldExtractor extractor);
+
+    // Returns a filter on a NewMinMaxPropertyCollectorFactory() property
+    // named "name" that rules out data blocks whose field range does not
+    // overlap [smallest, largest], and blocks where no entry has the field.
+    // The caller must delete it.
+    LEVELDB_EXPORT const BlockPropertyFilter *NewMinMaxPropertyFilter(const char *name, uint64_t smallest,
+                                                                      uint64_t largest);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_BLOCK_PROPERTY_H_
@@ -59,6 +59,58 @@ namespace leveldb {
     // 顺序写 功能
     class WritableFile;
 
+    // 磁盘带宽限速
+    class RateLimiter;
+
+    struct Options;
+
+    // Options that control how an Env opens files.
+    struct LEVELDB_EXPORT EnvOptions {
+        EnvOptions() = default;
+
+        // The options of the files of tables built or read with "options":
+        // direct reads, write buffers, range sync and the rate limiter.
+        explicit EnvOptions(const Options &options);
+
+        // If true, random-access files are opened with O_DIRECT (or the
+        // platform equivalent) so that reads bypass the OS page cache.  Such
+        // files report a non-zero RandomAccessFile::GetRequiredBufferAlignment().
+        // Env implementations without direct I/O support ignore this flag.
+        bool use_direct_reads = false;
+
+        // Size in bytes of each write buffer of a writable file.
+        size_t writable_file_buffer_size = 64 * 1024;
+
+        // Number of write buffers of a writable file.  With more than one, a
+        // full buffer is handed to a background thread that writes it out while
+        // Append() keeps filling the next one, so appends only wait for the
+        // disk when every buffer is queued.  In that mode Flush() only reports
+        // errors of earlier background writes; buffered data reaches the OS
+        // when its buffer fills, or on Sync() and Close().
+        int writable_file_buffers = 1;
+
+        // If non-zero, a writable file asks the OS to start writing back its
+        // dirty pages every time this many bytes have been written, so that
+        // writeback trickles out during the build instead of piling up for the
+        // final Sync().  Only a hint: it does not make the data durable.
+        uint64_t bytes_per_sync = 0;
+
+        // If non-zero, NewWritableFile() reserves this much disk space up front
+        // (the expected size of the file) to limit fragmentation and block
+        // allocation during writes.  Space that ends up unused is given back on
+        // Close().
+        uint64_t preallocation_size = 0;
+
+        // If non-null, every write of a writable file is charged against this
+        // limiter (at kIOLow priority) before it is issued.
+        RateLimiter *rate_limiter = nullptr;
+
+        // If true and rate_limiter is non-null, reads of random-access files
+        // are charged as well.  Such files are read with pread() rather than
+        // mmap(), since page faults cannot be accounted for.
+        bool rate_limit_reads = false;
+    };
+
     // 提供环境 类
     class LEVELDB_EXPORT Env {
     public:
@@ -96,6 +148,13 @@ namespace leveldb {
         // The returned file may be concurrently accessed by multiple threads.
         virtual Status NewRandomAccessFile(const std::string &fname, RandomAccessFile **result) = 0;
 
+        // Same as above, but the file is opened according to "options".
+        //
+        // The default implementation ignores "options" and calls the two-argument
+        // version.
+        virtual Status NewRandomAccessFile(const std::string &fname, const EnvOptions &options,
+                                           RandomAccessFile **result);
+
         // Create an object that writes to a new file with the specified
         // name.  Deletes any existing file with the same name and creates a
         // new file.  On success, stores a pointer to the new file in
@@ -105,6 +164,13 @@ namespace leveldb {
         // The returned file will only be accessed by one thread at a time.
         virtual Status NewWritableFile(const std::string &fname, WritableFile **result) = 0;
 
+        // Same as above, but the file is opened according to "options".
+        //
+        // The default implementation ignores "options" and calls the two-argument
+        // version.
+        virtual Status NewWritableFile(const std::string &fname, const EnvOptions &options,
+                                       WritableFile **result);
+
         // Create an object that either appends to an existing file, or
         // writes to a new file (if the file does not exist to begin with).
         // On success, stores a pointer to the new file in *result and
@@ -257,6 +323,17 @@ namespace leveldb {
         virtual Status Skip(uint64_t n) = 0;
     };
 
+    // A single read of a RandomAccessFile::MultiRead() batch.
+    // offset/n/scratch are inputs; result/status are filled in by MultiRead().
+    struct LEVELDB_EXPORT ReadRequest {
+        uint64_t offset = 0;
+        size_t n = 0;
+        char *scratch = nullptr;
+
+        Slice result;
+        Status status;
+    };
+
     // A file abstraction for randomly reading the contents of a file. 用于随机读取文件内容的文件抽象
     class LEVELDB_EXPORT RandomAccessFile {
     public:
@@ -278,6 +355,30 @@ namespace leveldb {
         //
         // Safe for concurrent use by multiple threads.
         virtual Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const = 0;
+
+        // Submit all of requests[0..num_requests-1] at once and wait until every
+        // one of them has completed.  Each request gets the same treatment as a
+        // Read(offset, n, &result, scratch) call, but implementations may keep
+        // several reads in flight to benefit from device queue depth.
+        // Returns the first non-OK request status, or OK.
+        //
+        // The default implementation issues the reads one at a time.
+        //
+        // Safe for concurrent use by multiple threads.
+        virtual Status MultiRead(ReadRequest *requests, size_t num_requests) const;
+
+        // Returns the alignment that the offset, length and scratch buffer of a
+        // Read() must satisfy to avoid an extra copy, or 0 if any read is fine.
+        // Non-zero for files opened with EnvOptions::use_direct_reads.  Unaligned
+        // reads still work, but are bounced through an internal aligned buffer.
+        virtual size_t GetRequiredBufferAlignment() const { return 0; }
+
+        // Hint that file[offset, offset + n) will be read soon, so that the
+        // implementation may start fetching it in the background.  Only a hint:
+        // the default implementation does nothing.
+        //
+        // Safe for concurrent use by multiple threads.
+        virtual void Prefetch(uint64_t /*offset*/, size_t /*n*/) const {}
     };
 
     // A file abstraction for sequential writing.  The implementation
@@ -367,10 +468,19 @@ namespace leveldb {
             return target_->NewRandomAccessFile(f, r);
         }
 
+        Status NewRandomAccessFile(const std::string &f, const EnvOptions &o,
+                                   RandomAccessFile **r) override {
+            return target_->NewRandomAccessFile(f, o, r);
+        }
+
         Status NewWritableFile(const std::string &f, WritableFile **r) override {
             return target_->NewWritableFile(f, r);
         }
 
+        Status NewWritableFile(const std::string &f, const EnvOptions &o, WritableFile **r) override {
+            return target_->NewWritableFile(f, o, r);
+        }
+
         Status NewAppendableFile(const std::string &f, WritableFile **r) override {
             return target_->NewAppendableFile(f, r);
         }
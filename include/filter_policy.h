@@ -0,0 +1,93 @@
+// Copyright (c) 2012 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A database can be configured with a custom FilterPolicy object.
+// This object is responsible for creating a small filter from a set
+// of keys.  These filters are stored in leveldb and are consulted
+// automatically by leveldb to decide whether or not to read some
+// information from disk. In many cases, a filter can cut down the
+// number of disk seeks form a handful to a single disk seek per
+// DB::Get() call.
+//
+// Most people will want to use the builtin bloom filter support (see
+// NewBloomFilterPolicy() below).
+
+#ifndef STORAGE_LEVELDB_INCLUDE_FILTER_POLICY_H_
+#define STORAGE_LEVELDB_INCLUDE_FILTER_POLICY_H_
+
+#include <string>
+
+#include "export.h"
+
+namespace leveldb {
+
+    class Slice;
+
+    class LEVELDB_EXPORT FilterPolicy {
+    public:
+        virtual ~FilterPolicy();
+
+        // Return the name of this policy.  Note that if the filter encoding
+        // changes in an incompatible way, the name returned by this method
+        // must be changed.  Otherwise, old incompatible filters may be
+        // passed to methods of this type.
+        virtual const char *Name() const = 0;
+
+        // keys[0,n-1] contains a list of keys (potentially with duplicates)
+        // that are ordered according to the user supplied comparator.
+        // Append a filter that summarizes keys[0,n-1] to *dst.
+        //
+        // Warning: do not change the initial contents of *dst.  Instead,
+        // append the newly constructed filter to *dst.
+        virtual void CreateFilter(const Slice *keys, int n, std::string *dst) const = 0;
+
+        // "filter" contains the data appended by a preceding call to
+        // CreateFilter() on this class.  This method must return true if
+        // the key was in the list of keys passed to CreateFilter().
+        // This method may return true or false if the key was not on the
+        // list, but it should aim to return false with a high probability.
+        virtual bool KeyMayMatch(const Slice &key, const Slice &filter) const = 0;
+
+        // Sets results[i] to KeyMayMatch(keys[i], filters[i]) for every i in
+        // [0, n).  Policies whose filters are larger than the cache may
+        // override it to hash every key first and prefetch what the probes
+        // will touch.  The default calls KeyMayMatch() n times.
+        virtual void KeysMayMatch(int n, const Slice *keys, const Slice *filters, bool *results) const;
+    };
+
+    // Return a new filter policy that uses a bloom filter with approximately
+    // the specified number of bits per key.  A good value for bits_per_key
+    // is 10, which yields a filter with ~ 1% false positive rate.
+    //
+    // Callers must delete the result after any database that is using the
+    // result has been closed.
+    LEVELDB_EXPORT const FilterPolicy *NewBloomFilterPolicy(int bits_per_key);
+
+    // Return a new filter policy whose bloom filters keep all probes of a
+    // key within one 64-byte block, so a lookup costs one cache miss
+    // instead of one per probe.  The probes are computed and tested with
+    // AVX2 when the CPU has it, and KeysMayMatch() prefetches the blocks of
+    // a batch before probing them.  The false positive rate is a little
+    // higher than NewBloomFilterPolicy()'s for the same bits_per_key, and
+    // its filters are not compatible with NewBloomFilterPolicy()'s.
+    //
+    // Callers must delete the result after any table that is using the
+    // result has been closed.
+    LEVELDB_EXPORT const FilterPolicy *NewBlockedBloomFilterPolicy(int bits_per_key);
+
+    // Return a new filter policy that uses binary fuse filters, which need
+    // about 25-30% less space than bloom filters for the same false positive
+    // rate at the cost of a slower build.  Each key stores a fingerprint of
+    // 8 bits (bits_per_fingerprint <= 8: ~9 bits per key, 0.4% false
+    // positives) or 16 bits (~18 bits per key, 0.0015%).  The overhead is
+    // high for the few dozen keys of a 2KB filter, so use it with
+    // Options::filter_block_format = kWholeTableFilter.
+    //
+    // Callers must delete the result after any table that is using the
+    // result has been closed.
+    LEVELDB_EXPORT const FilterPolicy *NewBinaryFuseFilterPolicy(int bits_per_fingerprint);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_FILTER_POLICY_H_
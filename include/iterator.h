@@ -21,6 +21,8 @@
 
 namespace leveldb {
 
+    class LazyValue;
+
     class LEVELDB_EXPORT Iterator {
     public:
         Iterator();
@@ -70,6 +72,14 @@ namespace leveldb {
         // REQUIRES: Valid()
         virtual Slice value() const = 0;
 
+        // Store a handle to the value of the current entry in *value.  Unlike
+        // value(), the handle remains usable after the iterator moves, and a
+        // value that lives outside the iterator's blocks (e.g. in a blob file)
+        // is only read when the handle is fetched.  The default implementation
+        // copies value().
+        // REQUIRES: Valid()
+        virtual void GetLazyValue(LazyValue *value) const;
+
         // If an error has occurred, return it.  Else return an ok status.
         virtual Status status() const = 0;
 
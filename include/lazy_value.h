@@ -0,0 +1,66 @@
+#ifndef SSTABLE_LAZY_VALUE_H
+#define SSTABLE_LAZY_VALUE_H
+
+#include <string>
+
+#include "options.h"
+#include "slice.h"
+#include "status.h"
+
+namespace leveldb {
+
+    class BlobSource;
+
+    // 延迟取值：先拿到 value 的句柄，真正需要时再读
+    // A handle to a value that is read only when Fetch() is called.  Obtained
+    // from Iterator::GetLazyValue(), it stays usable after the iterator has
+    // moved on or been deleted, so a scan can collect handles for the entries
+    // it selects by key and read just those values afterwards.
+    //
+    // Values stored inline in a block are copied into the handle (in tables
+    // with blob files they are small by construction); values stored in blob
+    // files are only described by the handle until fetched.
+    //
+    // Not thread-safe.
+    class LazyValue {
+    public:
+        LazyValue();
+
+        LazyValue(const LazyValue &) = delete;
+
+        LazyValue &operator=(const LazyValue &) = delete;
+
+        ~LazyValue();
+
+        // Makes the handle hold a copy of "value".
+        void SetValue(const Slice &value);
+
+        // Makes the handle refer to the blob that "encoded_index" (an encoded
+        // BlobIndex) points to.  "source" must outlive the handle.
+        void SetBlob(BlobSource *source, const ReadOptions &options, const Slice &encoded_index);
+
+        // Drops the value, if any; Fetch() then returns an empty value.
+        void Reset();
+
+        // True if Fetch() will not do any I/O.
+        bool IsFetched() const { return !is_blob_ || fetched_; }
+
+        // Stores the value in *value, reading it first if needed.  The
+        // result stays valid until the handle is reset, set or destroyed.
+        Status Fetch(Slice *value);
+
+    private:
+        void ReleaseBlob();
+
+        bool is_blob_;
+        bool fetched_;             // For blobs: blob_ holds the contents.
+        std::string data_;         // Inline value, or the encoded blob index.
+        BlobSource *source_;
+        ReadOptions options_;
+        Slice blob_;               // Fetched blob contents.
+        const char *blob_owned_;   // Heap buffer behind blob_, if any.
+    };
+
+}
+
+#endif //SSTABLE_LAZY_VALUE_H
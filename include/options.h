@@ -6,6 +6,8 @@
 #define STORAGE_LEVELDB_INCLUDE_OPTIONS_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include "export.h"
 
@@ -23,8 +25,24 @@ namespace leveldb {
     // 过滤器
     class FilterPolicy;
 
+    // 前缀提取器
+    class SliceTransform;
+
+    // 数据块属性
+    class BlockPropertyCollectorFactory;
+
+    class BlockPropertyFilter;
+
     class Logger;
 
+    // 磁盘带宽限速
+    class RateLimiter;
+
+    // 大 value 分离存储的 blob 文件
+    class BlobSource;
+
+    class Slice;
+
     // 快照
     class Snapshot;
 
@@ -39,6 +57,36 @@ namespace leveldb {
         kSnappyCompression = 0x1
     };
 
+    // Layout of the entries in a data block.  Readers detect the layout of
+    // each block, so tables may mix them.
+    enum DataBlockFormat {
+        // shared | non_shared | value_length | key delta | value, repeated.
+        kInterleavedBlock = 0x0,
+        // All keys (with their lengths) first, then all values, so searching
+        // and key-only scans never bring value bytes into the cache.
+        kSplitKeyValueBlock = 0x1,
+        // Keys of exactly Options::fixed_key_size bytes, stored as a packed
+        // sorted array and searched without decoding; then the values.
+        kFixedKeyBlock = 0x2
+    };
+
+    // What the filters of a table's filter block cover.
+    enum FilterBlockFormat {
+        // One filter per 2KB of data block offsets, built as the data blocks
+        // are written.
+        kDataRangeFilters = 0x0,
+        // One filter over every key, built by TableBuilder::Finish().  Suits
+        // policies such as NewBinaryFuseFilterPolicy() that are only compact
+        // for many keys.  Keeps all keys in memory until Finish().
+        kWholeTableFilter = 0x1,
+        // One filter per run of data blocks holding about
+        // Options::filter_partition_keys keys, found through a small
+        // partition index.  Only the index and the last partition read stay
+        // in memory; a lookup reads the one partition covering its key, like
+        // a data block, unless it is the one kept.
+        kPartitionedFilter = 0x2
+    };
+
     // Options to control the behavior of a database (passed to DB::Open)
     struct LEVELDB_EXPORT Options {
         // Create an Options object with default values for all fields.
@@ -116,6 +164,17 @@ namespace leveldb {
         int block_restart_interval = 16;
         // int block_restart_interval = 4;
 
+        // Layout of the data blocks of a table.  A TableBuilder copies its
+        // options when it is created, so the format is fixed for the table;
+        // readers detect the format of each block.  Index blocks are always
+        // interleaved.
+        DataBlockFormat data_block_format = kInterleavedBlock;
+
+        // Key size for kFixedKeyBlock.  Adding a key of another size to a
+        // table built with that format is an error.  With the bytewise
+        // comparator, 8- and 16-byte keys are searched with SIMD compares.
+        size_t fixed_key_size = 8;
+
         // Leveldb will write up to this amount of bytes to a file before
         // switching to a new one.
         // Most clients should leave this parameter alone.  However if your
@@ -150,8 +209,100 @@ namespace leveldb {
 
         // If non-null, use the specified filter policy to reduce disk reads.
         // Many applications will benefit from passing the result of
-        // NewBloomFilterPolicy() here.
+        // NewBloomFilterPolicy() here.  Table::InternalGet() then only
+        // reports an entry when the filter of its data block may hold "key".
         const FilterPolicy *filter_policy = nullptr;
+
+        // Which keys each filter of filter_policy covers.  Readers find out
+        // from the table, so this can be chosen per table.
+        FilterBlockFormat filter_block_format = kDataRangeFilters;
+
+        // With kPartitionedFilter, a partition ends at the first data block
+        // boundary after this many keys and prefixes were added to it (about
+        // 5KB with a 10 bits per key bloom filter).
+        size_t filter_partition_keys = 4096;
+
+        // If non-null, TableBuilder also adds the prefix of every key in the
+        // extractor's domain to the filter (see filter_policy), and a table
+        // read with an extractor of the same name can rule out a prefix
+        // without reading a data block.  Iterators created with
+        // ReadOptions::prefix_same_as_start use it to skip tables and stop at
+        // the end of the prefix.  See NewFixedPrefixTransform().
+        const SliceTransform *prefix_extractor = nullptr;
+
+        // If true, TableBuilder::Finish() adds a minimal perfect hash that
+        // maps every key to the number of its data block, for tables read
+        // mostly by exact key.  Table::InternalGet() then skips the index
+        // search: it hashes the key, jumps to the block's index entry and
+        // seeks within that one block, and reports only an entry equal to
+        // the key.  Costs under 3 bits per key plus log2(number of data
+        // blocks) bits for the block number, and 16 bytes per key of memory
+        // while building.
+        bool perfect_hash_index = false;
+
+        // If true, TableBuilder::Finish() adds a succinct trie of key
+        // prefixes that tells whether any key may lie in a range.  Iterators
+        // bounded by ReadOptions::iterate_upper_bound consult it on every
+        // seek and skip tables with no key in range without reading a block.
+        // Costs about 10 bits per trie edge, roughly 2-3 bytes per key.
+        // Only used with the bytewise comparator.
+        bool range_filter = false;
+
+        // Each factory's collectors summarize every data block (see
+        // block_property.h); the summaries follow the block handles in the
+        // index block, so ReadOptions::block_property_filter can skip blocks
+        // without reading them.  Costs the summary size per data block.
+        std::vector<const BlockPropertyCollectorFactory *> block_property_collectors;
+
+        // If true, table files opened with EnvOptions(options) are read with
+        // direct I/O (see EnvOptions::use_direct_reads), bypassing the OS page
+        // cache.  Worth it when the tables are much larger than memory, so
+        // that the page cache would only churn.
+        bool use_direct_reads = false;
+
+        // Table files opened with EnvOptions(options) are written through
+        // this many buffers of writable_file_buffer_size bytes each (see
+        // EnvOptions::writable_file_buffers).  With more than one, full
+        // buffers are written by a background thread while TableBuilder keeps
+        // encoding into the next, so a build is bound by encoding rather than
+        // by write latency.
+        size_t writable_file_buffer_size = 64 * 1024;
+        int writable_file_buffers = 1;
+
+        // If non-zero, table files opened with EnvOptions(options) start
+        // writeback every time this many bytes were written (see
+        // EnvOptions::bytes_per_sync), so that TableBuilder::Sync() after
+        // Finish() does not have to flush the whole file at once.
+        uint64_t bytes_per_sync = 0;
+
+        // If non-null, every write of a table file opened with
+        // EnvOptions(options) is charged against this limiter, so table builds
+        // stay within its budget.  Tables also report the latency of point
+        // lookups to it, which it uses to auto-tune the budget (see
+        // NewGenericRateLimiter()).  Reads are not charged.
+        RateLimiter *rate_limiter = nullptr;
+
+        // A TableBuilder given a blob file writes values of at least this
+        // many bytes to the blob file and keeps only a small reference to
+        // them in its data blocks, so blocks stay small and dense no matter
+        // how large the values are.  Ignored by builders without a blob file.
+        size_t min_blob_size = 4 * 1024;
+
+        // Resolves the blob references of tables built with a blob file.
+        // Tables without blob references never use it.
+        BlobSource *blob_source = nullptr;
+
+        // A PlainTableBuilder groups keys by their first this many bytes
+        // (shorter keys are their own prefix) and hashes each prefix to its
+        // records.  Lookups in a plain table only find keys whose prefix is
+        // in the table, so pick a prefix that every point lookup shares with
+        // the key it wants.
+        size_t plain_table_prefix_length = 8;
+
+        // A plain table keeps the offset of every this many records of a
+        // prefix, so a lookup reads at most this many records after the hash
+        // probe.  Prefixes with no more records than this need no offsets.
+        int plain_table_index_sparseness = 16;
     };
 
     // Options that control read operations
@@ -171,6 +322,38 @@ namespace leveldb {
         // not have been released).  If "snapshot" is null, use an implicit
         // snapshot of the state at the beginning of this read operation.
         const Snapshot *snapshot = nullptr;
+
+        // If non-zero, table iterators watch for sequential block reads and
+        // read ahead of the scan with a window that starts small and doubles on
+        // every refill, up to this many bytes.  Useful for long scans on
+        // devices where large reads are much cheaper than many small ones.
+        size_t readahead_size = 0;
+
+        // If true, iterators created with these options are only used for
+        // their keys: value() returns an empty slice and values are neither
+        // decoded nor read from blob files.  Key-only scans over tables whose
+        // blocks keep keys apart from values skip the value bytes entirely.
+        bool key_only = false;
+
+        // If non-null, iterators created with these options stop before the
+        // first key at or past this bound.  Seeking a table iterator to a
+        // target first asks the table's range filter (Options::range_filter)
+        // whether any key lies in [target, bound), and reads no block when
+        // none can.  Must outlive the iterator.
+        const Slice *iterate_upper_bound = nullptr;
+
+        // If true and Options::prefix_extractor is set, an iterator positioned
+        // by Seek() only visits keys with the same prefix as the target.  The
+        // table's filter is checked for the prefix before any block is read.
+        // Targets outside the extractor's domain are not limited.
+        bool prefix_same_as_start = false;
+
+        // If non-null, data blocks whose summary of the filter's property
+        // (see Options::block_property_collectors) rules out every entry are
+        // skipped by iterators and lookups without being read.  Entries of
+        // the blocks that are read are not checked.  Tables without the
+        // property are read as usual.
+        const BlockPropertyFilter *block_property_filter = nullptr;
     };
 
     // Options that control write operations
@@ -0,0 +1,80 @@
+// A RateLimiter caps the disk bandwidth used by background work such as
+// table builds, so that it does not crowd out foreground reads.
+//
+// One RateLimiter is normally shared by all the files of a process: attach it
+// through Options::rate_limiter (or EnvOptions::rate_limiter) and every write of
+// a file opened with it is charged against the same budget.
+//
+// All RateLimiter implementations are safe for concurrent access from
+// multiple threads without any external synchronization.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+#define STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+
+#include <cstdint>
+
+#include "export.h"
+
+namespace leveldb {
+
+    class Env;
+
+    // Priority of a request.  When the budget is short, kIOHigh requests are
+    // generally served first (see NewGenericRateLimiter's "fairness").
+    enum IOPriority {
+        kIOLow = 0,
+        kIOHigh = 1,
+    };
+
+    class LEVELDB_EXPORT RateLimiter {
+    public:
+        RateLimiter() = default;
+
+        RateLimiter(const RateLimiter &) = delete;
+
+        RateLimiter &operator=(const RateLimiter &) = delete;
+
+        virtual ~RateLimiter();
+
+        // Blocks until "bytes" bytes may be transferred.  Requests larger than
+        // what is refilled per period are granted in several pieces.
+        virtual void Request(int64_t bytes, IOPriority priority) = 0;
+
+        // Feedback for auto-tuning: the latency of one foreground read, in
+        // microseconds.  Ignored unless auto-tuning is enabled.
+        virtual void ReportForegroundLatency(uint64_t micros) = 0;
+
+        // The current budget.  With auto-tuning enabled it moves between a
+        // floor and the configured maximum.
+        virtual int64_t GetBytesPerSecond() const = 0;
+
+        // Changes the configured maximum budget.  REQUIRES: bytes_per_second > 0
+        virtual void SetBytesPerSecond(int64_t bytes_per_second) = 0;
+    };
+
+    // Return a token-bucket rate limiter that grants at most "bytes_per_second".
+    //
+    // "refill_period_us": how often the bucket is refilled.  Shorter periods
+    // smooth out bursts at the cost of more wakeups.
+    //
+    // "fairness": waiting kIOHigh requests are served before kIOLow ones,
+    // except that one refill out of "fairness" serves kIOLow first, so low
+    // priority work cannot starve.  Within a priority, requests are served
+    // first come, first served.
+    //
+    // "target_latency_us": if non-zero, the limiter tunes itself from
+    // ReportForegroundLatency(): while the smoothed foreground latency is above
+    // the target it cuts the budget (down to 1/20 of "bytes_per_second"), and
+    // it raises the budget back towards "bytes_per_second" while latency stays
+    // comfortably below the target.
+    //
+    // "env" supplies the clock; nullptr means Env::Default().
+    LEVELDB_EXPORT RateLimiter *NewGenericRateLimiter(int64_t bytes_per_second,
+                                                      int64_t refill_period_us = 100 * 1000,
+                                                      int32_t fairness = 10,
+                                                      uint64_t target_latency_us = 0,
+                                                      Env *env = nullptr);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
@@ -0,0 +1,46 @@
+#ifndef STORAGE_LEVELDB_INCLUDE_SLICE_TRANSFORM_H_
+#define STORAGE_LEVELDB_INCLUDE_SLICE_TRANSFORM_H_
+
+#include <cstddef>
+
+#include "export.h"
+#include "slice.h"
+
+namespace leveldb {
+
+    // 前缀提取器：从 key 中取出前缀，供前缀过滤和前缀扫描使用
+    //
+    // A SliceTransform maps a key to its prefix.  Keys that share a prefix
+    // must be adjacent in comparator order, so that all keys with a prefix
+    // form one contiguous range of the table.  Implementations must be
+    // thread-safe.
+    class LEVELDB_EXPORT SliceTransform {
+    public:
+        virtual ~SliceTransform();
+
+        // The name of the transform.  Tables record it, and a table's prefix
+        // filter is only used by readers whose transform has the same name;
+        // change it whenever Transform() changes.
+        virtual const char *Name() const = 0;
+
+        // Whether "key" has a prefix.
+        virtual bool InDomain(const Slice &key) const = 0;
+
+        // The prefix of "key", which points into it.
+        // REQUIRES: InDomain(key)
+        virtual Slice Transform(const Slice &key) const = 0;
+    };
+
+    // Returns a transform whose prefix is the first "prefix_length" bytes of
+    // the key; shorter keys have no prefix.  The caller must delete it.
+    LEVELDB_EXPORT const SliceTransform *NewFixedPrefixTransform(size_t prefix_length);
+
+    // Returns a transform whose prefix runs through the "count"th
+    // "delimiter" of the key, inclusive; e.g. with '|' and 2 the prefix of
+    // "tenant|entity|timestamp" is "tenant|entity|".  Keys with fewer
+    // delimiters have no prefix.  The caller must delete it.
+    LEVELDB_EXPORT const SliceTransform *NewDelimitedPrefixTransform(char delimiter, int count);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_SLICE_TRANSFORM_H_
@@ -56,6 +56,11 @@ namespace leveldb {
             // REQUIRES: this thread holds *mu
             void Wait();
 
+            // Same as Wait(), but also wakes up once |micros| microseconds have
+            // passed.  Returns true if the wait timed out.
+            // REQUIRES: this thread holds *mu
+            bool TimedWait(uint64_t micros);
+
             // If there are some threads waiting, wake up at least one of them.
             void Signal();
 
@@ -0,0 +1,263 @@
+#include "blob_file.h"
+
+#include <cstdio>
+#include <map>
+
+#include "../include/lazy_value.h"
+#include "../port/port_stdcxx.h"
+#include "../port/thread_annotations.h"
+#include "../util/coding.h"
+#include "../util/crc32c.h"
+#include "../util/mutexlock.h"
+
+namespace leveldb {
+
+    void BlobIndex::EncodeTo(std::string *dst) const {
+        PutVarint64(dst, file_number);
+        handle.EncodeTo(dst);
+    }
+
+    Status BlobIndex::DecodeFrom(Slice *input) {
+        if (!GetVarint64(input, &file_number)) {
+            return Status::Corruption("bad blob index");
+        }
+        return handle.DecodeFrom(input);
+    }
+
+    std::string BlobFileName(const std::string &dirname, uint64_t number) {
+        char buf[100];
+        std::snprintf(buf, sizeof(buf), "/%06llu.blob", static_cast<unsigned long long>(number));
+        return dirname + buf;
+    }
+
+    BlobFileBuilder::BlobFileBuilder(const Options &options, uint64_t file_number, WritableFile *file)
+            : options_(options), file_number_(file_number), file_(file), offset_(0), num_blobs_(0) {}
+
+    Status BlobFileBuilder::Add(const Slice &value, BlobIndex *index) {
+        if (!status_.ok()) {
+            return status_;
+        }
+
+        // 与 TableBuilder::WriteBlock 相同：压缩率不足 1/8 就存原数据
+        Slice contents = value;
+        CompressionType type = kNoCompression;
+        if (options_.compression == kSnappyCompression &&
+            port::Snappy_Compress(value.data(), value.size(), &compressed_) &&
+            compressed_.size() < value.size() - (value.size() / 8u)) {
+            contents = compressed_;
+            type = kSnappyCompression;
+        }
+
+        char trailer[kBlockTrailerSize];
+        trailer[0] = type;
+        uint32_t crc = crc32c::Value(contents.data(), contents.size());
+        crc = crc32c::Extend(crc, trailer, 1);
+        EncodeFixed32(trailer + 1, crc32c::Mask(crc));
+
+        status_ = file_->Append(contents);
+        if (status_.ok()) {
+            status_ = file_->Append(Slice(trailer, kBlockTrailerSize));
+        }
+        if (status_.ok()) {
+            index->file_number = file_number_;
+            index->handle.set_offset(offset_);
+            index->handle.set_size(contents.size());
+            offset_ += contents.size() + kBlockTrailerSize;
+            num_blobs_++;
+        }
+        compressed_.clear();
+        return status_;
+    }
+
+    Status BlobFileBuilder::Flush() {
+        if (status_.ok()) {
+            status_ = file_->Flush();
+        }
+        return status_;
+    }
+
+    Status BlobFileBuilder::Sync() {
+        if (status_.ok()) {
+            status_ = file_->Flush();
+        }
+        if (status_.ok()) {
+            status_ = file_->Sync();
+        }
+        return status_;
+    }
+
+    BlobSource::~BlobSource() = default;
+
+    namespace {
+
+        class BlobFileCache : public BlobSource {
+        public:
+            BlobFileCache(Env *env, std::string dirname, const EnvOptions &env_options)
+                    : env_(env), dirname_(std::move(dirname)), env_options_(env_options) {}
+
+            ~BlobFileCache() override {
+                for (auto &entry: files_) {
+                    delete entry.second;
+                }
+            }
+
+            Status GetBlobFile(uint64_t file_number, RandomAccessFile **file) override {
+                MutexLock l(&mu_);
+                auto it = files_.find(file_number);
+                if (it != files_.end()) {
+                    *file = it->second;
+                    return Status::OK();
+                }
+                // 首次访问时打开；打开期间持锁，同一个文件不会被打开两次
+                Status s = env_->NewRandomAccessFile(BlobFileName(dirname_, file_number), env_options_, file);
+                if (s.ok()) {
+                    files_[file_number] = *file;
+                }
+                return s;
+            }
+
+        private:
+            Env *const env_;
+            const std::string dirname_;
+            const EnvOptions env_options_;
+            port::Mutex mu_;
+            std::map<uint64_t, RandomAccessFile *> files_ GUARDED_BY(mu_);
+        };
+
+    }  // namespace
+
+    BlobSource *NewBlobFileCache(Env *env, const std::string &dirname, const EnvOptions &env_options) {
+        return new BlobFileCache(env, dirname, env_options);
+    }
+
+    Status ReadBlob(BlobSource *source, const ReadOptions &options, const Slice &encoded_index,
+                    BlockContents *result) {
+        if (source == nullptr) {
+            return Status::InvalidArgument("table has blob references but options.blob_source is null");
+        }
+        BlobIndex index;
+        Slice input = encoded_index;
+        Status s = index.DecodeFrom(&input);
+        RandomAccessFile *file = nullptr;
+        if (s.ok()) {
+            s = source->GetBlobFile(index.file_number, &file);
+        }
+        if (s.ok()) {
+            s = ReadBlock(file, options, index.handle, result);
+        }
+        return s;
+    }
+
+    namespace {
+
+        class BlobValueIterator : public Iterator {
+        public:
+            BlobValueIterator(Iterator *iter, BlobSource *source, const ReadOptions &options)
+                    : iter_(iter), source_(source), options_(options), has_blob_(false) {}
+
+            ~BlobValueIterator() override {
+                ReleaseBlob();
+                delete iter_;
+            }
+
+            bool Valid() const override { return iter_->Valid(); }
+
+            void SeekToFirst() override {
+                ReleaseBlob();
+                iter_->SeekToFirst();
+            }
+
+            void SeekToLast() override {
+                ReleaseBlob();
+                iter_->SeekToLast();
+            }
+
+            void Seek(const Slice &target) override {
+                ReleaseBlob();
+                iter_->Seek(target);
+            }
+
+            void Next() override {
+                ReleaseBlob();
+                iter_->Next();
+            }
+
+            void Prev() override {
+                ReleaseBlob();
+                iter_->Prev();
+            }
+
+            Slice key() const override { return iter_->key(); }
+
+            Slice value() const override {
+                Slice raw = iter_->value();
+                if (raw.empty()) {
+                    SaveError(Status::Corruption("value without a type"));
+                    return Slice();
+                }
+                const auto type = static_cast<unsigned char>(raw[0]);
+                raw.remove_prefix(1);
+                if (type == kTypeInlineValue) {
+                    return raw;
+                } else if (type != kTypeBlobIndex) {
+                    SaveError(Status::Corruption("bad value type"));
+                    return Slice();
+                }
+                // 只有真正取 value 时才去读 blob，同一条目只读一次
+                if (!has_blob_) {
+                    Status s = ReadBlob(source_, options_, raw, &blob_);
+                    if (!s.ok()) {
+                        SaveError(s);
+                        return Slice();
+                    }
+                    has_blob_ = true;
+                }
+                return blob_.data;
+            }
+
+            void GetLazyValue(LazyValue *value) const override {
+                Slice raw = iter_->value();
+                if (!raw.empty() && static_cast<unsigned char>(raw[0]) == kTypeBlobIndex) {
+                    raw.remove_prefix(1);
+                    value->SetBlob(source_, options_, raw);
+                } else {
+                    value->SetValue(this->value());
+                }
+            }
+
+            Status status() const override {
+                if (!iter_->status().ok()) {
+                    return iter_->status();
+                }
+                return status_;
+            }
+
+        private:
+            void SaveError(const Status &s) const {
+                if (status_.ok() && !s.ok()) status_ = s;
+            }
+
+            void ReleaseBlob() {
+                if (has_blob_ && blob_.heap_allocated) {
+                    delete[] blob_.data.data();
+                }
+                has_blob_ = false;
+            }
+
+            Iterator *const iter_;
+            BlobSource *const source_;
+            const ReadOptions options_;
+
+            // The blob of the current entry, once value() has read it.
+            mutable bool has_blob_;
+            mutable BlockContents blob_;
+            mutable Status status_;
+        };
+
+    }  // namespace
+
+    Iterator *NewBlobValueIterator(Iterator *block_iter, BlobSource *source, const ReadOptions &options) {
+        return new BlobValueIterator(block_iter, source, options);
+    }
+
+}
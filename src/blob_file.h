@@ -0,0 +1,121 @@
+#ifndef SSTABLE_BLOB_FILE_H
+#define SSTABLE_BLOB_FILE_H
+
+#include <cstdint>
+#include <string>
+
+#include "../include/env.h"
+#include "../include/iterator.h"
+#include "../include/options.h"
+#include "../include/slice.h"
+#include "../include/status.h"
+#include "format.h"
+
+namespace leveldb {
+
+    // 大 value 与 key 分离：value 写进 blob 文件，data block 里只存一个引用
+    //
+    // A blob file is an append-only sequence of records, each laid out like a
+    // table block:
+    //    contents (possibly compressed) | type (1 byte) | masked crc32 (4 bytes)
+    // so a blob is read back with ReadBlock().
+    //
+    // In a table built with a blob file every value in the data blocks starts
+    // with a one-byte ValueType.  kTypeInlineValue is followed by the value
+    // itself, kTypeBlobIndex by an encoded BlobIndex.  Such tables end with
+    // kBlobTableMagicNumber instead of kTableMagicNumber.
+    enum ValueType {
+        kTypeInlineValue = 0x0,
+        kTypeBlobIndex = 0x1
+    };
+
+    // Where a blob lives: the number of its blob file and the handle of its
+    // record in that file.
+    struct BlobIndex {
+        uint64_t file_number = 0;
+        BlockHandle handle;
+
+        void EncodeTo(std::string *dst) const;
+
+        Status DecodeFrom(Slice *input);
+    };
+
+    // Returns "<dirname>/<number>.blob".
+    std::string BlobFileName(const std::string &dirname, uint64_t number);
+
+    // Appends blobs to a blob file.  Not thread-safe.
+    class BlobFileBuilder {
+    public:
+        // Does not take ownership of "file", which must be empty.
+        BlobFileBuilder(const Options &options, uint64_t file_number, WritableFile *file);
+
+        BlobFileBuilder(const BlobFileBuilder &) = delete;
+
+        BlobFileBuilder &operator=(const BlobFileBuilder &) = delete;
+
+        // Appends "value" and stores its location in *index.
+        Status Add(const Slice &value, BlobIndex *index);
+
+        // Hands buffered blobs to the file system.  TableBuilder::Finish()
+        // calls this so that a finished table can be read right away.
+        Status Flush();
+
+        // Flushes, then syncs the file.  A table referring to the blobs must
+        // not be synced before its blob file.
+        Status Sync();
+
+        uint64_t file_number() const { return file_number_; }
+
+        uint64_t FileSize() const { return offset_; }
+
+        uint64_t NumBlobs() const { return num_blobs_; }
+
+        Status status() const { return status_; }
+
+    private:
+        const Options options_;
+        const uint64_t file_number_;
+        WritableFile *const file_;
+        uint64_t offset_;
+        uint64_t num_blobs_;
+        Status status_;
+        std::string compressed_;
+    };
+
+    // Opens blob files by number for the tables that refer to them.
+    // Implementations must be safe to call from several threads at once.
+    class BlobSource {
+    public:
+        BlobSource() = default;
+
+        BlobSource(const BlobSource &) = delete;
+
+        BlobSource &operator=(const BlobSource &) = delete;
+
+        virtual ~BlobSource();
+
+        // Stores blob file "file_number" in *file.  The source keeps
+        // ownership; *file stays valid until the source is deleted.
+        virtual Status GetBlobFile(uint64_t file_number, RandomAccessFile **file) = 0;
+    };
+
+    // Returns a source that opens "<dirname>/<number>.blob" through env on
+    // first use and keeps it open.  "env" must outlive the result.
+    BlobSource *NewBlobFileCache(Env *env, const std::string &dirname,
+                                 const EnvOptions &env_options = EnvOptions());
+
+    // Reads the blob that "encoded_index" (an encoded BlobIndex) refers to.
+    // If result->heap_allocated, the caller must delete[] result->data.data().
+    Status ReadBlob(BlobSource *source, const ReadOptions &options, const Slice &encoded_index,
+                    BlockContents *result);
+
+    // Wraps an iterator over a data block of a table with blob references.
+    // The ValueType tag is stripped from values, and a blob is only read when
+    // value() is called on its entry, so key-only scans never touch blob
+    // files.  If reading a blob fails, value() is empty and status() says why.
+    // Takes ownership of "block_iter".
+    Iterator *NewBlobValueIterator(Iterator *block_iter, BlobSource *source, const ReadOptions &options);
+
+}
+
+#endif //SSTABLE_BLOB_FILE_H
@@ -0,0 +1,228 @@
+#include "blob_file.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "table.h"
+#include "table_builder.h"
+#include "../util/testutil.h"
+
+namespace leveldb {
+
+    namespace {
+
+        std::string Key(int i) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "key%06d", i);
+            return std::string(buf);
+        }
+
+        // 每隔几个 key 有一个超过 min_blob_size 的大 value
+        std::string Value(int i) {
+            if (i % 3 == 0) {
+                return std::string(500 + i % 200, static_cast<char>('a' + i % 26));
+            }
+            return "small" + std::to_string(i);
+        }
+
+    }  // namespace
+
+    // 一张表加一个 blob 文件，blob 文件编号为 7
+    class BlobFileTest : public testing::Test {
+    public:
+        BlobFileTest() : env_(Env::Default()), file_(nullptr), table_(nullptr) {
+            options_.block_size = 512;
+            options_.min_blob_size = 256;
+            dir_ = test::TempFileName("blob_file_test");
+            env_->CreateDir(dir_);
+            table_fname_ = dir_ + "/table.sst";
+            blob_fname_ = BlobFileName(dir_, 7);
+        }
+
+        ~BlobFileTest() override {
+            Close();
+            env_->RemoveFile(table_fname_);
+            env_->RemoveFile(blob_fname_);
+            env_->RemoveDir(dir_);
+        }
+
+        void Build(int num_keys) {
+            WritableFile *table_file;
+            WritableFile *blob_file;
+            ASSERT_TRUE(env_->NewWritableFile(table_fname_, &table_file).ok());
+            ASSERT_TRUE(env_->NewWritableFile(blob_fname_, &blob_file).ok());
+            {
+                BlobFileBuilder blobs(options_, 7, blob_file);
+                TableBuilder builder(options_, table_file, &blobs);
+                for (int i = 0; i < num_keys; i++) {
+                    builder.Add(Key(i), Value(i));
+                }
+                ASSERT_TRUE(builder.Finish().ok());
+                ASSERT_TRUE(builder.Sync().ok());
+                ASSERT_EQ(static_cast<uint64_t>((num_keys + 2) / 3), blobs.NumBlobs());
+            }
+            ASSERT_TRUE(blob_file->Close().ok());
+            ASSERT_TRUE(table_file->Close().ok());
+            delete blob_file;
+            delete table_file;
+        }
+
+        void Open(BlobSource *source) {
+            Close();
+            options_.blob_source = source;
+            uint64_t size;
+            ASSERT_TRUE(env_->GetFileSize(table_fname_, &size).ok());
+            ASSERT_TRUE(env_->NewRandomAccessFile(table_fname_, &file_).ok());
+            ASSERT_TRUE(Table::Open(options_, file_, size, &table_).ok());
+        }
+
+        void Close() {
+            delete table_;
+            table_ = nullptr;
+            delete file_;
+            file_ = nullptr;
+        }
+
+        Env *env_;
+        Options options_;
+        std::string dir_;
+        std::string table_fname_;
+        std::string blob_fname_;
+        RandomAccessFile *file_;
+        Table *table_;
+    };
+
+    TEST_F(BlobFileTest, BlobIndexRoundTrip) {
+        BlobIndex index;
+        index.file_number = 12345678901ull;
+        index.handle.set_offset(1 << 20);
+        index.handle.set_size(4097);
+        std::string encoded;
+        index.EncodeTo(&encoded);
+
+        Slice input(encoded);
+        BlobIndex decoded;
+        ASSERT_TRUE(decoded.DecodeFrom(&input).ok());
+        ASSERT_EQ(index.file_number, decoded.file_number);
+        ASSERT_EQ(index.handle.offset(), decoded.handle.offset());
+        ASSERT_EQ(index.handle.size(), decoded.handle.size());
+        ASSERT_TRUE(input.empty());
+
+        Slice truncated(encoded.data(), encoded.size() - 1);
+        ASSERT_TRUE(decoded.DecodeFrom(&truncated).IsCorruption());
+    }
+
+    TEST_F(BlobFileTest, RoundTrip) {
+        for (const CompressionType compression: {kNoCompression, kSnappyCompression}) {
+            options_.compression = compression;
+            Build(1000);
+            std::unique_ptr<BlobSource> source(NewBlobFileCache(env_, dir_));
+            Open(source.get());
+
+            ReadOptions read_options;
+            read_options.verify_checksums = true;
+            Iterator *iter = table_->NewIterator(read_options);
+            int i = 0;
+            for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i++) {
+                ASSERT_EQ(Key(i), iter->key().ToString());
+                ASSERT_EQ(Value(i), iter->value().ToString());
+            }
+            ASSERT_TRUE(iter->status().ok()) << iter->status().ToString();
+            ASSERT_EQ(1000, i);
+            iter->Seek(Key(600));
+            ASSERT_TRUE(iter->Valid());
+            ASSERT_EQ(Value(600), iter->value().ToString());
+            delete iter;
+
+            const std::string keys[] = {Key(999), Key(3), Key(4), Key(1000)};
+            Slice key_slices[4] = {keys[0], keys[1], keys[2], keys[3]};
+            std::string values[4];
+            Status statuses[4];
+            table_->MultiGet(read_options, 4, key_slices, values, statuses);
+            ASSERT_TRUE(statuses[0].ok());
+            ASSERT_EQ(Value(999), values[0]);
+            ASSERT_TRUE(statuses[1].ok());
+            ASSERT_EQ(Value(3), values[1]);
+            ASSERT_TRUE(statuses[2].ok());
+            ASSERT_EQ(Value(4), values[2]);
+            ASSERT_TRUE(statuses[3].IsNotFound());
+            Close();
+        }
+    }
+
+    // 只扫 key 不需要 blob 文件
+    TEST_F(BlobFileTest, KeyOnlyScanSkipsBlobs) {
+        Build(300);
+        ASSERT_TRUE(env_->RemoveFile(blob_fname_).ok());
+        std::unique_ptr<BlobSource> source(NewBlobFileCache(env_, dir_));
+        Open(source.get());
+
+        ReadOptions read_options;
+        read_options.key_only = true;
+        Iterator *iter = table_->NewIterator(read_options);
+        int i = 0;
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i++) {
+            ASSERT_EQ(Key(i), iter->key().ToString());
+        }
+        ASSERT_TRUE(iter->status().ok()) << iter->status().ToString();
+        ASSERT_EQ(300, i);
+        delete iter;
+
+        // 要 value 时 blob 文件不见了就报错
+        iter = table_->NewIterator(ReadOptions());
+        iter->Seek(Key(3));
+        ASSERT_TRUE(iter->Valid());
+        iter->value();
+        ASSERT_FALSE(iter->status().ok());
+        delete iter;
+    }
+
+    TEST_F(BlobFileTest, MissingBlobSource) {
+        Build(30);
+        Open(nullptr);
+        Iterator *iter = table_->NewIterator(ReadOptions());
+        iter->Seek(Key(1));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Value(1), iter->value().ToString());
+        ASSERT_TRUE(iter->status().ok());
+        iter->Seek(Key(3));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ("", iter->value().ToString());
+        ASSERT_TRUE(iter->status().IsInvalidArgument()) << iter->status().ToString();
+        delete iter;
+    }
+
+    TEST_F(BlobFileTest, CorruptBlob) {
+        options_.compression = kNoCompression;
+        Build(30);
+        // 第一个 blob 从 blob 文件开头开始
+        std::FILE *f = std::fopen(blob_fname_.c_str(), "r+b");
+        ASSERT_TRUE(f != nullptr);
+        std::fseek(f, 10, SEEK_SET);
+        std::fputc('X', f);
+        std::fclose(f);
+
+        std::unique_ptr<BlobSource> source(NewBlobFileCache(env_, dir_));
+        Open(source.get());
+        ReadOptions read_options;
+        read_options.verify_checksums = true;
+        Iterator *iter = table_->NewIterator(read_options);
+        iter->Seek(Key(0));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ("", iter->value().ToString());
+        ASSERT_TRUE(iter->status().IsCorruption()) << iter->status().ToString();
+        delete iter;
+
+        // 其他 blob 不受影响
+        iter = table_->NewIterator(read_options);
+        iter->Seek(Key(3));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Value(3), iter->value().ToString());
+        ASSERT_TRUE(iter->status().ok());
+        delete iter;
+    }
+
+}  // namespace leveldb
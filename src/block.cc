@@ -1,13 +1,19 @@
+#include <algorithm>
+
 #include <status.h>
 #include "block.h"
 #include "../util/coding.h"
+#include "fixed_key_search.h"
 
 namespace leveldb {
 
+    // "values_inline" is false for split blocks, whose values are not in
+    // the entry region that "limit" ends.
     static inline const char *DecodeEntry(const char *p, const char *limit,
                                           uint32_t *shared,
                                           uint32_t *non_shared,
-                                          uint32_t *value_length) {
+                                          uint32_t *value_length,
+                                          bool values_inline = true) {
         // shared non_shared value.size 这三个字节都没有 说明错误
         if (limit - p < 3) return nullptr;
 
@@ -28,7 +34,7 @@ namespace leveldb {
         }
 
         // 如果剩下的空间都少于key和value的长度了，说明解析失败
-        if (static_cast<uint32_t>(limit - p) < (*non_shared + *value_length)) {
+        if (static_cast<uint32_t>(limit - p) < (*non_shared + (values_inline ? *value_length : 0))) {
             return nullptr;
         }
         return p;
@@ -39,7 +45,7 @@ namespace leveldb {
     inline uint32_t Block::NumRestarts() const {
         // data_ + size_ Block  尾地址
         // 获得保存的restart point个数的 数值
-        return DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+        return DecodeFixed32(data_ + size_ - sizeof(uint32_t)) & ~kBlockFormatMask;
     }
 
     // ------- <- data_
@@ -53,23 +59,62 @@ namespace leveldb {
     Block::Block(BlockContents contents)
             : data_(contents.data.data()),// data 区域首地址
               size_(contents.data.size()),// data 总长度
+              split_(false),
+              values_offset_(0),
+              fixed_key_(false),
+              key_size_(0),
+              num_entries_(0),
               owned(contents.heap_allocated) {
 
         // 防止 size_ - sizeof(uint32_t) 溢出
         // 同时防止 NumRestarts() 读取到 Block 前面的数据造成读取 restart point 出错
         if (size_ < sizeof(uint32_t)) {
             size_ = 0;
-        } else {
-            // 由于 size_ 是 size_t 类型的，是非负数，如果 size_ < sizeof(uint32_t)，那么 size_ - sizeof(uint32_t) < 0 会溢出
-            size_t max_restarts_allowed = (size_ - sizeof(uint32_t)) / sizeof(uint32_t);
-            // 如果实际存储的 restart point 比最大的 restart point 数量还多的话，说明 Block 保存的 restart point length 不合法
-            uint32_t numRestarts = NumRestarts();
-            if (numRestarts > max_restarts_allowed) {
+            return;
+        }
+        const uint32_t last_word = DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+        if ((last_word & kFixedKeyBlockFlag) != 0) {
+            // 定长 key 格式: keys | value 偏移数组 | values | key_size | n
+            fixed_key_ = true;
+            if (size_ < 2 * sizeof(uint32_t)) {
                 size_ = 0;
-            } else {
-                // restart point 的头部偏移量 是 总的偏移量 减去 restart point length 和 restart point 所占的长度
-                restarts_offset_ = size_ - (1 + numRestarts) * sizeof(uint32_t);
+                return;
+            }
+            key_size_ = DecodeFixed32(data_ + size_ - 2 * sizeof(uint32_t));
+            num_entries_ = last_word & ~kBlockFormatMask;
+            const uint64_t values_start = static_cast<uint64_t>(num_entries_) * key_size_ +
+                                          (static_cast<uint64_t>(num_entries_) + 1) * sizeof(uint32_t);
+            const uint64_t values_end = size_ - 2 * sizeof(uint32_t);
+            if (key_size_ == 0 || values_start > values_end ||
+                DecodeFixed32(data_ + values_start - sizeof(uint32_t)) != values_end - values_start) {
+                size_ = 0;
+                return;
             }
+            restarts_offset_ = static_cast<uint32_t>(values_end);
+            values_offset_ = static_cast<uint32_t>(values_start);
+            return;
+        }
+        split_ = (last_word & kSplitBlockFlag) != 0;
+        // split 格式: 每个 restart 有 key、value 两个偏移量, 之前还有 value 区的起始偏移
+        const size_t restart_size = split_ ? 2 * sizeof(uint32_t) : sizeof(uint32_t);
+        const size_t footer_size = split_ ? 2 * sizeof(uint32_t) : sizeof(uint32_t);
+        if (size_ < footer_size) {
+            size_ = 0;
+            return;
+        }
+        // 由于 size_ 是 size_t 类型的，是非负数，如果 size_ < sizeof(uint32_t)，那么 size_ - sizeof(uint32_t) < 0 会溢出
+        size_t max_restarts_allowed = (size_ - footer_size) / restart_size;
+        // 如果实际存储的 restart point 比最大的 restart point 数量还多的话，说明 Block 保存的 restart point length 不合法
+        uint32_t numRestarts = NumRestarts();
+        if (numRestarts > max_restarts_allowed) {
+            size_ = 0;
+            return;
+        }
+        // restart point 的头部偏移量 是 总的偏移量 减去 restart point length 和 restart point 所占的长度
+        restarts_offset_ = size_ - footer_size - numRestarts * restart_size;
+        values_offset_ = split_ ? DecodeFixed32(data_ + size_ - 2 * sizeof(uint32_t)) : restarts_offset_;
+        if (values_offset_ > restarts_offset_) {
+            size_ = 0;
         }
     }
 
@@ -83,10 +128,17 @@ namespace leveldb {
         const char *data_; // Block的头地址
         uint32_t const restarts_; // restart point 的头开始 偏移量
         uint32_t const num_restarts_; // restart point的个数，用于二分查找范围
+        bool const key_only_; // 只扫描 key 时不解析 value，value() 返回空
+        // Entry 区的尾偏移量；split 格式下 Entry 只含 key，value 在 values_ 区
+        uint32_t const entries_end_;
+        const char *const values_; // split 格式的 value 区, 否则为 nullptr
+        uint32_t const values_size_;
 
         // Block的动态属性
         uint32_t restart_index_; //组磁头：指向Block中某一组磁头
         uint32_t current_; //Entry磁头：指向一组中某一Entry的磁头
+        uint32_t next_entry_; // 下一个Entry的头偏移量
+        uint32_t next_value_; // split 格式: 下一个value在value区的偏移量
 
         // 临时变量
         std::string key_; // 读取到的key，需要用resize操作舍弃非共享部分，以减少数据拷贝
@@ -103,12 +155,21 @@ namespace leveldb {
         // 获得组磁头的地址
         uint32_t GetRestartPoint(uint32_t index) {
             assert(index < num_restarts_);
+            if (values_ != nullptr) {
+                return DecodeFixed32(data_ + restarts_ + index * 2 * sizeof(uint32_t));
+            }
             return DecodeFixed32(data_ + restarts_ + index * sizeof(uint32_t));
         }
 
+        // split 格式: 第 index 组第一个 value 在 value 区的偏移量
+        uint32_t GetRestartValueOffset(uint32_t index) {
+            assert(index < num_restarts_);
+            return DecodeFixed32(data_ + restarts_ + index * 2 * sizeof(uint32_t) + sizeof(uint32_t));
+        }
+
         // 获得下一个Entry的头偏移量
         inline uint32_t NextEntryOffset() const {
-            return (value_.data() + value_.size()) - data_;
+            return next_entry_;
         }
 
         // 移动组磁头和Entry磁头指向index组的第一个Entry
@@ -116,22 +177,22 @@ namespace leveldb {
             key_.clear();
             restart_index_ = index;
 
-            uint32_t offset = GetRestartPoint(index);
-
-            // NextEntryOffset = data_ + offset + 0 - data_ = offset;
-            // 为什么不通过更新current_的方式来重新定位呢？
-            // current_ = offset
-            // ParseNextKey()同一组时，value_的尾地址就是下一个Entry的开头地址
-            // 利用这个特性，顺序ParseNextKey()可以很自然地进行下去
-            // Seek的时候为了兼容它，也选择修改value_到offset
-            value_ = Slice(data_ + offset, 0);
+            // 下一次 ParseNextKey() 从这一组的第一个 Entry 开始解析
+            next_entry_ = GetRestartPoint(index);
+            value_.clear();
+            if (values_ != nullptr && !key_only_) {
+                next_value_ = GetRestartValueOffset(index);
+            }
         }
 
     public:
         Iter(const Comparator *comparator,
              const char *data,
              uint32_t num_restarts,
-             uint32_t restarts_offset)
+             uint32_t restarts_offset,
+             bool key_only,
+             uint32_t entries_end,
+             bool split)
         // 二分查找用的Compare
                 : comparator_(comparator),
 
@@ -139,19 +200,36 @@ namespace leveldb {
                   data_(data), // index | data block 的 data 首地址
                   restarts_(restarts_offset),// restart point 的头部偏移量
                   num_restarts_(num_restarts),// restart 元素总个数
+                  key_only_(key_only),
+                  entries_end_(entries_end),
+                  values_(split ? data + entries_end : nullptr),
+                  values_size_(split ? restarts_offset - entries_end : 0),
 
                 // Block 的动态属性
                 // 磁头最开始指向 Entry 区的尾偏移量
                   restart_index_(num_restarts_), // restart 索引指向尾部
-                  current_(restarts_offset) {// Entry磁头：指向一组中某一 Entry 的磁头偏移地址
+                  current_(entries_end),// Entry磁头：指向一组中某一 Entry 的磁头偏移地址
+                  next_entry_(0),
+                  next_value_(0) {
 
             assert(num_restarts > 0);
         }
 
+        // 直接定位到第 index 组的第一个 Entry，不做二分查找
+        void SeekToSlot(uint32_t index) {
+            if (index >= num_restarts_) {
+                restart_index_ = num_restarts_;
+                current_ = entries_end_;
+                return;
+            }
+            SeekToRestartPoint(index);
+            ParseNextKey();
+        }
+
         // 侦测到无效时，会使得磁头指向 restarts_
         bool Valid() const override {
             // 说明存在上次的结果？
-            return current_ < restarts_;
+            return current_ < entries_end_;
         }
 
         // 此方法 不仅用于 index block 中 也用在了 data block 中
@@ -205,8 +283,8 @@ namespace leveldb {
 
                 // 解析 shared non_shared value.size non_shared_key_data value.data
                 // key_ptr 指向的是 key 的首地址
-                const char *key_ptr = DecodeEntry(data_ + region_offset, data_ + restarts_,
-                                                  &shared, &non_shared, &value_length);
+                const char *key_ptr = DecodeEntry(data_ + region_offset, data_ + entries_end_,
+                                                  &shared, &non_shared, &value_length, values_ == nullptr);
 
                 // 是的 是的 share 应为 0
                 if (key_ptr == nullptr || shared != 0) {
@@ -278,12 +356,12 @@ namespace leveldb {
         // 获得缓冲区中保存的value
         Slice value() const override {
             assert(Valid());
-            return Slice(value_);
+            return value_;
         }
 
         // 返回状态信息，通常请情况下是ok的状态
         Status status() const override {
-            return Status();
+            return status_;
         }
 
         // 移动并读取整个Block中第一个Entry的位置
@@ -298,7 +376,7 @@ namespace leveldb {
             SeekToRestartPoint(num_restarts_ - 1);
 
             // 向右顺序遍历，找到遍历到的Entry的尾偏移量大于等于Entry区的尾偏移量
-            while (ParseNextKey() && NextEntryOffset() < restarts_) {
+            while (ParseNextKey() && NextEntryOffset() < entries_end_) {
 
             }
         }
@@ -316,7 +394,7 @@ namespace leveldb {
                 if (restart_index_ == 0) {
                     // 重置磁头
                     restart_index_ = num_restarts_;
-                    current_ = restarts_;
+                    current_ = entries_end_;
                     return; //说明找不到，前序遍历失败
                 }
 
@@ -337,7 +415,7 @@ namespace leveldb {
         void CorruptionError() {
             // 重置磁头
             restart_index_ = num_restarts_; //重置组磁头
-            current_ = restarts_; // 重置Entry磁头
+            current_ = entries_end_; // 重置Entry磁头
 
             status_ = Status::Corruption("bad entry in block");
 
@@ -348,13 +426,13 @@ namespace leveldb {
         bool ParseNextKey() {
             current_ = NextEntryOffset(); // 计算下一个Entry的开头位置
             const char *p = data_ + current_; // 计算restart point的开头地址
-            const char *limit = data_ + restarts_; // 计算Block的末尾地址
+            const char *limit = data_ + entries_end_; // 计算Block的末尾地址
 
             // 如果下一个Entry的开头位置不在Block以内，则肯定读取不到Entry
             if (p >= limit) {
                 restart_index_ = num_restarts_;
                 // 没有Entry可读了，重置为Block末尾指针的偏移量，此时Vaild()函数会指示失效
-                current_ = restarts_;
+                current_ = entries_end_;
                 // 返回false通知调用者解析下一个Entry失败
                 return false;
             }
@@ -362,10 +440,12 @@ namespace leveldb {
             uint32_t shared, non_shared, value_length;
 
             // 从下一个Entry中解析出key的共享长度、key的非共享长度和value的长度，并将指针移动到非共享的key的位置
-            p = DecodeEntry(p, limit, &shared, &non_shared, &value_length);
+            p = DecodeEntry(p, limit, &shared, &non_shared, &value_length, values_ == nullptr);
 
             // 如果key的指针为空或者上一个key还没共享长度长，那就拼接不起来完整的key
-            if (p == nullptr || key_.size() < shared) {
+            if (p == nullptr || key_.size() < shared ||
+                (values_ != nullptr && !key_only_ &&
+                 (next_value_ > values_size_ || values_size_ - next_value_ < value_length))) {
                 // 如果读取一个Entry失败，就将status改成错误的提示
                 CorruptionError();
                 return false;
@@ -375,7 +455,20 @@ namespace leveldb {
                 // 加上本次读取的 本Entry 的非共享的部分组成完整的key
                 key_.append(p, non_shared);
                 // 取出 value, index block 中是 data block 最后一个entry的的位移; data block 中的是每组的位移
-                value_ = Slice(p + non_shared, value_length);
+                // key_only 时只用 value 的长度跳过它，value 区完全不碰
+                if (values_ != nullptr) {
+                    // split 格式只记录 value 的位置，不会读到 value 区的内存
+                    next_entry_ = (p + non_shared) - data_;
+                    if (!key_only_) {
+                        value_ = Slice(values_ + next_value_, value_length);
+                        next_value_ += value_length;
+                    }
+                } else {
+                    next_entry_ = (p + non_shared + value_length) - data_;
+                    if (!key_only_) {
+                        value_ = Slice(p + non_shared, value_length);
+                    }
+                }
 
                 // 顺序遍历可能会遍历到下一个组中，导致 restart_index 和 current_ 不匹配
                 while (restart_index_ + 1 < num_restarts_ &&
@@ -388,13 +481,114 @@ namespace leveldb {
         }
     };
 
-    Iterator *Block::NewIterator(const Comparator *comparator) {
+    // 定长 key 块的迭代器：key 直接指向块内数据，不需要解码和拼接
+    class Block::FixedKeyIter : public Iterator {
+    public:
+        FixedKeyIter(const Comparator *comparator, const char *data, uint32_t key_size, uint32_t num_entries,
+                     uint32_t values_offset, uint32_t values_end, bool key_only)
+                : comparator_(comparator),
+                  bytewise_(comparator == BytewiseComparator()),
+                  keys_(data),
+                  key_size_(key_size),
+                  n_(num_entries),
+                  offsets_(data + static_cast<size_t>(num_entries) * key_size),
+                  values_(data + values_offset),
+                  values_size_(values_end - values_offset),
+                  key_only_(key_only),
+                  index_(num_entries) {}
+
+        bool Valid() const override { return index_ < n_; }
+
+        void SeekToFirst() override { index_ = 0; }
+
+        void SeekToSlot(uint32_t index) { index_ = std::min(index, n_); }
+
+        void SeekToLast() override { index_ = n_ - 1; }
+
+        void Seek(const Slice &target) override {
+            if (bytewise_ && target.size() == key_size_) {
+                index_ = FixedKeyLowerBound(keys_, n_, key_size_, target.data());
+                return;
+            }
+            // 其它比较器或长度不同的 target：按比较器二分
+            uint32_t left = 0;
+            uint32_t right = n_;
+            while (left < right) {
+                const uint32_t mid = left + (right - left) / 2;
+                if (comparator_->Compare(KeyAt(mid), target) < 0) {
+                    left = mid + 1;
+                } else {
+                    right = mid;
+                }
+            }
+            index_ = left;
+        }
+
+        void Next() override {
+            assert(Valid());
+            index_++;
+        }
+
+        void Prev() override {
+            assert(Valid());
+            index_ = (index_ == 0) ? n_ : index_ - 1;
+        }
+
+        Slice key() const override {
+            assert(Valid());
+            return KeyAt(index_);
+        }
+
+        Slice value() const override {
+            assert(Valid());
+            if (key_only_) {
+                return Slice();
+            }
+            const uint32_t begin = DecodeFixed32(offsets_ + index_ * sizeof(uint32_t));
+            const uint32_t end = DecodeFixed32(offsets_ + (index_ + 1) * sizeof(uint32_t));
+            if (begin > end || end > values_size_) {
+                if (status_.ok()) status_ = Status::Corruption("bad value offset in block");
+                return Slice();
+            }
+            return Slice(values_ + begin, end - begin);
+        }
+
+        Status status() const override { return status_; }
+
+    private:
+        Slice KeyAt(uint32_t index) const {
+            return Slice(keys_ + static_cast<size_t>(index) * key_size_, key_size_);
+        }
+
+        const Comparator *const comparator_;
+        const bool bytewise_;      // Keys can be compared as bytes.
+        const char *const keys_;
+        const uint32_t key_size_;
+        const uint32_t n_;
+        const char *const offsets_;
+        const char *const values_;
+        const uint32_t values_size_;
+        const bool key_only_;
+
+        uint32_t index_;           // n_ when not valid.
+        mutable Status status_;
+    };
+
+    Iterator *Block::NewIterator(const Comparator *comparator, bool key_only) {
         // 倘若 size_ < sizeof(uint32_t)，则会导致 data_ + size_ - sizeof(uint32_t) < data_
         // 调用 NumRestarts() 读取 restart length 肯定会出错
         if (size_ < sizeof(uint32_t)) {
             return NewErrorIterator(Status::Corruption("bad block contents"));
         }
 
+        if (fixed_key_) {
+            if (num_entries_ == 0) {
+                return NewEmptyIterator();
+            }
+            return new FixedKeyIter(comparator, data_, key_size_, num_entries_, values_offset_,
+                                    restarts_offset_, key_only);
+        }
+
         // 获得 Block 中的 restart point 的数量
         const uint32_t num_restarts_ = NumRestarts();
 
@@ -402,8 +596,30 @@ namespace leveldb {
         if (num_restarts_ == 0) {
             return NewEmptyIterator();
         } else { // 如果不为零，则说明Block正常，生成迭代器
-            return new Iter(comparator, data_, num_restarts_, restarts_offset_);
+            return new Iter(comparator, data_, num_restarts_, restarts_offset_, key_only, values_offset_, split_);
+        }
+    }
+
+    Iterator *Block::NewIteratorAt(const Comparator *comparator, uint32_t slot, bool key_only) {
+        if (size_ < sizeof(uint32_t)) {
+            return NewErrorIterator(Status::Corruption("bad block contents"));
+        }
+        if (fixed_key_) {
+            if (num_entries_ == 0) {
+                return NewEmptyIterator();
+            }
+            auto *iter = new FixedKeyIter(comparator, data_, key_size_, num_entries_, values_offset_,
+                                          restarts_offset_, key_only);
+            iter->SeekToSlot(slot);
+            return iter;
+        }
+        const uint32_t num_restarts = NumRestarts();
+        if (num_restarts == 0) {
+            return NewEmptyIterator();
         }
+        auto *iter = new Iter(comparator, data_, num_restarts, restarts_offset_, key_only, values_offset_, split_);
+        iter->SeekToSlot(slot);
+        return iter;
     }
 
     Block::~Block() {
@@ -19,15 +19,30 @@ namespace leveldb {
 
         ~Block();
 
-        Iterator *NewIterator(const Comparator *comparator);
+        // If "key_only" is true, value() of the result is always empty.
+        Iterator *NewIterator(const Comparator *comparator, bool key_only = false);
+
+        // Like NewIterator(), but the result starts at the first entry of
+        // restart interval "slot" (in a kFixedKeyBlock, at entry "slot")
+        // without searching, and is not valid if there is no such slot.
+        Iterator *NewIteratorAt(const Comparator *comparator, uint32_t slot, bool key_only = false);
 
     private:
         class Iter;
+
+        class FixedKeyIter;
         // data 区域 起始地址
         const char *data_;
         // 大小与  unsigned int  或  unsigned long  相同
         size_t size_; // size_ 要参与和 sizeof() 的计算，同时它并不会为了持久化被编码，所以声明为 size_t，其它的变量都是uint32_t
         uint32_t restarts_offset_; //
+        // kSplitKeyValueBlock: key 区与 value 区分开存放
+        bool split_;               // Keys and values are in separate regions.
+        uint32_t values_offset_;   // Start of the values; the end of the key entries.
+        // kFixedKeyBlock: 定长 key 连续存放，可以直接二分查找
+        bool fixed_key_;
+        uint32_t key_size_;        // Fixed-key blocks: size of every key.
+        uint32_t num_entries_;     // Fixed-key blocks: number of keys.
 
         bool owned;
 
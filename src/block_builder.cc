@@ -2,6 +2,8 @@
 
 #include <utility>
 
+#include "format.h"
+
 namespace leveldb {
 
 
@@ -16,6 +18,20 @@ namespace leveldb {
         // assert(buffer_.empty());
         // assert(options_->comparator->Compare(key, last_key_piece) > 0);
 
+        // 块的格式由第一条 Entry 决定，中途修改 options 不影响当前块
+        if (buffer_.empty()) {
+            format_ = options_->data_block_format;
+        }
+
+        // 定长 key 直接顺序排列，不做前缀压缩，也没有 restart point
+        if (format_ == kFixedKeyBlock) {
+            assert(key.size() == options_->fixed_key_size);
+            buffer_.append(key.data(), key.size());
+            value_offsets_.push_back(static_cast<uint32_t>(values_.size()));
+            values_.append(value.data(), value.size());
+            return;
+        }
+
         // 初始化共享长度，第一个Entry为0，因为保存的是完整的key
         size_t shared = 0;
 
@@ -34,6 +50,9 @@ namespace leveldb {
             // 16个 entry 为一组，然后记录每个组的大小
             // 在持久化 block 时也需要计算这个
             restarts_.push_back(buffer_.size());
+            if (format_ == kSplitKeyValueBlock) {
+                value_restarts_.push_back(values_.size());
+            }
             counter_ = 0;
         }
 
@@ -49,8 +68,12 @@ namespace leveldb {
         // 将 非共享key字段 写入buffer_，共享的key就不用了 1字节
         buffer_.append(key.data() + shared, non_shared);
 
-        // 将 value 写入 buffer_ 6字节
-        buffer_.append(value.data(), value.size());
+        // 将 value 写入 buffer_ 6字节; split 格式写入单独的 value 区
+        if (format_ == kSplitKeyValueBlock) {
+            values_.append(value.data(), value.size());
+        } else {
+            buffer_.append(value.data(), value.size());
+        }
 
         // 把上一个完整的 key 缩减到共享 key 的长度
         last_key_.resize(shared);
@@ -63,7 +86,40 @@ namespace leveldb {
         counter_++;
     }
 
+    // Split blocks are laid out as
+    //    key entries | values | (key offset, value offset) per restart |
+    //    fixed32 offset of values | fixed32 num_restarts | kSplitBlockFlag
+    // where a key entry is shared | non_shared | value_length | key delta.
+    //
+    // Fixed-key blocks are laid out as
+    //    keys (n * key_size bytes) | fixed32 value offsets (n + 1) | values |
+    //    fixed32 key_size | fixed32 n | kFixedKeyBlockFlag
+    // where value i is values[offset[i], offset[i + 1]).
     Slice BlockBuilder::Finish() {
+        if (format_ == kFixedKeyBlock) {
+            value_offsets_.push_back(static_cast<uint32_t>(values_.size()));
+            for (uint32_t offset: value_offsets_) {
+                PutFixed32(&buffer_, offset);
+            }
+            buffer_.append(values_);
+            PutFixed32(&buffer_, static_cast<uint32_t>(options_->fixed_key_size));
+            PutFixed32(&buffer_, static_cast<uint32_t>(value_offsets_.size() - 1) | kFixedKeyBlockFlag);
+            finished_ = true;
+            return Slice(buffer_);
+        }
+        if (format_ == kSplitKeyValueBlock) {
+            const auto values_offset = static_cast<uint32_t>(buffer_.size());
+            buffer_.append(values_);
+            for (size_t i = 0; i < restarts_.size(); i++) {
+                PutFixed32(&buffer_, restarts_[i]);
+                PutFixed32(&buffer_, value_restarts_[i]);
+            }
+            PutFixed32(&buffer_, values_offset);
+            PutFixed32(&buffer_, static_cast<uint32_t>(restarts_.size()) | kSplitBlockFlag);
+            finished_ = true;
+            return Slice(buffer_);
+        }
+
         // 这里面存放的是 16个entry为一组的 大小值
         for (unsigned int restart: restarts_) {
             // 因为要进行二分查找，所以使用固定大小的空间来存储 restart point
@@ -76,13 +132,23 @@ namespace leveldb {
     }
 
     BlockBuilder::BlockBuilder(const Options *options, std::string name)
-            : options_(options), restarts_(), counter_(0), finished_(false), name_(std::move(name)) {
+            : options_(options), restarts_(), format_(kInterleavedBlock), counter_(0), finished_(false),
+              name_(std::move(name)) {
         restarts_.push_back(0);
+        value_restarts_.push_back(0);
     }
 
     size_t BlockBuilder::CurrentSizeEstimate() const {
-        size_t buffers = buffer_.size();
+        size_t buffers = buffer_.size() + values_.size();
+        if (format_ == kFixedKeyBlock) {
+            // value 偏移数组 n + 1 个, key_size 和 n
+            return buffers + (value_offsets_.size() + 1) * sizeof(uint32_t) + 2 * sizeof(uint32_t);
+        }
         size_t res = restarts_.size() * sizeof(uint32_t);
+        if (format_ == kSplitKeyValueBlock) {
+            // value 区的 restart 偏移和 value 区起始偏移
+            res += value_restarts_.size() * sizeof(uint32_t) + sizeof(uint32_t);
+        }
         return (buffers + res + sizeof(uint32_t));
     }
 
@@ -92,6 +158,12 @@ namespace leveldb {
         restarts_.clear();
         restarts_.push_back(0);
 
+        format_ = kInterleavedBlock;
+        values_.clear();
+        value_restarts_.clear();
+        value_restarts_.push_back(0);
+        value_offsets_.clear();
+
         counter_ = 0;
         finished_ = false;
 
@@ -23,10 +23,18 @@ namespace leveldb {
 
         Slice Finish();
 
+        // Return true iff no entries have been added since the last Reset()
+        bool empty() const { return buffer_.empty(); }
+
     private:
         const Options *options_;
-        std::string buffer_;
+        std::string buffer_;   // Entries; for split blocks only their keys.
         std::vector<uint32_t> restarts_;
+        // kSplitKeyValueBlock / kFixedKeyBlock 格式：value 单独存放
+        DataBlockFormat format_;  // Layout of the current block, fixed by its first Add().
+        std::string values_;      // Split and fixed-key blocks: the values, in entry order.
+        std::vector<uint32_t> value_restarts_;  // Split blocks: offset in values_ of each restart.
+        std::vector<uint32_t> value_offsets_;   // Fixed-key blocks: offset in values_ of each value.
         std::string last_key_;
         bool finished_;
         int counter_; // 保存数量
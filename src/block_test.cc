@@ -0,0 +1,143 @@
+#include "block.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "block_builder.h"
+#include "gtest/gtest.h"
+#include "../util/coding.h"
+#include "../util/testutil.h"
+
+namespace leveldb {
+
+    namespace {
+
+        // 8 字节的 key，三种块格式都能用
+        std::string Key(int i) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "k%07d", i);
+            return std::string(buf);
+        }
+
+        std::string Value(int i) { return "value" + std::to_string(i) + std::string(i % 20, 'v'); }
+
+        std::string BuildBlock(const Options &options, int num_entries) {
+            BlockBuilder builder(&options, "test");
+            for (int i = 0; i < num_entries; i++) {
+                builder.Add(Key(i), Value(i));
+            }
+            return builder.Finish().ToString();
+        }
+
+        Block *NewBlock(const std::string &contents) {
+            BlockContents block_contents;
+            block_contents.data = contents;
+            block_contents.cachable = false;
+            block_contents.heap_allocated = false;
+            return new Block(block_contents);
+        }
+
+        const DataBlockFormat kFormats[] = {kInterleavedBlock, kSplitKeyValueBlock, kFixedKeyBlock};
+
+    }  // namespace
+
+    class BlockTest : public testing::TestWithParam<DataBlockFormat> {
+    public:
+        BlockTest() {
+            options_.data_block_format = GetParam();
+            options_.block_restart_interval = 4;
+        }
+
+        Options options_;
+    };
+
+    TEST_P(BlockTest, RoundTrip) {
+        const std::string contents = BuildBlock(options_, 100);
+        Block *block = NewBlock(contents);
+        Iterator *iter = block->NewIterator(BytewiseComparator());
+        test::KVList entries;
+        ASSERT_TRUE(test::ReadAll(iter, &entries).ok());
+        ASSERT_EQ(100u, entries.size());
+        for (int i = 0; i < 100; i++) {
+            ASSERT_EQ(Key(i), entries[i].first);
+            ASSERT_EQ(Value(i), entries[i].second);
+        }
+
+        iter->Seek(Key(37));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Value(37), iter->value().ToString());
+        iter->Prev();
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Key(36), iter->key().ToString());
+        ASSERT_EQ(Value(36), iter->value().ToString());
+        iter->Seek("k9");
+        ASSERT_FALSE(iter->Valid());
+        ASSERT_TRUE(iter->status().ok());
+        delete iter;
+        delete block;
+    }
+
+    // key_only 时 value() 为空，但前后移动和 Seek 不受影响
+    TEST_P(BlockTest, KeyOnly) {
+        const std::string contents = BuildBlock(options_, 100);
+        Block *block = NewBlock(contents);
+        Iterator *iter = block->NewIterator(BytewiseComparator(), true);
+        int i = 0;
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i++) {
+            ASSERT_EQ(Key(i), iter->key().ToString());
+            ASSERT_TRUE(iter->value().empty());
+        }
+        ASSERT_EQ(100, i);
+        for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+            i--;
+            ASSERT_EQ(Key(i), iter->key().ToString());
+            ASSERT_TRUE(iter->value().empty());
+        }
+        ASSERT_EQ(0, i);
+        iter->Seek(Key(50));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Key(50), iter->key().ToString());
+        iter->Next();
+        ASSERT_EQ(Key(51), iter->key().ToString());
+        ASSERT_TRUE(iter->status().ok());
+        delete iter;
+
+        iter = block->NewIteratorAt(BytewiseComparator(), 3, true);
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Key(GetParam() == kFixedKeyBlock ? 3 : 12), iter->key().ToString());
+        ASSERT_TRUE(iter->value().empty());
+        delete iter;
+        delete block;
+    }
+
+    INSTANTIATE_TEST_SUITE_P(Formats, BlockTest, testing::ValuesIn(kFormats));
+
+    // split 格式下 key_only 完全不读 value 区：value 的偏移坏了也照样能扫 key
+    TEST(SplitBlockTest, KeyOnlyIgnoresValueOffsets) {
+        Options options;
+        options.data_block_format = kSplitKeyValueBlock;
+        options.block_restart_interval = 4;
+        std::string contents = BuildBlock(options, 100);
+        // 尾部: restarts (key 偏移, value 偏移)... | values 起始 | restart 个数
+        const size_t num_restarts = 25;
+        const size_t restarts = contents.size() - 2 * sizeof(uint32_t) - num_restarts * 2 * sizeof(uint32_t);
+        EncodeFixed32(&contents[restarts + 10 * 2 * sizeof(uint32_t) + sizeof(uint32_t)], 0xfffffff0u);
+        Block *block = NewBlock(contents);
+
+        Iterator *iter = block->NewIterator(BytewiseComparator());
+        iter->Seek(Key(41));
+        ASSERT_FALSE(iter->Valid());
+        ASSERT_TRUE(iter->status().IsCorruption());
+        delete iter;
+
+        iter = block->NewIterator(BytewiseComparator(), true);
+        iter->Seek(Key(41));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Key(41), iter->key().ToString());
+        ASSERT_TRUE(iter->status().ok());
+        delete iter;
+        delete block;
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,211 @@
+#include "compaction.h"
+
+#include <algorithm>
+
+#include "../include/comparator.h"
+#include "../include/iterator.h"
+#include "../port/port_stdcxx.h"
+#include "../port/thread_annotations.h"
+#include "../util/mutexlock.h"
+#include "merger.h"
+#include "table.h"
+
+namespace leveldb {
+
+    // Compaction inputs are read once, front to back.
+    static const size_t kCompactionReadaheadSize = 256 * 1024;
+
+    namespace {
+
+        // One key range of a compaction, merged by one worker.
+        struct Subcompaction {
+            bool has_begin = false;
+            bool has_end = false;
+            std::string begin;
+            std::string end;
+
+            std::vector<TableFileMeta> outputs;
+            Status status;
+        };
+
+        class CompactionJob {
+        public:
+            CompactionJob(const Options &options, const std::vector<Table *> &inputs, TableFileFactory *factory)
+                    : options_(options), inputs_(inputs), factory_(factory), cv_(&mu_), pending_(0) {}
+
+            // Cuts [begin, end) into at most max_subcompactions subranges.
+            void Split(const Slice *begin, const Slice *end, int max_subcompactions);
+
+            // Runs every subcompaction, the first one on the calling thread.
+            void Run();
+
+            Status Collect(std::vector<TableFileMeta> *outputs) const;
+
+        private:
+            struct WorkerArg {
+                CompactionJob *job;
+                Subcompaction *sub;
+            };
+
+            static void Worker(void *arg);
+
+            void DoSubcompaction(Subcompaction *sub) const;
+
+            const Options &options_;
+            const std::vector<Table *> &inputs_;
+            TableFileFactory *const factory_;
+            std::vector<Subcompaction> subs_;
+
+            port::Mutex mu_;
+            port::CondVar cv_ GUARDED_BY(mu_);
+            int pending_ GUARDED_BY(mu_);  // Subcompactions still running on other threads.
+        };
+
+        void CompactionJob::Split(const Slice *begin, const Slice *end, int max_subcompactions) {
+            const Comparator *cmp = options_.comparator;
+
+            // 用所有输入的 index key 作为候选切分点，取分位数
+            std::vector<std::string> keys;
+            if (max_subcompactions > 1) {
+                for (const Table *table: inputs_) {
+                    table->GetIndexKeys(&keys);
+                }
+                auto out_of_range = [&](const std::string &k) {
+                    return (begin != nullptr && cmp->Compare(k, *begin) <= 0) ||
+                           (end != nullptr && cmp->Compare(k, *end) >= 0);
+                };
+                keys.erase(std::remove_if(keys.begin(), keys.end(), out_of_range), keys.end());
+                std::sort(keys.begin(), keys.end(),
+                          [cmp](const std::string &a, const std::string &b) { return cmp->Compare(a, b) < 0; });
+            }
+
+            std::vector<std::string> splits;
+            if (!keys.empty()) {
+                const size_t k = std::min(static_cast<size_t>(max_subcompactions), keys.size() + 1);
+                for (size_t i = 1; i < k; i++) {
+                    const std::string &key = keys[i * keys.size() / k];
+                    if (splits.empty() || cmp->Compare(splits.back(), key) < 0) {
+                        splits.push_back(key);
+                    }
+                }
+            }
+
+            subs_.resize(splits.size() + 1);
+            for (size_t i = 0; i < subs_.size(); i++) {
+                Subcompaction &sub = subs_[i];
+                if (i > 0) {
+                    sub.has_begin = true;
+                    sub.begin = splits[i - 1];
+                } else if (begin != nullptr) {
+                    sub.has_begin = true;
+                    sub.begin = begin->ToString();
+                }
+                if (i < splits.size()) {
+                    sub.has_end = true;
+                    sub.end = splits[i];
+                } else if (end != nullptr) {
+                    sub.has_end = true;
+                    sub.end = end->ToString();
+                }
+            }
+        }
+
+        void CompactionJob::Run() {
+            std::vector<WorkerArg> args(subs_.size());
+            mu_.Lock();
+            pending_ = static_cast<int>(subs_.size()) - 1;
+            mu_.Unlock();
+            for (size_t i = 1; i < subs_.size(); i++) {
+                args[i] = WorkerArg{this, &subs_[i]};
+                options_.env->StartThread(&CompactionJob::Worker, &args[i]);
+            }
+
+            DoSubcompaction(&subs_[0]);
+
+            MutexLock l(&mu_);
+            while (pending_ > 0) {
+                cv_.Wait();
+            }
+        }
+
+        void CompactionJob::Worker(void *arg) {
+            auto *worker = reinterpret_cast<WorkerArg *>(arg);
+            CompactionJob *job = worker->job;
+            job->DoSubcompaction(worker->sub);
+
+            MutexLock l(&job->mu_);
+            if (--job->pending_ == 0) {
+                job->cv_.SignalAll();
+            }
+        }
+
+        Status CompactionJob::Collect(std::vector<TableFileMeta> *outputs) const {
+            Status status;
+            for (const Subcompaction &sub: subs_) {
+                outputs->insert(outputs->end(), sub.outputs.begin(), sub.outputs.end());
+                if (status.ok()) {
+                    status = sub.status;
+                }
+            }
+            return status;
+        }
+
+        void CompactionJob::DoSubcompaction(Subcompaction *sub) const {
+            const Comparator *cmp = options_.comparator;
+
+            ReadOptions read_options;
+            read_options.fill_cache = false;
+            read_options.readahead_size = kCompactionReadaheadSize;
+            std::vector<Iterator *> children;
+            children.reserve(inputs_.size());
+            for (const Table *table: inputs_) {
+                children.push_back(table->NewIterator(read_options));
+            }
+            Iterator *input = NewMergingIterator(cmp, children.data(), static_cast<int>(children.size()));
+
+            MultiTableBuilder builder(options_, factory_);
+            std::string last_key;
+            bool has_last_key = false;
+
+            if (sub->has_begin) {
+                input->Seek(sub->begin);
+            } else {
+                input->SeekToFirst();
+            }
+            for (; input->Valid() && builder.status().ok(); input->Next()) {
+                const Slice key = input->key();
+                if (sub->has_end && cmp->Compare(key, sub->end) >= 0) {
+                    break;
+                }
+                // 合并迭代器中同一个 key 先出现的来自较新的输入，后面的旧版本丢弃
+                if (has_last_key && cmp->Compare(key, last_key) == 0) {
+                    continue;
+                }
+                last_key.assign(key.data(), key.size());
+                has_last_key = true;
+                builder.Add(key, input->value());
+            }
+
+            Status status = input->status();
+            if (status.ok()) {
+                status = builder.Finish();
+            } else {
+                builder.Abandon();
+            }
+            sub->outputs = builder.outputs();
+            sub->status = status;
+            delete input;
+        }
+
+    }  // namespace
+
+    Status CompactTables(const Options &options, const std::vector<Table *> &inputs,
+                         const Slice *begin, const Slice *end, int max_subcompactions,
+                         TableFileFactory *factory, std::vector<TableFileMeta> *outputs) {
+        CompactionJob job(options, inputs, factory);
+        job.Split(begin, end, std::max(max_subcompactions, 1));
+        job.Run();
+        return job.Collect(outputs);
+    }
+
+}
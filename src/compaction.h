@@ -0,0 +1,35 @@
+#ifndef SSTABLE_COMPACTION_H
+#define SSTABLE_COMPACTION_H
+
+#include <vector>
+
+#include "../include/options.h"
+#include "../include/slice.h"
+#include "../include/status.h"
+#include "multi_table_builder.h"
+
+namespace leveldb {
+
+    class Table;
+
+    // 多路归并压缩，按 key 范围切分后并行执行
+    // Merges "inputs" into non-overlapping output tables covering the keys in
+    // [*begin, *end).  A null begin (end) means the range is unbounded on that
+    // side.  "inputs" are ordered newest first: when a key is present in
+    // several inputs, only the value from the earliest one is kept.
+    //
+    // The range is cut into up to "max_subcompactions" subranges of about the
+    // same number of data blocks, using the inputs' index blocks, and each
+    // subrange is merged by its own thread into a MultiTableBuilder, which
+    // starts a new output once the current one reaches options.max_file_size.
+    //
+    // On success *outputs holds the produced files in key order.  On error
+    // *outputs still describes the files completed so far, which the caller
+    // may want to delete.
+    Status CompactTables(const Options &options, const std::vector<Table *> &inputs,
+                         const Slice *begin, const Slice *end, int max_subcompactions,
+                         TableFileFactory *factory, std::vector<TableFileMeta> *outputs);
+
+}
+
+#endif //SSTABLE_COMPACTION_H
@@ -0,0 +1,157 @@
+#include "compaction.h"
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "table.h"
+#include "../util/random.h"
+#include "../util/testutil.h"
+
+namespace leveldb {
+
+    namespace {
+
+        std::string Key(int i) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "key%06d", i);
+            return std::string(buf);
+        }
+
+    }  // namespace
+
+    // 几张互相重叠的输入表，newest first；同一个 key 取最新那张表的值
+    class CompactionTest : public testing::Test {
+    public:
+        CompactionTest() {
+            options_.block_size = 512;
+            options_.max_file_size = 16 * 1024;
+            output_dir_ = test::TempFileName("compaction_test");
+            options_.env->CreateDir(output_dir_);
+
+            Random rnd(301);
+            for (int t = 0; t < 3; t++) {
+                std::map<std::string, std::string> entries;
+                for (int i = 0; i < 3000; i++) {
+                    const std::string key = Key(rnd.Uniform(6000));
+                    entries[key] = "t" + std::to_string(t) + "-" + key;
+                    if (expected_.count(key) == 0) {
+                        expected_[key] = entries[key];
+                    }
+                }
+                const std::string fname = test::TempFileName("compaction_input" + std::to_string(t));
+                EXPECT_TRUE(test::BuildTableFile(options_, fname,
+                                                 test::KVList(entries.begin(), entries.end())).ok());
+                input_fnames_.push_back(fname);
+
+                uint64_t size;
+                RandomAccessFile *file;
+                Table *table;
+                EXPECT_TRUE(options_.env->GetFileSize(fname, &size).ok());
+                EXPECT_TRUE(options_.env->NewRandomAccessFile(fname, &file).ok());
+                EXPECT_TRUE(Table::Open(options_, file, size, &table).ok());
+                files_.push_back(file);
+                inputs_.push_back(table);
+            }
+        }
+
+        ~CompactionTest() override {
+            for (size_t i = 0; i < inputs_.size(); i++) {
+                delete inputs_[i];
+                delete files_[i];
+                options_.env->RemoveFile(input_fnames_[i]);
+            }
+            RemoveOutputs();
+            options_.env->RemoveDir(output_dir_);
+        }
+
+        void RemoveOutputs() {
+            for (const TableFileMeta &meta: outputs_) {
+                options_.env->RemoveFile(meta.fname);
+            }
+            outputs_.clear();
+        }
+
+        // 合并后按顺序读出所有输出表，并检查输出之间不重叠、元数据对得上
+        void Compact(const Slice *begin, const Slice *end, int max_subcompactions, test::KVList *result) {
+            RemoveOutputs();
+            std::unique_ptr<TableFileFactory> factory(NewTableFileFactory(options_.env, output_dir_, 1));
+            ASSERT_TRUE(CompactTables(options_, inputs_, begin, end, max_subcompactions, factory.get(),
+                                      &outputs_).ok());
+            for (size_t i = 0; i < outputs_.size(); i++) {
+                const TableFileMeta &meta = outputs_[i];
+                test::KVList entries;
+                ASSERT_TRUE(test::ReadTableFile(options_, meta.fname, &entries).ok());
+                ASSERT_FALSE(entries.empty());
+                ASSERT_EQ(meta.num_entries, entries.size());
+                ASSERT_EQ(meta.smallest, entries.front().first);
+                ASSERT_EQ(meta.largest, entries.back().first);
+                if (i > 0) {
+                    ASSERT_LT(outputs_[i - 1].largest, meta.smallest);
+                }
+                result->insert(result->end(), entries.begin(), entries.end());
+            }
+        }
+
+        // expected_ 中落在 [begin, end) 的部分
+        test::KVList ExpectedRange(const std::string *begin, const std::string *end) const {
+            test::KVList result;
+            for (const auto &entry: expected_) {
+                if ((begin == nullptr || entry.first >= *begin) && (end == nullptr || entry.first < *end)) {
+                    result.push_back(entry);
+                }
+            }
+            return result;
+        }
+
+        Options options_;
+        std::string output_dir_;
+        std::vector<std::string> input_fnames_;
+        std::vector<RandomAccessFile *> files_;
+        std::vector<Table *> inputs_;
+        std::map<std::string, std::string> expected_;
+        std::vector<TableFileMeta> outputs_;
+    };
+
+    TEST_F(CompactionTest, WholeRange) {
+        for (const int subcompactions: {1, 4}) {
+            test::KVList result;
+            Compact(nullptr, nullptr, subcompactions, &result);
+            ASSERT_EQ(ExpectedRange(nullptr, nullptr), result) << subcompactions << " subcompactions";
+            // 输出按 max_file_size 切开
+            ASSERT_GT(outputs_.size(), 3u);
+        }
+    }
+
+    TEST_F(CompactionTest, BoundedRange) {
+        const std::string begin = Key(1000);
+        const std::string end = Key(4500);
+        const Slice begin_slice(begin);
+        const Slice end_slice(end);
+        for (const int subcompactions: {1, 3, 8}) {
+            test::KVList result;
+            Compact(&begin_slice, &end_slice, subcompactions, &result);
+            ASSERT_EQ(ExpectedRange(&begin, &end), result) << subcompactions << " subcompactions";
+        }
+
+        test::KVList result;
+        Compact(nullptr, &end_slice, 2, &result);
+        ASSERT_EQ(ExpectedRange(nullptr, &end), result);
+        result.clear();
+        Compact(&begin_slice, nullptr, 2, &result);
+        ASSERT_EQ(ExpectedRange(&begin, nullptr), result);
+    }
+
+    TEST_F(CompactionTest, EmptyRange) {
+        const std::string begin = "zzz";
+        const Slice begin_slice(begin);
+        test::KVList result;
+        Compact(&begin_slice, nullptr, 4, &result);
+        ASSERT_TRUE(result.empty());
+        ASSERT_TRUE(outputs_.empty());
+    }
+
+}  // namespace leveldb
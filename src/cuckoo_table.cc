@@ -0,0 +1,106 @@
+#include "cuckoo_table.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "../util/coding.h"
+#include "cuckoo_table_builder.h"
+#include "format.h"
+
+namespace leveldb {
+
+    Status CuckooTable::Open(const Options &, RandomAccessFile *file, uint64_t file_size,
+                             CuckooTable **table) {
+        *table = nullptr;
+        if (file_size < kCuckooTableFooterSize) {
+            return Status::Corruption("file is too short to be a cuckoo table");
+        }
+
+        char footer_space[kCuckooTableFooterSize];
+        Slice footer;
+        Status s = file->Read(file_size - kCuckooTableFooterSize, kCuckooTableFooterSize, &footer, footer_space);
+        if (!s.ok()) return s;
+        if (footer.size() != kCuckooTableFooterSize ||
+            DecodeFixed64(footer.data() + kCuckooTableFooterSize - 8) != kCuckooTableMagicNumber) {
+            return Status::Corruption("not a cuckoo table (bad magic number)");
+        }
+        const uint32_t num_blocks = DecodeFixed32(footer.data());
+        const uint32_t slots_per_block = DecodeFixed32(footer.data() + 4);
+        const uint32_t slot_size = DecodeFixed32(footer.data() + 8);
+        if (num_blocks == 0 || slots_per_block == 0 || slot_size < kCuckooSlotHeaderSize ||
+            uint64_t{num_blocks} * slots_per_block * slot_size != file_size - kCuckooTableFooterSize) {
+            return Status::Corruption("bad cuckoo table footer");
+        }
+
+        BlockContents contents;
+        s = ReadFileContents(file, file_size, &contents);
+        if (!s.ok()) return s;
+
+        // 映射的文件从页边界开始，原地使用；new[] 只保证 16 字节对齐，
+        // 复制到 64 字节对齐的内存里，小 slot 的块才正好是一个 cache line
+        const char *data = contents.data.data();
+        char *owned = nullptr;
+        if (contents.heap_allocated || reinterpret_cast<uintptr_t>(data) % kCuckooBlockAlignment != 0) {
+            void *buf = nullptr;
+            if (posix_memalign(&buf, kCuckooBlockAlignment, contents.data.size()) == 0) {
+                owned = static_cast<char *>(buf);
+                std::memcpy(owned, data, contents.data.size());
+            }
+            if (contents.heap_allocated) {
+                delete[] data;
+            }
+            if (owned == nullptr) {
+                return Status::IOError("out of memory for cuckoo table");
+            }
+            data = owned;
+        }
+
+        auto *t = new CuckooTable;
+        t->data_ = data;
+        t->owned_ = owned;
+        t->num_blocks_ = num_blocks;
+        t->slots_per_block_ = slots_per_block;
+        t->slot_size_ = slot_size;
+        t->seed_ = DecodeFixed32(footer.data() + 12);
+        t->num_entries_ = DecodeFixed64(footer.data() + 16);
+        *table = t;
+        return Status::OK();
+    }
+
+    CuckooTable::~CuckooTable() { std::free(owned_); }
+
+    Status CuckooTable::InternalGet(const ReadOptions &, const Slice &key,
+                                    void (*handle_result)(const Slice &k, const Slice &v)) const {
+        uint32_t blocks[2];
+        CuckooBlocks(CuckooHash(key, seed_), num_blocks_, &blocks[0], &blocks[1]);
+        const size_t block_size = static_cast<size_t>(slots_per_block_) * slot_size_;
+        // 两个块互不依赖，先把第二个块取进来
+        const char *second = data_ + blocks[1] * block_size;
+        for (size_t offset = 0; offset < block_size; offset += kCuckooBlockAlignment) {
+            __builtin_prefetch(second + offset);
+        }
+
+        for (uint32_t b: blocks) {
+            const char *slot = data_ + b * block_size;
+            for (uint32_t s = 0; s < slots_per_block_; s++, slot += slot_size_) {
+                const uint32_t key_length = DecodeFixed32(slot);
+                const uint32_t value_length = DecodeFixed32(slot + sizeof(uint32_t));
+                // 构建时块内 slot 从前往后填，且 key 一旦放入就不会留下空位：
+                // 遇到空 slot 说明 key 不在表中
+                if (value_length == kCuckooEmptySlot) {
+                    return Status::OK();
+                }
+                if (uint64_t{key_length} + value_length > slot_size_ - kCuckooSlotHeaderSize) {
+                    return Status::Corruption("bad cuckoo table slot");
+                }
+                const char *slot_key = slot + kCuckooSlotHeaderSize;
+                if (key_length == key.size() && std::memcmp(slot_key, key.data(), key_length) == 0) {
+                    (*handle_result)(Slice(slot_key, key_length), Slice(slot_key + key_length, value_length));
+                    return Status::OK();
+                }
+            }
+        }
+        return Status::OK();
+    }
+
+}
@@ -0,0 +1,55 @@
+#ifndef SSTABLE_CUCKOO_TABLE_H
+#define SSTABLE_CUCKOO_TABLE_H
+
+#include <cstdint>
+
+#include "../include/env.h"
+#include "../include/options.h"
+#include "../include/status.h"
+
+namespace leveldb {
+
+    // 布谷鸟哈希表：点查最多探测两个块，slot 不超过 32 字节时就是两个 cache line
+    // Reads tables written by CuckooTableBuilder.  A lookup hashes the key
+    // once and compares it with the slots of at most two blocks.  When
+    // slots take at most 32 bytes a block is one aligned cache line; larger
+    // slots come four to a block, so a block spans four slots' worth of
+    // cache lines.  Like PlainTable, the table is used in place when the
+    // file is mmap()ed; otherwise it is read into memory once and copied to
+    // a 64-byte aligned buffer, briefly holding two copies.  Keys are not
+    // ordered, so there is no iterator.
+    //
+    // Safe for concurrent use.
+    class CuckooTable {
+    public:
+        // "options" is not used yet.  "file" must outlive the table.
+        static Status Open(const Options &options, RandomAccessFile *file, uint64_t file_size, CuckooTable **table);
+
+        CuckooTable(const CuckooTable &) = delete;
+
+        CuckooTable &operator=(const CuckooTable &) = delete;
+
+        // Does not close or delete the file passed to Open().
+        ~CuckooTable();
+
+        // Calls handle_result with the entry whose key equals "key", if any.
+        Status InternalGet(const ReadOptions &, const Slice &key,
+                           void (*handle_result)(const Slice &k, const Slice &v)) const;
+
+        uint64_t NumEntries() const { return num_entries_; }
+
+    private:
+        CuckooTable() = default;
+
+        const char *data_ = nullptr;   // The slots.
+        char *owned_ = nullptr;        // data_, if copied into memory; from posix_memalign().
+        uint32_t num_blocks_ = 0;
+        uint32_t slots_per_block_ = 0;
+        uint32_t slot_size_ = 0;
+        uint32_t seed_ = 0;
+        uint64_t num_entries_ = 0;
+    };
+
+}
+
+#endif //SSTABLE_CUCKOO_TABLE_H
@@ -0,0 +1,209 @@
+#include "cuckoo_table_builder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "../util/coding.h"
+#include "../util/hash.h"
+#include "../util/random.h"
+#include "format.h"
+
+namespace leveldb {
+
+    namespace {
+        // Slots of more than half a cache line come this many to a block.
+        const uint32_t kLargeSlotsPerBlock = 4;
+
+        // 一次插入最多踢出这么多个 key，超过就换种子、加大表重来
+        const int kMaxKicks = 500;
+        const int kMaxAttempts = 64;
+    }
+
+    uint64_t CuckooHash(const Slice &key, uint32_t seed) {
+        return (static_cast<uint64_t>(Hash(key.data(), key.size(), 2 * seed + 0x85ebca6b)) << 32) |
+               Hash(key.data(), key.size(), 2 * seed + 0xc2b2ae35);
+    }
+
+    void CuckooBlocks(uint64_t hash, uint32_t num_blocks, uint32_t *first, uint32_t *second) {
+        *first = static_cast<uint32_t>(((hash & 0xffffffffu) * num_blocks) >> 32);
+        *second = static_cast<uint32_t>(((hash >> 32) * num_blocks) >> 32);
+        if (*second == *first && num_blocks > 1) {
+            *second = (*first + 1) % num_blocks;
+        }
+    }
+
+    CuckooTableBuilder::CuckooTableBuilder(const Options &, WritableFile *file)
+            : file_(file), finished_(false), file_size_(0), max_key_size_(0), max_value_size_(0) {}
+
+    CuckooTableBuilder::~CuckooTableBuilder() = default;
+
+    Slice CuckooTableBuilder::KeyAt(uint32_t i) const {
+        return Slice(data_.data() + offsets_[i], key_sizes_[i]);
+    }
+
+    Slice CuckooTableBuilder::ValueAt(uint32_t i) const {
+        const uint64_t begin = offsets_[i] + key_sizes_[i];
+        const uint64_t end = (i + 1 < offsets_.size()) ? offsets_[i + 1] : data_.size();
+        return Slice(data_.data() + begin, end - begin);
+    }
+
+    void CuckooTableBuilder::Add(const Slice &key, const Slice &value) {
+        assert(!finished_);
+        if (!status_.ok()) return;
+        if (value.size() >= kCuckooEmptySlot) {
+            status_ = Status::InvalidArgument("value too large for a cuckoo table", key);
+            return;
+        }
+        offsets_.push_back(data_.size());
+        key_sizes_.push_back(static_cast<uint32_t>(key.size()));
+        data_.append(key.data(), key.size());
+        data_.append(value.data(), value.size());
+        max_key_size_ = std::max(max_key_size_, key.size());
+        max_value_size_ = std::max(max_value_size_, value.size());
+    }
+
+    bool CuckooTableBuilder::Place(uint32_t num_blocks, uint32_t slots_per_block, uint32_t seed,
+                                   std::vector<uint32_t> *slots) const {
+        slots->assign(static_cast<size_t>(num_blocks) * slots_per_block, kCuckooEmptySlot);
+        std::vector<uint64_t> hashes(offsets_.size());
+        for (uint32_t i = 0; i < offsets_.size(); i++) {
+            hashes[i] = CuckooHash(KeyAt(i), seed);
+        }
+
+        Random rnd(seed + 1);
+        for (uint32_t i = 0; i < offsets_.size(); i++) {
+            uint32_t entry = i;
+            uint32_t from = num_blocks;  // Block "entry" was just evicted from.
+            bool placed = false;
+            for (int kick = 0; kick < kMaxKicks && !placed; kick++) {
+                uint32_t blocks[2];
+                CuckooBlocks(hashes[entry], num_blocks, &blocks[0], &blocks[1]);
+                // 已用的 slot 总在块的前部，找到第一个空位即可
+                for (uint32_t b: blocks) {
+                    uint32_t *block = slots->data() + static_cast<size_t>(b) * slots_per_block;
+                    for (uint32_t s = 0; s < slots_per_block && !placed; s++) {
+                        if (block[s] == kCuckooEmptySlot) {
+                            block[s] = entry;
+                            placed = true;
+                        }
+                    }
+                    if (placed) break;
+                }
+                if (placed) break;
+
+                // 两个块都满了：从刚才没待过的块里随机踢出一个 key
+                uint32_t victim_block;
+                if (from == blocks[0]) {
+                    victim_block = blocks[1];
+                } else if (from == blocks[1]) {
+                    victim_block = blocks[0];
+                } else {
+                    victim_block = blocks[rnd.OneIn(2) ? 0 : 1];
+                }
+                uint32_t &victim = (*slots)[static_cast<size_t>(victim_block) * slots_per_block +
+                                            rnd.Uniform(static_cast<int>(slots_per_block))];
+                std::swap(entry, victim);
+                from = victim_block;
+            }
+            if (!placed) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Status CuckooTableBuilder::Finish() {
+        assert(!finished_);
+        finished_ = true;
+        if (!status_.ok()) return status_;
+
+        const auto n = static_cast<uint32_t>(offsets_.size());
+        {
+            std::vector<uint32_t> order(n);
+            for (uint32_t i = 0; i < n; i++) order[i] = i;
+            std::sort(order.begin(), order.end(),
+                      [this](uint32_t a, uint32_t b) { return KeyAt(a).compare(KeyAt(b)) < 0; });
+            for (uint32_t i = 1; i < n; i++) {
+                if (KeyAt(order[i - 1]) == KeyAt(order[i])) {
+                    return status_ = Status::InvalidArgument("duplicate key in cuckoo table", KeyAt(order[i]));
+                }
+            }
+        }
+
+        // 小 slot 向上取 2 的幂，一个块正好占满一个 cache line；
+        // 大 slot 每块 4 个，保证装载率
+        size_t slot_size = kCuckooSlotHeaderSize + max_key_size_ + max_value_size_;
+        uint32_t slots_per_block;
+        if (slot_size <= kCuckooBlockAlignment / 2) {
+            size_t rounded = 1;
+            while (rounded < slot_size) rounded *= 2;
+            slot_size = rounded;
+            slots_per_block = static_cast<uint32_t>(kCuckooBlockAlignment / slot_size);
+        } else {
+            slot_size = (slot_size + 7) / 8 * 8;
+            slots_per_block = kLargeSlotsPerBlock;
+        }
+        if (slot_size >= kCuckooEmptySlot) {
+            return status_ = Status::InvalidArgument("entries too large for a cuckoo table");
+        }
+        // 每块 slot 越多，能达到的装载率越高
+        const double load = slots_per_block >= 4 ? 0.9 : 0.8;
+        uint64_t num_blocks = std::max<uint64_t>(1, static_cast<uint64_t>(n / (slots_per_block * load)) + 1);
+
+        if (num_blocks > 0xffffffffu) {
+            return status_ = Status::InvalidArgument("cuckoo table too large");
+        }
+
+        std::vector<uint32_t> slots;
+        uint32_t seed = 0;
+        while (!Place(static_cast<uint32_t>(num_blocks), slots_per_block, seed, &slots)) {
+            if (++seed == kMaxAttempts) {
+                return status_ = Status::InvalidArgument("can not place the keys of a cuckoo table");
+            }
+            num_blocks += num_blocks / 16 + 1;
+            if (num_blocks > 0xffffffffu) {
+                return status_ = Status::InvalidArgument("cuckoo table too large");
+            }
+        }
+
+        std::string block;
+        for (uint64_t b = 0; b < num_blocks && status_.ok(); b++) {
+            block.assign(slots_per_block * slot_size, '\0');
+            for (uint32_t s = 0; s < slots_per_block; s++) {
+                char *slot = &block[s * slot_size];
+                const uint32_t entry = slots[b * slots_per_block + s];
+                if (entry == kCuckooEmptySlot) {
+                    EncodeFixed32(slot + sizeof(uint32_t), kCuckooEmptySlot);
+                    continue;
+                }
+                const Slice key = KeyAt(entry);
+                const Slice value = ValueAt(entry);
+                EncodeFixed32(slot, static_cast<uint32_t>(key.size()));
+                EncodeFixed32(slot + sizeof(uint32_t), static_cast<uint32_t>(value.size()));
+                std::memcpy(slot + kCuckooSlotHeaderSize, key.data(), key.size());
+                std::memcpy(slot + kCuckooSlotHeaderSize + key.size(), value.data(), value.size());
+            }
+            status_ = file_->Append(block);
+            file_size_ += block.size();
+        }
+
+        std::string footer;
+        PutFixed32(&footer, static_cast<uint32_t>(num_blocks));
+        PutFixed32(&footer, slots_per_block);
+        PutFixed32(&footer, static_cast<uint32_t>(slot_size));
+        PutFixed32(&footer, seed);
+        PutFixed64(&footer, n);
+        PutFixed64(&footer, kCuckooTableMagicNumber);
+        assert(footer.size() == kCuckooTableFooterSize);
+        if (status_.ok()) {
+            status_ = file_->Append(footer);
+            file_size_ += footer.size();
+        }
+        if (status_.ok()) {
+            status_ = file_->Flush();
+        }
+        return status_;
+    }
+
+}
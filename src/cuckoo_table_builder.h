@@ -0,0 +1,92 @@
+#ifndef SSTABLE_CUCKOO_TABLE_BUILDER_H
+#define SSTABLE_CUCKOO_TABLE_BUILDER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../include/env.h"
+#include "../include/options.h"
+#include "../include/slice.h"
+#include "../include/status.h"
+
+namespace leveldb {
+
+    // 布谷鸟哈希表格式：只支持按 key 精确查找，每次最多探测两个位置
+    //
+    // A cuckoo table is an array of fixed-size slots followed by a footer.
+    // A slot is
+    //    fixed32 key_length | fixed32 value_length | key | value | padding
+    // sized for the longest key and value; value_length is
+    // kCuckooEmptySlot in unused slots.  Slots of up to 32 bytes are rounded
+    // up to a power of two and grouped into 64-byte blocks, which do not
+    // straddle cache lines in a mapped file; larger slots are rounded up to
+    // a multiple of 8 bytes and come four to a block.  Each key lives in one of the two blocks its hash picks.  The
+    // footer is
+    //    fixed32 num_blocks | fixed32 slots_per_block | fixed32 slot_size |
+    //    fixed32 hash seed | fixed64 num_entries | fixed64 magic
+    static const uint32_t kCuckooEmptySlot = 0xffffffffu;
+    static const size_t kCuckooSlotHeaderSize = 2 * sizeof(uint32_t);
+    static const size_t kCuckooTableFooterSize = 4 * sizeof(uint32_t) + 8 + 8;
+
+    // Blocks of small slots are this large.  Readers keep the slots at an
+    // address aligned to it, so that such a block is one cache line.
+    static const size_t kCuckooBlockAlignment = 64;
+
+    // The two blocks, out of "num_blocks", that a key hashing to "hash" may
+    // be stored in.  They differ unless there is only one block.
+    void CuckooBlocks(uint64_t hash, uint32_t num_blocks, uint32_t *first, uint32_t *second);
+
+    uint64_t CuckooHash(const Slice &key, uint32_t seed);
+
+    // Builds a cuckoo table from keys added in any order.  Keeps every key
+    // and value in memory until Finish() places them.  Not thread-safe.
+    class CuckooTableBuilder {
+    public:
+        // Does not take ownership of "file".
+        CuckooTableBuilder(const Options &options, WritableFile *file);
+
+        CuckooTableBuilder(const CuckooTableBuilder &) = delete;
+
+        CuckooTableBuilder &operator=(const CuckooTableBuilder &) = delete;
+
+        ~CuckooTableBuilder();
+
+        // REQUIRES: key was not added before; Finish() not called.
+        void Add(const Slice &key, const Slice &value);
+
+        // Places the entries and writes the table.  Fails on duplicate keys.
+        // Does not sync the file.
+        Status Finish();
+
+        Status status() const { return status_; }
+
+        uint64_t NumEntries() const { return offsets_.size(); }
+
+        uint64_t FileSize() const { return file_size_; }
+
+    private:
+        Slice KeyAt(uint32_t i) const;
+
+        Slice ValueAt(uint32_t i) const;
+
+        // Tries to place every entry in num_blocks blocks with the given
+        // hash seed, storing in slots (num_blocks * slots_per_block, entry
+        // index or kCuckooEmptySlot) where each one went.
+        bool Place(uint32_t num_blocks, uint32_t slots_per_block, uint32_t seed,
+                   std::vector<uint32_t> *slots) const;
+
+        WritableFile *const file_;
+        Status status_;
+        bool finished_;
+        uint64_t file_size_;
+        std::string data_;              // Keys and values, back to back.
+        std::vector<uint64_t> offsets_; // Start of each entry's key in data_.
+        std::vector<uint32_t> key_sizes_;
+        size_t max_key_size_;
+        size_t max_value_size_;
+    };
+
+}
+
+#endif //SSTABLE_CUCKOO_TABLE_BUILDER_H
@@ -0,0 +1,183 @@
+#include "cuckoo_table.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "cuckoo_table_builder.h"
+#include "gtest/gtest.h"
+#include "../util/testutil.h"
+
+namespace leveldb {
+
+    namespace {
+
+        std::string Key(int i) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "key%06d", i);
+            return std::string(buf);
+        }
+
+        std::string found_key;
+        std::string found_value;
+
+        void SaveResult(const Slice &k, const Slice &v) {
+            found_key = k.ToString();
+            found_value = v.ToString();
+        }
+
+        // 总是读进 scratch，模拟没有 mmap 的文件
+        class CopyingFile : public RandomAccessFile {
+        public:
+            explicit CopyingFile(RandomAccessFile *target) : target_(target) {}
+
+            ~CopyingFile() override { delete target_; }
+
+            Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override {
+                Status s = target_->Read(offset, n, result, scratch);
+                if (s.ok() && result->data() != scratch) {
+                    std::memcpy(scratch, result->data(), result->size());
+                    *result = Slice(scratch, result->size());
+                }
+                return s;
+            }
+
+        private:
+            RandomAccessFile *const target_;
+        };
+
+    }  // namespace
+
+    // 参数是 value 的最大长度：4 时 slot 不超过 32 字节，一个块一个 cache line；100 时每块 4 个大 slot
+    class CuckooTableTest : public testing::TestWithParam<int> {
+    public:
+        CuckooTableTest() : env_(Env::Default()), file_(nullptr), table_(nullptr) {
+            fname_ = test::TempFileName("cuckoo_table_test.sst");
+        }
+
+        ~CuckooTableTest() override {
+            Close();
+            env_->RemoveFile(fname_);
+        }
+
+        std::string Value(int i) const { return std::string(i % GetParam() + 1, static_cast<char>('a' + i % 26)); }
+
+        // 偶数 key 写进表里，奇数留给不存在的 key
+        void Build(int num_keys) {
+            WritableFile *file;
+            ASSERT_TRUE(env_->NewWritableFile(fname_, &file).ok());
+            {
+                CuckooTableBuilder builder(options_, file);
+                for (int i = num_keys - 2; i >= 0; i -= 2) {
+                    builder.Add(Key(i), Value(i));
+                }
+                ASSERT_TRUE(builder.Finish().ok());
+            }
+            ASSERT_TRUE(file->Close().ok());
+            delete file;
+        }
+
+        Status Open(bool copying) {
+            Close();
+            uint64_t size;
+            EXPECT_TRUE(env_->GetFileSize(fname_, &size).ok());
+            EXPECT_TRUE(env_->NewRandomAccessFile(fname_, &file_).ok());
+            if (copying) {
+                file_ = new CopyingFile(file_);
+            }
+            return CuckooTable::Open(options_, file_, size, &table_);
+        }
+
+        void Close() {
+            delete table_;
+            table_ = nullptr;
+            delete file_;
+            file_ = nullptr;
+        }
+
+        void CorruptByte(uint64_t offset, char c) {
+            std::FILE *f = std::fopen(fname_.c_str(), "r+b");
+            ASSERT_TRUE(f != nullptr);
+            std::fseek(f, static_cast<long>(offset), SEEK_SET);
+            std::fputc(c, f);
+            std::fclose(f);
+        }
+
+        Env *env_;
+        Options options_;
+        std::string fname_;
+        RandomAccessFile *file_;
+        CuckooTable *table_;
+    };
+
+    TEST_P(CuckooTableTest, Lookups) {
+        Build(10000);
+        for (const bool copying: {false, true}) {
+            ASSERT_TRUE(Open(copying).ok());
+            ASSERT_EQ(5000u, table_->NumEntries());
+            for (int i = 0; i < 10100; i++) {
+                found_key.clear();
+                found_value.clear();
+                ASSERT_TRUE(table_->InternalGet(ReadOptions(), Key(i), SaveResult).ok());
+                if (i % 2 == 0 && i < 10000) {
+                    ASSERT_EQ(Key(i), found_key);
+                    ASSERT_EQ(Value(i), found_value);
+                } else {
+                    ASSERT_EQ("", found_key) << Key(i);
+                }
+            }
+        }
+    }
+
+    TEST_P(CuckooTableTest, SingleEntry) {
+        Build(2);
+        ASSERT_TRUE(Open(true).ok());
+        ASSERT_TRUE(table_->InternalGet(ReadOptions(), Key(0), SaveResult).ok());
+        ASSERT_EQ(Value(0), found_value);
+    }
+
+    TEST_P(CuckooTableTest, DuplicateKeys) {
+        WritableFile *file;
+        ASSERT_TRUE(env_->NewWritableFile(fname_, &file).ok());
+        {
+            CuckooTableBuilder builder(options_, file);
+            builder.Add(Key(1), Value(1));
+            builder.Add(Key(2), Value(2));
+            builder.Add(Key(1), Value(3));
+            ASSERT_TRUE(builder.Finish().IsInvalidArgument());
+        }
+        delete file;
+    }
+
+    TEST_P(CuckooTableTest, BadFooter) {
+        Build(100);
+        uint64_t size;
+        ASSERT_TRUE(env_->GetFileSize(fname_, &size).ok());
+
+        // magic number 在文件最后
+        CorruptByte(size - 1, 'X');
+        ASSERT_TRUE(Open(false).IsCorruption());
+        Build(100);
+
+        // num_blocks 在 footer 开头：和文件大小对不上
+        CorruptByte(size - kCuckooTableFooterSize, '\x7f');
+        ASSERT_TRUE(Open(false).IsCorruption());
+
+        RandomAccessFile *file;
+        ASSERT_TRUE(env_->NewRandomAccessFile(fname_, &file).ok());
+        CuckooTable *table;
+        ASSERT_TRUE(CuckooTable::Open(options_, file, kCuckooTableFooterSize - 1, &table).IsCorruption());
+        delete file;
+    }
+
+    // slot 的 key 长度坏了，查到它时报错
+    TEST_P(CuckooTableTest, CorruptSlot) {
+        Build(2);
+        CorruptByte(3, '\x7f');
+        ASSERT_TRUE(Open(true).ok());
+        ASSERT_TRUE(table_->InternalGet(ReadOptions(), Key(0), SaveResult).IsCorruption());
+    }
+
+    INSTANTIATE_TEST_SUITE_P(ValueSizes, CuckooTableTest, testing::Values(4, 100));
+
+}  // namespace leveldb
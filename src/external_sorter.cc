@@ -0,0 +1,392 @@
+#include "external_sorter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <limits>
+
+#include "../include/comparator.h"
+#include "../include/env.h"
+#include "../port/port_stdcxx.h"
+#include "../port/thread_annotations.h"
+#include "../util/coding.h"
+#include "../util/mutexlock.h"
+#include "compaction.h"
+#include "table.h"
+#include "table_builder.h"
+
+namespace leveldb {
+
+    // Temporary run tables are written and read with large sequential I/O.
+    static const size_t kRunFileBufferSize = 1024 * 1024;
+
+    // Options for the temporary run tables.  Runs are read back once, in
+    // order, by the sorter itself, so they carry none of the user's extras
+    // (blob values, filters, perfect hash, range filter, property
+    // collectors, block cache); only what decides the key order, the block
+    // layout and how the files are written and read is kept.
+    static Options RunOptions(const Options &options) {
+        Options run_options;
+        run_options.comparator = options.comparator;
+        run_options.env = options.env;
+        run_options.block_size = options.block_size;
+        run_options.block_restart_interval = options.block_restart_interval;
+        run_options.compression = options.compression;
+        run_options.max_file_size = std::numeric_limits<size_t>::max();
+        run_options.rate_limiter = options.rate_limiter;
+        run_options.use_direct_reads = options.use_direct_reads;
+        run_options.writable_file_buffer_size = std::max(kRunFileBufferSize, options.writable_file_buffer_size);
+        run_options.writable_file_buffers = options.writable_file_buffers;
+        return run_options;
+    }
+
+    namespace {
+
+        // Names temporary run tables "<dir>/sort-<id>-<number>.run".
+        class TempFileFactory : public TableFileFactory {
+        public:
+            // "options" are the run options (see RunOptions()).
+            TempFileFactory(const Options &options, const std::string &dir)
+                    : env_(options.env), env_options_(options), next_number_(1) {
+                char buf[100];
+                std::snprintf(buf, sizeof(buf), "/sort-%llu-%p-",
+                              static_cast<unsigned long long>(env_->NowMicros()), static_cast<void *>(this));
+                prefix_ = dir + buf;
+            }
+
+            Status NewTableFile(std::string *fname, WritableFile **file) override {
+                const uint64_t number = next_number_.fetch_add(1, std::memory_order_relaxed);
+                *fname = prefix_ + std::to_string(number) + ".run";
+                return env_->NewWritableFile(*fname, env_options_, file);
+            }
+
+        private:
+            Env *const env_;
+            std::string prefix_;
+            EnvOptions env_options_;
+            std::atomic<uint64_t> next_number_;
+        };
+
+    }  // namespace
+
+    // A buffer of unsorted records.
+    struct ExternalSorter::Run {
+        explicit Run(uint64_t n) : number(n) {}
+
+        size_t MemoryUsage() const { return data.size() + offsets.size() * sizeof(size_t); }
+
+        const uint64_t number;        // Runs are numbered in the order they were filled.
+        std::string data;             // Length-prefixed keys and values, in arrival order.
+        std::vector<size_t> offsets;  // Start of each record in data.
+    };
+
+    // State shared by the sorter and its sort threads.
+    struct ExternalSorter::Shared {
+        Shared(const Options &opt, const std::string &tmp_dir)
+                : options(RunOptions(opt)),
+                  temp_factory(options, tmp_dir),
+                  cv(&mu),
+                  in_flight(0),
+                  running_threads(0),
+                  shutting_down(false) {}
+
+        const Options options;  // For the run tables.
+        TempFileFactory temp_factory;
+
+        port::Mutex mu;
+        port::CondVar cv GUARDED_BY(mu);
+        std::deque<Run *> queue GUARDED_BY(mu);
+        int in_flight GUARDED_BY(mu);        // Runs queued or being spilled.
+        int running_threads GUARDED_BY(mu);
+        bool shutting_down GUARDED_BY(mu);
+        Status status GUARDED_BY(mu);        // First spill error.
+        // (run number, file name) of every spilled run.
+        std::vector<std::pair<uint64_t, std::string>> spilled GUARDED_BY(mu);
+    };
+
+    static Slice DecodeKey(const std::string &data, size_t offset) {
+        Slice input(data.data() + offset, data.size() - offset);
+        Slice key;
+        GetLengthPrefixedSlice(&input, &key);
+        return key;
+    }
+
+    ExternalSorter::ExternalSorter(const Options &options, const ExternalSortOptions &sort_options,
+                                   TableFileFactory *factory)
+            : options_(options),
+              sort_options_(sort_options),
+              factory_(factory),
+              run_budget_(sort_options.memory_budget / (std::max(sort_options.threads, 1) + 1)),
+              shared_(new Shared(options, sort_options.tmp_dir)),
+              current_(new Run(0)),
+              finished_(false) {
+        const int threads = std::max(sort_options_.threads, 1);
+        MutexLock l(&shared_->mu);
+        shared_->running_threads = threads;
+        for (int i = 0; i < threads; i++) {
+            options_.env->StartThread(&ExternalSorter::SortThread, shared_);
+        }
+    }
+
+    ExternalSorter::~ExternalSorter() {
+        {
+            MutexLock l(&shared_->mu);
+            shared_->shutting_down = true;
+            shared_->cv.SignalAll();
+            while (shared_->running_threads > 0) {
+                shared_->cv.Wait();
+            }
+            for (Run *run: shared_->queue) {
+                delete run;
+            }
+            for (const auto &spilled: shared_->spilled) {
+                options_.env->RemoveFile(spilled.second);
+            }
+        }
+        delete current_;
+        delete shared_;
+    }
+
+    Status ExternalSorter::Add(const Slice &key, const Slice &value) {
+        assert(!finished_);
+        if (stats_.entries == 0) {
+            stats_.spill_micros = options_.env->NowMicros();
+        }
+        current_->offsets.push_back(current_->data.size());
+        PutLengthPrefixedSlice(&current_->data, key);
+        PutLengthPrefixedSlice(&current_->data, value);
+        stats_.entries++;
+        stats_.bytes += key.size() + value.size();
+
+        if (current_->MemoryUsage() >= run_budget_) {
+            SubmitRun();
+            MutexLock l(&shared_->mu);
+            return shared_->status;
+        }
+        return Status::OK();
+    }
+
+    void ExternalSorter::SubmitRun() {
+        Run *run = current_;
+        current_ = new Run(run->number + 1);
+        current_->data.reserve(run->data.capacity());
+        current_->offsets.reserve(run->offsets.capacity());
+        stats_.runs++;
+
+        // Wait for a free thread so that at most threads + 1 runs are in memory.
+        MutexLock l(&shared_->mu);
+        while (shared_->in_flight >= std::max(sort_options_.threads, 1) && shared_->status.ok()) {
+            shared_->cv.Wait();
+        }
+        shared_->queue.push_back(run);
+        shared_->in_flight++;
+        shared_->cv.SignalAll();
+    }
+
+    void ExternalSorter::SortThread(void *arg) {
+        auto *shared = reinterpret_cast<Shared *>(arg);
+        MutexLock l(&shared->mu);
+        while (true) {
+            while (shared->queue.empty() && !shared->shutting_down) {
+                shared->cv.Wait();
+            }
+            if (shared->queue.empty()) {
+                break;
+            }
+            Run *run = shared->queue.front();
+            shared->queue.pop_front();
+
+            std::string fname;
+            Status s;
+            shared->mu.Unlock();
+            s = SpillRun(shared, run, &fname);
+            const uint64_t number = run->number;
+            delete run;
+            shared->mu.Lock();
+
+            if (s.ok()) {
+                shared->spilled.emplace_back(number, fname);
+            } else if (shared->status.ok()) {
+                shared->status = s;
+            }
+            shared->in_flight--;
+            shared->cv.SignalAll();
+        }
+        shared->running_threads--;
+        shared->cv.SignalAll();
+    }
+
+    Status ExternalSorter::SpillRun(Shared *shared, Run *run, std::string *fname) {
+        const Comparator *cmp = shared->options.comparator;
+        const std::string &data = run->data;
+
+        // 按 key 排序；相同 key 后写入的排在前面，只保留它
+        std::sort(run->offsets.begin(), run->offsets.end(), [&](size_t a, size_t b) {
+            const int r = cmp->Compare(DecodeKey(data, a), DecodeKey(data, b));
+            return r < 0 || (r == 0 && a > b);
+        });
+
+        WritableFile *file;
+        Status s = shared->temp_factory.NewTableFile(fname, &file);
+        if (!s.ok()) {
+            return s;
+        }
+        TableBuilder builder(shared->options, file);
+        Slice last_key;
+        bool has_last_key = false;
+        for (size_t offset: run->offsets) {
+            Slice input(data.data() + offset, data.size() - offset);
+            Slice key, value;
+            GetLengthPrefixedSlice(&input, &key);
+            GetLengthPrefixedSlice(&input, &value);
+            if (has_last_key && cmp->Compare(key, last_key) == 0) {
+                continue;  // Overwritten later in this run.
+            }
+            builder.Add(key, value);
+            last_key = key;
+            has_last_key = true;
+        }
+        s = builder.Finish();
+        Status close_status = file->Close();
+        if (s.ok()) {
+            s = close_status;
+        }
+        delete file;
+        return s;
+    }
+
+    // Opens the tables in "fnames", appending them to *tables and their files to *files.
+    static Status OpenTables(const Options &options, const std::vector<std::string> &fnames,
+                             std::vector<Table *> *tables, std::vector<RandomAccessFile *> *files) {
+        for (const std::string &fname: fnames) {
+            uint64_t size;
+            Status s = options.env->GetFileSize(fname, &size);
+            RandomAccessFile *file = nullptr;
+            if (s.ok()) {
+                s = options.env->NewRandomAccessFile(fname, EnvOptions(options), &file);
+            }
+            Table *table = nullptr;
+            if (s.ok()) {
+                s = Table::Open(options, file, size, &table);
+            }
+            if (!s.ok()) {
+                delete file;
+                return s;
+            }
+            tables->push_back(table);
+            files->push_back(file);
+        }
+        return Status::OK();
+    }
+
+    static void CloseTables(std::vector<Table *> *tables, std::vector<RandomAccessFile *> *files) {
+        for (Table *table: *tables) {
+            delete table;
+        }
+        for (RandomAccessFile *file: *files) {
+            delete file;
+        }
+        tables->clear();
+        files->clear();
+    }
+
+    Status ExternalSorter::MergeRuns(std::vector<std::string> *runs, std::vector<TableFileMeta> *outputs) {
+        Env *env = options_.env;
+        const size_t width = std::max(sort_options_.max_merge_width, 2);
+        std::vector<Table *> tables;
+        std::vector<RandomAccessFile *> files;
+        Status s;
+
+        // Intermediate passes: merge groups of adjacent runs (so that newer
+        // runs stay ahead of older ones) into one run each.
+        const Options &run_options = shared_->options;
+        while (s.ok() && runs->size() > width) {
+            std::vector<std::string> merged;
+            for (size_t start = 0; s.ok() && start < runs->size(); start += width) {
+                const size_t end = std::min(start + width, runs->size());
+                std::vector<std::string> group(runs->begin() + start, runs->begin() + end);
+                if (group.size() == 1) {
+                    merged.push_back(group[0]);
+                    continue;
+                }
+                std::vector<TableFileMeta> out;
+                s = OpenTables(run_options, group, &tables, &files);
+                if (s.ok()) {
+                    s = CompactTables(run_options, tables, nullptr, nullptr, 1, &shared_->temp_factory, &out);
+                }
+                CloseTables(&tables, &files);
+                for (const TableFileMeta &meta: out) {
+                    merged.push_back(meta.fname);
+                }
+                if (s.ok()) {
+                    for (const std::string &fname: group) {
+                        env->RemoveFile(fname);
+                    }
+                } else {
+                    // Keep the group; the files produced so far are removed below.
+                    for (const TableFileMeta &meta: out) {
+                        env->RemoveFile(meta.fname);
+                    }
+                    merged.resize(merged.size() - out.size());
+                    merged.insert(merged.end(), group.begin(), group.end());
+                }
+            }
+            runs->swap(merged);
+            stats_.merge_passes++;
+        }
+
+        if (s.ok()) {
+            s = OpenTables(run_options, *runs, &tables, &files);
+        }
+        if (s.ok()) {
+            s = CompactTables(options_, tables, nullptr, nullptr, std::max(sort_options_.threads, 1), factory_,
+                              outputs);
+            stats_.merge_passes++;
+        }
+        CloseTables(&tables, &files);
+        return s;
+    }
+
+    Status ExternalSorter::Finish(std::vector<TableFileMeta> *outputs) {
+        assert(!finished_);
+        finished_ = true;
+        if (!current_->offsets.empty()) {
+            SubmitRun();
+        }
+
+        std::vector<std::pair<uint64_t, std::string>> spilled;
+        Status s;
+        {
+            MutexLock l(&shared_->mu);
+            while (shared_->in_flight > 0) {
+                shared_->cv.Wait();
+            }
+            s = shared_->status;
+            spilled.swap(shared_->spilled);
+        }
+        stats_.spill_micros = (stats_.entries > 0) ? options_.env->NowMicros() - stats_.spill_micros : 0;
+
+        // Newest run first, so that the merge keeps the last value of a key.
+        std::sort(spilled.begin(), spilled.end(),
+                  [](const std::pair<uint64_t, std::string> &a, const std::pair<uint64_t, std::string> &b) {
+                      return a.first > b.first;
+                  });
+        std::vector<std::string> runs;
+        for (const auto &run: spilled) {
+            runs.push_back(run.second);
+        }
+
+        const uint64_t start_micros = options_.env->NowMicros();
+        if (s.ok() && !runs.empty()) {
+            s = MergeRuns(&runs, outputs);
+        }
+        stats_.merge_micros = options_.env->NowMicros() - start_micros;
+
+        for (const std::string &fname: runs) {
+            options_.env->RemoveFile(fname);
+        }
+        return s;
+    }
+
+}
@@ -0,0 +1,104 @@
+#ifndef SSTABLE_EXTERNAL_SORTER_H
+#define SSTABLE_EXTERNAL_SORTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../include/options.h"
+#include "../include/slice.h"
+#include "../include/status.h"
+#include "multi_table_builder.h"
+
+namespace leveldb {
+
+    // Options for an ExternalSorter.
+    struct ExternalSortOptions {
+        // Memory used to buffer unsorted records, shared by the run being
+        // filled and the runs being sorted.
+        size_t memory_budget = 256 * 1024 * 1024;
+
+        // Number of threads sorting and spilling runs, and the number of
+        // subcompactions used by the final merge.
+        int threads = 4;
+
+        // Directory for the temporary run tables.  Must exist.
+        std::string tmp_dir = "/tmp";
+
+        // Maximum number of runs merged at once.  With more runs than this,
+        // intermediate merge passes combine them first, so that the final
+        // merge keeps few files open and reads each with large sequential I/O.
+        int max_merge_width = 64;
+    };
+
+    // 外部排序：乱序输入，分段排序落盘，再多路归并成最终的 SSTable
+    // Turns an unsorted stream of key/value pairs into sorted, non-overlapping
+    // tables using bounded memory.
+    //
+    // Add() copies records into a run buffer.  A full buffer is handed to a
+    // pool of threads that sort it and spill it as a temporary table while
+    // Add() fills the next one.  Finish() merges the runs (in several passes
+    // if there are more than max_merge_width) into the final tables, which are
+    // cut at options.max_file_size and created through "factory".
+    //
+    // When a key is added several times, the last value wins.
+    //
+    // Not thread-safe: Add() and Finish() must be called from one thread.
+    class ExternalSorter {
+    public:
+        struct Stats {
+            uint64_t entries = 0;       // Records passed to Add().
+            uint64_t bytes = 0;         // Key and value bytes passed to Add().
+            int runs = 0;               // Sorted runs spilled.
+            int merge_passes = 0;       // Including the final merge.
+            uint64_t spill_micros = 0;  // From the first Add() until every run is spilled.
+            uint64_t merge_micros = 0;  // Time spent merging in Finish().
+        };
+
+        // "factory" must outlive the sorter.
+        ExternalSorter(const Options &options, const ExternalSortOptions &sort_options, TableFileFactory *factory);
+
+        ExternalSorter(const ExternalSorter &) = delete;
+
+        ExternalSorter &operator=(const ExternalSorter &) = delete;
+
+        // Stops the sort threads and removes temporary files.
+        ~ExternalSorter();
+
+        // Returns the first error of a sort thread, if any.
+        // REQUIRES: Finish() has not been called.
+        Status Add(const Slice &key, const Slice &value);
+
+        // Merges everything added so far into the final tables and stores
+        // their descriptions, in key order, in *outputs.
+        // REQUIRES: Finish() has not been called.
+        Status Finish(std::vector<TableFileMeta> *outputs);
+
+        const Stats &stats() const { return stats_; }
+
+    private:
+        struct Run;
+        struct Shared;
+
+        static void SortThread(void *arg);
+
+        static Status SpillRun(Shared *shared, Run *run, std::string *fname);
+
+        void SubmitRun();
+
+        Status MergeRuns(std::vector<std::string> *runs, std::vector<TableFileMeta> *outputs);
+
+        const Options options_;
+        const ExternalSortOptions sort_options_;
+        TableFileFactory *const factory_;
+        const size_t run_budget_;  // Memory for one run.
+
+        Shared *shared_;
+        Run *current_;  // The run Add() is filling.
+        bool finished_;
+        Stats stats_;
+    };
+
+}
+
+#endif //SSTABLE_EXTERNAL_SORTER_H
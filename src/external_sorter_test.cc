@@ -0,0 +1,171 @@
+#include "external_sorter.h"
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../include/block_property.h"
+#include "../include/env.h"
+#include "../include/filter_policy.h"
+#include "../util/random.h"
+#include "../util/testutil.h"
+
+namespace leveldb {
+
+    namespace {
+
+        std::string Key(int i) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "key%06d", i);
+            return std::string(buf);
+        }
+
+        // 数一数建了几张表、收集了多少条记录
+        class CountingCollectorFactory : public BlockPropertyCollectorFactory {
+        public:
+            class Collector : public BlockPropertyCollector {
+            public:
+                explicit Collector(std::atomic<int> *entries) : entries_(entries) {}
+
+                void Add(const Slice &, const Slice &) override { entries_->fetch_add(1); }
+
+                void FinishBlock(std::string *) override {}
+
+            private:
+                std::atomic<int> *const entries_;
+            };
+
+            const char *Name() const override { return "test.counting"; }
+
+            BlockPropertyCollector *NewCollector() const override {
+                tables.fetch_add(1);
+                return new Collector(&entries);
+            }
+
+            mutable std::atomic<int> tables{0};
+            mutable std::atomic<int> entries{0};
+        };
+
+    }  // namespace
+
+    class ExternalSorterTest : public testing::Test {
+    public:
+        ExternalSorterTest() {
+            options_.block_size = 1024;
+            options_.max_file_size = 256 * 1024;
+            output_dir_ = test::TempFileName("external_sorter_out");
+            tmp_dir_ = test::TempFileName("external_sorter_tmp");
+            options_.env->CreateDir(output_dir_);
+            options_.env->CreateDir(tmp_dir_);
+            sort_options_.tmp_dir = tmp_dir_;
+            sort_options_.memory_budget = 256 * 1024;
+            sort_options_.threads = 3;
+            factory_.reset(NewTableFileFactory(options_.env, output_dir_, 1));
+        }
+
+        ~ExternalSorterTest() override {
+            for (const std::string &dir: {output_dir_, tmp_dir_}) {
+                for (const std::string &child: Children(dir)) {
+                    options_.env->RemoveFile(dir + "/" + child);
+                }
+                options_.env->RemoveDir(dir);
+            }
+        }
+
+        std::vector<std::string> Children(const std::string &dir) const {
+            std::vector<std::string> children;
+            options_.env->GetChildren(dir, &children);
+            std::vector<std::string> files;
+            for (const std::string &child: children) {
+                if (child != "." && child != "..") {
+                    files.push_back(child);
+                }
+            }
+            return files;
+        }
+
+        // 乱序写入 n 条（key 有重复），排好序后和 model 对比
+        void SortAndCheck(int n, std::vector<TableFileMeta> *outputs) {
+            std::map<std::string, std::string> model;
+            Random rnd(301);
+            ExternalSorter sorter(options_, sort_options_, factory_.get());
+            for (int i = 0; i < n; i++) {
+                const std::string key = Key(rnd.Uniform(n));
+                const std::string value = std::to_string(i) + std::string(rnd.Uniform(100), 'v');
+                ASSERT_TRUE(sorter.Add(key, value).ok());
+                model[key] = value;
+            }
+            ASSERT_TRUE(sorter.Finish(outputs).ok());
+            ASSERT_EQ(static_cast<uint64_t>(n), sorter.stats().entries);
+            ASSERT_GT(sorter.stats().runs, 1);
+
+            auto it = model.begin();
+            for (size_t f = 0; f < outputs->size(); f++) {
+                const TableFileMeta &meta = (*outputs)[f];
+                test::KVList entries;
+                ASSERT_TRUE(test::ReadTableFile(options_, meta.fname, &entries).ok());
+                ASSERT_EQ(meta.num_entries, entries.size());
+                for (const auto &entry: entries) {
+                    ASSERT_TRUE(it != model.end());
+                    ASSERT_EQ(it->first, entry.first);
+                    ASSERT_EQ(it->second, entry.second);
+                    ++it;
+                }
+            }
+            ASSERT_TRUE(it == model.end());
+            // 临时的 run 文件都删掉了
+            ASSERT_TRUE(Children(tmp_dir_).empty());
+        }
+
+        Options options_;
+        ExternalSortOptions sort_options_;
+        std::string output_dir_;
+        std::string tmp_dir_;
+        std::unique_ptr<TableFileFactory> factory_;
+    };
+
+    TEST_F(ExternalSorterTest, SingleMergePass) {
+        std::vector<TableFileMeta> outputs;
+        SortAndCheck(20000, &outputs);
+        ASSERT_GT(outputs.size(), 1u);
+    }
+
+    TEST_F(ExternalSorterTest, IntermediateMergePasses) {
+        sort_options_.max_merge_width = 2;
+        std::vector<TableFileMeta> outputs;
+        SortAndCheck(20000, &outputs);
+    }
+
+    TEST_F(ExternalSorterTest, Empty) {
+        ExternalSorter sorter(options_, sort_options_, factory_.get());
+        std::vector<TableFileMeta> outputs;
+        ASSERT_TRUE(sorter.Finish(&outputs).ok());
+        ASSERT_TRUE(outputs.empty());
+        ASSERT_EQ(0, sorter.stats().runs);
+    }
+
+    // 用户的 filter、perfect hash、属性收集器只用于最终输出，run 表用的是最朴素的 Options
+    TEST_F(ExternalSorterTest, RunsUsePlainOptions) {
+        CountingCollectorFactory collectors;
+        std::unique_ptr<const FilterPolicy> filter(NewBloomFilterPolicy(10));
+        options_.block_property_collectors.push_back(&collectors);
+        options_.filter_policy = filter.get();
+        options_.perfect_hash_index = true;
+        options_.range_filter = true;
+        sort_options_.max_merge_width = 2;
+
+        std::vector<TableFileMeta> outputs;
+        SortAndCheck(20000, &outputs);
+        uint64_t entries = 0;
+        for (const TableFileMeta &meta: outputs) {
+            entries += meta.num_entries;
+        }
+        ASSERT_EQ(static_cast<int>(outputs.size()), collectors.tables.load());
+        ASSERT_EQ(static_cast<int>(entries), collectors.entries.load());
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,82 @@
+// Copyright (c) 2012 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A filter block is stored near the end of a Table file.  It contains
+// filters (e.g., bloom filters) for all data blocks in the table combined
+// into a single filter block.
+
+#ifndef SSTABLE_FILTER_BLOCK_H
+#define SSTABLE_FILTER_BLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../include/slice.h"
+
+namespace leveldb {
+
+    class FilterPolicy;
+
+    // A FilterBlockBuilder is used to construct all of the filters for a
+    // particular Table.  It generates a single string which is stored as
+    // a special block in the Table.
+    //
+    // The sequence of calls to FilterBlockBuilder must match the regexp:
+    //      (StartBlock AddKey*)* Finish
+    class FilterBlockBuilder {
+    public:
+        // With "whole_table", a single filter covers every key and is built
+        // by Finish().
+        FilterBlockBuilder(const FilterPolicy *, bool whole_table = false);
+
+        FilterBlockBuilder(const FilterBlockBuilder &) = delete;
+
+        FilterBlockBuilder &operator=(const FilterBlockBuilder &) = delete;
+
+        void StartBlock(uint64_t block_offset);
+
+        void AddKey(const Slice &key);
+
+        Slice Finish();
+
+    private:
+        void GenerateFilter();
+
+        const FilterPolicy *policy_;
+        const size_t base_lg_;
+        std::string keys_;             // Flattened key contents
+        std::vector<size_t> start_;    // Starting index in keys_ of each key
+        std::string result_;           // Filter data computed so far
+        std::vector<Slice> tmp_keys_;  // policy_->CreateFilter() argument
+        std::vector<uint32_t> filter_offsets_;
+    };
+
+    class FilterBlockReader {
+    public:
+        // REQUIRES: "contents" and *policy must stay live while *this is live.
+        FilterBlockReader(const FilterPolicy *policy, const Slice &contents);
+
+        bool KeyMayMatch(uint64_t block_offset, const Slice &key) const;
+
+        // Sets results[i] to KeyMayMatch(block_offsets[i], keys[i]) for every
+        // i in [0, n), probing through FilterPolicy::KeysMayMatch().
+        void KeysMayMatch(int n, const uint64_t *block_offsets, const Slice *keys, bool *results) const;
+
+    private:
+        // The filter for "block_offset": true with *filter set if there is
+        // one, false with *result set if the answer does not need a probe.
+        bool GetFilter(uint64_t block_offset, Slice *filter, bool *result) const;
+
+        const FilterPolicy *policy_;
+        const char *data_;    // Pointer to filter data (at block-start)
+        const char *offset_;  // Pointer to beginning of offset array (at block-end)
+        size_t num_;          // Number of entries in offset array
+        size_t base_lg_;      // Encoding parameter (see kFilterBaseLg in .cc file)
+    };
+
+}
+
+#endif //SSTABLE_FILTER_BLOCK_H
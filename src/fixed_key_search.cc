@@ -0,0 +1,192 @@
+#include "fixed_key_search.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SSTABLE_HAVE_AVX2_SEARCH 1
+#else
+#define SSTABLE_HAVE_AVX2_SEARCH 0
+#endif
+
+namespace leveldb {
+
+    namespace {
+
+        // The binary search stops once this few keys are left; they are then
+        // counted in one pass (2 or 4 cache lines of 8- or 16-byte keys).
+        const uint32_t kLinearWindow = 16;
+
+        // 按大端解码，数值顺序即字节序；编译器会生成一条 bswap
+        inline uint64_t DecodeBigEndian64(const char *p) {
+            const auto *b = reinterpret_cast<const uint8_t *>(p);
+            return (static_cast<uint64_t>(b[0]) << 56) | (static_cast<uint64_t>(b[1]) << 48) |
+                   (static_cast<uint64_t>(b[2]) << 40) | (static_cast<uint64_t>(b[3]) << 32) |
+                   (static_cast<uint64_t>(b[4]) << 24) | (static_cast<uint64_t>(b[5]) << 16) |
+                   (static_cast<uint64_t>(b[6]) << 8) | static_cast<uint64_t>(b[7]);
+        }
+
+        struct Key8 {
+            static const size_t kSize = 8;
+
+            explicit Key8(const char *target) : t(DecodeBigEndian64(target)) {}
+
+            bool LessAt(const char *keys, uint32_t i) const {
+                return DecodeBigEndian64(keys + i * kSize) < t;
+            }
+
+            const uint64_t t;
+        };
+
+        struct Key16 {
+            static const size_t kSize = 16;
+
+            explicit Key16(const char *target)
+                    : hi(DecodeBigEndian64(target)), lo(DecodeBigEndian64(target + 8)) {}
+
+            bool LessAt(const char *keys, uint32_t i) const {
+                const uint64_t k_hi = DecodeBigEndian64(keys + i * kSize);
+                const uint64_t k_lo = DecodeBigEndian64(keys + i * kSize + 8);
+                return k_hi < hi || (k_hi == hi && k_lo < lo);
+            }
+
+            const uint64_t hi;
+            const uint64_t lo;
+        };
+
+        // Narrows [0, n] to [*first, *first + *len] holding the lower bound.
+        template<typename Key>
+        inline void BinarySearch(const char *keys, uint32_t n, const Key &key, uint32_t *first, uint32_t *len) {
+            uint32_t base = 0;
+            uint32_t count = n;
+            while (count > kLinearWindow) {
+                const uint32_t half = count / 2;
+                // 无分支：编译成 cmov，避免分支预测失败
+                base = key.LessAt(keys, base + half) ? base + half : base;
+                count -= half;
+            }
+            *first = base;
+            *len = count;
+        }
+
+        template<typename Key>
+        inline uint32_t CountLessScalar(const char *keys, uint32_t first, uint32_t len, const Key &key) {
+            uint32_t less = 0;
+            for (uint32_t i = first; i < first + len; i++) {
+                less += key.LessAt(keys, i) ? 1 : 0;
+            }
+            return less;
+        }
+
+#if SSTABLE_HAVE_AVX2_SEARCH
+        bool CpuHasAvx2() {
+            static const bool has_avx2 = __builtin_cpu_supports("avx2");
+            return has_avx2;
+        }
+
+        // Reverses the bytes of each 64-bit lane, turning big-endian keys
+        // into integers.
+        __attribute__((target("avx2")))
+        inline __m256i ByteSwap64(__m256i v) {
+            const __m256i shuffle = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                                     7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+            return _mm256_shuffle_epi8(v, shuffle);
+        }
+
+        // AVX2 只有有符号 64 位比较，翻转符号位后等价于无符号比较
+        __attribute__((target("avx2")))
+        uint32_t CountLess8Avx2(const char *keys, uint32_t first, uint32_t len, const Key8 &key) {
+            const __m256i sign = _mm256_set1_epi64x(static_cast<long long>(1ull << 63));
+            const __m256i t = _mm256_set1_epi64x(static_cast<long long>(key.t ^ (1ull << 63)));
+            uint32_t less = 0;
+            uint32_t i = first;
+            for (; i + 4 <= first + len; i += 4) {
+                __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i * 8));
+                k = _mm256_xor_si256(ByteSwap64(k), sign);
+                const __m256i lt = _mm256_cmpgt_epi64(t, k);
+                less += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(lt)));
+            }
+            return less + CountLessScalar(keys, i, first + len - i, key);
+        }
+
+        // Two 16-byte keys per register, as (hi, lo) lane pairs.  A key is
+        // less than the target if its hi lane is, or its hi lane is equal and
+        // its lo lane is less.
+        __attribute__((target("avx2")))
+        uint32_t CountLess16Avx2(const char *keys, uint32_t first, uint32_t len, const Key16 &key) {
+            const __m256i sign = _mm256_set1_epi64x(static_cast<long long>(1ull << 63));
+            const __m256i t = _mm256_setr_epi64x(static_cast<long long>(key.hi ^ (1ull << 63)),
+                                                 static_cast<long long>(key.lo ^ (1ull << 63)),
+                                                 static_cast<long long>(key.hi ^ (1ull << 63)),
+                                                 static_cast<long long>(key.lo ^ (1ull << 63)));
+            uint32_t less = 0;
+            uint32_t i = first;
+            for (; i + 2 <= first + len; i += 2) {
+                __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i * 16));
+                k = _mm256_xor_si256(ByteSwap64(k), sign);
+                const int gt = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(t, k)));
+                const int eq = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(t, k)));
+                // bit 0/2: hi lanes of the two keys, bit 1/3: lo lanes
+                less += __builtin_popcount((gt | (eq & (gt >> 1))) & 0x5);
+            }
+            return less + CountLessScalar(keys, i, first + len - i, key);
+        }
+#endif
+
+        template<typename Key>
+        uint32_t LowerBound(const char *keys, uint32_t n, const char *target) {
+            const Key key(target);
+            uint32_t first, len;
+            BinarySearch(keys, n, key, &first, &len);
+            return first + CountLessScalar(keys, first, len, key);
+        }
+
+#if SSTABLE_HAVE_AVX2_SEARCH
+        template<>
+        uint32_t LowerBound<Key8>(const char *keys, uint32_t n, const char *target) {
+            const Key8 key(target);
+            uint32_t first, len;
+            BinarySearch(keys, n, key, &first, &len);
+            if (CpuHasAvx2()) {
+                return first + CountLess8Avx2(keys, first, len, key);
+            }
+            return first + CountLessScalar(keys, first, len, key);
+        }
+
+        template<>
+        uint32_t LowerBound<Key16>(const char *keys, uint32_t n, const char *target) {
+            const Key16 key(target);
+            uint32_t first, len;
+            BinarySearch(keys, n, key, &first, &len);
+            if (CpuHasAvx2()) {
+                return first + CountLess16Avx2(keys, first, len, key);
+            }
+            return first + CountLessScalar(keys, first, len, key);
+        }
+#endif
+
+    }  // namespace
+
+    uint32_t FixedKeyLowerBound(const char *keys, uint32_t n, size_t key_size, const char *target) {
+        switch (key_size) {
+            case 8:
+                return LowerBound<Key8>(keys, n, target);
+            case 16:
+                return LowerBound<Key16>(keys, n, target);
+            default: {
+                uint32_t left = 0;
+                uint32_t right = n;
+                while (left < right) {
+                    const uint32_t mid = left + (right - left) / 2;
+                    if (std::memcmp(keys + mid * key_size, target, key_size) < 0) {
+                        left = mid + 1;
+                    } else {
+                        right = mid;
+                    }
+                }
+                return left;
+            }
+        }
+    }
+
+}
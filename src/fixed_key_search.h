@@ -0,0 +1,22 @@
+#ifndef SSTABLE_FIXED_KEY_SEARCH_H
+#define SSTABLE_FIXED_KEY_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace leveldb {
+
+    // 定长 key 数组的二分 + SIMD 查找
+    // Returns the index of the first of the "n" sorted, packed "key_size"-byte
+    // keys at "keys" that is not less than the "key_size"-byte "target", in
+    // bytewise order, or n if there is none.
+    //
+    // 8- and 16-byte keys are compared as big-endian integers: a branchless
+    // binary search narrows the range to a few cache lines, which are then
+    // counted with AVX2 compares when the CPU has them.  Other sizes use
+    // memcmp.
+    uint32_t FixedKeyLowerBound(const char *keys, uint32_t n, size_t key_size, const char *target);
+
+}
+
+#endif //SSTABLE_FIXED_KEY_SEARCH_H
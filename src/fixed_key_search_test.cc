@@ -0,0 +1,86 @@
+#include "fixed_key_search.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../util/random.h"
+
+namespace leveldb {
+
+    namespace {
+
+        // 随机字节的 key，包括 0x00 和 0xff，检查按无符号字节序比较
+        std::string RandomKey(Random *rnd, size_t key_size) {
+            std::string key(key_size, '\0');
+            for (size_t i = 0; i < key_size; i++) {
+                key[i] = static_cast<char>(rnd->OneIn(4) ? (rnd->OneIn(2) ? 0x00 : 0xff) : rnd->Uniform(256));
+            }
+            return key;
+        }
+
+        uint32_t ModelLowerBound(const std::vector<std::string> &keys, const std::string &target) {
+            return static_cast<uint32_t>(std::lower_bound(keys.begin(), keys.end(), target) - keys.begin());
+        }
+
+    }  // namespace
+
+    class FixedKeySearchTest : public testing::TestWithParam<size_t> {
+    };
+
+    TEST_P(FixedKeySearchTest, MatchesLowerBound) {
+        const size_t key_size = GetParam();
+        Random rnd(301 + static_cast<uint32_t>(key_size));
+        for (const uint32_t n: {0u, 1u, 2u, 3u, 7u, 8u, 9u, 31u, 64u, 100u, 1000u, 4097u}) {
+            std::vector<std::string> keys;
+            for (uint32_t i = 0; i < n; i++) {
+                keys.push_back(RandomKey(&rnd, key_size));
+            }
+            std::sort(keys.begin(), keys.end());
+            std::string packed;
+            for (const std::string &key: keys) {
+                packed += key;
+            }
+
+            for (int round = 0; round < 200; round++) {
+                // 一半查存在的 key，一半查随机 key
+                const std::string target = (n > 0 && rnd.OneIn(2)) ? keys[rnd.Uniform(n)] : RandomKey(&rnd, key_size);
+                ASSERT_EQ(ModelLowerBound(keys, target),
+                          FixedKeyLowerBound(packed.data(), n, key_size, target.data()))
+                                            << "n=" << n << " round=" << round;
+            }
+            if (n > 0) {
+                const std::string smallest(key_size, '\0');
+                const std::string largest(key_size, '\xff');
+                ASSERT_EQ(ModelLowerBound(keys, smallest),
+                          FixedKeyLowerBound(packed.data(), n, key_size, smallest.data()));
+                ASSERT_EQ(ModelLowerBound(keys, largest),
+                          FixedKeyLowerBound(packed.data(), n, key_size, largest.data()));
+            }
+        }
+    }
+
+    // 大量重复的 key：要返回第一个
+    TEST_P(FixedKeySearchTest, Duplicates) {
+        const size_t key_size = GetParam();
+        std::vector<std::string> keys;
+        for (int i = 0; i < 300; i++) {
+            keys.push_back(std::string(key_size, static_cast<char>('a' + i / 100)));
+        }
+        std::string packed;
+        for (const std::string &key: keys) {
+            packed += key;
+        }
+        for (const char c: {'a', 'b', 'c', 'd', '0'}) {
+            const std::string target(key_size, c);
+            ASSERT_EQ(ModelLowerBound(keys, target),
+                      FixedKeyLowerBound(packed.data(), 300, key_size, target.data()));
+        }
+    }
+
+    // 8、16 字节走整数比较和 SIMD，其它长度走 memcmp
+    INSTANTIATE_TEST_SUITE_P(KeySizes, FixedKeySearchTest, testing::Values(1, 5, 8, 12, 16, 24));
+
+}  // namespace leveldb
@@ -1,5 +1,8 @@
 #include "format.h"
 
+#include <cstdlib>
+#include <cstring>
+
 namespace leveldb {
 
     void BlockHandle::EncodeTo(std::string *dst) const {
@@ -26,28 +29,41 @@ namespace leveldb {
         }
     }
 
-    // index_handle + padding
+    // [metaindex_handle] + index_handle + padding
     // magic number
     void Footer::EncodeTo(std::string *dst) const {
         const size_t original_size = dst->size();
+        const size_t length = has_metaindex_ ? kMetaEncodedLength : kEncodedLength;
 
+        if (has_metaindex_) {
+            metaindex_handle_.EncodeTo(dst);
+        }
         index_handle_.EncodeTo(dst); // add index_handle to dst 2*8 = 16
-        dst->resize(BlockHandle::kMaxEncodedLength); // padding  16+4 = 20
+        dst->resize(original_size + length - 8); // padding  16+4 = 20
 
         // @todo 为什么不直接调用PutFixed64接口进行持久化？
-        PutFixed32(dst, static_cast<uint32_t>(kTableMagicNumber & 0xffffffffu));
-        PutFixed32(dst, static_cast<uint32_t>(kTableMagicNumber >> 32));
+        uint64_t magic;
+        if (has_metaindex_) {
+            magic = has_blob_values_ ? kMetaBlobTableMagicNumber : kMetaTableMagicNumber;
+        } else {
+            magic = has_blob_values_ ? kBlobTableMagicNumber : kTableMagicNumber;
+        }
+        PutFixed32(dst, static_cast<uint32_t>(magic & 0xffffffffu));
+        PutFixed32(dst, static_cast<uint32_t>(magic >> 32));
         // PutFixed64(dst, kTableMagicNumber);
-        // kEncodedLength 28 字节
-        assert(original_size + kEncodedLength == dst->size());
+        // kEncodedLength 28 字节, kMetaEncodedLength 48 字节
+        assert(original_size + length == dst->size());
         (void) original_size;
     }
 
-    // index_handle + padding
+    // [metaindex_handle] + index_handle + padding
     // magic number
     Status Footer::DecodeFrom(Slice *input) {
+        if (input->size() < kEncodedLength) {
+            return Status::Corruption("file is too short to be an sstable");
+        }
         // 获得最后 8 字节的魔数
-        const char *magic_ptr = (input->data() + kEncodedLength) - 8;
+        const char *magic_ptr = input->data() + input->size() - 8;
 
         // 将字符数组中的 字节 转为 低4字节 高4字节
         const uint32_t magic_lo = DecodeFixed32(magic_ptr);
@@ -55,13 +71,29 @@ namespace leveldb {
         const uint64_t magic = ((static_cast<uint64_t>(magic_hi) << 32) | (static_cast<uint64_t>(magic_lo)));
         // const uint64_t magic = DecodeFixed64(magic_ptr);// 为啥不用这个呢？
 
-        if (magic != kTableMagicNumber) {
+        if (magic == kTableMagicNumber || magic == kBlobTableMagicNumber) {
+            has_metaindex_ = false;
+        } else if (magic == kMetaTableMagicNumber || magic == kMetaBlobTableMagicNumber) {
+            has_metaindex_ = true;
+        } else {
             return Status::Corruption("not an sstable (bad magic number)");
         }
+        has_blob_values_ = (magic == kBlobTableMagicNumber || magic == kMetaBlobTableMagicNumber);
 
+        const size_t length = has_metaindex_ ? kMetaEncodedLength : kEncodedLength;
+        if (input->size() < length) {
+            return Status::Corruption("file is too short to be an sstable");
+        }
+        Slice handles(magic_ptr + 8 - length, length - 8);
+        Status status;
+        if (has_metaindex_) {
+            status = metaindex_handle_.DecodeFrom(&handles);
+        }
         // 字符数组 解码 为 64位数值
         // 从 input头开始 解析出 index block offset |   index block size
-        Status status = index_handle_.DecodeFrom(input);
+        if (status.ok()) {
+            status = index_handle_.DecodeFrom(&handles);
+        }
 
         // todo 为什么还要对input进行这样的处理呢？
         if (status.ok()) {
@@ -71,34 +103,19 @@ namespace leveldb {
         return status;
     }
 
-    Status
-    ReadBlock(RandomAccessFile *file, const ReadOptions &options, const BlockHandle &handle, BlockContents *result) {
+    // 直接 I/O 的文件要求 offset、长度、缓冲区都对齐
+    Status DecodeBlockContents(const ReadOptions &options, const Slice &raw, BlockContents *result) {
         result->data = Slice();
         result->cachable = false;
         result->heap_allocated = false;
 
-        // 准备好保存block的空间: data + restarts_
-        auto n = static_cast<size_t>(handle.size());
-        //  1Byte的type加上4Byte的CRC校验值
-        char *buf = new char[n + kBlockTrailerSize];
-
-        Slice contents;
-        // 根据 BlockHandle 从 文件偏移量 index block offset 处 读取数据到 buf
-        // 如果底层用mmap，会把磁盘中的数据映射到content中
-        Status s = file->Read(handle.offset(), n + kBlockTrailerSize, &contents, buf);
-
-        if (!s.ok()) {
-            delete[] buf;
-            return s;
-        }
-
-        if (contents.size() != n + kBlockTrailerSize) {
-            delete[] buf;
+        if (raw.size() < kBlockTrailerSize) {
             return Status::Corruption("truncated block read");
         }
+        const size_t n = raw.size() - kBlockTrailerSize;
 
         // crc 校验
-        const char *data = contents.data();
+        const char *data = raw.data();
         // 打开了校验
         if (options.verify_checksums) {
             // 读取出crc值，data后面就是type和crc值 4B
@@ -107,60 +124,152 @@ namespace leveldb {
             const uint32_t actual = crc32c::Value(data, n + 1);
             // 如果校验失败
             if (actual != crc) {
-                delete[] buf;
-                s = Status::Corruption("block checksum mismatch");
-                return s;
+                return Status::Corruption("block checksum mismatch");
             }
         }
 
         // 解压缩
         switch (data[n]) {
             case kNoCompression:
-                // 如果两者不相等
-                // 说明读取时调用的是mmap接口
-                if (data != buf) {
-                    delete[] buf;
-
-                    // 直接从映射的内存中读取数据返回
-                    result->data = Slice(data, n);
-
-                    // 已经在内存中cache了，不需要LRUCache
-                    result->cachable = false;
-                    // Block对象释放的时候不允许释放内存中的Block数据
-                    // 下回读取磁盘中同一块区域的数据还能从内存中读取
-                    result->heap_allocated = false;
-                } else {
-                    // 返回临时变量中的data数据
-                    result->data = Slice(buf, n);
-                    // 因为buf是临时的，所以需要cache到LRUCache
-                    result->cachable = true;
-                    // 使用到了 堆空间
-                    result->heap_allocated = true;
-                }
+                // 不压缩的块直接指向读出来的数据，由调用者决定谁释放
+                result->data = Slice(data, n);
                 break;
             case kSnappyCompression: {
                 size_t ulength = 0;
-                if (!port::Snappy_GetUncompressedLength(contents.data(), contents.size(), &ulength)) {
-                    delete[] buf;
+                if (!port::Snappy_GetUncompressedLength(data, n, &ulength)) {
                     return Status::Corruption("corrupted compressed block contents");
                 }
                 char *ubuf = new char[ulength];
                 if (!port::Snappy_Uncompress(data, n, ubuf)) {
-                    delete[] buf;
                     delete[] ubuf;
                     return Status::Corruption("corrupted compressed block contents");
                 }
-
-                delete[] buf;
                 result->data = Slice(ubuf, ulength);
                 result->heap_allocated = true;
                 result->cachable = true;
                 break;
             }
             default:
-                delete[] buf;
                 return Status::Corruption("bad block type");
         }
         return Status::OK();
     }
+
+    // 直接 I/O 的文件：读出包含这个块的对齐范围，在对齐的缓冲区里直接校验、解压，
+    // 只有不压缩的块才拷贝一次，拷到 Block 自己的内存里
+    static Status ReadBlockAligned(RandomAccessFile *file, size_t alignment, const ReadOptions &options,
+                                   const BlockHandle &handle, BlockContents *result) {
+        const size_t n = static_cast<size_t>(handle.size()) + kBlockTrailerSize;
+        const uint64_t aligned_offset = handle.offset() - (handle.offset() % alignment);
+        const size_t prefix = static_cast<size_t>(handle.offset() - aligned_offset);
+        const size_t aligned_size = (prefix + n + alignment - 1) / alignment * alignment;
+
+        void *aligned_buf = nullptr;
+        if (posix_memalign(&aligned_buf, alignment, aligned_size) != 0) {
+            return Status::IOError("out of memory for aligned block read");
+        }
+
+        Slice raw;
+        Status s = file->Read(aligned_offset, aligned_size, &raw, static_cast<char *>(aligned_buf));
+        if (s.ok() && raw.size() < prefix + n) {
+            s = Status::Corruption("truncated block read");
+        }
+        if (s.ok()) {
+            s = DecodeBlockContents(options, Slice(raw.data() + prefix, n), result);
+        }
+        if (s.ok() && !result->heap_allocated) {
+            // 不压缩的块还指向对齐的缓冲区
+            char *buf = new char[result->data.size()];
+            std::memcpy(buf, result->data.data(), result->data.size());
+            result->data = Slice(buf, result->data.size());
+            result->cachable = true;
+            result->heap_allocated = true;
+        }
+        free(aligned_buf);
+        return s;
+    }
+
+    Status
+    ReadBlock(RandomAccessFile *file, const ReadOptions &options, const BlockHandle &handle, BlockContents *result) {
+        result->data = Slice();
+        result->cachable = false;
+        result->heap_allocated = false;
+
+        const size_t alignment = file->GetRequiredBufferAlignment();
+        if (alignment > 0) {
+            return ReadBlockAligned(file, alignment, options, handle, result);
+        }
+
+        // 准备好保存block的空间: data + restarts_
+        auto n = static_cast<size_t>(handle.size());
+        //  1Byte的type加上4Byte的CRC校验值
+        char *buf = new char[n + kBlockTrailerSize];
+
+        Slice contents;
+        // 根据 BlockHandle 从 文件偏移量 index block offset 处 读取数据到 buf
+        // 如果底层用mmap，会把磁盘中的数据映射到content中
+        Status s = file->Read(handle.offset(), n + kBlockTrailerSize, &contents, buf);
+
+        if (!s.ok()) {
+            delete[] buf;
+            return s;
+        }
+
+        if (contents.size() != n + kBlockTrailerSize) {
+            delete[] buf;
+            return Status::Corruption("truncated block read");
+        }
+
+        s = DecodeBlockContents(options, contents, result);
+        if (s.ok() && result->data.data() == buf) {
+            // 返回临时变量中的data数据：因为buf是临时的，所以需要cache到LRUCache，
+            // Block 释放的时候一并释放
+            result->cachable = true;
+            result->heap_allocated = true;
+        } else {
+            // 解压到了新的缓冲区，或者读取时调用的是mmap接口，直接从映射的内存中读取数据：
+            // 已经在内存中cache了，Block对象释放的时候不允许释放内存中的Block数据
+            delete[] buf;
+        }
+        return s;
+    }
+
+    Status ReadFileContents(RandomAccessFile *file, uint64_t file_size, BlockContents *result) {
+        result->data = Slice();
+        result->cachable = false;
+        result->heap_allocated = false;
+
+        const auto n = static_cast<size_t>(file_size);
+        const size_t alignment = file->GetRequiredBufferAlignment();
+        Slice contents;
+        Status s;
+        // 和 ReadBlock 一样：mmap 的文件返回映射内存，不会写 scratch。
+        // 先读一个字节看看，映射的文件就不用分配整个文件大小的缓冲区
+        bool mapped = false;
+        if (alignment == 0 && n > 0) {
+            char probe;
+            s = file->Read(0, 1, &contents, &probe);
+            if (!s.ok()) {
+                return s;
+            }
+            mapped = contents.size() == 1 && contents.data() != &probe;
+        }
+        // 直接 I/O 的文件自己会经过对齐的缓冲区读，整个文件只读这一次
+        char *buf = mapped ? nullptr : new char[n];
+        s = file->Read(0, n, &contents, buf);
+        if (s.ok() && contents.size() != n) {
+            s = Status::Corruption("truncated file read");
+        }
+        if (!s.ok()) {
+            delete[] buf;
+            return s;
+        }
+        if (buf != nullptr && contents.data() == buf) {
+            result->heap_allocated = true;
+        } else {
+            delete[] buf;
+        }
+        result->data = contents;
+        return Status::OK();
+    }
 }
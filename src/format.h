@@ -42,13 +42,23 @@ namespace leveldb {
     };
 
     // 文件尾部 固定长度
+    // The footer is
+    //    index handle | padding | magic
+    // padded to kEncodedLength bytes or, in tables with meta blocks,
+    //    metaindex handle | index handle | padding | magic
+    // padded to kMetaEncodedLength bytes.  The magic number tells them apart,
+    // so tables without meta blocks keep the original format.
     class Footer {
     public:
         // 一个 index block handle 加上 padding 是 BlockHandle::kMaxEncodedLength
         // magic number为uint64_t，8Byte
         enum {
             // offset_ size_ enum magic_number
-            kEncodedLength = BlockHandle::kMaxEncodedLength + 8
+            kEncodedLength = BlockHandle::kMaxEncodedLength + 8,
+            kMetaEncodedLength = 2 * BlockHandle::kMaxEncodedLength + 8,
+            // Read this many bytes (or the whole file, if shorter) to decode
+            // any footer.
+            kMaxEncodedLength = kMetaEncodedLength
         };
 
         Footer() = default;
@@ -59,12 +69,34 @@ namespace leveldb {
 
         BlockHandle index_handle() const { return index_handle_; }
 
+        // The metaindex block maps the names of meta blocks to their handles.
+        void set_metaindex_handle(const BlockHandle &h) {
+            metaindex_handle_ = h;
+            has_metaindex_ = true;
+        }
+
+        BlockHandle metaindex_handle() const { return metaindex_handle_; }
+
+        bool has_metaindex() const { return has_metaindex_; }
+
+        // True if the values in the data blocks carry a ValueType tag and
+        // may refer to blob files (see blob_file.h).  Encoded by the magic
+        // number, so tables without blob files keep the original format.
+        void set_has_blob_values(bool v) { has_blob_values_ = v; }
+
+        bool has_blob_values() const { return has_blob_values_; }
+
         void EncodeTo(std::string *dst) const;
 
+        // Decodes the footer that ends "input", which must hold the last
+        // kMaxEncodedLength bytes of the table (or all of it, if shorter).
         Status DecodeFrom(Slice *input);
 
     private:
+        BlockHandle metaindex_handle_;
         BlockHandle index_handle_;
+        bool has_metaindex_ = false;
+        bool has_blob_values_ = false;
     };
 
     // kTableMagicNumber was picked by running
@@ -72,6 +104,54 @@ namespace leveldb {
     // and taking the leading 64 bits.
     static const uint64_t kTableMagicNumber = 0xdb4775248b80fb57ull;
 
+    // Magic number of tables whose values are tagged with a ValueType.
+    static const uint64_t kBlobTableMagicNumber = 0xdb4775248b80fb58ull;
+
+    // Magic numbers of tables with a metaindex block.
+    static const uint64_t kMetaTableMagicNumber = 0xdb4775248b80fb5aull;
+    static const uint64_t kMetaBlobTableMagicNumber = 0xdb4775248b80fb5bull;
+
+    // Magic number of plain tables (see plain_table_builder.h).
+    static const uint64_t kPlainTableMagicNumber = 0xdb4775248b80fb59ull;
+
+    // Magic number of cuckoo tables (see cuckoo_table_builder.h).
+    static const uint64_t kCuckooTableMagicNumber = 0xdb4775248b80fb5cull;
+
+    // The last word of a block is its restart count (for a kFixedKeyBlock,
+    // its entry count) with the format in the top bits.
+    static const uint32_t kSplitBlockFlag = 1u << 31;
+    static const uint32_t kFixedKeyBlockFlag = 1u << 30;
+    static const uint32_t kBlockFormatMask = kSplitBlockFlag | kFixedKeyBlockFlag;
+
+    // Metaindex entry whose value lists the names of the block properties
+    // (see Options::block_property_collectors), each length-prefixed.  The
+    // value of every index block entry is the block handle followed by the
+    // length-prefixed summaries in the same order.
+    static const char kBlockPropertiesName[] = "leveldb.BlockProperties";
+
+    // Name of the perfect hash index in the metaindex block (see
+    // Options::perfect_hash_index).
+    static const char kPerfectHashIndexBlockName[] = "leveldb.PerfectHashIndex";
+
+    // Prefix of the name of the filter block in the metaindex block; the
+    // FilterPolicy's name follows it.
+    static const char kFilterBlockNamePrefix[] = "filter.";
+
+    // Same for the index of a partitioned filter (kPartitionedFilter).  It
+    // maps the index key of the last data block of each partition to the
+    // partition, a filter block with one filter.
+    static const char kPartitionedFilterBlockNamePrefix[] = "partitionedfilter.";
+
+    // Metaindex entry whose value is the name of the SliceTransform whose
+    // prefixes were added to the filter (see Options::prefix_extractor),
+    // rather than a block handle.
+    static const char kPrefixExtractorName[] = "leveldb.PrefixExtractor";
+
+    // Name of the range filter in the metaindex block (see
+    // Options::range_filter).  Meta blocks are added to the metaindex in
+    // name order.
+    static const char kRangeFilterBlockName[] = "leveldb.RangeFilter";
+
     // 1Byte的type加上4Byte的CRC校验值
     static const size_t kBlockTrailerSize = 5;
 
@@ -83,6 +163,20 @@ namespace leveldb {
 
     Status
     ReadBlock(RandomAccessFile *file, const ReadOptions &options, const BlockHandle &handle, BlockContents *result);
+
+    // 校验并解压一个已经读进内存的块
+    // Checks the trailer of "raw", the bytes of a block followed by its
+    // trailer, and uncompresses the block.  An uncompressed block is returned
+    // in place: result->data then points into "raw", which must outlive it,
+    // and result->heap_allocated is false.
+    Status DecodeBlockContents(const ReadOptions &options, const Slice &raw, BlockContents *result);
+
+    // 整个文件读进内存；mmap 的文件直接用映射的内存
+    // Stores the whole file in *result.  Files that return data outside the
+    // scratch buffer (such as mmap()ed files) are used in place, assuming as
+    // ReadBlock() does that the data stays live while the file is open;
+    // others are read into a heap buffer.
+    Status ReadFileContents(RandomAccessFile *file, uint64_t file_size, BlockContents *result);
 }
 
 
@@ -4,6 +4,8 @@
 
 #include "iterator.h"
 
+#include "lazy_value.h"
+
 namespace leveldb {
 
 Iterator::Iterator() {
@@ -38,6 +40,10 @@ void Iterator::RegisterCleanup(CleanupFunction func, void* arg1, void* arg2) {
   node->arg2 = arg2;
 }
 
+void Iterator::GetLazyValue(LazyValue* value) const {
+  value->SetValue(this->value());
+}
+
 namespace {
 
 class EmptyIterator : public Iterator {
@@ -0,0 +1,59 @@
+#include "lazy_value.h"
+
+#include "blob_file.h"
+
+namespace leveldb {
+
+    LazyValue::LazyValue()
+            : is_blob_(false), fetched_(false), source_(nullptr), blob_owned_(nullptr) {}
+
+    LazyValue::~LazyValue() { ReleaseBlob(); }
+
+    void LazyValue::ReleaseBlob() {
+        delete[] blob_owned_;
+        blob_owned_ = nullptr;
+        blob_ = Slice();
+        fetched_ = false;
+    }
+
+    void LazyValue::SetValue(const Slice &value) {
+        ReleaseBlob();
+        is_blob_ = false;
+        data_.assign(value.data(), value.size());
+    }
+
+    void LazyValue::SetBlob(BlobSource *source, const ReadOptions &options, const Slice &encoded_index) {
+        ReleaseBlob();
+        is_blob_ = true;
+        data_.assign(encoded_index.data(), encoded_index.size());
+        source_ = source;
+        options_ = options;
+    }
+
+    void LazyValue::Reset() {
+        ReleaseBlob();
+        is_blob_ = false;
+        data_.clear();
+    }
+
+    Status LazyValue::Fetch(Slice *value) {
+        if (!is_blob_) {
+            *value = Slice(data_);
+            return Status::OK();
+        }
+        if (!fetched_) {
+            BlockContents contents;
+            Status s = ReadBlob(source_, options_, data_, &contents);
+            if (!s.ok()) {
+                *value = Slice();
+                return s;
+            }
+            blob_ = contents.data;
+            blob_owned_ = contents.heap_allocated ? contents.data.data() : nullptr;
+            fetched_ = true;
+        }
+        *value = blob_;
+        return Status::OK();
+    }
+
+}
@@ -105,8 +105,9 @@ void init() {
 }
 
 // 根据index取test_case中取数，追加到head后面
-leveldb::Slice add_number_to_slice(std::string head, int index) {
-    return leveldb::Slice(head.append(test_case[index]));
+// 返回 string：指向局部变量 head 的 Slice 在函数返回后就失效了
+std::string add_number_to_slice(std::string head, int index) {
+    return head.append(test_case[index]);
 }
 
 // 使用comparator对test_case进行检验，不然无法Add进Block
@@ -121,15 +122,15 @@ void test_test_case() {
 // 写操作
 void test_block_write() {
     // 清空文件 只写文件 创造文件
-    s = env->NewWritableFile(path, &file);
+    s = env->NewWritableFile(path, leveldb::EnvOptions(options), &file);
     check_status(s);
     // 初始化 ssTable 构造器
-    leveldb::TableBuilder tableBuilder = leveldb::TableBuilder(options, file);
+    leveldb::TableBuilder tableBuilder(options, file);
 
     // 把test_case的所有KV写入SSTable，并且达到阈值后，会进行刷盘的
     for (int i = 0; i < KV_NUM; ++i) {
-        leveldb::Slice key_ = add_number_to_slice(key, i);
-        leveldb::Slice value_ = add_number_to_slice(value, i);
+        std::string key_ = add_number_to_slice(key, i);
+        std::string value_ = add_number_to_slice(value, i);
         // 向 data 向 index 中 写入数据
         tableBuilder.Add(key_, value_);
     }
@@ -156,7 +157,7 @@ void kv_handler(const leveldb::Slice &key, const leveldb::Slice &value) {
 // 之所以分开两个函数，是因为读写同一个文件似乎不能写在一个函数中
 void test_block_read() {
     // 打开文件 仅仅可读
-    s = env->NewRandomAccessFile(path, &randomAccessFile);
+    s = env->NewRandomAccessFile(path, leveldb::EnvOptions(options), &randomAccessFile);
     check_status(s);
 
     leveldb::Table *table = nullptr;
@@ -172,6 +173,24 @@ void test_block_read() {
         // 从随机序列中取得一个序号，取得字符串与key合并，查询这个key，使用kv_handler检查kv对是否对应
         table->InternalGet(readOptions, add_number_to_slice("key", get_queue[i]), kv_handler);
     }
+
+    // 成批查询：同一批 key 的 data block 一起读出来
+    const int kBatchSize = 16;
+    for (int i = 0; i + kBatchSize <= KV_NUM; i += kBatchSize) {
+        std::string batch_keys[kBatchSize];
+        leveldb::Slice key_slices[kBatchSize];
+        std::string values[kBatchSize];
+        leveldb::Status statuses[kBatchSize];
+        for (int j = 0; j < kBatchSize; j++) {
+            batch_keys[j] = key + test_case[get_queue[i + j]];
+            key_slices[j] = batch_keys[j];
+        }
+        table->MultiGet(readOptions, kBatchSize, key_slices, values, statuses);
+        for (int j = 0; j < kBatchSize; j++) {
+            check_status(statuses[j]);
+            assert(values[j] == value + test_case[get_queue[i + j]]);
+        }
+    }
     printf("All test passed\n");
 }
 
@@ -0,0 +1,185 @@
+#include "memtable.h"
+
+#include <cstring>
+#include <limits>
+
+#include "../util/coding.h"
+#include "../util/mutexlock.h"
+#include "table_builder.h"
+
+namespace leveldb {
+
+    // Skiplist entry layout:
+    //    varint32  internal key length (user key length + 8)
+    //    char[]    user key
+    //    fixed64   sequence number
+    //    varint32  value length
+    //    char[]    value
+    static const uint64_t kMaxSequenceNumber = std::numeric_limits<uint64_t>::max();
+
+    static Slice GetLengthPrefixedSlice(const char *data) {
+        uint32_t len;
+        const char *p = data;
+        p = GetVarint32Ptr(p, p + 5, &len);  // +5: we assume "p" is not corrupted
+        return Slice(p, len);
+    }
+
+    static Slice UserKey(const Slice &internal_key) {
+        return Slice(internal_key.data(), internal_key.size() - 8);
+    }
+
+    static uint64_t Sequence(const Slice &internal_key) {
+        return DecodeFixed64(internal_key.data() + internal_key.size() - 8);
+    }
+
+    // Encodes (user_key, kMaxSequenceNumber) into *scratch, which sorts before
+    // every version of user_key, and returns a pointer usable as a skiplist key.
+    static const char *EncodeLookupKey(const Slice &user_key, std::string *scratch) {
+        scratch->clear();
+        PutVarint32(scratch, static_cast<uint32_t>(user_key.size() + 8));
+        scratch->append(user_key.data(), user_key.size());
+        PutFixed64(scratch, kMaxSequenceNumber);
+        return scratch->data();
+    }
+
+    int MemTable::KeyComparator::operator()(const char *aptr, const char *bptr) const {
+        Slice a = GetLengthPrefixedSlice(aptr);
+        Slice b = GetLengthPrefixedSlice(bptr);
+        int r = comparator->Compare(UserKey(a), UserKey(b));
+        if (r == 0) {
+            // 同一个 key，新版本排在前面
+            const uint64_t aseq = Sequence(a);
+            const uint64_t bseq = Sequence(b);
+            if (aseq > bseq) {
+                r = -1;
+            } else if (aseq < bseq) {
+                r = +1;
+            }
+        }
+        return r;
+    }
+
+    MemTable::MemTable(const Options &options)
+            : comparator_(options.comparator),
+              write_buffer_size_(options.write_buffer_size),
+              refs_(0),
+              table_(comparator_, &arena_),
+              last_sequence_(0) {}
+
+    MemTable::~MemTable() { assert(refs_.load(std::memory_order_relaxed) == 0); }
+
+    void MemTable::Add(const Slice &key, const Slice &value) {
+        size_t key_size = key.size();
+        size_t val_size = value.size();
+        size_t internal_key_size = key_size + 8;
+        const size_t encoded_len = VarintLength(internal_key_size) + internal_key_size +
+                                   VarintLength(val_size) + val_size;
+
+        MutexLock l(&mu_);
+        const uint64_t sequence = last_sequence_.load(std::memory_order_relaxed) + 1;
+        char *buf = arena_.Allocate(encoded_len);
+        char *p = EncodeVarint32(buf, internal_key_size);
+        std::memcpy(p, key.data(), key_size);
+        p += key_size;
+        EncodeFixed64(p, sequence);
+        p += 8;
+        p = EncodeVarint32(p, val_size);
+        std::memcpy(p, value.data(), val_size);
+        assert(p + val_size == buf + encoded_len);
+        table_.Insert(buf);
+        last_sequence_.store(sequence, std::memory_order_release);
+    }
+
+    bool MemTable::Get(const Slice &key, std::string *value) const {
+        std::string scratch;
+        Table::Iterator iter(&table_);
+        iter.Seek(EncodeLookupKey(key, &scratch));
+        if (!iter.Valid()) {
+            return false;
+        }
+        const char *entry = iter.key();
+        uint32_t key_length;
+        const char *key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
+        if (comparator_.comparator->Compare(Slice(key_ptr, key_length - 8), key) != 0) {
+            return false;
+        }
+        Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
+        value->assign(v.data(), v.size());
+        return true;
+    }
+
+    // Yields the newest version of each user key: versions of a key are
+    // adjacent and sorted newest first, so moving forward skips the rest of
+    // the run and moving backward re-seeks to the start of the run.
+    class MemTableIterator : public Iterator {
+    public:
+        explicit MemTableIterator(const MemTable::Table *table, const Comparator *comparator)
+                : iter_(table), comparator_(comparator) {}
+
+        MemTableIterator(const MemTableIterator &) = delete;
+
+        MemTableIterator &operator=(const MemTableIterator &) = delete;
+
+        ~MemTableIterator() override = default;
+
+        bool Valid() const override { return iter_.Valid(); }
+
+        void Seek(const Slice &k) override { iter_.Seek(EncodeLookupKey(k, &tmp_)); }
+
+        void SeekToFirst() override { iter_.SeekToFirst(); }
+
+        void SeekToLast() override {
+            iter_.SeekToLast();
+            SeekToNewestVersion();
+        }
+
+        void Next() override {
+            assert(Valid());
+            const Slice current = key();
+            do {
+                iter_.Next();
+            } while (iter_.Valid() && comparator_->Compare(key(), current) == 0);
+        }
+
+        void Prev() override {
+            assert(Valid());
+            iter_.Prev();  // The oldest version of the previous key.
+            SeekToNewestVersion();
+        }
+
+        Slice key() const override { return UserKey(GetLengthPrefixedSlice(iter_.key())); }
+
+        Slice value() const override {
+            Slice key_slice = GetLengthPrefixedSlice(iter_.key());
+            return GetLengthPrefixedSlice(key_slice.data() + key_slice.size());
+        }
+
+        Status status() const override { return Status::OK(); }
+
+    private:
+        void SeekToNewestVersion() {
+            if (iter_.Valid()) {
+                const Slice user_key = key();
+                std::string lookup;
+                iter_.Seek(EncodeLookupKey(user_key, &lookup));
+            }
+        }
+
+        MemTable::Table::Iterator iter_;
+        const Comparator *const comparator_;
+        std::string tmp_;  // For passing to EncodeLookupKey
+    };
+
+    Iterator *MemTable::NewIterator() const {
+        return new MemTableIterator(&table_, comparator_.comparator);
+    }
+
+    Status MemTable::FlushTo(TableBuilder *builder) const {
+        MemTableIterator iter(&table_, comparator_.comparator);
+        for (iter.SeekToFirst(); iter.Valid() && builder->status().ok(); iter.Next()) {
+            builder->Add(iter.key(), iter.value());
+        }
+        return builder->status();
+    }
+
+}
@@ -0,0 +1,117 @@
+#ifndef SSTABLE_MEMTABLE_H
+#define SSTABLE_MEMTABLE_H
+
+#include <cstdint>
+#include <string>
+
+#include "../include/comparator.h"
+#include "../include/iterator.h"
+#include "../include/options.h"
+#include "../port/port_stdcxx.h"
+#include "../port/thread_annotations.h"
+#include "../util/arena.h"
+#include "skiplist.h"
+
+namespace leveldb {
+
+    class TableBuilder;
+
+    // 内存写缓冲区：乱序写入，有序输出
+    // An in-memory write buffer that accepts keys in any order and hands them
+    // back sorted by options.comparator, so that it can be flushed into a
+    // TableBuilder (which requires sorted input).
+    //
+    // Entries live in a skiplist whose nodes and key/value bytes are carved
+    // out of an Arena.  Writing a key that is already present adds a newer
+    // version instead of modifying the old one; lookups and iterators only
+    // ever see the newest version of each key.
+    //
+    // Thread safety: Add() may be called from several threads, which are
+    // serialized by an internal mutex.  Get() and iterators never lock and may
+    // run concurrently with Add().
+    class MemTable {
+    public:
+        // MemTables are reference counted.  The initial reference count
+        // is zero and the caller must call Ref() at least once.
+        explicit MemTable(const Options &options);
+
+        MemTable(const MemTable &) = delete;
+
+        MemTable &operator=(const MemTable &) = delete;
+
+        // Increase reference count.
+        void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
+
+        // Drop reference count.  Delete if no more references exist.
+        void Unref() {
+            const int previous = refs_.fetch_sub(1, std::memory_order_acq_rel);
+            assert(previous >= 1);
+            if (previous == 1) {
+                delete this;
+            }
+        }
+
+        // Returns an estimate of the number of bytes of data in use by this
+        // data structure.  It is safe to call while the memtable is being
+        // modified.
+        size_t ApproximateMemoryUsage() const { return arena_.MemoryUsage(); }
+
+        // True once the memtable has grown to options.write_buffer_size and
+        // should be flushed and replaced by a fresh one.
+        bool ShouldFlush() const { return ApproximateMemoryUsage() >= write_buffer_size_; }
+
+        // Number of Add() calls so far, counting overwrites.
+        uint64_t NumEntries() const { return last_sequence_.load(std::memory_order_acquire); }
+
+        // Add an entry that maps key to value.  If key is already present the
+        // new value replaces it for all later reads.
+        void Add(const Slice &key, const Slice &value) LOCKS_EXCLUDED(mu_);
+
+        // If the memtable contains a value for key, store it in *value and
+        // return true.  Else return false.
+        bool Get(const Slice &key, std::string *value) const;
+
+        // Return an iterator that yields the newest version of every key, in
+        // comparator order.  key() is the user key, value() its value.
+        //
+        // The caller must ensure that the underlying MemTable remains live
+        // while the returned iterator is live.  The keys returned by this
+        // iterator are not affected by later Add() calls on keys it has
+        // already passed.
+        Iterator *NewIterator() const;
+
+        // 刷盘：按序把每个 key 的最新值交给 builder
+        // Streams the contents of the memtable into *builder, which must be
+        // empty.  Does not call builder->Finish(); returns builder->status().
+        Status FlushTo(TableBuilder *builder) const;
+
+    private:
+        friend class MemTableIterator;
+
+        // Orders skiplist entries by user key, then newest version first.
+        struct KeyComparator {
+            const Comparator *comparator;
+
+            explicit KeyComparator(const Comparator *c) : comparator(c) {}
+
+            int operator()(const char *a, const char *b) const;
+        };
+
+        typedef SkipList<const char *, KeyComparator> Table;
+
+        ~MemTable();  // Private since only Unref() should be used to delete it
+
+        KeyComparator comparator_;
+        const size_t write_buffer_size_;
+        std::atomic<int> refs_;
+        Arena arena_;
+        Table table_;
+
+        port::Mutex mu_;  // Serializes writers.
+        // Sequence number of the newest entry; published after its insert.
+        std::atomic<uint64_t> last_sequence_;
+    };
+
+}
+
+#endif //SSTABLE_MEMTABLE_H
@@ -0,0 +1,210 @@
+#include "memtable.h"
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "table.h"
+#include "table_builder.h"
+#include "../util/random.h"
+
+namespace leveldb {
+
+    namespace {
+
+        std::string Key(int i) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "key%06d", i);
+            return std::string(buf);
+        }
+
+        // 测试里的 memtable 用完就 Unref()
+        struct MemTableRef {
+            explicit MemTableRef(const Options &options) : mem(new MemTable(options)) { mem->Ref(); }
+
+            ~MemTableRef() { mem->Unref(); }
+
+            MemTable *const mem;
+        };
+
+    }  // namespace
+
+    TEST(MemTableTest, AddAndGet) {
+        MemTableRef ref{Options()};
+        MemTable *mem = ref.mem;
+        std::string value;
+        ASSERT_FALSE(mem->Get("a", &value));
+
+        mem->Add("b", "1");
+        mem->Add("a", "2");
+        mem->Add("c", "");
+        ASSERT_TRUE(mem->Get("a", &value));
+        ASSERT_EQ("2", value);
+        ASSERT_TRUE(mem->Get("b", &value));
+        ASSERT_EQ("1", value);
+        ASSERT_TRUE(mem->Get("c", &value));
+        ASSERT_EQ("", value);
+        ASSERT_FALSE(mem->Get("ab", &value));
+        ASSERT_EQ(3u, mem->NumEntries());
+    }
+
+    TEST(MemTableTest, NewestVersionWins) {
+        MemTableRef ref{Options()};
+        MemTable *mem = ref.mem;
+        mem->Add("k", "old");
+        mem->Add("j", "x");
+        mem->Add("k", "new");
+        std::string value;
+        ASSERT_TRUE(mem->Get("k", &value));
+        ASSERT_EQ("new", value);
+        ASSERT_EQ(3u, mem->NumEntries());
+
+        // 迭代器每个 key 只给出最新的值
+        Iterator *iter = mem->NewIterator();
+        iter->SeekToFirst();
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ("j", iter->key().ToString());
+        iter->Next();
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ("k", iter->key().ToString());
+        ASSERT_EQ("new", iter->value().ToString());
+        iter->Next();
+        ASSERT_FALSE(iter->Valid());
+        iter->Seek("k");
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ("new", iter->value().ToString());
+        delete iter;
+    }
+
+    TEST(MemTableTest, IteratorIsSorted) {
+        MemTableRef ref{Options()};
+        MemTable *mem = ref.mem;
+        std::map<std::string, std::string> model;
+        Random rnd(301);
+        for (int i = 0; i < 5000; i++) {
+            const std::string key = Key(rnd.Uniform(2000));
+            const std::string value = std::to_string(i);
+            mem->Add(key, value);
+            model[key] = value;
+        }
+
+        Iterator *iter = mem->NewIterator();
+        auto it = model.begin();
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++it) {
+            ASSERT_TRUE(it != model.end());
+            ASSERT_EQ(it->first, iter->key().ToString());
+            ASSERT_EQ(it->second, iter->value().ToString());
+        }
+        ASSERT_TRUE(it == model.end());
+
+        // 反向也一样
+        auto rit = model.rbegin();
+        for (iter->SeekToLast(); iter->Valid(); iter->Prev(), ++rit) {
+            ASSERT_TRUE(rit != model.rend());
+            ASSERT_EQ(rit->first, iter->key().ToString());
+            ASSERT_EQ(rit->second, iter->value().ToString());
+        }
+        ASSERT_TRUE(rit == model.rend());
+        delete iter;
+    }
+
+    TEST(MemTableTest, ShouldFlushAtWriteBufferSize) {
+        Options options;
+        options.write_buffer_size = 64 * 1024;
+        MemTableRef ref(options);
+        MemTable *mem = ref.mem;
+        int i = 0;
+        while (!mem->ShouldFlush()) {
+            mem->Add(Key(i++), std::string(100, 'v'));
+            ASSERT_LT(i, 10000);
+        }
+        ASSERT_GE(mem->ApproximateMemoryUsage(), options.write_buffer_size);
+        ASSERT_GT(i, 64 * 1024 / 200);
+    }
+
+    // 几个线程同时写，同时还有读者；写完以后每个 key 都在
+    TEST(MemTableTest, ConcurrentAdds) {
+        MemTableRef ref{Options()};
+        MemTable *mem = ref.mem;
+        const int kThreads = 4;
+        const int kKeysPerThread = 5000;
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; t++) {
+            threads.emplace_back([mem, t]() {
+                for (int i = 0; i < kKeysPerThread; i++) {
+                    mem->Add(Key(i * kThreads + t), std::to_string(t));
+                }
+            });
+        }
+        threads.emplace_back([mem]() {
+            std::string value;
+            for (int i = 0; i < kThreads * kKeysPerThread; i++) {
+                if (mem->Get(Key(i), &value)) {
+                    ASSERT_EQ(std::to_string(i % kThreads), value);
+                }
+            }
+        });
+        for (std::thread &thread: threads) {
+            thread.join();
+        }
+
+        ASSERT_EQ(static_cast<uint64_t>(kThreads * kKeysPerThread), mem->NumEntries());
+        Iterator *iter = mem->NewIterator();
+        int count = 0;
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), count++) {
+            ASSERT_EQ(Key(count), iter->key().ToString());
+            ASSERT_EQ(std::to_string(count % kThreads), iter->value().ToString());
+        }
+        ASSERT_EQ(kThreads * kKeysPerThread, count);
+        delete iter;
+    }
+
+    TEST(MemTableTest, FlushToTable) {
+        Env *env = Env::Default();
+        std::string fname;
+        ASSERT_TRUE(env->GetTestDirectory(&fname).ok());
+        fname += "/memtable_test.sst";
+
+        Options options;
+        options.block_size = 256;
+        MemTableRef ref(options);
+        MemTable *mem = ref.mem;
+        for (int i = 999; i >= 0; i--) {
+            mem->Add(Key(i), "old");
+            mem->Add(Key(i), std::to_string(i));
+        }
+
+        WritableFile *file;
+        ASSERT_TRUE(env->NewWritableFile(fname, &file).ok());
+        {
+            TableBuilder builder(options, file);
+            ASSERT_TRUE(mem->FlushTo(&builder).ok());
+            ASSERT_TRUE(builder.Finish().ok());
+        }
+        ASSERT_TRUE(file->Close().ok());
+        delete file;
+
+        uint64_t size;
+        ASSERT_TRUE(env->GetFileSize(fname, &size).ok());
+        RandomAccessFile *reader;
+        ASSERT_TRUE(env->NewRandomAccessFile(fname, &reader).ok());
+        Table *table;
+        ASSERT_TRUE(Table::Open(options, reader, size, &table).ok());
+        Iterator *iter = table->NewIterator(ReadOptions());
+        int i = 0;
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i++) {
+            ASSERT_EQ(Key(i), iter->key().ToString());
+            ASSERT_EQ(std::to_string(i), iter->value().ToString());
+        }
+        ASSERT_EQ(1000, i);
+        delete iter;
+        delete table;
+        delete reader;
+        env->RemoveFile(fname);
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,266 @@
+#include "merger.h"
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#include "../include/comparator.h"
+#include "../include/iterator.h"
+#include "iterator_wrapper.h"
+
+namespace leveldb {
+
+    namespace {
+
+        // 败者树多路归并
+        // The children are the leaves of a loser tree: tree_[1, n) hold the loser
+        // of the match played at each internal node and tree_[0] the overall
+        // winner, i.e. the child positioned at the current entry.  Leaf i sits
+        // at position n + i, so the parent of position x is x / 2.
+        //
+        // Matches are decided by a strict total order: exhausted children lose
+        // to positioned ones, positioned children compare by key (smallest
+        // first moving forward, largest first moving backward) and ties go to
+        // the lower child index moving forward, the higher one moving backward,
+        // so that Prev() visits duplicates in the reverse order of Next().
+        class MergingIterator : public Iterator {
+        public:
+            MergingIterator(const Comparator *comparator, Iterator **children, int n)
+                    : comparator_(comparator),
+                      children_(new IteratorWrapper[n]),
+                      n_(n),
+                      tree_(n),
+                      runner_up_(-1),
+                      direction_(kForward) {
+                for (int i = 0; i < n; i++) {
+                    children_[i].Set(children[i]);
+                }
+            }
+
+            ~MergingIterator() override { delete[] children_; }
+
+            bool Valid() const override { return children_[tree_[0]].Valid(); }
+
+            void SeekToFirst() override {
+                for (int i = 0; i < n_; i++) {
+                    children_[i].SeekToFirst();
+                }
+                direction_ = kForward;
+                Build();
+            }
+
+            void SeekToLast() override {
+                for (int i = 0; i < n_; i++) {
+                    children_[i].SeekToLast();
+                }
+                direction_ = kReverse;
+                Build();
+            }
+
+            void Seek(const Slice &target) override {
+                for (int i = 0; i < n_; i++) {
+                    children_[i].Seek(target);
+                }
+                direction_ = kForward;
+                Build();
+            }
+
+            void Next() override {
+                assert(Valid());
+
+                // Ensure that all children are positioned after key().
+                // If we are moving in the forward direction, it is already
+                // true for all of the non-current children since current_ is
+                // the smallest child and key() == current_->key().  Otherwise,
+                // we explicitly position the non-current children.
+                if (direction_ != kForward) {
+                    const int current = tree_[0];
+                    for (int i = 0; i < n_; i++) {
+                        IteratorWrapper *child = &children_[i];
+                        if (i != current) {
+                            child->Seek(key());
+                            if (child->Valid() && comparator_->Compare(key(), child->key()) == 0) {
+                                child->Next();
+                            }
+                        }
+                    }
+                    direction_ = kForward;
+                    children_[current].Next();
+                    Build();
+                    return;
+                }
+
+                Advance(&IteratorWrapper::Next);
+            }
+
+            void Prev() override {
+                assert(Valid());
+
+                // Ensure that all children are positioned before key().
+                // If we are moving in the reverse direction, it is already
+                // true for all of the non-current children since current_ is
+                // the largest child and key() == current_->key().  Otherwise,
+                // we explicitly position the non-current children.
+                if (direction_ != kReverse) {
+                    const int current = tree_[0];
+                    for (int i = 0; i < n_; i++) {
+                        IteratorWrapper *child = &children_[i];
+                        if (i != current) {
+                            child->Seek(key());
+                            if (child->Valid()) {
+                                // Child is at first entry >= key().  Step back one to be < key()
+                                child->Prev();
+                            } else {
+                                // Child has no entries >= key().  Position at last entry.
+                                child->SeekToLast();
+                            }
+                        }
+                    }
+                    direction_ = kReverse;
+                    children_[current].Prev();
+                    Build();
+                    return;
+                }
+
+                Advance(&IteratorWrapper::Prev);
+            }
+
+            Slice key() const override {
+                assert(Valid());
+                return children_[tree_[0]].key();
+            }
+
+            Slice value() const override {
+                assert(Valid());
+                return children_[tree_[0]].value();
+            }
+
+            void GetLazyValue(LazyValue *value) const override {
+                assert(Valid());
+                children_[tree_[0]].iter()->GetLazyValue(value);
+            }
+
+            Status status() const override {
+                Status status;
+                for (int i = 0; i < n_; i++) {
+                    status = children_[i].status();
+                    if (!status.ok()) {
+                        break;
+                    }
+                }
+                return status;
+            }
+
+        private:
+            // Which direction is the iterator moving?
+            enum Direction {
+                kForward, kReverse
+            };
+
+            // True if child a comes before child b in the current direction.
+            bool Beats(int a, int b) const {
+                const IteratorWrapper &ca = children_[a];
+                const IteratorWrapper &cb = children_[b];
+                if (!ca.Valid() || !cb.Valid()) {
+                    return ca.Valid() || (!cb.Valid() && a < b);
+                }
+                int r = comparator_->Compare(ca.key(), cb.key());
+                if (r == 0) {
+                    r = a - b;
+                }
+                return (direction_ == kForward) ? r < 0 : r > 0;
+            }
+
+            // Plays every match from scratch after all children moved. O(n).
+            void Build() {
+                runner_up_ = -1;
+                if (n_ == 1) {
+                    tree_[0] = 0;
+                    return;
+                }
+                std::vector<int> winners(2 * n_);
+                for (int i = 0; i < n_; i++) {
+                    winners[n_ + i] = i;
+                }
+                for (int x = n_ - 1; x >= 1; x--) {
+                    const int a = winners[2 * x];
+                    const int b = winners[2 * x + 1];
+                    if (Beats(a, b)) {
+                        winners[x] = a;
+                        tree_[x] = b;
+                    } else {
+                        winners[x] = b;
+                        tree_[x] = a;
+                    }
+                }
+                tree_[0] = winners[1];
+            }
+
+            // Replays the matches on the path of child i after it moved. O(log n).
+            void Replay(int i) {
+                int winner = i;
+                for (int x = (n_ + i) / 2; x > 0; x /= 2) {
+                    if (Beats(tree_[x], winner)) {
+                        std::swap(tree_[x], winner);
+                    }
+                }
+                tree_[0] = winner;
+            }
+
+            // The best child other than the winner: every other child lost, at
+            // some node of the winner's path, to a player that is on that path.
+            int FindRunnerUp() const {
+                int best = -1;
+                for (int x = (n_ + tree_[0]) / 2; x > 0; x /= 2) {
+                    if (best < 0 || Beats(tree_[x], best)) {
+                        best = tree_[x];
+                    }
+                }
+                return best;
+            }
+
+            // Moves the winner one step in the current direction.
+            void Advance(void (IteratorWrapper::*step)()) {
+                const int current = tree_[0];
+                (children_[current].*step)();
+
+                // 同一个子迭代器连续胜出时，只需和亚军比一次
+                // While the winner keeps beating the runner-up it beats every
+                // loser on its path, so the tree stays valid without replaying.
+                if (runner_up_ >= 0) {
+                    if (Beats(current, runner_up_)) {
+                        return;
+                    }
+                    runner_up_ = -1;
+                }
+                Replay(current);
+                if (tree_[0] == current && n_ > 1) {
+                    runner_up_ = FindRunnerUp();
+                }
+            }
+
+            // We might want to use a heap in case there are lots of children.
+            // For now we use a loser tree, which needs about log2(n)
+            // comparisons per step where a binary heap needs about twice that.
+            const Comparator *comparator_;
+            IteratorWrapper *children_;
+            const int n_;
+            std::vector<int> tree_;
+            int runner_up_;  // Cached second-best child, or -1 if unknown.
+            Direction direction_;
+        };
+
+    }  // namespace
+
+    Iterator *NewMergingIterator(const Comparator *comparator, Iterator **children, int n) {
+        assert(n >= 0);
+        if (n == 0) {
+            return NewEmptyIterator();
+        } else if (n == 1) {
+            return children[0];
+        } else {
+            return new MergingIterator(comparator, children, n);
+        }
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,28 @@
+#ifndef SSTABLE_MERGER_H
+#define SSTABLE_MERGER_H
+
+namespace leveldb {
+
+    class Comparator;
+
+    class Iterator;
+
+    // Return an iterator that provided the union of the data in
+    // children[0,n-1].  Takes ownership of the child iterators and
+    // will delete them when the result iterator is deleted.
+    //
+    // The result does no duplicate suppression.  I.e., if a particular
+    // key is present in K child iterators, it will be yielded K times,
+    // in the order of the children that hold it (children[0] first) when
+    // moving forward.
+    //
+    // The children are kept in a loser tree, so advancing costs O(log n)
+    // comparisons, and only one comparison while the same child keeps
+    // producing the smallest key.
+    //
+    // REQUIRES: n >= 0
+    Iterator *NewMergingIterator(const Comparator *comparator, Iterator **children, int n);
+
+}  // namespace leveldb
+
+#endif //SSTABLE_MERGER_H
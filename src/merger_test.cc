@@ -0,0 +1,179 @@
+#include "merger.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../include/comparator.h"
+#include "../include/iterator.h"
+#include "../util/random.h"
+
+namespace leveldb {
+
+    namespace {
+
+        typedef std::vector<std::pair<std::string, std::string>> KVList;
+
+        // 有序 vector 上的迭代器
+        class VectorIterator : public Iterator {
+        public:
+            explicit VectorIterator(KVList entries) : entries_(std::move(entries)), pos_(entries_.size()) {}
+
+            bool Valid() const override { return pos_ < entries_.size(); }
+
+            void SeekToFirst() override { pos_ = 0; }
+
+            void SeekToLast() override { pos_ = entries_.empty() ? 0 : entries_.size() - 1; }
+
+            void Seek(const Slice &target) override {
+                pos_ = 0;
+                while (pos_ < entries_.size() && Slice(entries_[pos_].first).compare(target) < 0) {
+                    pos_++;
+                }
+            }
+
+            void Next() override { pos_++; }
+
+            void Prev() override { pos_ = (pos_ == 0) ? entries_.size() : pos_ - 1; }
+
+            Slice key() const override { return entries_[pos_].first; }
+
+            Slice value() const override { return entries_[pos_].second; }
+
+            Status status() const override { return Status::OK(); }
+
+        private:
+            const KVList entries_;
+            size_t pos_;
+        };
+
+        // n 个有序的子迭代器，key 可能重复；value 记下子迭代器编号
+        std::vector<KVList> RandomChildren(Random *rnd, int n, int keys_per_child) {
+            std::vector<KVList> children(n);
+            for (int c = 0; c < n; c++) {
+                std::vector<std::string> keys;
+                const int count = rnd->Uniform(keys_per_child + 1);
+                for (int i = 0; i < count; i++) {
+                    keys.push_back("k" + std::to_string(1000 + rnd->Uniform(500)));
+                }
+                std::sort(keys.begin(), keys.end());
+                for (const std::string &key: keys) {
+                    children[c].push_back(std::make_pair(key, std::to_string(c)));
+                }
+            }
+            return children;
+        }
+
+        // 期望的合并结果：按 key 排序，同一个 key 按子迭代器编号
+        KVList Expected(const std::vector<KVList> &children) {
+            KVList all;
+            for (const KVList &child: children) {
+                all.insert(all.end(), child.begin(), child.end());
+            }
+            std::stable_sort(all.begin(), all.end(),
+                             [](const std::pair<std::string, std::string> &a,
+                                const std::pair<std::string, std::string> &b) { return a.first < b.first; });
+            return all;
+        }
+
+        Iterator *Merge(const std::vector<KVList> &children) {
+            std::vector<Iterator *> iters;
+            for (const KVList &child: children) {
+                iters.push_back(new VectorIterator(child));
+            }
+            return NewMergingIterator(BytewiseComparator(), iters.data(), static_cast<int>(iters.size()));
+        }
+
+    }  // namespace
+
+    TEST(MergerTest, Empty) {
+        Iterator *iter = NewMergingIterator(BytewiseComparator(), nullptr, 0);
+        iter->SeekToFirst();
+        ASSERT_FALSE(iter->Valid());
+        iter->SeekToLast();
+        ASSERT_FALSE(iter->Valid());
+        iter->Seek("a");
+        ASSERT_FALSE(iter->Valid());
+        ASSERT_TRUE(iter->status().ok());
+        delete iter;
+    }
+
+    TEST(MergerTest, ForwardAndBackward) {
+        Random rnd(301);
+        for (const int n: {1, 2, 3, 7, 16, 33}) {
+            const std::vector<KVList> children = RandomChildren(&rnd, n, 60);
+            const KVList expected = Expected(children);
+            Iterator *iter = Merge(children);
+
+            size_t i = 0;
+            for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i++) {
+                ASSERT_LT(i, expected.size());
+                ASSERT_EQ(expected[i].first, iter->key().ToString());
+                ASSERT_EQ(expected[i].second, iter->value().ToString()) << "n=" << n << " i=" << i;
+            }
+            ASSERT_EQ(expected.size(), i);
+
+            // 反向时 key 仍然有序；重复的 key 之间的先后不作要求
+            i = expected.size();
+            for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+                ASSERT_GT(i, 0u);
+                i--;
+                ASSERT_EQ(expected[i].first, iter->key().ToString());
+            }
+            ASSERT_EQ(0u, i);
+            delete iter;
+        }
+    }
+
+    TEST(MergerTest, SeekAndSwitchDirection) {
+        Random rnd(17);
+        const std::vector<KVList> children = RandomChildren(&rnd, 9, 80);
+        const KVList expected = Expected(children);
+        Iterator *iter = Merge(children);
+
+        for (int round = 0; round < 200; round++) {
+            const std::string target = "k" + std::to_string(1000 + rnd.Uniform(520));
+            iter->Seek(target);
+            size_t pos = 0;
+            while (pos < expected.size() && expected[pos].first < target) {
+                pos++;
+            }
+            if (pos == expected.size()) {
+                ASSERT_FALSE(iter->Valid());
+                continue;
+            }
+            ASSERT_TRUE(iter->Valid());
+            ASSERT_EQ(expected[pos].first, iter->key().ToString());
+
+            // 往前一步再往回走，越过前一个 key 的其他副本后回到同一个 key
+            iter->Prev();
+            if (pos == 0) {
+                ASSERT_FALSE(iter->Valid());
+                continue;
+            }
+            ASSERT_TRUE(iter->Valid());
+            const std::string prev_key = expected[pos - 1].first;
+            ASSERT_EQ(prev_key, iter->key().ToString());
+            do {
+                iter->Next();
+                ASSERT_TRUE(iter->Valid());
+            } while (iter->key() == Slice(prev_key));
+            ASSERT_EQ(expected[pos].first, iter->key().ToString());
+        }
+        delete iter;
+    }
+
+    TEST(MergerTest, ReportsChildErrors) {
+        std::vector<Iterator *> iters;
+        iters.push_back(new VectorIterator(KVList{{"a", "1"}, {"c", "1"}}));
+        iters.push_back(NewErrorIterator(Status::Corruption("bad child")));
+        iters.push_back(new VectorIterator(KVList{{"b", "2"}}));
+        Iterator *iter = NewMergingIterator(BytewiseComparator(), iters.data(), 3);
+        iter->SeekToFirst();
+        ASSERT_TRUE(iter->status().IsCorruption());
+        delete iter;
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,130 @@
+#include "multi_table_builder.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+
+#include "table_builder.h"
+
+namespace leveldb {
+
+    TableFileFactory::~TableFileFactory() = default;
+
+    namespace {
+
+        class NumberedTableFileFactory : public TableFileFactory {
+        public:
+            NumberedTableFileFactory(Env *env, std::string dirname, uint64_t first_number,
+                                     const EnvOptions &env_options)
+                    : env_(env), dirname_(std::move(dirname)), env_options_(env_options),
+                      next_number_(first_number) {}
+
+            Status NewTableFile(std::string *fname, WritableFile **file) override {
+                const uint64_t number = next_number_.fetch_add(1, std::memory_order_relaxed);
+                char buf[100];
+                std::snprintf(buf, sizeof(buf), "/%06llu.sst", static_cast<unsigned long long>(number));
+                *fname = dirname_ + buf;
+                return env_->NewWritableFile(*fname, env_options_, file);
+            }
+
+        private:
+            Env *const env_;
+            const std::string dirname_;
+            const EnvOptions env_options_;
+            std::atomic<uint64_t> next_number_;
+        };
+
+    }  // namespace
+
+    TableFileFactory *NewTableFileFactory(Env *env, const std::string &dirname, uint64_t first_number,
+                                          const EnvOptions &env_options) {
+        return new NumberedTableFileFactory(env, dirname, first_number, env_options);
+    }
+
+    MultiTableBuilder::MultiTableBuilder(const Options &options, TableFileFactory *factory)
+            : options_(options),
+              factory_(factory),
+              closed_(false),
+              num_entries_(0),
+              builder_(nullptr),
+              file_(nullptr) {}
+
+    MultiTableBuilder::~MultiTableBuilder() {
+        assert(closed_);  // Catch errors where caller forgot to call Finish()
+        CloseTable();
+    }
+
+    void MultiTableBuilder::Add(const Slice &key, const Slice &value) {
+        assert(!closed_);
+        if (!ok()) return;
+        if (builder_ == nullptr) {
+            status_ = OpenTable();
+            if (!ok()) return;
+            current_.smallest.assign(key.data(), key.size());
+        }
+
+        builder_->Add(key, value);
+        current_.largest.assign(key.data(), key.size());
+        current_.num_entries++;
+        num_entries_++;
+
+        // 过滤器分区可能在 Add() 一开始就写出去，这时当前块里还有 entry，
+        // 要等这个块写完再切
+        if (builder_->FileSize() >= options_.max_file_size && builder_->AtBlockBoundary()) {
+            status_ = FinishTable();
+        }
+    }
+
+    Status MultiTableBuilder::Finish() {
+        assert(!closed_);
+        closed_ = true;
+        if (ok() && builder_ != nullptr) {
+            status_ = FinishTable();
+        }
+        return status_;
+    }
+
+    void MultiTableBuilder::Abandon() {
+        assert(!closed_);
+        closed_ = true;
+        CloseTable();
+    }
+
+    Status MultiTableBuilder::OpenTable() {
+        current_ = TableFileMeta();
+        Status s = factory_->NewTableFile(&current_.fname, &file_);
+        if (s.ok()) {
+            builder_ = new TableBuilder(options_, file_);
+        }
+        return s;
+    }
+
+    Status MultiTableBuilder::FinishTable() {
+        Status s = builder_->Finish();
+        if (s.ok()) {
+            s = builder_->Sync();
+        }
+        if (s.ok()) {
+            s = file_->Close();
+            delete file_;
+            file_ = nullptr;
+        }
+        current_.file_size = builder_->FileSize();
+        CloseTable();
+        if (s.ok()) {
+            outputs_.push_back(current_);
+        }
+        return s;
+    }
+
+    void MultiTableBuilder::CloseTable() {
+        if (file_ != nullptr) {
+            file_->Close();  // Ignoring any potential errors
+            delete file_;
+            file_ = nullptr;
+        }
+        delete builder_;
+        builder_ = nullptr;
+    }
+
+}
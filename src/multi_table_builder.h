@@ -0,0 +1,124 @@
+#ifndef SSTABLE_MULTI_TABLE_BUILDER_H
+#define SSTABLE_MULTI_TABLE_BUILDER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../include/env.h"
+#include "../include/options.h"
+#include "../include/slice.h"
+#include "../include/status.h"
+
+namespace leveldb {
+
+    class TableBuilder;
+
+    // Describes one table file produced by a MultiTableBuilder.
+    struct TableFileMeta {
+        std::string fname;
+        uint64_t file_size = 0;
+        uint64_t num_entries = 0;
+        std::string smallest;  // First key in the file.
+        std::string largest;   // Last key in the file.
+    };
+
+    // Creates the files a MultiTableBuilder writes its tables to.
+    // Implementations must be safe to call from several threads at once.
+    class TableFileFactory {
+    public:
+        TableFileFactory() = default;
+
+        TableFileFactory(const TableFileFactory &) = delete;
+
+        TableFileFactory &operator=(const TableFileFactory &) = delete;
+
+        virtual ~TableFileFactory();
+
+        // Creates a new, empty file, stores its name in *fname and the open
+        // file in *file.  The caller closes and deletes *file.
+        virtual Status NewTableFile(std::string *fname, WritableFile **file) = 0;
+    };
+
+    // Returns a factory that names files "<dirname>/<number>.sst" with
+    // consecutive numbers starting at "first_number", and opens them through
+    // env with "env_options".  "env" must outlive the result.
+    TableFileFactory *NewTableFileFactory(Env *env, const std::string &dirname, uint64_t first_number,
+                                          const EnvOptions &env_options = EnvOptions());
+
+    // 按 max_file_size 切分输出文件
+    // Builds a sorted stream of key/value pairs into as many tables as needed
+    // to keep each one around options.max_file_size.  A table is finished,
+    // synced and closed as soon as it reaches the limit, and the next Add()
+    // opens a new file through the factory.
+    //
+    // The cut always falls on a data block boundary: once a table reaches
+    // the limit, it is finished right after the next data block is flushed,
+    // with no partial block pending.  (A filter partition, see
+    // kPartitionedFilter, can push the size over the limit in the middle of
+    // a block.)  Each table thus overshoots the limit by at most about one
+    // block and one filter partition, plus its meta blocks, index block and
+    // footer.
+    //
+    // Not thread-safe; use one builder per thread.
+    class MultiTableBuilder {
+    public:
+        // "factory" must outlive the builder.
+        MultiTableBuilder(const Options &options, TableFileFactory *factory);
+
+        MultiTableBuilder(const MultiTableBuilder &) = delete;
+
+        MultiTableBuilder &operator=(const MultiTableBuilder &) = delete;
+
+        // REQUIRES: Either Finish() or Abandon() has been called.
+        ~MultiTableBuilder();
+
+        // Add key,value to the current table, opening one if needed.
+        // REQUIRES: key is after any previously added key according to comparator.
+        // REQUIRES: Finish(), Abandon() have not been called
+        void Add(const Slice &key, const Slice &value);
+
+        // Return non-ok iff some error has been detected.
+        Status status() const { return status_; }
+
+        // Finish the current table, if any.  Stops using the factory after
+        // this function returns.
+        // REQUIRES: Finish(), Abandon() have not been called
+        Status Finish();
+
+        // Close the current table without finishing it; its file is left
+        // incomplete and is not listed in outputs().
+        // REQUIRES: Finish(), Abandon() have not been called
+        void Abandon();
+
+        // The tables completed so far, in key order.
+        const std::vector<TableFileMeta> &outputs() const { return outputs_; }
+
+        // Number of calls to Add() so far.
+        uint64_t NumEntries() const { return num_entries_; }
+
+    private:
+        bool ok() const { return status().ok(); }
+
+        Status OpenTable();
+
+        Status FinishTable();
+
+        void CloseTable();
+
+        const Options options_;
+        TableFileFactory *const factory_;
+        Status status_;
+        bool closed_;  // Either Finish() or Abandon() has been called.
+        uint64_t num_entries_;
+        std::vector<TableFileMeta> outputs_;
+
+        // The table being built, if any.
+        TableBuilder *builder_;
+        WritableFile *file_;
+        TableFileMeta current_;
+    };
+
+}
+
+#endif //SSTABLE_MULTI_TABLE_BUILDER_H
@@ -0,0 +1,113 @@
+#include "multi_table_builder.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "../util/testutil.h"
+
+namespace leveldb {
+
+    namespace {
+
+        std::string Key(int i) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "key%06d", i);
+            return std::string(buf);
+        }
+
+        std::string Value(int i) { return std::string(50 + i % 100, static_cast<char>('a' + i % 26)); }
+
+    }  // namespace
+
+    class MultiTableBuilderTest : public testing::Test {
+    public:
+        MultiTableBuilderTest() {
+            options_.block_size = 1024;
+            options_.max_file_size = 32 * 1024;
+            options_.compression = kNoCompression;
+            dir_ = test::TempFileName("multi_table_builder_test");
+            options_.env->CreateDir(dir_);
+            factory_.reset(NewTableFileFactory(options_.env, dir_, 1));
+        }
+
+        ~MultiTableBuilderTest() override {
+            std::vector<std::string> children;
+            options_.env->GetChildren(dir_, &children);
+            for (const std::string &child: children) {
+                options_.env->RemoveFile(dir_ + "/" + child);
+            }
+            options_.env->RemoveDir(dir_);
+        }
+
+        Options options_;
+        std::string dir_;
+        std::unique_ptr<TableFileFactory> factory_;
+    };
+
+    TEST_F(MultiTableBuilderTest, SplitsAtMaxFileSize) {
+        MultiTableBuilder builder(options_, factory_.get());
+        const int kNum = 5000;
+        for (int i = 0; i < kNum; i++) {
+            builder.Add(Key(i), Value(i));
+        }
+        ASSERT_TRUE(builder.Finish().ok());
+        ASSERT_EQ(static_cast<uint64_t>(kNum), builder.NumEntries());
+
+        const std::vector<TableFileMeta> &outputs = builder.outputs();
+        ASSERT_GT(outputs.size(), 5u);
+        int next = 0;
+        for (size_t f = 0; f < outputs.size(); f++) {
+            const TableFileMeta &meta = outputs[f];
+            uint64_t size;
+            ASSERT_TRUE(options_.env->GetFileSize(meta.fname, &size).ok());
+            ASSERT_EQ(size, meta.file_size);
+            // 切在块边界上：最多多出大约一个块，加上 index block 和 footer
+            ASSERT_LE(meta.file_size, options_.max_file_size + 2 * options_.block_size + 1024);
+            if (f + 1 < outputs.size()) {
+                ASSERT_GE(meta.file_size, options_.max_file_size);
+            }
+
+            test::KVList entries;
+            ASSERT_TRUE(test::ReadTableFile(options_, meta.fname, &entries).ok());
+            ASSERT_EQ(meta.num_entries, entries.size());
+            ASSERT_EQ(meta.smallest, entries.front().first);
+            ASSERT_EQ(meta.largest, entries.back().first);
+            for (const auto &entry: entries) {
+                ASSERT_EQ(Key(next), entry.first);
+                ASSERT_EQ(Value(next), entry.second);
+                next++;
+            }
+        }
+        ASSERT_EQ(kNum, next);
+    }
+
+    TEST_F(MultiTableBuilderTest, NothingAdded) {
+        MultiTableBuilder builder(options_, factory_.get());
+        ASSERT_TRUE(builder.Finish().ok());
+        ASSERT_TRUE(builder.outputs().empty());
+    }
+
+    TEST_F(MultiTableBuilderTest, AbandonKeepsCompletedTables) {
+        MultiTableBuilder builder(options_, factory_.get());
+        int i = 0;
+        while (builder.outputs().size() < 2) {
+            builder.Add(Key(i), Value(i));
+            i++;
+        }
+        // 再往第三张表里加一些，然后放弃
+        for (int j = 0; j < 10; j++, i++) {
+            builder.Add(Key(i), Value(i));
+        }
+        builder.Abandon();
+        ASSERT_TRUE(builder.status().ok());
+        ASSERT_EQ(2u, builder.outputs().size());
+        for (const TableFileMeta &meta: builder.outputs()) {
+            test::KVList entries;
+            ASSERT_TRUE(test::ReadTableFile(options_, meta.fname, &entries).ok());
+            ASSERT_EQ(meta.num_entries, entries.size());
+        }
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,308 @@
+#include "partitioned_writer.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "../include/comparator.h"
+#include "../include/env.h"
+#include "../port/port_stdcxx.h"
+#include "../port/thread_annotations.h"
+#include "../util/coding.h"
+#include "../util/mutexlock.h"
+
+namespace leveldb {
+
+    // Producers hand key/value pairs to a partition thread in batches of
+    // about this many bytes ...
+    static const size_t kBatchSize = 256 * 1024;
+
+    // ... and block once this many batches are waiting to be built.
+    static const size_t kMaxQueuedBatches = 4;
+
+    std::vector<std::string> ChooseSplitKeys(const Comparator *comparator, std::vector<std::string> samples,
+                                             int num_partitions) {
+        std::sort(samples.begin(), samples.end(), [comparator](const std::string &a, const std::string &b) {
+            return comparator->Compare(a, b) < 0;
+        });
+        std::vector<std::string> split_keys;
+        if (samples.empty()) {
+            return split_keys;
+        }
+        for (int i = 1; i < num_partitions; i++) {
+            const std::string &key = samples[i * samples.size() / num_partitions];
+            if (split_keys.empty() || comparator->Compare(split_keys.back(), key) < 0) {
+                split_keys.push_back(key);
+            }
+        }
+        return split_keys;
+    }
+
+    struct PartitionedTableWriter::Partition {
+        Partition(const Options &options, TableFileFactory *factory)
+                : comparator(options.comparator),
+                  has_begin(false),
+                  has_end(false),
+                  cv(&mu),
+                  done(false),
+                  abandon(false),
+                  running(true),
+                  builder(options, factory) {}
+
+        // Returns true if key belongs to [begin, end).
+        bool Contains(const Slice &key) const {
+            return (!has_begin || comparator->Compare(key, begin) >= 0) &&
+                   (!has_end || comparator->Compare(key, end) < 0);
+        }
+
+        const Comparator *const comparator;
+        bool has_begin;
+        bool has_end;
+        std::string begin;
+        std::string end;
+
+        // Pairs added since the last Submit(); only touched by the producer.
+        std::string staging;
+
+        port::Mutex mu;
+        port::CondVar cv GUARDED_BY(mu);
+        std::deque<std::string *> queue GUARDED_BY(mu);
+        bool done GUARDED_BY(mu);     // No more batches will be queued.
+        bool abandon GUARDED_BY(mu);  // Drop queued batches and the open table.
+        bool running GUARDED_BY(mu);  // The partition thread has not exited.
+        Status status GUARDED_BY(mu);
+
+        // Only used by the partition thread while it runs.
+        MultiTableBuilder builder;
+    };
+
+    PartitionedTableWriter::PartitionedTableWriter(const Options &options,
+                                                   const std::vector<std::string> &split_keys,
+                                                   TableFileFactory *factory)
+            : options_(options), factory_(factory), finished_(false) {
+        partitions_.resize(split_keys.size() + 1);
+        for (size_t i = 0; i < partitions_.size(); i++) {
+            auto *p = new Partition(options_, factory_);
+            if (i > 0) {
+                p->has_begin = true;
+                p->begin = split_keys[i - 1];
+            }
+            if (i < split_keys.size()) {
+                p->has_end = true;
+                p->end = split_keys[i];
+            }
+            partitions_[i] = p;
+            options_.env->StartThread(&PartitionedTableWriter::PartitionThread, p);
+        }
+    }
+
+    PartitionedTableWriter::~PartitionedTableWriter() {
+        for (Partition *p: partitions_) {
+            MutexLock l(&p->mu);
+            if (!finished_) {
+                p->done = true;
+                p->abandon = true;
+                p->cv.SignalAll();
+            }
+            while (p->running) {
+                p->cv.Wait();
+            }
+        }
+        for (Partition *p: partitions_) {
+            for (std::string *batch: p->queue) {
+                delete batch;
+            }
+            delete p;
+        }
+    }
+
+    int PartitionedTableWriter::PartitionFor(const Slice &key) const {
+        // Binary search for the first partition whose end is after key.
+        int left = 0;
+        int right = NumPartitions() - 1;
+        while (left < right) {
+            const int mid = (left + right) / 2;
+            if (options_.comparator->Compare(key, partitions_[mid]->end) < 0) {
+                right = mid;
+            } else {
+                left = mid + 1;
+            }
+        }
+        return left;
+    }
+
+    Status PartitionedTableWriter::Add(int partition, const Slice &key, const Slice &value) {
+        assert(!finished_);
+        assert(partition >= 0 && partition < NumPartitions());
+        Partition *p = partitions_[partition];
+        if (!p->Contains(key)) {
+            return Status::InvalidArgument("key outside of partition range", key);
+        }
+        PutLengthPrefixedSlice(&p->staging, key);
+        PutLengthPrefixedSlice(&p->staging, value);
+        if (p->staging.size() >= kBatchSize) {
+            Submit(p);
+            MutexLock l(&p->mu);
+            return p->status;
+        }
+        return Status::OK();
+    }
+
+    void PartitionedTableWriter::Submit(Partition *p) {
+        auto *batch = new std::string;
+        batch->swap(p->staging);
+        p->staging.reserve(kBatchSize + kBatchSize / 8);
+
+        MutexLock l(&p->mu);
+        while (p->queue.size() >= kMaxQueuedBatches && p->running) {
+            p->cv.Wait();
+        }
+        p->queue.push_back(batch);
+        p->cv.SignalAll();
+    }
+
+    void PartitionedTableWriter::PartitionThread(void *arg) {
+        auto *p = reinterpret_cast<Partition *>(arg);
+        p->mu.Lock();
+        while (true) {
+            while (p->queue.empty() && !p->done) {
+                p->cv.Wait();
+            }
+            if (p->abandon || p->queue.empty()) {
+                break;
+            }
+            std::string *batch = p->queue.front();
+            p->queue.pop_front();
+            p->cv.SignalAll();  // Room for the producer.
+            p->mu.Unlock();
+
+            Slice input(*batch);
+            Slice key, value;
+            while (p->builder.status().ok() && GetLengthPrefixedSlice(&input, &key) &&
+                   GetLengthPrefixedSlice(&input, &value)) {
+                p->builder.Add(key, value);
+            }
+            delete batch;
+
+            p->mu.Lock();
+            if (p->status.ok()) {
+                p->status = p->builder.status();
+            }
+        }
+
+        if (p->abandon) {
+            p->mu.Unlock();
+            p->builder.Abandon();
+            p->mu.Lock();
+        } else {
+            p->mu.Unlock();
+            Status s = p->builder.Finish();
+            p->mu.Lock();
+            if (p->status.ok()) {
+                p->status = s;
+            }
+        }
+        p->running = false;
+        p->cv.SignalAll();
+        p->mu.Unlock();
+    }
+
+    Status PartitionedTableWriter::Finish(const std::string &manifest_fname) {
+        assert(!finished_);
+        finished_ = true;
+        for (Partition *p: partitions_) {
+            if (!p->staging.empty()) {
+                Submit(p);
+            }
+            MutexLock l(&p->mu);
+            p->done = true;
+            p->cv.SignalAll();
+        }
+
+        Status status;
+        manifest_.clear();
+        for (Partition *p: partitions_) {
+            MutexLock l(&p->mu);
+            while (p->running) {
+                p->cv.Wait();
+            }
+            if (status.ok()) {
+                status = p->status;
+            }
+            PartitionMeta meta;
+            meta.begin = p->begin;
+            meta.end = p->end;
+            meta.files = p->builder.outputs();
+            manifest_.push_back(meta);
+        }
+
+        if (status.ok() && !manifest_fname.empty()) {
+            std::string contents;
+            EncodeManifest(manifest_, &contents);
+            WritableFile *file;
+            status = options_.env->NewWritableFile(manifest_fname, &file);
+            if (status.ok()) {
+                status = file->Append(contents);
+                if (status.ok()) {
+                    status = file->Sync();
+                }
+                if (status.ok()) {
+                    status = file->Close();
+                }
+                delete file;
+            }
+        }
+        return status;
+    }
+
+    void PartitionedTableWriter::EncodeManifest(const std::vector<PartitionMeta> &manifest, std::string *dst) {
+        PutVarint32(dst, static_cast<uint32_t>(manifest.size()));
+        for (const PartitionMeta &partition: manifest) {
+            PutLengthPrefixedSlice(dst, partition.begin);
+            PutLengthPrefixedSlice(dst, partition.end);
+            PutVarint32(dst, static_cast<uint32_t>(partition.files.size()));
+            for (const TableFileMeta &file: partition.files) {
+                PutLengthPrefixedSlice(dst, file.fname);
+                PutVarint64(dst, file.file_size);
+                PutVarint64(dst, file.num_entries);
+                PutLengthPrefixedSlice(dst, file.smallest);
+                PutLengthPrefixedSlice(dst, file.largest);
+            }
+        }
+    }
+
+    Status PartitionedTableWriter::DecodeManifest(const Slice &input, std::vector<PartitionMeta> *manifest) {
+        Slice in = input;
+        uint32_t num_partitions;
+        if (!GetVarint32(&in, &num_partitions)) {
+            return Status::Corruption("bad partition manifest");
+        }
+        manifest->clear();
+        for (uint32_t i = 0; i < num_partitions; i++) {
+            PartitionMeta partition;
+            Slice begin, end;
+            uint32_t num_files;
+            if (!GetLengthPrefixedSlice(&in, &begin) || !GetLengthPrefixedSlice(&in, &end) ||
+                !GetVarint32(&in, &num_files)) {
+                return Status::Corruption("bad partition manifest");
+            }
+            partition.begin = begin.ToString();
+            partition.end = end.ToString();
+            for (uint32_t j = 0; j < num_files; j++) {
+                TableFileMeta file;
+                Slice fname, smallest, largest;
+                if (!GetLengthPrefixedSlice(&in, &fname) || !GetVarint64(&in, &file.file_size) ||
+                    !GetVarint64(&in, &file.num_entries) || !GetLengthPrefixedSlice(&in, &smallest) ||
+                    !GetLengthPrefixedSlice(&in, &largest)) {
+                    return Status::Corruption("bad partition manifest");
+                }
+                file.fname = fname.ToString();
+                file.smallest = smallest.ToString();
+                file.largest = largest.ToString();
+                partition.files.push_back(file);
+            }
+            manifest->push_back(partition);
+        }
+        return Status::OK();
+    }
+
+}
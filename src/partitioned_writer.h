@@ -0,0 +1,103 @@
+#ifndef SSTABLE_PARTITIONED_WRITER_H
+#define SSTABLE_PARTITIONED_WRITER_H
+
+#include <string>
+#include <vector>
+
+#include "../include/options.h"
+#include "../include/slice.h"
+#include "../include/status.h"
+#include "multi_table_builder.h"
+
+namespace leveldb {
+
+    class Comparator;
+
+    // One key range of a PartitionedTableWriter and the tables built for it.
+    struct PartitionMeta {
+        std::string begin;  // Inclusive; empty for the first partition.
+        std::string end;    // Exclusive; empty for the last partition.
+        std::vector<TableFileMeta> files;
+    };
+
+    // Returns num_partitions - 1 split keys taken at evenly spaced quantiles
+    // of "samples", for use with PartitionedTableWriter.  May return fewer
+    // when the samples have too few distinct keys.
+    std::vector<std::string> ChooseSplitKeys(const Comparator *comparator, std::vector<std::string> samples,
+                                             int num_partitions);
+
+    // 按 key 范围分区，多线程并行建表
+    // Builds a large sorted data set into non-overlapping tables in parallel.
+    // The key space is cut by split keys s[0] < s[1] < ... < s[N-2] into N
+    // partitions [-inf, s[0]), [s[0], s[1]), ..., [s[N-2], +inf), each built by
+    // its own thread into its own MultiTableBuilder (so a partition may
+    // produce several files when it exceeds options.max_file_size).
+    //
+    // Producers push key/value pairs to a partition with Add(); pairs are
+    // copied into batches that are handed to the partition's thread, so a
+    // producer only waits when the partition falls several batches behind.
+    //
+    // Thread safety: different partitions may be fed concurrently from
+    // different threads, but each partition must have at most one producer
+    // at a time, and its keys must arrive in sorted order.
+    class PartitionedTableWriter {
+    public:
+        // "split_keys" must be sorted by options.comparator and distinct.
+        // "factory" must outlive the writer.
+        PartitionedTableWriter(const Options &options, const std::vector<std::string> &split_keys,
+                               TableFileFactory *factory);
+
+        PartitionedTableWriter(const PartitionedTableWriter &) = delete;
+
+        PartitionedTableWriter &operator=(const PartitionedTableWriter &) = delete;
+
+        // Abandons any partition that was not finished.
+        ~PartitionedTableWriter();
+
+        int NumPartitions() const { return static_cast<int>(partitions_.size()); }
+
+        // Index of the partition whose range contains key.
+        int PartitionFor(const Slice &key) const;
+
+        // Queues key,value for "partition".  Returns a non-ok status if key is
+        // outside the partition's range or the partition already failed.
+        // REQUIRES: key is after any key previously added to this partition.
+        // REQUIRES: Finish() has not been called.
+        Status Add(int partition, const Slice &key, const Slice &value);
+
+        // Waits for every partition to finish its tables.  If "manifest_fname"
+        // is non-empty, also writes the manifest there (see EncodeManifest).
+        // Returns the first error of any partition.
+        Status Finish(const std::string &manifest_fname = std::string());
+
+        // After Finish(): the partitions, in key order.
+        const std::vector<PartitionMeta> &manifest() const { return manifest_; }
+
+        // Manifest encoding:
+        //    varint32 number of partitions, then for each one:
+        //        length-prefixed begin, length-prefixed end,
+        //        varint32 number of files, then for each file:
+        //            length-prefixed fname, varint64 file_size,
+        //            varint64 num_entries, length-prefixed smallest,
+        //            length-prefixed largest
+        static void EncodeManifest(const std::vector<PartitionMeta> &manifest, std::string *dst);
+
+        static Status DecodeManifest(const Slice &input, std::vector<PartitionMeta> *manifest);
+
+    private:
+        struct Partition;
+
+        static void PartitionThread(void *arg);
+
+        void Submit(Partition *partition);
+
+        const Options options_;
+        TableFileFactory *const factory_;
+        std::vector<Partition *> partitions_;
+        std::vector<PartitionMeta> manifest_;
+        bool finished_;
+    };
+
+}
+
+#endif //SSTABLE_PARTITIONED_WRITER_H
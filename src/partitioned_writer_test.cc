@@ -0,0 +1,165 @@
+#include "partitioned_writer.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../include/comparator.h"
+#include "../include/env.h"
+#include "../util/random.h"
+#include "../util/testutil.h"
+
+namespace leveldb {
+
+    namespace {
+
+        std::string Key(int i) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "key%06d", i);
+            return std::string(buf);
+        }
+
+    }  // namespace
+
+    class PartitionedWriterTest : public testing::Test {
+    public:
+        PartitionedWriterTest() {
+            options_.block_size = 1024;
+            options_.max_file_size = 64 * 1024;
+            dir_ = test::TempFileName("partitioned_writer_test");
+            options_.env->CreateDir(dir_);
+            factory_.reset(NewTableFileFactory(options_.env, dir_, 1));
+        }
+
+        ~PartitionedWriterTest() override {
+            std::vector<std::string> children;
+            options_.env->GetChildren(dir_, &children);
+            for (const std::string &child: children) {
+                options_.env->RemoveFile(dir_ + "/" + child);
+            }
+            options_.env->RemoveDir(dir_);
+        }
+
+        Options options_;
+        std::string dir_;
+        std::unique_ptr<TableFileFactory> factory_;
+    };
+
+    TEST(ChooseSplitKeysTest, Quantiles) {
+        std::vector<std::string> samples;
+        Random rnd(301);
+        for (int i = 0; i < 1000; i++) {
+            samples.push_back(Key(rnd.Uniform(100000)));
+        }
+        const std::vector<std::string> split_keys = ChooseSplitKeys(BytewiseComparator(), samples, 8);
+        ASSERT_EQ(7u, split_keys.size());
+        for (size_t i = 1; i < split_keys.size(); i++) {
+            ASSERT_LT(split_keys[i - 1], split_keys[i]);
+        }
+
+        // 只有两个不同的 key 时分不出 8 个区，重复的切分点要去掉
+        samples.assign(500, "b");
+        samples.insert(samples.end(), 500, "a");
+        ASSERT_EQ((std::vector<std::string>{"a", "b"}), ChooseSplitKeys(BytewiseComparator(), samples, 8));
+        ASSERT_TRUE(ChooseSplitKeys(BytewiseComparator(), std::vector<std::string>(), 8).empty());
+    }
+
+    // 每个分区一个生产者线程；读回所有表应该得到全部 key，且分区之间不重叠
+    TEST_F(PartitionedWriterTest, ParallelPartitions) {
+        const int kNum = 40000;
+        const std::vector<std::string> split_keys = {Key(10000), Key(15000), Key(30000)};
+        PartitionedTableWriter writer(options_, split_keys, factory_.get());
+        ASSERT_EQ(4, writer.NumPartitions());
+        ASSERT_EQ(0, writer.PartitionFor(Key(0)));
+        ASSERT_EQ(1, writer.PartitionFor(Key(10000)));
+        ASSERT_EQ(2, writer.PartitionFor(Key(29999)));
+        ASSERT_EQ(3, writer.PartitionFor(Key(kNum)));
+
+        const int bounds[] = {0, 10000, 15000, 30000, kNum};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < 4; p++) {
+            threads.emplace_back([&writer, &bounds, p]() {
+                for (int i = bounds[p]; i < bounds[p + 1]; i++) {
+                    ASSERT_TRUE(writer.Add(p, Key(i), std::string(100, 'a' + p)).ok());
+                }
+            });
+        }
+        for (std::thread &thread: threads) {
+            thread.join();
+        }
+        const std::string manifest_fname = dir_ + "/MANIFEST";
+        ASSERT_TRUE(writer.Finish(manifest_fname).ok());
+
+        const std::vector<PartitionMeta> &manifest = writer.manifest();
+        ASSERT_EQ(4u, manifest.size());
+        ASSERT_EQ("", manifest.front().begin);
+        ASSERT_EQ("", manifest.back().end);
+        int next = 0;
+        for (int p = 0; p < 4; p++) {
+            if (p > 0) {
+                ASSERT_EQ(split_keys[p - 1], manifest[p].begin);
+            }
+            ASSERT_FALSE(manifest[p].files.empty());
+            for (const TableFileMeta &meta: manifest[p].files) {
+                test::KVList entries;
+                ASSERT_TRUE(test::ReadTableFile(options_, meta.fname, &entries).ok());
+                ASSERT_EQ(meta.num_entries, entries.size());
+                for (const auto &entry: entries) {
+                    ASSERT_EQ(Key(next), entry.first);
+                    ASSERT_EQ(std::string(100, 'a' + p), entry.second);
+                    next++;
+                }
+            }
+        }
+        ASSERT_EQ(kNum, next);
+        // 最大的分区超过了 max_file_size，应该切成多个文件
+        ASSERT_GT(manifest[3].files.size(), 1u);
+
+        // 写出去的 manifest 能解回同样的内容
+        std::string contents;
+        ASSERT_TRUE(ReadFileToString(options_.env, manifest_fname, &contents).ok());
+        std::vector<PartitionMeta> decoded;
+        ASSERT_TRUE(PartitionedTableWriter::DecodeManifest(contents, &decoded).ok());
+        ASSERT_EQ(manifest.size(), decoded.size());
+        for (size_t p = 0; p < manifest.size(); p++) {
+            ASSERT_EQ(manifest[p].begin, decoded[p].begin);
+            ASSERT_EQ(manifest[p].end, decoded[p].end);
+            ASSERT_EQ(manifest[p].files.size(), decoded[p].files.size());
+            for (size_t f = 0; f < manifest[p].files.size(); f++) {
+                ASSERT_EQ(manifest[p].files[f].fname, decoded[p].files[f].fname);
+                ASSERT_EQ(manifest[p].files[f].file_size, decoded[p].files[f].file_size);
+                ASSERT_EQ(manifest[p].files[f].num_entries, decoded[p].files[f].num_entries);
+                ASSERT_EQ(manifest[p].files[f].smallest, decoded[p].files[f].smallest);
+                ASSERT_EQ(manifest[p].files[f].largest, decoded[p].files[f].largest);
+            }
+        }
+
+        // 截断的 manifest 都要报 Corruption
+        for (size_t n = 0; n < contents.size(); n += 7) {
+            const Slice truncated(contents.data(), n);
+            ASSERT_TRUE(PartitionedTableWriter::DecodeManifest(truncated, &decoded).IsCorruption()) << n;
+        }
+    }
+
+    TEST_F(PartitionedWriterTest, RejectsKeysOutsidePartition) {
+        PartitionedTableWriter writer(options_, {Key(100)}, factory_.get());
+        ASSERT_TRUE(writer.Add(0, Key(1), "v").ok());
+        ASSERT_FALSE(writer.Add(0, Key(100), "v").ok());
+        ASSERT_FALSE(writer.Add(1, Key(99), "v").ok());
+        ASSERT_TRUE(writer.Add(1, Key(100), "v").ok());
+    }
+
+    TEST_F(PartitionedWriterTest, EmptyPartitions) {
+        PartitionedTableWriter writer(options_, {Key(100), Key(200)}, factory_.get());
+        ASSERT_TRUE(writer.Add(1, Key(150), "v").ok());
+        ASSERT_TRUE(writer.Finish().ok());
+        ASSERT_EQ(3u, writer.manifest().size());
+        ASSERT_TRUE(writer.manifest()[0].files.empty());
+        ASSERT_EQ(1u, writer.manifest()[1].files.size());
+        ASSERT_TRUE(writer.manifest()[2].files.empty());
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,205 @@
+#include "perfect_hash.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "../util/coding.h"
+#include "../util/hash.h"
+
+namespace leveldb {
+
+    // The encoding is
+    //    varint32 num_levels | varint64 bits of each level |
+    //    varint32 value_bits | varint64 num_keys | varint64 num_values |
+    //    fixed64 words of all levels | fixed32 rank per 8 words |
+    //    fixed64 words of packed values
+    namespace {
+
+        // 每层的 bit 数等于到达该层的 key 数：空间约 2.9 bit/key(含 rank 表)，平均约查 1.6 层
+        const double kBitsPerKeyPerLevel = 1.0;
+
+        // Keys still colliding after this many levels are left out.
+        const int kMaxLevels = 32;
+
+        const uint64_t kWordsPerRank = 8;
+
+        uint64_t HashKey(const Slice &key) {
+            return (static_cast<uint64_t>(Hash(key.data(), key.size(), 0x1b873593)) << 32) |
+                   Hash(key.data(), key.size(), 0xcc9e2d51);
+        }
+
+        // The bit a key hashing to "h" picks in a level of "bits" bits.
+        inline uint64_t LevelPosition(uint64_t h, int level, uint64_t bits) {
+            // splitmix64 的混合函数，每层换一个增量
+            uint64_t x = h + static_cast<uint64_t>(level + 1) * 0x9e3779b97f4a7c15ull;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            x ^= x >> 31;
+            // 用乘法代替取模：把高 32 位映射到 [0, bits)
+            return ((x >> 32) * bits) >> 32;
+        }
+
+        inline bool TestBit(const std::vector<uint64_t> &words, uint64_t bit) {
+            return (words[bit / 64] >> (bit % 64)) & 1;
+        }
+
+        inline void SetBit(std::vector<uint64_t> *words, uint64_t bit) {
+            (*words)[bit / 64] |= uint64_t{1} << (bit % 64);
+        }
+
+        // 把 value 写进从 bit 开始的 value_bits 位
+        void PutBits(std::vector<uint64_t> *words, uint64_t bit, int value_bits, uint64_t value) {
+            const uint64_t word = bit / 64;
+            const int shift = static_cast<int>(bit % 64);
+            (*words)[word] |= value << shift;
+            if (shift + value_bits > 64) {
+                (*words)[word + 1] |= value >> (64 - shift);
+            }
+        }
+
+    }  // namespace
+
+    void PerfectHashBuilder::Add(const Slice &key, uint64_t value) {
+        hashes_.push_back(HashKey(key));
+        values_.push_back(value);
+    }
+
+    void PerfectHashBuilder::Finish(int value_bits, std::string *dst) {
+        assert(value_bits > 0 && value_bits <= 64);
+        std::vector<uint64_t> words;
+        std::vector<uint64_t> level_bits;
+        std::vector<std::pair<uint64_t, uint64_t>> placed;  // (global bit, value)
+        placed.reserve(hashes_.size());
+
+        std::vector<uint32_t> remaining(hashes_.size());
+        for (uint32_t i = 0; i < remaining.size(); i++) remaining[i] = i;
+        std::vector<uint32_t> next;
+        for (int level = 0; level < kMaxLevels && !remaining.empty(); level++) {
+            uint64_t bits = static_cast<uint64_t>(remaining.size() * kBitsPerKeyPerLevel) + 63;
+            bits -= bits % 64;
+            std::vector<uint64_t> seen(bits / 64, 0);
+            std::vector<uint64_t> collided(bits / 64, 0);
+            for (uint32_t i: remaining) {
+                const uint64_t pos = LevelPosition(hashes_[i], level, bits);
+                if (TestBit(seen, pos)) {
+                    SetBit(&collided, pos);
+                } else {
+                    SetBit(&seen, pos);
+                }
+            }
+            // 只有独占一个 bit 的 key 留在本层，其余进入下一层
+            const uint64_t start = words.size() * 64;
+            next.clear();
+            for (uint32_t i: remaining) {
+                const uint64_t pos = LevelPosition(hashes_[i], level, bits);
+                if (TestBit(collided, pos)) {
+                    next.push_back(i);
+                } else {
+                    placed.emplace_back(start + pos, values_[i]);
+                }
+            }
+            for (size_t w = 0; w < seen.size(); w++) {
+                words.push_back(seen[w] & ~collided[w]);
+            }
+            level_bits.push_back(bits);
+            remaining.swap(next);
+        }
+
+        std::vector<uint32_t> ranks;
+        uint32_t count = 0;
+        for (size_t w = 0; w < words.size(); w++) {
+            if (w % kWordsPerRank == 0) ranks.push_back(count);
+            count += __builtin_popcountll(words[w]);
+        }
+        assert(count == placed.size());
+
+        // 按 key 的编号(所在 bit 的 rank)排列 value
+        std::sort(placed.begin(), placed.end());
+        std::vector<uint64_t> packed((placed.size() * value_bits + 63) / 64, 0);
+        for (size_t i = 0; i < placed.size(); i++) {
+            PutBits(&packed, i * value_bits, value_bits, placed[i].second);
+        }
+
+        PutVarint32(dst, static_cast<uint32_t>(level_bits.size()));
+        for (uint64_t bits: level_bits) {
+            PutVarint64(dst, bits);
+        }
+        PutVarint32(dst, static_cast<uint32_t>(value_bits));
+        PutVarint64(dst, hashes_.size());
+        PutVarint64(dst, placed.size());
+        for (uint64_t w: words) PutFixed64(dst, w);
+        for (uint32_t r: ranks) PutFixed32(dst, r);
+        for (uint64_t w: packed) PutFixed64(dst, w);
+    }
+
+    bool PerfectHash::Init(const Slice &contents) {
+        Slice input = contents;
+        uint32_t num_levels, value_bits;
+        if (!GetVarint32(&input, &num_levels) || num_levels > kMaxLevels) return false;
+        uint64_t total_bits = 0;
+        level_bits_.clear();
+        level_starts_.clear();
+        for (uint32_t l = 0; l < num_levels; l++) {
+            uint64_t bits;
+            if (!GetVarint64(&input, &bits) || bits == 0 || bits % 64 != 0 || bits > (uint64_t{1} << 40)) {
+                return false;
+            }
+            level_starts_.push_back(total_bits);
+            level_bits_.push_back(bits);
+            total_bits += bits;
+        }
+        if (!GetVarint32(&input, &value_bits) || value_bits == 0 || value_bits > 64 ||
+            !GetVarint64(&input, &num_keys_) || !GetVarint64(&input, &num_values_) ||
+            num_values_ > total_bits || num_values_ > num_keys_) {
+            return false;
+        }
+        value_bits_ = static_cast<int>(value_bits);
+        num_words_ = total_bits / 64;
+        const uint64_t num_ranks = (num_words_ + kWordsPerRank - 1) / kWordsPerRank;
+        const uint64_t num_packed = (num_values_ * value_bits_ + 63) / 64;
+        if (input.size() != num_words_ * 8 + num_ranks * 4 + num_packed * 8) {
+            return false;
+        }
+        words_ = input.data();
+        ranks_ = words_ + num_words_ * 8;
+        values_ = ranks_ + num_ranks * 4;
+        return true;
+    }
+
+    inline uint64_t PerfectHash::Word(uint64_t i) const {
+        return DecodeFixed64(words_ + i * 8);
+    }
+
+    uint64_t PerfectHash::Rank(uint64_t bit) const {
+        const uint64_t word = bit / 64;
+        uint64_t rank = DecodeFixed32(ranks_ + (word / kWordsPerRank) * 4);
+        for (uint64_t w = word - word % kWordsPerRank; w < word; w++) {
+            rank += __builtin_popcountll(Word(w));
+        }
+        return rank + __builtin_popcountll(Word(word) & ((uint64_t{1} << (bit % 64)) - 1));
+    }
+
+    bool PerfectHash::Lookup(const Slice &key, uint64_t *value) const {
+        const uint64_t h = HashKey(key);
+        for (size_t level = 0; level < level_bits_.size(); level++) {
+            const uint64_t bit = level_starts_[level] + LevelPosition(h, static_cast<int>(level), level_bits_[level]);
+            if (((Word(bit / 64) >> (bit % 64)) & 1) == 0) {
+                continue;
+            }
+            const uint64_t index = Rank(bit);
+            if (index >= num_values_) {
+                return false;
+            }
+            const uint64_t first = index * value_bits_;
+            const int shift = static_cast<int>(first % 64);
+            uint64_t v = DecodeFixed64(values_ + (first / 64) * 8) >> shift;
+            if (shift + value_bits_ > 64) {
+                v |= DecodeFixed64(values_ + (first / 64 + 1) * 8) << (64 - shift);
+            }
+            *value = (value_bits_ == 64) ? v : v & ((uint64_t{1} << value_bits_) - 1);
+            return true;
+        }
+        return false;
+    }
+
+}
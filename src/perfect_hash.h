@@ -0,0 +1,84 @@
+#ifndef SSTABLE_PERFECT_HASH_H
+#define SSTABLE_PERFECT_HASH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../include/slice.h"
+
+namespace leveldb {
+
+    // 最小完美哈希：n 个 key 一一映射到 [0, n)，约 3 bit/key，再加每个 key 一个定长的 value
+    //
+    // A minimal perfect hash function over a fixed set of keys, built in
+    // the style of BBHash: level l is a bit array of about as many bits
+    // as keys reach it; a key goes to the bit its level-l hash picks,
+    // and keys that collide there move on to level l + 1.  A key's number
+    // is the rank of its bit among all set bits, so the n keys are numbered
+    // 0..n-1 with under 3 bits per key.  Each number is mapped to a value of
+    // a fixed number of bits, which the caller chooses as small as it can.
+    //
+    // Keys that are not in the set get an arbitrary value or none, so
+    // callers verify the result.  Keys whose 64-bit hashes collide are left
+    // out; Complete() tells whether that happened, since only then may a
+    // lookup miss a key that was added.
+
+    // Collects keys and their values.  Keeps 16 bytes per key in memory.
+    class PerfectHashBuilder {
+    public:
+        PerfectHashBuilder() = default;
+
+        PerfectHashBuilder(const PerfectHashBuilder &) = delete;
+
+        PerfectHashBuilder &operator=(const PerfectHashBuilder &) = delete;
+
+        // REQUIRES: value < 2^value_bits, where value_bits is passed to Finish().
+        void Add(const Slice &key, uint64_t value);
+
+        size_t NumKeys() const { return hashes_.size(); }
+
+        // Appends the hash function and the values, of "value_bits" bits
+        // each, to *dst.
+        void Finish(int value_bits, std::string *dst);
+
+    private:
+        std::vector<uint64_t> hashes_;
+        std::vector<uint64_t> values_;
+    };
+
+    // Reads what PerfectHashBuilder::Finish() wrote.  Refers to the
+    // contents passed to Init(), which must outlive it.  Thread-safe.
+    class PerfectHash {
+    public:
+        PerfectHash() = default;
+
+        // Returns false if "contents" is malformed.
+        bool Init(const Slice &contents);
+
+        // Stores in *value the value of "key", if the key may be in the set.
+        bool Lookup(const Slice &key, uint64_t *value) const;
+
+        // Whether every key added to the builder was placed, so that Lookup()
+        // returning false proves a key is not in the set.
+        bool Complete() const { return num_values_ == num_keys_; }
+
+    private:
+        uint64_t Word(uint64_t i) const;
+
+        uint64_t Rank(uint64_t bit) const;
+
+        std::vector<uint64_t> level_bits_;    // Size of each level, in bits.
+        std::vector<uint64_t> level_starts_;  // First bit of each level.
+        const char *words_ = nullptr;         // All levels, as fixed64 words.
+        uint64_t num_words_ = 0;
+        const char *ranks_ = nullptr;         // Set bits before each 8 words.
+        int value_bits_ = 0;
+        uint64_t num_keys_ = 0;               // Keys added to the builder.
+        uint64_t num_values_ = 0;             // Keys placed.
+        const char *values_ = nullptr;        // Packed values, as fixed64 words.
+    };
+
+}
+
+#endif //SSTABLE_PERFECT_HASH_H
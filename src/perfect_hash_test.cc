@@ -0,0 +1,94 @@
+#include "perfect_hash.h"
+
+#include <cstdio>
+#include <set>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace leveldb {
+
+    namespace {
+
+        std::string Key(int i) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "key%06d", i);
+            return std::string(buf);
+        }
+
+        std::string Build(int num_keys, int value_bits) {
+            PerfectHashBuilder builder;
+            for (int i = 0; i < num_keys; i++) {
+                builder.Add(Key(i), static_cast<uint64_t>(i) & ((uint64_t{1} << value_bits) - 1));
+            }
+            std::string contents;
+            builder.Finish(value_bits, &contents);
+            return contents;
+        }
+
+    }  // namespace
+
+    TEST(PerfectHashTest, Empty) {
+        const std::string contents = Build(0, 1);
+        PerfectHash hash;
+        ASSERT_TRUE(hash.Init(contents));
+        ASSERT_TRUE(hash.Complete());
+        uint64_t value;
+        ASSERT_FALSE(hash.Lookup(Key(0), &value));
+    }
+
+    TEST(PerfectHashTest, RoundTrip) {
+        for (const int value_bits: {1, 7, 20, 64}) {
+            const int n = 10000;
+            const std::string contents = Build(n, value_bits);
+            PerfectHash hash;
+            ASSERT_TRUE(hash.Init(contents));
+            ASSERT_TRUE(hash.Complete());
+            for (int i = 0; i < n; i++) {
+                uint64_t value;
+                ASSERT_TRUE(hash.Lookup(Key(i), &value)) << i;
+                ASSERT_EQ(static_cast<uint64_t>(i) & ((uint64_t{1} << value_bits) - 1), value) << i;
+            }
+        }
+    }
+
+    // 不在集合里的 key 可能查不到，也可能得到某个已有 key 的值，调用方要自己核对
+    TEST(PerfectHashTest, AbsentKeys) {
+        const std::string contents = Build(10000, 16);
+        PerfectHash hash;
+        ASSERT_TRUE(hash.Init(contents));
+        for (int i = 10000; i < 20000; i++) {
+            uint64_t value;
+            if (hash.Lookup(Key(i), &value)) {
+                ASSERT_LT(value, 10000u);
+            }
+        }
+    }
+
+    // 去掉值之后，哈希函数本身(含 rank 表)不到 3 bit/key
+    TEST(PerfectHashTest, BitsPerKey) {
+        const int n = 100000;
+        const std::string contents = Build(n, 1);
+        const double bits_per_key = (contents.size() * 8.0 - n) / n;
+        ASSERT_LT(bits_per_key, 3.0);
+
+        // 每多一个 value bit，每个 key 多一个 bit
+        const std::string wider = Build(n, 11);
+        ASSERT_NEAR(10.0, (wider.size() - contents.size()) * 8.0 / n, 0.01);
+    }
+
+    TEST(PerfectHashTest, RejectsMalformedContents) {
+        const std::string contents = Build(1000, 10);
+        PerfectHash hash;
+        ASSERT_FALSE(hash.Init(Slice()));
+        ASSERT_FALSE(hash.Init(Slice(contents.data(), contents.size() - 1)));
+        ASSERT_FALSE(hash.Init(contents + "x"));
+
+        // 第一个字节是层数
+        std::string corrupt = contents;
+        corrupt[0] = 100;
+        ASSERT_FALSE(hash.Init(corrupt));
+        ASSERT_TRUE(hash.Init(contents));
+    }
+
+}  // namespace leveldb
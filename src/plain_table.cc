@@ -0,0 +1,264 @@
+#include "plain_table.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "../util/coding.h"
+#include "format.h"
+#include "plain_table_builder.h"
+
+namespace leveldb {
+
+    class PlainTable::Iter : public Iterator {
+    public:
+        explicit Iter(const PlainTable *table)
+                : table_(table), offset_(table->data_size_), next_(table->data_size_) {}
+
+        bool Valid() const override { return offset_ < table_->data_size_; }
+
+        void SeekToFirst() override { Position(0); }
+
+        void SeekToLast() override { Unsupported(); }
+
+        void Seek(const Slice &target) override {
+            uint32_t offset;
+            status_ = table_->LowerBound(target, &offset);
+            Position(status_.ok() ? offset : table_->data_size_);
+        }
+
+        void Next() override {
+            assert(Valid());
+            Position(next_);
+        }
+
+        void Prev() override { Unsupported(); }
+
+        Slice key() const override {
+            assert(Valid());
+            return key_;
+        }
+
+        Slice value() const override {
+            assert(Valid());
+            return value_;
+        }
+
+        Status status() const override { return status_; }
+
+    private:
+        void Position(uint32_t offset) {
+            offset_ = offset;
+            if (offset_ < table_->data_size_) {
+                Status s = table_->DecodeRecord(offset_, &key_, &value_, &next_);
+                if (!s.ok()) {
+                    status_ = s;
+                    offset_ = table_->data_size_;
+                }
+            }
+        }
+
+        void Unsupported() {
+            status_ = Status::NotSupported("plain table iterators only move forward");
+            offset_ = table_->data_size_;
+        }
+
+        const PlainTable *const table_;
+        uint32_t offset_;  // Current record; data_size_ if not valid.
+        uint32_t next_;
+        Slice key_;
+        Slice value_;
+        Status status_;
+    };
+
+    Status PlainTable::Open(const Options &options, RandomAccessFile *file, uint64_t file_size,
+                            PlainTable **table) {
+        *table = nullptr;
+        if (file_size < kPlainTableFooterSize) {
+            return Status::Corruption("file is too short to be a plain table");
+        }
+
+        char footer_space[kPlainTableFooterSize];
+        Slice footer;
+        Status s = file->Read(file_size - kPlainTableFooterSize, kPlainTableFooterSize, &footer, footer_space);
+        if (!s.ok()) return s;
+        if (footer.size() != kPlainTableFooterSize ||
+            DecodeFixed64(footer.data() + kPlainTableFooterSize - 8) != kPlainTableMagicNumber) {
+            return Status::Corruption("not a plain table (bad magic number)");
+        }
+        const uint64_t data_size = DecodeFixed64(footer.data());
+        const uint64_t num_entries = DecodeFixed64(footer.data() + 8);
+        const uint32_t num_buckets = DecodeFixed32(footer.data() + 16);
+        const uint32_t prefix_length = DecodeFixed32(footer.data() + 20);
+        const uint32_t index_sparseness = DecodeFixed32(footer.data() + 24);
+        const uint64_t index_size = file_size - kPlainTableFooterSize;
+        if (data_size >= kPlainTableSubIndexFlag || num_buckets == 0 || index_sparseness == 0 ||
+            data_size + uint64_t{num_buckets} * 4 > index_size ||
+            index_size - data_size - uint64_t{num_buckets} * 4 >= kPlainTableSubIndexFlag) {
+            return Status::Corruption("bad plain table footer");
+        }
+
+        BlockContents contents;
+        s = ReadFileContents(file, file_size, &contents);
+        if (!s.ok()) return s;
+
+        auto *t = new PlainTable;
+        t->data_ = contents.data.data();
+        t->owned_ = contents.heap_allocated ? t->data_ : nullptr;
+        t->data_size_ = static_cast<uint32_t>(data_size);
+        t->buckets_ = t->data_ + data_size;
+        t->num_buckets_ = num_buckets;
+        t->sub_indexes_ = t->buckets_ + uint64_t{num_buckets} * 4;
+        t->sub_indexes_size_ = static_cast<uint32_t>(index_size - data_size - uint64_t{num_buckets} * 4);
+        t->num_entries_ = num_entries;
+        t->prefix_length_ = prefix_length;
+        t->index_sparseness_ = index_sparseness;
+
+        if (options.paranoid_checks) {
+            // 逐条解码，确认记录区完整
+            uint64_t n = 0;
+            Slice key, value;
+            for (uint32_t offset = 0; s.ok() && offset < t->data_size_; n++) {
+                s = t->DecodeRecord(offset, &key, &value, &offset);
+            }
+            if (s.ok() && n != num_entries) {
+                s = Status::Corruption("plain table entry count mismatch");
+            }
+            if (!s.ok()) {
+                delete t;
+                return s;
+            }
+        }
+        *table = t;
+        return Status::OK();
+    }
+
+    PlainTable::~PlainTable() { delete[] owned_; }
+
+    Slice PlainTable::PrefixOf(const Slice &key) const {
+        return Slice(key.data(), std::min<size_t>(key.size(), prefix_length_));
+    }
+
+    Status PlainTable::DecodeRecord(uint32_t offset, Slice *key, Slice *value, uint32_t *next) const {
+        assert(offset < data_size_);
+        const char *limit = data_ + data_size_;
+        const char *p = data_ + offset;
+        uint32_t key_length, value_length;
+        if ((p = GetVarint32Ptr(p, limit, &key_length)) == nullptr ||
+            static_cast<uint32_t>(limit - p) < key_length) {
+            return Status::Corruption("bad plain table record");
+        }
+        *key = Slice(p, key_length);
+        p += key_length;
+        if ((p = GetVarint32Ptr(p, limit, &value_length)) == nullptr ||
+            static_cast<uint32_t>(limit - p) < value_length) {
+            return Status::Corruption("bad plain table record");
+        }
+        *value = Slice(p, value_length);
+        *next = static_cast<uint32_t>(p + value_length - data_);
+        return Status::OK();
+    }
+
+    Status PlainTable::ScanFrom(uint32_t offset, const Slice &target, uint32_t *result) const {
+        Slice key, value;
+        uint32_t next;
+        // 采样点之间最多 index_sparseness_ 条记录，再往后一条必然 >= target
+        for (uint32_t i = 0; i <= index_sparseness_ && offset < data_size_; i++) {
+            Status s = DecodeRecord(offset, &key, &value, &next);
+            if (!s.ok()) return s;
+            if (key.compare(target) >= 0) break;
+            offset = next;
+        }
+        *result = offset;
+        return Status::OK();
+    }
+
+    Status PlainTable::LowerBound(const Slice &target, uint32_t *offset) const {
+        *offset = data_size_;
+        const Slice prefix = PrefixOf(target);
+        const uint32_t bucket = DecodeFixed32(buckets_ + (PlainTablePrefixHash(prefix) % num_buckets_) * 4);
+        if (bucket == kPlainTableEmptyBucket) {
+            return Status::OK();
+        }
+
+        Slice key, value;
+        uint32_t next;
+        Status s;
+        if ((bucket & kPlainTableSubIndexFlag) == 0) {
+            // 桶里只有一个短前缀，bucket 就是它第一条记录的偏移
+            if (bucket >= data_size_) {
+                return Status::Corruption("bad plain table bucket");
+            }
+            s = DecodeRecord(bucket, &key, &value, &next);
+            if (!s.ok() || PrefixOf(key) != prefix) return s;
+            return ScanFrom(bucket, target, offset);
+        }
+
+        const uint32_t position = bucket & ~kPlainTableSubIndexFlag;
+        const char *limit = sub_indexes_ + sub_indexes_size_;
+        const char *samples = sub_indexes_ + position;
+        uint32_t n = 0;
+        if (position >= sub_indexes_size_ ||
+            (samples = GetVarint32Ptr(samples, limit, &n)) == nullptr || n == 0 ||
+            static_cast<uint32_t>(limit - samples) / 4 < n) {
+            return Status::Corruption("bad plain table sub-index");
+        }
+
+        // 二分找到第一个 key > target 的采样点
+        uint32_t left = 0;
+        uint32_t right = n;
+        while (left < right) {
+            const uint32_t mid = left + (right - left) / 2;
+            const uint32_t sample = DecodeFixed32(samples + mid * 4);
+            if (sample >= data_size_) {
+                return Status::Corruption("bad plain table sub-index");
+            }
+            s = DecodeRecord(sample, &key, &value, &next);
+            if (!s.ok()) return s;
+            if (key.compare(target) <= 0) {
+                left = mid + 1;
+            } else {
+                right = mid;
+            }
+        }
+
+        // 桶里可能有别的前缀：target 落在它自己前缀的某个采样点之后，
+        // 或者早于它前缀的第一条记录
+        if (left > 0) {
+            const uint32_t sample = DecodeFixed32(samples + (left - 1) * 4);
+            s = DecodeRecord(sample, &key, &value, &next);
+            if (!s.ok()) return s;
+            if (PrefixOf(key) == prefix) {
+                return ScanFrom(sample, target, offset);
+            }
+        }
+        if (left < n) {
+            const uint32_t sample = DecodeFixed32(samples + left * 4);
+            s = DecodeRecord(sample, &key, &value, &next);
+            if (!s.ok()) return s;
+            if (PrefixOf(key) == prefix) {
+                *offset = sample;
+            }
+        }
+        return Status::OK();
+    }
+
+    Iterator *PlainTable::NewIterator(const ReadOptions &) const {
+        return new Iter(this);
+    }
+
+    Status PlainTable::InternalGet(const ReadOptions &, const Slice &key,
+                                   void (*handle_result)(const Slice &k, const Slice &v)) const {
+        uint32_t offset;
+        Status s = LowerBound(key, &offset);
+        if (s.ok() && offset < data_size_) {
+            Slice found, value;
+            uint32_t next;
+            s = DecodeRecord(offset, &found, &value, &next);
+            if (s.ok() && found == key) {
+                (*handle_result)(found, value);
+            }
+        }
+        return s;
+    }
+
+}
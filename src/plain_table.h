@@ -0,0 +1,83 @@
+#ifndef SSTABLE_PLAIN_TABLE_H
+#define SSTABLE_PLAIN_TABLE_H
+
+#include <cstdint>
+
+#include "../include/env.h"
+#include "../include/iterator.h"
+#include "../include/options.h"
+#include "../include/status.h"
+
+namespace leveldb {
+
+    // 平铺格式的只读表：一次哈希探测 + 少量 memcmp 完成点查
+    // Reads tables written by PlainTableBuilder.  Keys and values are used
+    // in place: on a file from the default Env (which maps files with mmap()
+    // while it has mmap regions left) nothing is copied, decoded or
+    // checksummed.  Other files are read into memory once, at Open().
+    //
+    // Lookups find a key only if its prefix is in the table; see
+    // Options::plain_table_prefix_length.
+    //
+    // Safe for concurrent use.
+    class PlainTable {
+    public:
+        // The layout is read from the file; of "options" only
+        // paranoid_checks is used, to decode every record up front.
+        // "file" must outlive the table.
+        static Status Open(const Options &options, RandomAccessFile *file, uint64_t file_size, PlainTable **table);
+
+        PlainTable(const PlainTable &) = delete;
+
+        PlainTable &operator=(const PlainTable &) = delete;
+
+        // Does not close or delete the file passed to Open().
+        ~PlainTable();
+
+        // Returns an iterator that supports SeekToFirst(), Next() and Seek().
+        // Seek() positions at the first key at or past the target if the
+        // target's prefix is in the table, and is invalid otherwise.  The
+        // iterator can not move backwards: SeekToLast() and Prev() make it
+        // invalid with a NotSupported status.
+        Iterator *NewIterator(const ReadOptions &) const;
+
+        // Calls handle_result with the entry whose key equals "key", if any.
+        Status InternalGet(const ReadOptions &, const Slice &key,
+                           void (*handle_result)(const Slice &k, const Slice &v)) const;
+
+        uint64_t NumEntries() const { return num_entries_; }
+
+    private:
+        class Iter;
+
+        PlainTable() = default;
+
+        Slice PrefixOf(const Slice &key) const;
+
+        // Decodes the record at "offset" and stores the offset of the next
+        // record in *next.  REQUIRES: offset < data_size_.
+        Status DecodeRecord(uint32_t offset, Slice *key, Slice *value, uint32_t *next) const;
+
+        // Stores in *offset the first record at or past "target" if the
+        // target's prefix is in the table, or data_size_ otherwise.
+        Status LowerBound(const Slice &target, uint32_t *offset) const;
+
+        // Scans at most index_sparseness_ + 1 records from "offset" for the
+        // first one at or past "target".
+        Status ScanFrom(uint32_t offset, const Slice &target, uint32_t *result) const;
+
+        const char *data_ = nullptr;         // The whole file.
+        const char *owned_ = nullptr;        // data_, if read into memory.
+        uint32_t data_size_ = 0;             // Size of the records.
+        const char *buckets_ = nullptr;
+        uint32_t num_buckets_ = 0;
+        const char *sub_indexes_ = nullptr;
+        uint32_t sub_indexes_size_ = 0;
+        uint64_t num_entries_ = 0;
+        uint32_t prefix_length_ = 0;
+        uint32_t index_sparseness_ = 0;
+    };
+
+}
+
+#endif //SSTABLE_PLAIN_TABLE_H
@@ -0,0 +1,146 @@
+#include "plain_table_builder.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "../include/comparator.h"
+#include "../util/coding.h"
+#include "format.h"
+
+namespace leveldb {
+
+    namespace {
+        // Record and sub-index offsets must fit below kPlainTableSubIndexFlag.
+        const uint64_t kMaxPlainTableOffset = kPlainTableSubIndexFlag - 1;
+    }
+
+    PlainTableBuilder::PlainTableBuilder(const Options &options, WritableFile *file)
+            : options_(options),
+              index_sparseness_(static_cast<uint32_t>(std::max(options.plain_table_index_sparseness, 1))),
+              file_(file),
+              offset_(0),
+              num_entries_(0),
+              finished_(false) {
+        // 前缀相同的 key 必须连续，只有按字节序才能保证
+        if (options.comparator != BytewiseComparator()) {
+            status_ = Status::InvalidArgument("plain tables require the bytewise comparator");
+        }
+    }
+
+    PlainTableBuilder::~PlainTableBuilder() = default;
+
+    Slice PlainTableBuilder::PrefixOf(const Slice &key) const {
+        return Slice(key.data(), std::min(key.size(), options_.plain_table_prefix_length));
+    }
+
+    void PlainTableBuilder::Add(const Slice &key, const Slice &value) {
+        assert(!finished_);
+        if (!ok()) return;
+        if (num_entries_ > 0 && key.compare(Slice(last_key_)) <= 0) {
+            status_ = Status::InvalidArgument("keys added to a plain table out of order", key);
+            return;
+        }
+
+        record_.clear();
+        PutVarint32(&record_, static_cast<uint32_t>(key.size()));
+        record_.append(key.data(), key.size());
+        PutVarint32(&record_, static_cast<uint32_t>(value.size()));
+        record_.append(value.data(), value.size());
+        if (offset_ + record_.size() > kMaxPlainTableOffset) {
+            status_ = Status::InvalidArgument("plain table records exceed 2GB");
+            return;
+        }
+
+        // 新前缀开始一个新的 run；每 index_sparseness 条记录采样一个偏移
+        const Slice prefix = PrefixOf(key);
+        if (num_entries_ == 0 || prefix != PrefixOf(Slice(last_key_))) {
+            prefixes_.push_back(PrefixRun{PlainTablePrefixHash(prefix),
+                                          static_cast<uint32_t>(samples_.size()), 0});
+        }
+        PrefixRun &run = prefixes_.back();
+        if (run.num_records % index_sparseness_ == 0) {
+            samples_.push_back(static_cast<uint32_t>(offset_));
+        }
+        run.num_records++;
+
+        status_ = file_->Append(record_);
+        if (!ok()) return;
+        offset_ += record_.size();
+        num_entries_++;
+        last_key_.assign(key.data(), key.size());
+    }
+
+    Status PlainTableBuilder::Finish() {
+        assert(!finished_);
+        finished_ = true;
+        if (!ok()) return status_;
+
+        // 装载率约 75%，空表也保留一个桶
+        const uint32_t num_buckets = std::max<uint32_t>(1, static_cast<uint32_t>(prefixes_.size() * 4 / 3));
+
+        // 按桶分组，同一个桶里的前缀保持 key 的顺序
+        std::vector<uint32_t> bucket_start(num_buckets + 1, 0);
+        for (const PrefixRun &run: prefixes_) {
+            bucket_start[run.hash % num_buckets + 1]++;
+        }
+        for (uint32_t b = 0; b < num_buckets; b++) {
+            bucket_start[b + 1] += bucket_start[b];
+        }
+        std::vector<uint32_t> by_bucket(prefixes_.size());
+        std::vector<uint32_t> fill(bucket_start.begin(), bucket_start.end() - 1);
+        for (uint32_t i = 0; i < prefixes_.size(); i++) {
+            by_bucket[fill[prefixes_[i].hash % num_buckets]++] = i;
+        }
+
+        std::string buckets;
+        std::string sub_indexes;
+        buckets.reserve(num_buckets * sizeof(uint32_t));
+        for (uint32_t b = 0; b < num_buckets; b++) {
+            const uint32_t first = bucket_start[b];
+            const uint32_t last = bucket_start[b + 1];
+            if (first == last) {
+                PutFixed32(&buckets, kPlainTableEmptyBucket);
+                continue;
+            }
+            const PrefixRun &only = prefixes_[by_bucket[first]];
+            if (last - first == 1 && only.num_records <= index_sparseness_) {
+                // 单个短前缀：直接指向它的第一条记录
+                PutFixed32(&buckets, samples_[only.first_sample]);
+                continue;
+            }
+            if (sub_indexes.size() > kMaxPlainTableOffset) {
+                return status_ = Status::InvalidArgument("plain table index exceeds 2GB");
+            }
+            PutFixed32(&buckets, kPlainTableSubIndexFlag | static_cast<uint32_t>(sub_indexes.size()));
+            uint32_t n = 0;
+            for (uint32_t i = first; i < last; i++) {
+                n += (prefixes_[by_bucket[i]].num_records + index_sparseness_ - 1) / index_sparseness_;
+            }
+            PutVarint32(&sub_indexes, n);
+            for (uint32_t i = first; i < last; i++) {
+                const PrefixRun &run = prefixes_[by_bucket[i]];
+                const uint32_t num_samples = (run.num_records + index_sparseness_ - 1) / index_sparseness_;
+                for (uint32_t s = 0; s < num_samples; s++) {
+                    PutFixed32(&sub_indexes, samples_[run.first_sample + s]);
+                }
+            }
+        }
+
+        std::string footer;
+        PutFixed64(&footer, offset_);
+        PutFixed64(&footer, num_entries_);
+        PutFixed32(&footer, num_buckets);
+        PutFixed32(&footer, static_cast<uint32_t>(options_.plain_table_prefix_length));
+        PutFixed32(&footer, index_sparseness_);
+        PutFixed64(&footer, kPlainTableMagicNumber);
+        assert(footer.size() == kPlainTableFooterSize);
+
+        for (const std::string *part: {&buckets, &sub_indexes, &footer}) {
+            status_ = file_->Append(*part);
+            if (!ok()) return status_;
+            offset_ += part->size();
+        }
+        return status_ = file_->Flush();
+    }
+
+}
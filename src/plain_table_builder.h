@@ -0,0 +1,103 @@
+#ifndef SSTABLE_PLAIN_TABLE_BUILDER_H
+#define SSTABLE_PLAIN_TABLE_BUILDER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../include/env.h"
+#include "../include/options.h"
+#include "../include/slice.h"
+#include "../include/status.h"
+#include "../util/hash.h"
+
+namespace leveldb {
+
+    // 面向内存文件系统(tmpfs)的平铺格式：没有 block、压缩和校验，查找时直接在映射内存上比较
+    //
+    // A plain table is laid out as
+    //    records | buckets | sub-indexes | footer
+    // Records are
+    //    varint32 key_length | key | varint32 value_length | value
+    // in key order, with no compression, checksums or block boundaries, so a
+    // reader can use keys and values right where the file is mapped.
+    //
+    // Keys are grouped by prefix (Options::plain_table_prefix_length).  Each
+    // prefix hashes to one of num_buckets fixed32 buckets, which holds
+    //    kPlainTableEmptyBucket            no prefix hashes here;
+    //    a record offset                   the bucket has a single prefix of
+    //                                      at most index_sparseness records,
+    //                                      which starts at this record;
+    //    kPlainTableSubIndexFlag | offset  the sub-index at this offset past
+    //                                      the end of the buckets.
+    // A sub-index is
+    //    varint32 n | fixed32 record offset * n
+    // listing every index_sparseness-th record of each prefix in the bucket,
+    // in key order.  The footer is
+    //    fixed64 records size | fixed64 num_entries | fixed32 num_buckets |
+    //    fixed32 prefix_length | fixed32 index_sparseness | fixed64 magic
+    //
+    // Records may take up to 2GB so that offsets fit in a bucket.
+    static const uint32_t kPlainTableEmptyBucket = 0xffffffffu;
+    static const uint32_t kPlainTableSubIndexFlag = 1u << 31;
+    static const size_t kPlainTableFooterSize = 8 + 8 + 4 + 4 + 4 + 8;
+
+    inline uint32_t PlainTablePrefixHash(const Slice &prefix) {
+        return Hash(prefix.data(), prefix.size(), 0x9e3779b9);
+    }
+
+    // Builds a plain table from keys added in increasing order.  Requires
+    // the bytewise comparator, which keeps the keys of a prefix together.
+    // Not thread-safe.
+    class PlainTableBuilder {
+    public:
+        // Does not take ownership of "file".
+        PlainTableBuilder(const Options &options, WritableFile *file);
+
+        PlainTableBuilder(const PlainTableBuilder &) = delete;
+
+        PlainTableBuilder &operator=(const PlainTableBuilder &) = delete;
+
+        ~PlainTableBuilder();
+
+        // REQUIRES: key is after any previously added key; Finish() not called.
+        void Add(const Slice &key, const Slice &value);
+
+        // Writes the hash index and the footer.  Does not sync the file.
+        Status Finish();
+
+        Status status() const { return status_; }
+
+        uint64_t NumEntries() const { return num_entries_; }
+
+        uint64_t FileSize() const { return offset_; }
+
+    private:
+        // A run of records sharing a prefix.  Its samples, the offsets of
+        // every index_sparseness-th record, are samples_[first_sample, ...).
+        struct PrefixRun {
+            uint32_t hash;
+            uint32_t first_sample;
+            uint32_t num_records;
+        };
+
+        Slice PrefixOf(const Slice &key) const;
+
+        bool ok() const { return status_.ok(); }
+
+        const Options options_;
+        const uint32_t index_sparseness_;
+        WritableFile *const file_;
+        Status status_;
+        uint64_t offset_;
+        uint64_t num_entries_;
+        bool finished_;
+        std::string last_key_;
+        std::string record_;
+        std::vector<PrefixRun> prefixes_;
+        std::vector<uint32_t> samples_;
+    };
+
+}
+
+#endif //SSTABLE_PLAIN_TABLE_BUILDER_H
@@ -0,0 +1,207 @@
+#include "plain_table.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "plain_table_builder.h"
+#include "../util/testutil.h"
+
+namespace leveldb {
+
+    namespace {
+
+        // 前 8 字节是前缀：每个前缀下有 (p % 40) + 1 个 key
+        std::string Key(int prefix, int i) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "pfx%05d-%04d", prefix, i);
+            return std::string(buf);
+        }
+
+        int RecordsOf(int prefix) { return prefix % 40 + 1; }
+
+        std::string Value(int prefix, int i) { return std::to_string(prefix * 10000 + i); }
+
+        std::string found_value;
+
+        void SaveValue(const Slice &, const Slice &v) { found_value = v.ToString(); }
+
+    }  // namespace
+
+    // 偶数前缀写进表里，奇数前缀不在表里
+    class PlainTableTest : public testing::TestWithParam<int> {
+    public:
+        PlainTableTest() : env_(Env::Default()), file_(nullptr), table_(nullptr) {
+            options_.plain_table_prefix_length = 8;
+            options_.plain_table_index_sparseness = GetParam();
+            fname_ = test::TempFileName("plain_table_test.sst");
+        }
+
+        ~PlainTableTest() override {
+            Close();
+            env_->RemoveFile(fname_);
+        }
+
+        void Build(int num_prefixes) {
+            WritableFile *file;
+            ASSERT_TRUE(env_->NewWritableFile(fname_, &file).ok());
+            {
+                PlainTableBuilder builder(options_, file);
+                for (int p = 0; p < num_prefixes; p += 2) {
+                    for (int i = 0; i < RecordsOf(p); i++) {
+                        builder.Add(Key(p, i), Value(p, i));
+                    }
+                }
+                ASSERT_TRUE(builder.Finish().ok());
+                num_entries_ = builder.NumEntries();
+            }
+            ASSERT_TRUE(file->Close().ok());
+            delete file;
+        }
+
+        Status Open() {
+            Close();
+            uint64_t size;
+            EXPECT_TRUE(env_->GetFileSize(fname_, &size).ok());
+            EXPECT_TRUE(env_->NewRandomAccessFile(fname_, &file_).ok());
+            return PlainTable::Open(options_, file_, size, &table_);
+        }
+
+        void Close() {
+            delete table_;
+            table_ = nullptr;
+            delete file_;
+            file_ = nullptr;
+        }
+
+        void CorruptByte(uint64_t offset, char c) {
+            std::FILE *f = std::fopen(fname_.c_str(), "r+b");
+            ASSERT_TRUE(f != nullptr);
+            std::fseek(f, static_cast<long>(offset), SEEK_SET);
+            std::fputc(c, f);
+            std::fclose(f);
+        }
+
+        Env *env_;
+        Options options_;
+        std::string fname_;
+        uint64_t num_entries_ = 0;
+        RandomAccessFile *file_;
+        PlainTable *table_;
+    };
+
+    TEST_P(PlainTableTest, RoundTrip) {
+        Build(200);
+        ASSERT_TRUE(Open().ok());
+        ASSERT_EQ(num_entries_, table_->NumEntries());
+
+        Iterator *iter = table_->NewIterator(ReadOptions());
+        uint64_t n = 0;
+        int p = 0;
+        int i = 0;
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), n++) {
+            ASSERT_EQ(Key(p, i), iter->key().ToString());
+            ASSERT_EQ(Value(p, i), iter->value().ToString());
+            if (++i == RecordsOf(p)) {
+                p += 2;
+                i = 0;
+            }
+        }
+        ASSERT_TRUE(iter->status().ok());
+        ASSERT_EQ(num_entries_, n);
+        delete iter;
+    }
+
+    TEST_P(PlainTableTest, Lookups) {
+        Build(200);
+        ASSERT_TRUE(Open().ok());
+        for (int p = 0; p < 200; p++) {
+            for (int i = 0; i <= RecordsOf(p); i++) {
+                found_value = "none";
+                ASSERT_TRUE(table_->InternalGet(ReadOptions(), Key(p, i), SaveValue).ok());
+                const bool present = (p % 2 == 0 && i < RecordsOf(p));
+                ASSERT_EQ(present ? Value(p, i) : "none", found_value) << Key(p, i);
+            }
+        }
+    }
+
+    TEST_P(PlainTableTest, SeekWithinPrefix) {
+        Build(200);
+        ASSERT_TRUE(Open().ok());
+        Iterator *iter = table_->NewIterator(ReadOptions());
+
+        // 前缀内的空隙：落到下一个 key
+        iter->Seek(Key(38, 5) + "x");
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Key(38, 6), iter->key().ToString());
+        iter->Next();
+        ASSERT_EQ(Key(38, 7), iter->key().ToString());
+
+        // 越过前缀的最后一个 key：落到下一个前缀
+        iter->Seek(Key(38, RecordsOf(38)));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Key(40, 0), iter->key().ToString());
+
+        // 不在表里的前缀
+        iter->Seek(Key(39, 0));
+        ASSERT_FALSE(iter->Valid());
+        ASSERT_TRUE(iter->status().ok());
+
+        iter->SeekToFirst();
+        iter->Prev();
+        ASSERT_FALSE(iter->Valid());
+        ASSERT_TRUE(iter->status().IsNotSupportedError());
+        delete iter;
+    }
+
+    TEST_P(PlainTableTest, KeysOutOfOrder) {
+        WritableFile *file;
+        ASSERT_TRUE(env_->NewWritableFile(fname_, &file).ok());
+        {
+            PlainTableBuilder builder(options_, file);
+            builder.Add(Key(2, 0), "v");
+            builder.Add(Key(1, 0), "v");
+            ASSERT_TRUE(builder.status().IsInvalidArgument());
+        }
+        delete file;
+    }
+
+    TEST_P(PlainTableTest, BadFooter) {
+        Build(20);
+        uint64_t size;
+        ASSERT_TRUE(env_->GetFileSize(fname_, &size).ok());
+
+        // magic number 在文件最后
+        CorruptByte(size - 1, 'X');
+        ASSERT_TRUE(Open().IsCorruption());
+
+        // 太短，连 footer 都放不下
+        RandomAccessFile *file;
+        ASSERT_TRUE(env_->NewRandomAccessFile(fname_, &file).ok());
+        PlainTable *table;
+        ASSERT_TRUE(PlainTable::Open(options_, file, kPlainTableFooterSize - 1, &table).IsCorruption());
+        delete file;
+    }
+
+    // 记录区坏了：paranoid_checks 打开时 Open() 就能发现，否则读到时报错
+    TEST_P(PlainTableTest, CorruptRecord) {
+        Build(20);
+        // 第一条记录的 key 长度改成超出记录区的 varint
+        CorruptByte(0, '\xff');
+        options_.paranoid_checks = true;
+        ASSERT_TRUE(Open().IsCorruption());
+
+        options_.paranoid_checks = false;
+        ASSERT_TRUE(Open().ok());
+        Iterator *iter = table_->NewIterator(ReadOptions());
+        iter->SeekToFirst();
+        ASSERT_FALSE(iter->Valid());
+        ASSERT_TRUE(iter->status().IsCorruption());
+        delete iter;
+    }
+
+    // 索引稀疏度 1 时每条记录都有索引；16 时大的前缀用 sub-index
+    INSTANTIATE_TEST_SUITE_P(Sparseness, PlainTableTest, testing::Values(1, 4, 16));
+
+}  // namespace leveldb
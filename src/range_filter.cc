@@ -0,0 +1,285 @@
+#include "range_filter.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "../util/coding.h"
+
+namespace leveldb {
+
+    // The filter is
+    //    varint64 num_labels | varint64 num_nodes | labels |
+    //    has_child bits | louds bits | prefix_key bits
+    // with the labels of all nodes in level order.  Bits are
+    //    varint64 size | varint64 ones | fixed64 words |
+    //    fixed32 ones before every 512 bits | [fixed32 position of every 64th one]
+    // where only the louds bits carry select samples.
+
+    namespace {
+        const uint64_t kWordsPerRank = 8;
+        const uint64_t kOnesPerSelect = 64;
+
+        // 区分前后 key 所需的前缀之外再多存这么多字节，以降低误判率
+        const size_t kSuffixBytes = 1;
+
+        size_t SharedLength(const Slice &a, const Slice &b) {
+            const size_t n = std::min(a.size(), b.size());
+            size_t i = 0;
+            while (i < n && a[i] == b[i]) i++;
+            return i;
+        }
+
+        void PutBits(std::string *dst, const std::vector<bool> &bits, bool with_select) {
+            std::vector<uint64_t> words((bits.size() + 63) / 64, 0);
+            std::vector<uint32_t> selects;
+            uint64_t ones = 0;
+            for (size_t i = 0; i < bits.size(); i++) {
+                if (!bits[i]) continue;
+                words[i / 64] |= uint64_t{1} << (i % 64);
+                if (ones % kOnesPerSelect == 0) selects.push_back(static_cast<uint32_t>(i));
+                ones++;
+            }
+            PutVarint64(dst, bits.size());
+            PutVarint64(dst, ones);
+            for (uint64_t w: words) PutFixed64(dst, w);
+            uint32_t rank = 0;
+            for (size_t w = 0; w < words.size(); w++) {
+                if (w % kWordsPerRank == 0) PutFixed32(dst, rank);
+                rank += __builtin_popcountll(words[w]);
+            }
+            if (with_select) {
+                for (uint32_t pos: selects) PutFixed32(dst, pos);
+            }
+        }
+    }  // namespace
+
+    RangeFilterBuilder::RangeFilterBuilder() : has_pending_(false), pending_shared_(0), empty_(true) {}
+
+    void RangeFilterBuilder::AddKey(const Slice &key) {
+        if (!has_pending_) {
+            pending_.assign(key.data(), key.size());
+            has_pending_ = true;
+            return;
+        }
+        assert(Slice(pending_).compare(key) <= 0);
+        if (key == Slice(pending_)) return;
+        // 只保留能和前后两个 key 区分开的最短前缀
+        const size_t shared = SharedLength(pending_, key);
+        const size_t length = std::min(std::max(pending_shared_, shared) + 1 + kSuffixBytes, pending_.size());
+        Insert(Slice(pending_.data(), length));
+        pending_shared_ = shared;
+        pending_.assign(key.data(), key.size());
+    }
+
+    void RangeFilterBuilder::AppendLabel(size_t level, char label, bool first_in_node) {
+        if (levels_.size() <= level) levels_.resize(level + 1);
+        Level &l = levels_[level];
+        l.labels.push_back(label);
+        l.has_child.push_back(false);
+        l.louds.push_back(first_in_node);
+    }
+
+    void RangeFilterBuilder::Insert(const Slice &prefix) {
+        size_t shared;
+        if (empty_) {
+            // 根节点
+            levels_.resize(1);
+            levels_[0].prefix_key.push_back(prefix.empty());
+            empty_ = false;
+            shared = 0;
+            if (!prefix.empty()) AppendLabel(0, prefix[0], true);
+        } else {
+            // 截断后的 key 有序、互不相同，只有整个 key 才可能是下一个的前缀
+            shared = SharedLength(last_prefix_, prefix);
+            assert(shared < prefix.size());
+            if (shared < last_prefix_.size()) {
+                // 和上一个 key 在同一个节点上分叉
+                AppendLabel(shared, prefix[shared], false);
+            } else if (shared > 0) {
+                // 上一个 key 是这个 key 的前缀：它的最后一条边接出一个新节点
+                levels_[shared - 1].has_child.back() = true;
+                if (levels_.size() <= shared) levels_.resize(shared + 1);
+                levels_[shared].prefix_key.push_back(true);
+                AppendLabel(shared, prefix[shared], true);
+            } else {
+                // 上一个 key 是空串，根节点还没有边
+                AppendLabel(0, prefix[0], true);
+            }
+        }
+        for (size_t level = shared + 1; level < prefix.size(); level++) {
+            levels_[level - 1].has_child.back() = true;
+            if (levels_.size() <= level) levels_.resize(level + 1);
+            levels_[level].prefix_key.push_back(false);
+            AppendLabel(level, prefix[level], true);
+        }
+        last_prefix_.assign(prefix.data(), prefix.size());
+    }
+
+    void RangeFilterBuilder::Finish(std::string *dst) {
+        if (has_pending_) {
+            Insert(Slice(pending_.data(), std::min(pending_shared_ + 1 + kSuffixBytes, pending_.size())));
+            has_pending_ = false;
+        }
+        std::string labels;
+        std::vector<bool> has_child, louds, prefix_key;
+        for (const Level &l: levels_) {
+            labels.append(l.labels);
+            has_child.insert(has_child.end(), l.has_child.begin(), l.has_child.end());
+            louds.insert(louds.end(), l.louds.begin(), l.louds.end());
+            prefix_key.insert(prefix_key.end(), l.prefix_key.begin(), l.prefix_key.end());
+        }
+        PutVarint64(dst, labels.size());
+        PutVarint64(dst, prefix_key.size());
+        dst->append(labels);
+        PutBits(dst, has_child, false);
+        PutBits(dst, louds, true);
+        PutBits(dst, prefix_key, false);
+    }
+
+    bool RangeFilter::DecodeBits(Slice *input, bool with_select, Bits *bits) {
+        if (!GetVarint64(input, &bits->size) || !GetVarint64(input, &bits->ones) ||
+            bits->size >= (uint64_t{1} << 32) || bits->ones > bits->size) {
+            return false;
+        }
+        const uint64_t num_words = (bits->size + 63) / 64;
+        const uint64_t num_ranks = (num_words + kWordsPerRank - 1) / kWordsPerRank;
+        const uint64_t num_selects = with_select ? (bits->ones + kOnesPerSelect - 1) / kOnesPerSelect : 0;
+        const uint64_t length = num_words * 8 + num_ranks * 4 + num_selects * 4;
+        if (input->size() < length) return false;
+        bits->words = input->data();
+        bits->ranks = bits->words + num_words * 8;
+        bits->selects = with_select ? bits->ranks + num_ranks * 4 : nullptr;
+        input->remove_prefix(length);
+        return true;
+    }
+
+    bool RangeFilter::Bits::Get(uint64_t i) const {
+        return (DecodeFixed64(words + (i / 64) * 8) >> (i % 64)) & 1;
+    }
+
+    uint64_t RangeFilter::Bits::Rank(uint64_t i) const {
+        if (i >= size) return ones;
+        const uint64_t word = i / 64;
+        uint64_t rank = DecodeFixed32(ranks + (word / kWordsPerRank) * 4);
+        for (uint64_t w = word - word % kWordsPerRank; w < word; w++) {
+            rank += __builtin_popcountll(DecodeFixed64(words + w * 8));
+        }
+        if (i % 64 != 0) {
+            rank += __builtin_popcountll(DecodeFixed64(words + word * 8) & ((uint64_t{1} << (i % 64)) - 1));
+        }
+        return rank;
+    }
+
+    uint64_t RangeFilter::Bits::Select(uint64_t k) const {
+        assert(k < ones);
+        // 从采样点所在的字开始往后数
+        uint64_t pos = DecodeFixed32(selects + (k / kOnesPerSelect) * 4);
+        uint64_t left = k % kOnesPerSelect;
+        uint64_t word = pos / 64;
+        uint64_t bits = DecodeFixed64(words + word * 8) & (~uint64_t{0} << (pos % 64));
+        while (true) {
+            const auto count = static_cast<uint64_t>(__builtin_popcountll(bits));
+            if (left < count) break;
+            left -= count;
+            bits = DecodeFixed64(words + (++word) * 8);
+        }
+        for (; left > 0; left--) {
+            bits &= bits - 1;
+        }
+        return word * 64 + __builtin_ctzll(bits);
+    }
+
+    bool RangeFilter::Init(const Slice &contents) {
+        Slice input = contents;
+        if (!GetVarint64(&input, &num_labels_) || !GetVarint64(&input, &num_nodes_) ||
+            input.size() < num_labels_) {
+            return false;
+        }
+        labels_ = input.data();
+        input.remove_prefix(num_labels_);
+        if (!DecodeBits(&input, false, &has_child_) || !DecodeBits(&input, true, &louds_) ||
+            !DecodeBits(&input, false, &prefix_key_) || !input.empty()) {
+            return false;
+        }
+        if (num_nodes_ == 0) {
+            // 没有加入任何 key
+            return num_labels_ == 0 && has_child_.size == 0 && louds_.size == 0 && prefix_key_.size == 0;
+        }
+        // 每个节点恰好一个 louds 位(只有空串时根节点没有边)，除根节点外每个节点恰好一个父边
+        return has_child_.size == num_labels_ && louds_.size == num_labels_ &&
+               prefix_key_.size == num_nodes_ && has_child_.ones + 1 == num_nodes_ &&
+               (louds_.ones == num_nodes_ || (num_labels_ == 0 && num_nodes_ == 1));
+    }
+
+    uint64_t RangeFilter::NodeEnd(uint64_t node) const {
+        return node + 1 < num_nodes_ ? louds_.Select(node + 1) : num_labels_;
+    }
+
+    bool RangeFilter::LeftmostFromLabel(uint64_t pos, std::string *prefix, const Slice &end) const {
+        prefix->push_back(labels_[pos]);
+        if (!has_child_.Get(pos)) {
+            return Slice(*prefix).compare(end) < 0;
+        }
+        return LeftmostFromNode(Child(pos), prefix, end);
+    }
+
+    bool RangeFilter::LeftmostFromNode(uint64_t node, std::string *prefix, const Slice &end) const {
+        // 沿最左边一路向下，直到有 key 结束
+        while (!prefix_key_.Get(node)) {
+            const uint64_t pos = NodeStart(node);
+            prefix->push_back(labels_[pos]);
+            if (!has_child_.Get(pos)) break;
+            node = Child(pos);
+        }
+        // 找到的是某个 key 的前缀：前缀 >= end 时 key 一定 >= end
+        return Slice(*prefix).compare(end) < 0;
+    }
+
+    bool RangeFilter::RangeMayMatch(const Slice &begin, const Slice &end) const {
+        if (begin.compare(end) >= 0 || num_nodes_ == 0) return false;
+        if (num_labels_ == 0) {
+            // 只有空串
+            return prefix_key_.Get(0) && begin.empty();
+        }
+
+        // 找 >= begin 的最小 key，再和 end 比较
+        std::string prefix;
+        std::vector<uint64_t> path;  // Labels followed from the root.
+        uint64_t node = 0;
+        while (true) {
+            const size_t level = prefix.size();
+            if (level == begin.size()) {
+                return LeftmostFromNode(node, &prefix, end);
+            }
+            const auto c = static_cast<unsigned char>(begin[level]);
+            const uint64_t node_end = NodeEnd(node);
+            uint64_t pos = NodeStart(node);
+            while (pos < node_end && static_cast<unsigned char>(labels_[pos]) < c) pos++;
+            if (pos < node_end && static_cast<unsigned char>(labels_[pos]) == c) {
+                if (!has_child_.Get(pos)) {
+                    // key 只存了前缀，可能小于 begin 也可能不小于，只能当作可能存在
+                    prefix.push_back(labels_[pos]);
+                    return Slice(prefix).compare(end) < 0;
+                }
+                path.push_back(pos);
+                prefix.push_back(labels_[pos]);
+                node = Child(pos);
+                continue;
+            }
+            if (pos < node_end) {
+                return LeftmostFromLabel(pos, &prefix, end);
+            }
+            // 这个节点里没有更大的边：退回上层，换成右边的兄弟
+            while (!path.empty()) {
+                const uint64_t p = path.back();
+                path.pop_back();
+                prefix.pop_back();
+                if (p + 1 < num_labels_ && !louds_.Get(p + 1)) {
+                    return LeftmostFromLabel(p + 1, &prefix, end);
+                }
+            }
+            return false;
+        }
+    }
+
+}
@@ -0,0 +1,114 @@
+#ifndef SSTABLE_RANGE_FILTER_H
+#define SSTABLE_RANGE_FILTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../include/slice.h"
+
+namespace leveldb {
+
+    // 简洁 trie 范围过滤器(SuRF-Base)：回答 [begin, end) 内是否可能有 key
+    //
+    // A range filter in the style of SuRF: a trie of the shortest prefixes
+    // that tell each key apart from its neighbours, plus one more byte,
+    // stored level by level as LOUDS-Sparse bit vectors (about 10 bits per
+    // trie edge).  It answers "may a key exist in [begin, end)?" with no
+    // false negatives; false positives come from the dropped key suffixes.
+    //
+    // Keys are ordered bytewise.
+
+    // Builds a range filter from keys added in increasing order.
+    class RangeFilterBuilder {
+    public:
+        RangeFilterBuilder();
+
+        RangeFilterBuilder(const RangeFilterBuilder &) = delete;
+
+        RangeFilterBuilder &operator=(const RangeFilterBuilder &) = delete;
+
+        // REQUIRES: key is not less than any previously added key.
+        void AddKey(const Slice &key);
+
+        // Appends the encoded filter to *dst.
+        void Finish(std::string *dst);
+
+    private:
+        // One level of the trie.  has_child and louds are per label,
+        // prefix_key is per node.
+        struct Level {
+            std::string labels;
+            std::vector<bool> has_child;    // The label leads to a node.
+            std::vector<bool> louds;        // The label starts its node.
+            std::vector<bool> prefix_key;   // A key ends at the node.
+        };
+
+        // Adds a truncated key, in increasing order, to the trie.
+        void Insert(const Slice &prefix);
+
+        void AppendLabel(size_t level, char label, bool first_in_node);
+
+        std::vector<Level> levels_;
+        std::string pending_;      // Last added key, not yet inserted.
+        bool has_pending_;
+        size_t pending_shared_;    // Bytes pending_ shares with the key before it.
+        std::string last_prefix_;  // Last inserted truncated key.
+        bool empty_;               // Nothing inserted yet.
+    };
+
+    // Reads what RangeFilterBuilder::Finish() wrote.  Refers to the contents
+    // passed to Init(), which must outlive it.  Thread-safe.
+    class RangeFilter {
+    public:
+        RangeFilter() = default;
+
+        // Returns false if "contents" is malformed.
+        bool Init(const Slice &contents);
+
+        // Returns false if no key in [begin, end) was added.
+        bool RangeMayMatch(const Slice &begin, const Slice &end) const;
+
+    private:
+        // A bit vector of fixed64 words with rank and select samples.
+        struct Bits {
+            const char *words = nullptr;
+            const char *ranks = nullptr;    // Ones before each 512 bits.
+            const char *selects = nullptr;  // Position of every 64th one.
+            uint64_t size = 0;
+            uint64_t ones = 0;
+
+            bool Get(uint64_t i) const;
+
+            // Ones in [0, i).
+            uint64_t Rank(uint64_t i) const;
+
+            // Position of the one numbered k, counting from 0.
+            uint64_t Select(uint64_t k) const;
+        };
+
+        static bool DecodeBits(Slice *input, bool with_select, Bits *bits);
+
+        uint64_t NodeStart(uint64_t node) const { return louds_.Select(node); }
+
+        uint64_t NodeEnd(uint64_t node) const;
+
+        uint64_t Child(uint64_t pos) const { return has_child_.Rank(pos + 1); }
+
+        // Whether the smallest key below label "pos" or node "node", which
+        // starts with "prefix", may be less than "end".
+        bool LeftmostFromLabel(uint64_t pos, std::string *prefix, const Slice &end) const;
+
+        bool LeftmostFromNode(uint64_t node, std::string *prefix, const Slice &end) const;
+
+        const char *labels_ = nullptr;
+        uint64_t num_labels_ = 0;
+        uint64_t num_nodes_ = 0;
+        Bits has_child_;
+        Bits louds_;
+        Bits prefix_key_;
+    };
+
+}
+
+#endif //SSTABLE_RANGE_FILTER_H
@@ -0,0 +1,126 @@
+#include "range_filter.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../util/random.h"
+
+namespace leveldb {
+
+    namespace {
+
+        // 长度 0..max_length 的随机 key，字节取自很小的字母表，好让 key 之间有长的公共前缀
+        std::string RandomKey(Random *rnd, int max_length) {
+            std::string key(rnd->Uniform(max_length + 1), '\0');
+            for (char &c: key) {
+                const uint32_t r = rnd->Uniform(5);
+                c = static_cast<char>(r == 0 ? 0x00 : r == 4 ? 0xff : 'a' + r);
+            }
+            return key;
+        }
+
+        std::string BuildFilter(const std::set<std::string> &keys) {
+            RangeFilterBuilder builder;
+            for (const std::string &key: keys) {
+                builder.AddKey(key);
+            }
+            std::string contents;
+            builder.Finish(&contents);
+            return contents;
+        }
+
+        bool ModelMayMatch(const std::set<std::string> &keys, const std::string &begin, const std::string &end) {
+            auto it = keys.lower_bound(begin);
+            return it != keys.end() && *it < end;
+        }
+
+    }  // namespace
+
+    TEST(RangeFilterTest, Empty) {
+        const std::string contents = BuildFilter({});
+        RangeFilter filter;
+        ASSERT_TRUE(filter.Init(contents));
+        ASSERT_FALSE(filter.RangeMayMatch("", "\xff"));
+        ASSERT_FALSE(filter.RangeMayMatch("a", "b"));
+    }
+
+    TEST(RangeFilterTest, EmptyKeyAndPrefixes) {
+        const std::set<std::string> keys = {"", "a", "ab", "abc", "b"};
+        const std::string contents = BuildFilter(keys);
+        RangeFilter filter;
+        ASSERT_TRUE(filter.Init(contents));
+        ASSERT_TRUE(filter.RangeMayMatch("", "\x01"));
+        ASSERT_TRUE(filter.RangeMayMatch("ab", "ab\x01"));
+        ASSERT_TRUE(filter.RangeMayMatch("abb", "abd"));
+        ASSERT_TRUE(filter.RangeMayMatch("b", "c"));
+        ASSERT_FALSE(filter.RangeMayMatch("c", "z"));
+        // 空区间
+        ASSERT_FALSE(filter.RangeMayMatch("a", "a"));
+        ASSERT_FALSE(filter.RangeMayMatch("b", "a"));
+    }
+
+    // 没有假阴性；离所有 key 都很远的区间被排除
+    TEST(RangeFilterTest, MatchesModel) {
+        Random rnd(301);
+        for (const int n: {1, 2, 10, 100, 1000, 10000}) {
+            std::set<std::string> keys;
+            while (keys.size() < static_cast<size_t>(n)) {
+                keys.insert("k" + RandomKey(&rnd, 12));
+            }
+            const std::string contents = BuildFilter(keys);
+            RangeFilter filter;
+            ASSERT_TRUE(filter.Init(contents));
+
+            for (int round = 0; round < 2000; round++) {
+                std::string begin = "k" + RandomKey(&rnd, 12);
+                std::string end = "k" + RandomKey(&rnd, 12);
+                if (end < begin) std::swap(begin, end);
+                if (ModelMayMatch(keys, begin, end)) {
+                    ASSERT_TRUE(filter.RangeMayMatch(begin, end)) << "n=" << n << " round=" << round;
+                }
+            }
+            for (const std::string &key: keys) {
+                ASSERT_TRUE(filter.RangeMayMatch(key, key + '\0'));
+            }
+            ASSERT_FALSE(filter.RangeMayMatch("a", "k"));
+            ASSERT_FALSE(filter.RangeMayMatch("l", "z"));
+        }
+    }
+
+    // 相距较远的 key 之间的空隙大多能被排除
+    TEST(RangeFilterTest, RulesOutGaps) {
+        std::set<std::string> keys;
+        for (int i = 0; i < 1000; i++) {
+            keys.insert("key" + std::to_string(i * 10 + 1000));
+        }
+        const std::string contents = BuildFilter(keys);
+        RangeFilter filter;
+        ASSERT_TRUE(filter.Init(contents));
+        int matches = 0;
+        for (int i = 0; i < 1000; i++) {
+            const std::string begin = "key" + std::to_string(i * 10 + 1003);
+            const std::string end = "key" + std::to_string(i * 10 + 1008);
+            matches += filter.RangeMayMatch(begin, end);
+        }
+        ASSERT_LT(matches, 100);
+    }
+
+    TEST(RangeFilterTest, RejectsMalformedContents) {
+        std::set<std::string> keys;
+        for (int i = 0; i < 500; i++) {
+            keys.insert("key" + std::to_string(i * 7));
+        }
+        const std::string contents = BuildFilter(keys);
+        RangeFilter filter;
+        ASSERT_FALSE(filter.Init(Slice()));
+        for (size_t n = 0; n < contents.size(); n += 1 + n / 8) {
+            ASSERT_FALSE(filter.Init(Slice(contents.data(), n))) << n;
+        }
+        ASSERT_FALSE(filter.Init(contents + "x"));
+        ASSERT_TRUE(filter.Init(contents));
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,126 @@
+#include "readahead_file.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace leveldb {
+
+    // C++11 还需要类外定义，std::min 按引用取它
+    constexpr size_t ReadaheadRandomAccessFile::kInitialReadaheadSize;
+
+    ReadaheadRandomAccessFile::ReadaheadRandomAccessFile(const RandomAccessFile *target,
+                                                         size_t max_readahead_size)
+            : target_(target),
+              max_readahead_size_(max_readahead_size),
+              alignment_(target->GetRequiredBufferAlignment()),
+              readahead_size_(std::min(kInitialReadaheadSize, max_readahead_size)),
+              prev_end_(~static_cast<uint64_t>(0)),
+              zero_copy_target_(false),
+              prefetched_end_(0),
+              buffer_(nullptr),
+              buffer_capacity_(0),
+              buffer_offset_(0),
+              buffer_len_(0) {}
+
+    ReadaheadRandomAccessFile::~ReadaheadRandomAccessFile() { FreeBuffer(); }
+
+    void ReadaheadRandomAccessFile::FreeBuffer() const {
+        free(buffer_);
+        buffer_ = nullptr;
+        buffer_capacity_ = buffer_len_ = 0;
+    }
+
+    bool ReadaheadRandomAccessFile::IsSequential(uint64_t offset) const {
+        if (alignment_ == 0) {
+            return offset == prev_end_;
+        }
+        // 对齐的读取首尾都扩到对齐边界：紧接着的块会从上一次读取的最后一个对齐单位开始
+        return offset <= prev_end_ && prev_end_ - offset <= alignment_;
+    }
+
+    void ReadaheadRandomAccessFile::UpdateWindow(uint64_t offset) const {
+        if (!IsSequential(offset)) {
+            // 随机读，窗口回到初始大小
+            readahead_size_ = std::min(kInitialReadaheadSize, max_readahead_size_);
+            prefetched_end_ = 0;
+        }
+    }
+
+    Status ReadaheadRandomAccessFile::Refill(uint64_t offset, size_t n) const {
+        size_t want = std::max(n, readahead_size_);
+        if (alignment_ > 0) {
+            want = (want + alignment_ - 1) / alignment_ * alignment_;
+        }
+        if (want > buffer_capacity_) {
+            FreeBuffer();
+            void *buf = nullptr;
+            if (posix_memalign(&buf, std::max(alignment_, sizeof(void *)), want) != 0) {
+                return Status::IOError("out of memory for readahead");
+            }
+            buffer_ = static_cast<char *>(buf);
+            buffer_capacity_ = want;
+        }
+
+        Slice data;
+        buffer_len_ = 0;
+        Status s = target_->Read(offset, want, &data, buffer_);
+        if (!s.ok()) {
+            return s;
+        }
+        if (data.data() != buffer_) {
+            std::memcpy(buffer_, data.data(), data.size());
+        }
+        buffer_offset_ = offset;
+        buffer_len_ = data.size();
+
+        // 每次顺序补充缓冲区后，窗口翻倍，直到上限
+        readahead_size_ = std::min(readahead_size_ * 2, max_readahead_size_);
+        return s;
+    }
+
+    Status ReadaheadRandomAccessFile::Read(uint64_t offset, size_t n, Slice *result, char *scratch) const {
+        const bool sequential = IsSequential(offset);
+        UpdateWindow(offset);
+        prev_end_ = offset + n;
+
+        if (zero_copy_target_) {
+            // The data is already addressable; just ask for the window to be
+            // paged in before the scan gets there.
+            if (sequential && offset + n + readahead_size_ / 2 > prefetched_end_) {
+                const uint64_t start = std::max<uint64_t>(prefetched_end_, offset + n);
+                const uint64_t end = offset + n + readahead_size_;
+                target_->Prefetch(start, static_cast<size_t>(end - start));
+                prefetched_end_ = end;
+                readahead_size_ = std::min(readahead_size_ * 2, max_readahead_size_);
+            }
+            return target_->Read(offset, n, result, scratch);
+        }
+
+        if (offset >= buffer_offset_ && offset + n <= buffer_offset_ + buffer_len_) {
+            std::memcpy(scratch, buffer_ + (offset - buffer_offset_), n);
+            *result = Slice(scratch, n);
+            return Status::OK();
+        }
+
+        if (!sequential) {
+            Status s = target_->Read(offset, n, result, scratch);
+            if (s.ok() && !result->empty() && result->data() != scratch) {
+                zero_copy_target_ = true;
+                FreeBuffer();
+            }
+            return s;
+        }
+
+        Status s = Refill(offset, n);
+        if (!s.ok()) {
+            *result = Slice();
+            return s;
+        }
+        const size_t copy_size = std::min(n, buffer_len_);
+        std::memcpy(scratch, buffer_, copy_size);
+        *result = Slice(scratch, copy_size);
+        return s;
+    }
+
+}
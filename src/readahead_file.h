@@ -0,0 +1,83 @@
+#ifndef SSTABLE_READAHEAD_FILE_H
+#define SSTABLE_READAHEAD_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../include/env.h"
+
+namespace leveldb {
+
+    // 顺序扫描时的预读
+    // A RandomAccessFile wrapper that detects sequential reads and serves them
+    // from a readahead window.  The window starts at kInitialReadaheadSize and
+    // doubles on every refill while the access pattern stays sequential, up to
+    // "max_readahead_size".  A read that does not start where the previous one
+    // ended resets the window.  For a target that wants aligned reads, whose
+    // callers widen each read to the alignment, a read that starts less than
+    // one alignment unit before the previous end still counts as sequential,
+    // and refills are aligned reads into an aligned buffer.
+    //
+    // When the target copies into the caller's scratch buffer (pread), a refill
+    // is a single large Read() into a private buffer, so a table scan issues one
+    // I/O per window instead of one per data block.  When the target returns
+    // its own memory (mmap), reads are passed through and the window is only
+    // announced ahead of time with RandomAccessFile::Prefetch().
+    //
+    // Unlike other RandomAccessFiles, instances are NOT safe for concurrent use:
+    // each one belongs to a single iterator.  "target" must outlive it.
+    class ReadaheadRandomAccessFile : public RandomAccessFile {
+    public:
+        static constexpr size_t kInitialReadaheadSize = 8 * 1024;
+
+        ReadaheadRandomAccessFile(const RandomAccessFile *target, size_t max_readahead_size);
+
+        ReadaheadRandomAccessFile(const ReadaheadRandomAccessFile &) = delete;
+
+        ReadaheadRandomAccessFile &operator=(const ReadaheadRandomAccessFile &) = delete;
+
+        ~ReadaheadRandomAccessFile() override;
+
+        Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override;
+
+        size_t GetRequiredBufferAlignment() const override {
+            return target_->GetRequiredBufferAlignment();
+        }
+
+        void Prefetch(uint64_t offset, size_t n) const override { target_->Prefetch(offset, n); }
+
+    private:
+        // Whether a read at "offset" continues the previous one.
+        bool IsSequential(uint64_t offset) const;
+
+        // Resets the window unless the read at "offset" is sequential.  The
+        // window only grows in Refill() and when prefetching.
+        void UpdateWindow(uint64_t offset) const;
+
+        // Refills buffer_ with file[offset, offset + max(n, window)), rounded
+        // up to the target's alignment, and doubles the window.
+        Status Refill(uint64_t offset, size_t n) const;
+
+        // Frees buffer_.
+        void FreeBuffer() const;
+
+        const RandomAccessFile *const target_;
+        const size_t max_readahead_size_;
+        const size_t alignment_;          // Target's required alignment, or 0.
+
+        mutable size_t readahead_size_;   // Current window.
+        mutable uint64_t prev_end_;       // End offset of the previous Read().
+        mutable bool zero_copy_target_;   // Target returned memory it owns (mmap).
+        mutable uint64_t prefetched_end_; // End of the last Prefetch() hint.
+
+        // buffer_[0, buffer_len_) holds file[buffer_offset_, buffer_offset_ + buffer_len_).
+        // Allocated with posix_memalign() so that direct reads need no bounce buffer.
+        mutable char *buffer_;
+        mutable size_t buffer_capacity_;
+        mutable uint64_t buffer_offset_;
+        mutable size_t buffer_len_;
+    };
+
+}
+
+#endif //SSTABLE_READAHEAD_FILE_H
@@ -0,0 +1,132 @@
+#include "readahead_file.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace leveldb {
+
+    namespace {
+
+        // 内存里的文件，记下每次读取；alignment 非零时只接受对齐的读取
+        class StringFile : public RandomAccessFile {
+        public:
+            StringFile(std::string data, size_t alignment) : data_(std::move(data)), alignment_(alignment) {}
+
+            Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override {
+                reads_.push_back(std::make_pair(offset, n));
+                if (alignment_ > 0 && (offset % alignment_ != 0 || n % alignment_ != 0 ||
+                                       reinterpret_cast<uintptr_t>(scratch) % alignment_ != 0)) {
+                    return Status::InvalidArgument("unaligned read");
+                }
+                if (offset > data_.size()) {
+                    *result = Slice();
+                    return Status::OK();
+                }
+                n = std::min<size_t>(n, data_.size() - offset);
+                data_.copy(scratch, n, offset);
+                *result = Slice(scratch, n);
+                return Status::OK();
+            }
+
+            size_t GetRequiredBufferAlignment() const override { return alignment_; }
+
+            const std::string data_;
+            const size_t alignment_;
+            mutable std::vector<std::pair<uint64_t, size_t>> reads_;
+        };
+
+        std::string Contents(size_t n) {
+            std::string data(n, '\0');
+            for (size_t i = 0; i < n; i++) {
+                data[i] = static_cast<char>('a' + i % 23);
+            }
+            return data;
+        }
+
+    }  // namespace
+
+    TEST(ReadaheadFileTest, SequentialReadsShareRefills) {
+        const std::string data = Contents(1 << 20);
+        StringFile target(data, 0);
+        ReadaheadRandomAccessFile file(&target, 256 * 1024);
+
+        // 1000 字节一块顺序读完整个文件
+        char scratch[1000];
+        uint64_t offset = 0;
+        while (offset < data.size()) {
+            Slice result;
+            ASSERT_TRUE(file.Read(offset, sizeof(scratch), &result, scratch).ok());
+            ASSERT_EQ(data.substr(offset, sizeof(scratch)), result.ToString());
+            offset += result.size();
+        }
+
+        // 第一次读不算顺序读；之后窗口每次补充翻倍，到上限为止
+        ASSERT_EQ(1000u, target.reads_[0].second);
+        ASSERT_EQ(ReadaheadRandomAccessFile::kInitialReadaheadSize, target.reads_[1].second);
+        ASSERT_EQ(2 * ReadaheadRandomAccessFile::kInitialReadaheadSize, target.reads_[2].second);
+        ASSERT_EQ(256 * 1024u, target.reads_.back().second);
+        ASSERT_LT(target.reads_.size(), 15u);
+    }
+
+    TEST(ReadaheadFileTest, RandomReadResetsWindow) {
+        const std::string data = Contents(1 << 20);
+        StringFile target(data, 0);
+        ReadaheadRandomAccessFile file(&target, 256 * 1024);
+
+        char scratch[100];
+        Slice result;
+        uint64_t offset = 0;
+        for (int i = 0; i < 200; i++, offset += 100) {
+            ASSERT_TRUE(file.Read(offset, 100, &result, scratch).ok());
+        }
+        const size_t reads = target.reads_.size();
+        ASSERT_GT(target.reads_.back().second, ReadaheadRandomAccessFile::kInitialReadaheadSize);
+
+        // 跳到别处：直接读，不预读
+        ASSERT_TRUE(file.Read(900000, 100, &result, scratch).ok());
+        ASSERT_EQ(data.substr(900000, 100), result.ToString());
+        ASSERT_EQ(reads + 1, target.reads_.size());
+        ASSERT_EQ(100u, target.reads_.back().second);
+
+        // 再接着读，窗口从初始大小重新开始
+        ASSERT_TRUE(file.Read(900100, 100, &result, scratch).ok());
+        ASSERT_EQ(data.substr(900100, 100), result.ToString());
+        ASSERT_EQ(ReadaheadRandomAccessFile::kInitialReadaheadSize, target.reads_.back().second);
+    }
+
+    TEST(ReadaheadFileTest, AlignedReadsAreSequential) {
+        const size_t kAlignment = 4096;
+        const std::string data = Contents(1 << 20);
+        StringFile target(data, kAlignment);
+        ReadaheadRandomAccessFile file(&target, 256 * 1024);
+        ASSERT_EQ(kAlignment, file.GetRequiredBufferAlignment());
+
+        // 模仿直接 I/O 读块：每个块 3000 字节，读取扩到对齐边界，相邻两次读取有重叠
+        void *buf = nullptr;
+        ASSERT_EQ(0, posix_memalign(&buf, kAlignment, 4 * kAlignment));
+        char *scratch = static_cast<char *>(buf);
+        for (uint64_t block = 0; block + 3000 <= data.size(); block += 3000) {
+            const uint64_t start = block - block % kAlignment;
+            const uint64_t end = (block + 3000 + kAlignment - 1) / kAlignment * kAlignment;
+            Slice result;
+            ASSERT_TRUE(file.Read(start, end - start, &result, scratch).ok());
+            ASSERT_EQ(data.substr(start, end - start), result.ToString());
+        }
+        free(buf);
+
+        // 全部是对齐的读取，而且被当成顺序读合并成了大读取
+        for (const auto &read: target.reads_) {
+            ASSERT_EQ(0u, read.first % kAlignment);
+            ASSERT_EQ(0u, read.second % kAlignment);
+        }
+        ASSERT_EQ(256 * 1024u, target.reads_.back().second);
+        ASSERT_LT(target.reads_.size(), 15u);
+    }
+
+}  // namespace leveldb
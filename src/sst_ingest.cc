@@ -0,0 +1,261 @@
+// sst_ingest: turns an unsorted dump of key/value records into SSTables.
+//
+//   sst_ingest --input=FILE --output_dir=DIR [flags]
+//
+// Records are read from FILE in one of two formats:
+//   --format=tsv      one "key<TAB>value" record per line (default)
+//   --format=binary   varint32-length-prefixed key, then value, repeated
+//
+// Other flags:
+//   --tmp_dir=DIR            directory for temporary runs (default: output_dir)
+//   --memory_mb=N            memory for buffering unsorted records (256)
+//   --threads=N              sort/spill threads and merge workers (4)
+//   --max_merge_width=N      runs merged at once (64)
+//   --max_file_size_mb=N     size of each output table (64)
+//   --block_size=N           data block size in bytes (4096)
+//   --compression=0|1        1 for snappy (default 1)
+//   --first_file_number=N    number of the first output table (1)
+//   --use_direct_reads=0|1   read the temporary runs with direct I/O (0)
+//   --rate_limit_mb=N        cap writes at N MB/s, 0 for no limit (0)
+//
+// When a key appears several times the last record wins.  Progress and
+// throughput are reported on stderr.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "env.h"
+#include "options.h"
+#include "rate_limiter.h"
+#include "../util/coding.h"
+#include "external_sorter.h"
+
+namespace leveldb {
+
+    namespace {
+
+        // Input is read in chunks of this size.
+        const size_t kReadChunkSize = 4 * 1024 * 1024;
+
+        struct Flags {
+            std::string input;
+            std::string output_dir;
+            std::string tmp_dir;
+            bool binary = false;
+            int memory_mb = 256;
+            int threads = 4;
+            int max_merge_width = 64;
+            int max_file_size_mb = 64;
+            int block_size = 4096;
+            int compression = 1;
+            uint64_t first_file_number = 1;
+            int use_direct_reads = 0;
+            int rate_limit_mb = 0;
+        };
+
+        void Usage() {
+            std::fprintf(stderr,
+                         "Usage: sst_ingest --input=FILE --output_dir=DIR [--format=tsv|binary]\n"
+                         "       [--tmp_dir=DIR] [--memory_mb=N] [--threads=N] [--max_merge_width=N]\n"
+                         "       [--max_file_size_mb=N] [--block_size=N] [--compression=0|1]\n"
+                         "       [--first_file_number=N] [--use_direct_reads=0|1] [--rate_limit_mb=N]\n");
+        }
+
+        bool ParseFlags(int argc, char **argv, Flags *flags) {
+            for (int i = 1; i < argc; i++) {
+                int n;
+                unsigned long long u;
+                char junk;
+                if (std::strncmp(argv[i], "--input=", 8) == 0) {
+                    flags->input = argv[i] + 8;
+                } else if (std::strncmp(argv[i], "--output_dir=", 13) == 0) {
+                    flags->output_dir = argv[i] + 13;
+                } else if (std::strncmp(argv[i], "--tmp_dir=", 10) == 0) {
+                    flags->tmp_dir = argv[i] + 10;
+                } else if (std::strcmp(argv[i], "--format=tsv") == 0) {
+                    flags->binary = false;
+                } else if (std::strcmp(argv[i], "--format=binary") == 0) {
+                    flags->binary = true;
+                } else if (sscanf(argv[i], "--memory_mb=%d%c", &n, &junk) == 1 && n > 0) {
+                    flags->memory_mb = n;
+                } else if (sscanf(argv[i], "--threads=%d%c", &n, &junk) == 1 && n > 0) {
+                    flags->threads = n;
+                } else if (sscanf(argv[i], "--max_merge_width=%d%c", &n, &junk) == 1 && n > 1) {
+                    flags->max_merge_width = n;
+                } else if (sscanf(argv[i], "--max_file_size_mb=%d%c", &n, &junk) == 1 && n > 0) {
+                    flags->max_file_size_mb = n;
+                } else if (sscanf(argv[i], "--block_size=%d%c", &n, &junk) == 1 && n > 0) {
+                    flags->block_size = n;
+                } else if (sscanf(argv[i], "--compression=%d%c", &n, &junk) == 1 && (n == 0 || n == 1)) {
+                    flags->compression = n;
+                } else if (sscanf(argv[i], "--first_file_number=%llu%c", &u, &junk) == 1) {
+                    flags->first_file_number = u;
+                } else if (sscanf(argv[i], "--use_direct_reads=%d%c", &n, &junk) == 1 && (n == 0 || n == 1)) {
+                    flags->use_direct_reads = n;
+                } else if (sscanf(argv[i], "--rate_limit_mb=%d%c", &n, &junk) == 1 && n >= 0) {
+                    flags->rate_limit_mb = n;
+                } else {
+                    std::fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+                    return false;
+                }
+            }
+            if (flags->input.empty() || flags->output_dir.empty()) {
+                return false;
+            }
+            if (flags->tmp_dir.empty()) {
+                flags->tmp_dir = flags->output_dir;
+            }
+            return true;
+        }
+
+        double MBPerSec(uint64_t bytes, uint64_t micros) {
+            return micros == 0 ? 0.0 : (bytes / 1048576.0) / (micros * 1e-6);
+        }
+
+        // Parses the complete records at the front of *input and feeds them to
+        // the sorter, leaving an incomplete trailing record in *input.
+        Status ParseRecords(bool binary, Slice *input, ExternalSorter *sorter) {
+            Status s;
+            while (s.ok() && !input->empty()) {
+                Slice key, value;
+                if (binary) {
+                    Slice rest = *input;
+                    if (!GetLengthPrefixedSlice(&rest, &key) || !GetLengthPrefixedSlice(&rest, &value)) {
+                        break;  // Incomplete record.
+                    }
+                    *input = rest;
+                } else {
+                    const char *end = static_cast<const char *>(std::memchr(input->data(), '\n', input->size()));
+                    if (end == nullptr) {
+                        break;  // Incomplete line.
+                    }
+                    Slice line(input->data(), end - input->data());
+                    input->remove_prefix(line.size() + 1);
+                    const char *tab = static_cast<const char *>(std::memchr(line.data(), '\t', line.size()));
+                    if (tab == nullptr) {
+                        return Status::Corruption("line without a tab", line);
+                    }
+                    key = Slice(line.data(), tab - line.data());
+                    value = Slice(tab + 1, line.size() - key.size() - 1);
+                }
+                s = sorter->Add(key, value);
+            }
+            return s;
+        }
+
+        Status Ingest(const Flags &flags) {
+            Env *env = Env::Default();
+            Options options;
+            options.block_size = flags.block_size;
+            options.max_file_size = static_cast<size_t>(flags.max_file_size_mb) * 1024 * 1024;
+            options.compression = flags.compression ? kSnappyCompression : kNoCompression;
+            options.use_direct_reads = flags.use_direct_reads != 0;
+            // 两个 1MB 的缓冲区：后台线程写一个，排好序的数据继续编码进另一个
+            options.writable_file_buffer_size = 1024 * 1024;
+            options.writable_file_buffers = 2;
+            std::unique_ptr<RateLimiter> rate_limiter;
+            if (flags.rate_limit_mb > 0) {
+                rate_limiter.reset(NewGenericRateLimiter(int64_t{flags.rate_limit_mb} * 1024 * 1024));
+                options.rate_limiter = rate_limiter.get();
+            }
+
+            ExternalSortOptions sort_options;
+            sort_options.memory_budget = static_cast<size_t>(flags.memory_mb) * 1024 * 1024;
+            sort_options.threads = flags.threads;
+            sort_options.max_merge_width = flags.max_merge_width;
+            sort_options.tmp_dir = flags.tmp_dir;
+
+            SequentialFile *input;
+            Status s = env->NewSequentialFile(flags.input, &input);
+            if (!s.ok()) {
+                return s;
+            }
+            env->CreateDir(flags.output_dir);  // Ignore error: it may already exist.
+
+            TableFileFactory *factory =
+                    NewTableFileFactory(env, flags.output_dir, flags.first_file_number, EnvOptions(options));
+            ExternalSorter *sorter = new ExternalSorter(options, sort_options, factory);
+
+            // 分块读取输入，不完整的尾部记录留到下一块
+            const uint64_t start_micros = env->NowMicros();
+            std::string buffer;
+            std::vector<char> scratch(kReadChunkSize);
+            uint64_t bytes_read = 0;
+            uint64_t next_report = 1ull << 30;
+            while (s.ok()) {
+                Slice chunk;
+                s = input->Read(kReadChunkSize, &chunk, scratch.data());
+                if (!s.ok() || chunk.empty()) {
+                    break;
+                }
+                bytes_read += chunk.size();
+                buffer.append(chunk.data(), chunk.size());
+                Slice pending(buffer);
+                s = ParseRecords(flags.binary, &pending, sorter);
+                buffer.erase(0, buffer.size() - pending.size());
+                if (bytes_read >= next_report) {
+                    const uint64_t micros = env->NowMicros() - start_micros;
+                    std::fprintf(stderr, "... read %.0f MB, %llu records, %.1f MB/s\n", bytes_read / 1048576.0,
+                                 static_cast<unsigned long long>(sorter->stats().entries),
+                                 MBPerSec(bytes_read, micros));
+                    next_report += 1ull << 30;
+                }
+            }
+            delete input;
+            if (s.ok() && !buffer.empty()) {
+                s = Status::Corruption("truncated last record", flags.input);
+            }
+
+            std::vector<TableFileMeta> outputs;
+            if (s.ok()) {
+                s = sorter->Finish(&outputs);
+            }
+            const uint64_t total_micros = env->NowMicros() - start_micros;
+
+            if (s.ok()) {
+                const ExternalSorter::Stats &stats = sorter->stats();
+                uint64_t output_bytes = 0;
+                uint64_t output_entries = 0;
+                for (const TableFileMeta &meta: outputs) {
+                    output_bytes += meta.file_size;
+                    output_entries += meta.num_entries;
+                }
+                std::fprintf(stderr,
+                             "input:  %llu records, %.1f MB (%.1f MB of keys and values)\n"
+                             "sort:   %d runs spilled in %.2f s\n"
+                             "merge:  %d pass(es) in %.2f s\n"
+                             "output: %zu tables, %llu records, %.1f MB in %s\n"
+                             "total:  %.2f s, %.1f MB/s, %.0f records/s\n",
+                             static_cast<unsigned long long>(stats.entries), bytes_read / 1048576.0,
+                             stats.bytes / 1048576.0, stats.runs, stats.spill_micros * 1e-6,
+                             stats.merge_passes, stats.merge_micros * 1e-6, outputs.size(),
+                             static_cast<unsigned long long>(output_entries), output_bytes / 1048576.0,
+                             flags.output_dir.c_str(), total_micros * 1e-6, MBPerSec(bytes_read, total_micros),
+                             total_micros == 0 ? 0.0 : stats.entries / (total_micros * 1e-6));
+            }
+            delete sorter;
+            delete factory;
+            return s;
+        }
+
+    }  // namespace
+
+}  // namespace leveldb
+
+int main(int argc, char **argv) {
+    leveldb::Flags flags;
+    if (!leveldb::ParseFlags(argc, argv, &flags)) {
+        leveldb::Usage();
+        return 1;
+    }
+    leveldb::Status s = leveldb::Ingest(flags);
+    if (!s.ok()) {
+        std::fprintf(stderr, "sst_ingest: %s\n", s.ToString().c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -1,20 +1,83 @@
 #include "table.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <memory>
+
+#include "blob_file.h"
+#include "block_property.h"
+#include "comparator.h"
+#include "filter_block.h"
+#include "filter_policy.h"
+#include "perfect_hash.h"
+#include "range_filter.h"
+#include "rate_limiter.h"
+#include "readahead_file.h"
+#include "slice_transform.h"
+#include "two_level_iterator.h"
+#include "../port/port_stdcxx.h"
+#include "../port/thread_annotations.h"
+#include "../util/mutexlock.h"
+
 namespace leveldb {
 
+    // 完美哈希索引：key -> data block 编号 -> index block 中的第几项
+    struct Table::PerfectHashIndex {
+        ~PerfectHashIndex() { delete[] owned; }
+
+        PerfectHash hash;
+        uint32_t index_restart_interval = 0;  // Of the index block, as written.
+        const char *owned = nullptr;          // Contents of the meta block, if on the heap.
+    };
+
     struct Table::Rep {
+        ~Rep() {
+            delete perfect_hash;
+            delete filter;
+            delete[] filter_data;
+            delete filter_index;
+            delete partition;
+            delete[] partition_data;
+            delete[] range_filter_owned;
+        }
+
         Block *index_block;
         RandomAccessFile *file;
         Options options;
+        bool blob_values;  // Values carry a ValueType tag (see blob_file.h).
+        PerfectHashIndex *perfect_hash = nullptr;  // Null if the table has none.
+
+        FilterBlockReader *filter = nullptr;
+        const char *filter_data = nullptr;  // Contents of the filter block, if on the heap.
+        bool prefix_filter = false;         // The filter holds options.prefix_extractor's prefixes.
+        // Handles of the filter partitions by the last key each covers, if
+        // the filter is partitioned (see kPartitionedFilter).
+        Block *filter_index = nullptr;
+        // 最近读过的一个过滤器分区：表不经过 block cache，相邻的查找多半
+        // 落在同一个分区，留住它就不用每次重读
+        port::Mutex partition_mu;
+        uint64_t partition_offset GUARDED_BY(partition_mu) = 0;
+        FilterBlockReader *partition GUARDED_BY(partition_mu) = nullptr;
+        const char *partition_data GUARDED_BY(partition_mu) = nullptr;  // If on the heap.
+
+        // Names of the block properties whose summaries follow the handles
+        // in the index block, in order (see kBlockPropertiesName).
+        std::vector<std::string> property_names;
+
+        bool has_range_filter = false;
+        RangeFilter range_filter;
+        const char *range_filter_owned = nullptr;  // Contents of the meta block, if on the heap.
     };
 
     Status Table::Open(const Options &options, RandomAccessFile *file, uint64_t file_size, Table **table) {
         // 文件 结尾 数据块
         Slice footer_input;
-        // 存放结尾块的字节空间 固定28字节空间
-        char footer_space[Footer::kEncodedLength];
-        // 读取文件末尾 28字节  到内存中
-        Status s = file->Read(file_size - Footer::kEncodedLength, Footer::kEncodedLength, &footer_input, footer_space);
+        // 存放结尾块的字节空间 最多 48 字节
+        char footer_space[Footer::kMaxEncodedLength];
+        const size_t footer_size = std::min<uint64_t>(file_size, Footer::kMaxEncodedLength);
+        // 读取文件末尾 footer 到内存中
+        Status s = file->Read(file_size - footer_size, footer_size, &footer_input, footer_space);
 
         if (!s.ok()) return s;
         // 解析尾巴信息
@@ -38,30 +101,668 @@ namespace leveldb {
             rep->index_block = index_block;
             rep->file = file;
             rep->options = options;
+            rep->blob_values = footer.has_blob_values();
             *table = new Table(rep);
+            if (footer.has_metaindex()) {
+                (*table)->ReadMeta(footer);
+            }
         }
-        return Status::OK();
+        return s;
     }
 
-    Iterator *Table::BlockReader(void *arg, const ReadOptions &options, const Slice &index_value) {
-        auto *table = reinterpret_cast<Table *>(arg);
-        BlockHandle handle{};
+    // 元数据块只用于加速，读取失败时表照样可用
+    void Table::ReadMeta(const Footer &footer) {
+        ReadOptions opt;
+        opt.verify_checksums = true;
+        BlockContents contents;
+        if (!ReadBlock(rep_->file, opt, footer.metaindex_handle(), &contents).ok()) {
+            return;
+        }
+        Block *meta = new Block(contents);
+        Iterator *iter = meta->NewIterator(BytewiseComparator());
+        const FilterPolicy *const policy = rep_->options.filter_policy;
+        if (policy != nullptr) {
+            std::string name = kFilterBlockNamePrefix;
+            name.append(policy->Name());
+            iter->Seek(name);
+            if (iter->Valid() && iter->key() == Slice(name)) {
+                ReadFilter(iter->value());
+            } else {
+                name = kPartitionedFilterBlockNamePrefix;
+                name.append(policy->Name());
+                iter->Seek(name);
+                if (iter->Valid() && iter->key() == Slice(name)) {
+                    ReadFilterIndex(iter->value());
+                }
+            }
+        }
+        // 只有建表时用的是同一个前缀提取器，过滤器里的前缀才有意义
+        const SliceTransform *const extractor = rep_->options.prefix_extractor;
+        if ((rep_->filter != nullptr || rep_->filter_index != nullptr) && extractor != nullptr) {
+            iter->Seek(kPrefixExtractorName);
+            rep_->prefix_filter = iter->Valid() && iter->key() == Slice(kPrefixExtractorName) &&
+                                  iter->value() == Slice(extractor->Name());
+        }
+        iter->Seek(kBlockPropertiesName);
+        if (iter->Valid() && iter->key() == Slice(kBlockPropertiesName)) {
+            Slice input = iter->value();
+            Slice name;
+            while (GetLengthPrefixedSlice(&input, &name)) {
+                rep_->property_names.push_back(name.ToString());
+            }
+        }
+        iter->Seek(kPerfectHashIndexBlockName);
+        if (iter->Valid() && iter->key() == Slice(kPerfectHashIndexBlockName)) {
+            ReadPerfectHashIndex(iter->value());
+        }
+        // 过滤器按字节序回答范围查询，换了比较器就不能用
+        iter->Seek(kRangeFilterBlockName);
+        if (iter->Valid() && iter->key() == Slice(kRangeFilterBlockName) &&
+            rep_->options.comparator == BytewiseComparator()) {
+            ReadRangeFilter(iter->value());
+        }
+        delete iter;
+        delete meta;
+    }
+
+    void Table::ReadPerfectHashIndex(const Slice &handle_value) {
+        Slice input = handle_value;
+        BlockHandle handle;
+        BlockContents contents;
+        ReadOptions opt;
+        opt.verify_checksums = true;
+        if (!handle.DecodeFrom(&input).ok() || !ReadBlock(rep_->file, opt, handle, &contents).ok()) {
+            return;
+        }
+
+        auto *index = new PerfectHashIndex;
+        index->owned = contents.heap_allocated ? contents.data.data() : nullptr;
+        const Slice data = contents.data;
+        bool ok = data.size() >= sizeof(uint32_t);
+        if (ok) {
+            const size_t hash_size = data.size() - sizeof(uint32_t);
+            index->index_restart_interval = DecodeFixed32(data.data() + hash_size);
+            ok = index->index_restart_interval > 0 && index->hash.Init(Slice(data.data(), hash_size));
+        }
+        if (!ok) {
+            delete index;
+            return;
+        }
+        rep_->perfect_hash = index;
+    }
+
+    void Table::ReadRangeFilter(const Slice &handle_value) {
+        Slice input = handle_value;
+        BlockHandle handle;
+        BlockContents contents;
+        ReadOptions opt;
+        opt.verify_checksums = true;
+        if (!handle.DecodeFrom(&input).ok() || !ReadBlock(rep_->file, opt, handle, &contents).ok()) {
+            return;
+        }
+        const char *owned = contents.heap_allocated ? contents.data.data() : nullptr;
+        if (!rep_->range_filter.Init(contents.data)) {
+            delete[] owned;
+            return;
+        }
+        rep_->range_filter_owned = owned;
+        rep_->has_range_filter = true;
+    }
+
+    void Table::ReadFilter(const Slice &handle_value) {
+        Slice input = handle_value;
+        BlockHandle handle;
+        BlockContents contents;
+        ReadOptions opt;
+        opt.verify_checksums = true;
+        if (!handle.DecodeFrom(&input).ok() || !ReadBlock(rep_->file, opt, handle, &contents).ok()) {
+            return;
+        }
+        if (contents.heap_allocated) {
+            rep_->filter_data = contents.data.data();
+        }
+        rep_->filter = new FilterBlockReader(rep_->options.filter_policy, contents.data);
+    }
+
+    void Table::ReadFilterIndex(const Slice &handle_value) {
+        Slice input = handle_value;
+        BlockHandle handle;
+        BlockContents contents;
+        ReadOptions opt;
+        opt.verify_checksums = true;
+        if (!handle.DecodeFrom(&input).ok() || !ReadBlock(rep_->file, opt, handle, &contents).ok()) {
+            return;
+        }
+        rep_->filter_index = new Block(contents);
+    }
+
+    bool Table::FilterMayMatch(const ReadOptions &options, const Slice &index_key,
+                               const Slice &index_value, const Slice &key) const {
+        if (rep_->filter_index != nullptr) {
+            return PartitionMayMatch(options, index_key, key);
+        }
         Slice input = index_value;
+        BlockHandle handle;
+        return rep_->filter == nullptr || !handle.DecodeFrom(&input).ok() ||
+               rep_->filter->KeyMayMatch(handle.offset(), key);
+    }
+
+    bool Table::PartitionMayMatch(const ReadOptions &options, const Slice &index_key, const Slice &key) const {
+        // 分区按 data block 切分：data block 的 index key 落在哪个分区，它的 key 就在哪个分区
+        Iterator *iter = rep_->filter_index->NewIterator(rep_->options.comparator);
+        iter->Seek(index_key);
+        bool may_match = true;
+        if (iter->Valid()) {
+            Slice input = iter->value();
+            BlockHandle handle;
+            // 读不出来的分区只能当作可能存在
+            if (handle.DecodeFrom(&input).ok()) {
+                ProbePartition(options, handle, 1, &key, &may_match);
+            }
+        }
+        delete iter;
+        return may_match;
+    }
+
+    void Table::ProbePartition(const ReadOptions &options, const BlockHandle &handle, int n,
+                               const Slice *keys, bool *results) const {
+        // 分区里只有一个过滤器，偏移都是 0
+        const std::vector<uint64_t> offsets(n, 0);
+        {
+            MutexLock l(&rep_->partition_mu);
+            if (rep_->partition != nullptr && rep_->partition_offset == handle.offset()) {
+                rep_->partition->KeysMayMatch(n, offsets.data(), keys, results);
+                return;
+            }
+        }
+
         BlockContents contents;
+        if (!ReadBlock(rep_->file, options, handle, &contents).ok()) {
+            std::fill(results, results + n, true);
+            return;
+        }
+        auto *partition = new FilterBlockReader(rep_->options.filter_policy, contents.data);
+        partition->KeysMayMatch(n, offsets.data(), keys, results);
+
+        // 换下原来留住的分区；别的线程只在持锁时用它，放锁后就可以删
+        FilterBlockReader *old_partition;
+        const char *old_data;
+        {
+            MutexLock l(&rep_->partition_mu);
+            old_partition = rep_->partition;
+            old_data = rep_->partition_data;
+            rep_->partition = partition;
+            rep_->partition_data = contents.heap_allocated ? contents.data.data() : nullptr;
+            rep_->partition_offset = handle.offset();
+        }
+        delete old_partition;
+        delete[] old_data;
+    }
+
+    void Table::KeysMayMatch(int n, const Slice *keys, bool *results) const {
+        // 先在 index block 里找到每个 key 的 data block，再把要探测的过滤器一起交给过滤策略
+        std::vector<int> probed;
+        std::vector<uint64_t> offsets;
+        std::vector<Slice> probe_keys;
+        // 分区过滤器：按分区把 key 分组，每个分区只读一次
+        std::map<uint64_t, std::pair<BlockHandle, std::vector<int>>> partition_keys;
+        Iterator *iter = rep_->index_block->NewIterator(rep_->options.comparator);
+        Iterator *partition_iter = rep_->filter_index != nullptr
+                                   ? rep_->filter_index->NewIterator(rep_->options.comparator)
+                                   : nullptr;
+        for (int i = 0; i < n; i++) {
+            iter->Seek(keys[i]);
+            if (!iter->Valid()) {
+                // 比表里所有 key 都大
+                results[i] = !iter->status().ok();
+                continue;
+            }
+            results[i] = true;
+            if (partition_iter != nullptr) {
+                partition_iter->Seek(iter->key());
+                Slice input = partition_iter->Valid() ? partition_iter->value() : Slice();
+                BlockHandle handle;
+                if (handle.DecodeFrom(&input).ok()) {
+                    auto &group = partition_keys[handle.offset()];
+                    group.first = handle;
+                    group.second.push_back(i);
+                }
+                continue;
+            }
+            Slice input = iter->value();
+            BlockHandle handle;
+            if (rep_->filter != nullptr && handle.DecodeFrom(&input).ok()) {
+                probed.push_back(i);
+                offsets.push_back(handle.offset());
+                probe_keys.push_back(keys[i]);
+            }
+        }
+        delete partition_iter;
+        delete iter;
+
+        for (const auto &entry: partition_keys) {
+            const std::vector<int> &indices = entry.second.second;
+            std::vector<Slice> group_keys;
+            for (int i: indices) {
+                group_keys.push_back(keys[i]);
+            }
+            std::unique_ptr<bool[]> group_results(new bool[indices.size()]);
+            ProbePartition(ReadOptions(), entry.second.first, static_cast<int>(indices.size()), group_keys.data(),
+                           group_results.get());
+            for (size_t j = 0; j < indices.size(); j++) {
+                results[indices[j]] = group_results[j];
+            }
+        }
+        if (probed.empty()) return;
+
+        std::unique_ptr<bool[]> probe_results(new bool[probed.size()]);
+        rep_->filter->KeysMayMatch(static_cast<int>(probed.size()), offsets.data(), probe_keys.data(),
+                                   probe_results.get());
+        for (size_t j = 0; j < probed.size(); j++) {
+            results[probed[j]] = probe_results[j];
+        }
+    }
+
+    bool Table::PrefixMayMatch(const Slice &target) const {
+        const SliceTransform *const extractor = rep_->options.prefix_extractor;
+        if (!rep_->prefix_filter || !extractor->InDomain(target)) {
+            return true;
+        }
+        const Slice prefix = extractor->Transform(target);
+        // 同一前缀的 key 连续存放：>= target 的这些 key 要么在 target 所在的块，
+        // 要么从下一个块的开头开始
+        Iterator *iter = rep_->index_block->NewIterator(rep_->options.comparator);
+        iter->Seek(target);
+        bool may_match = !iter->status().ok();
+        for (int i = 0; i < 2 && !may_match && iter->Valid(); i++) {
+            may_match = FilterMayMatch(ReadOptions(), iter->key(), iter->value(), prefix);
+            iter->Next();
+        }
+        if (!iter->status().ok()) {
+            may_match = true;
+        }
+        delete iter;
+        return may_match;
+    }
+
+    bool Table::RangeMayMatch(const Slice &begin, const Slice &end) const {
+        return !rep_->has_range_filter || rep_->range_filter.RangeMayMatch(begin, end);
+    }
+
+    bool Table::PerfectHashGet(const ReadOptions &options, const Slice &key,
+                               void (*handle_result)(const Slice &, const Slice &), Status *s) const {
+        const PerfectHashIndex *index = rep_->perfect_hash;
+        uint64_t block;
+        if (!index->hash.Lookup(key, &block)) {
+            return index->hash.Complete();
+        }
+        // 第 block 个 data block 就是 index block 的第 block 项：跳到它所在的组再往后走
+        const uint32_t interval = index->index_restart_interval;
+        if (block / interval >= 0xffffffffu) {
+            return false;
+        }
+        Iterator *index_iter = rep_->index_block->NewIteratorAt(rep_->options.comparator,
+                                                                static_cast<uint32_t>(block / interval));
+        for (uint64_t i = block % interval; i > 0 && index_iter->Valid(); i--) {
+            index_iter->Next();
+        }
+        if (!index_iter->Valid()) {
+            // 块号超出了 index block，哈希和表对不上，只能按 index 找
+            delete index_iter;
+            return false;
+        }
+
+        // 表里的 key 一定被映射到它自己的块：过滤器排除了它，或者块里没有它，表里就没有它
+        bool found = false;
+        if (FilterMayMatch(options, index_iter->key(), index_iter->value(), key)) {
+            Iterator *block_iter = ReadDataBlock(rep_->file, options, index_iter->value());
+            block_iter->Seek(key);
+            if (block_iter->Valid() && rep_->options.comparator->Compare(block_iter->key(), key) == 0) {
+                (*handle_result)(block_iter->key(), block_iter->value());
+                found = true;
+            }
+            *s = block_iter->status();
+            delete block_iter;
+        }
+        delete index_iter;
+        return found || !s->ok() || index->hash.Complete();
+    }
+
+    Table::~Table() {
+        delete rep_->index_block;
+        delete rep_;
+    }
+
+    // 扫描迭代器私有的状态：带预读的文件
+    struct Table::ScanState {
+        ScanState(const Table *t, size_t readahead_size)
+                : table(t), file(t->rep_->file, readahead_size) {}
+
+        const Table *const table;
+        ReadaheadRandomAccessFile file;
+    };
+
+    static void DeleteBlock(void *arg, void *) {
+        delete reinterpret_cast<Block *>(arg);
+    }
+
+    Iterator *Table::ReadDataBlock(RandomAccessFile *file, const ReadOptions &options,
+                                   const Slice &index_value) const {
+        BlockHandle handle{};
+        Slice input = index_value;
         // 解析出来 offset_  size_
-        handle.DecodeFrom(&input);
+        Status s = handle.DecodeFrom(&input);
+        if (!s.ok()) {
+            return NewErrorIterator(s);
+        }
+        // 块的摘要说明里面没有满足谓词的 entry，就当它是空块
+        if (options.block_property_filter != nullptr &&
+            !BlockPropertiesMayMatch(*options.block_property_filter, input)) {
+            return NewEmptyIterator();
+        }
+        return ReadDataBlock(file, options, handle);
+    }
+
+    bool Table::BlockPropertiesMayMatch(const BlockPropertyFilter &filter, const Slice &properties) const {
+        Slice input = properties;
+        for (const std::string &name: rep_->property_names) {
+            Slice summary;
+            if (!GetLengthPrefixedSlice(&input, &summary)) {
+                return true;
+            }
+            if (name == filter.Name()) {
+                return filter.MayMatch(summary);
+            }
+        }
+        return true;
+    }
+
+    Iterator *Table::ReadDataBlock(RandomAccessFile *file, const ReadOptions &options,
+                                   const BlockHandle &handle) const {
+        Status s;
+        BlockContents contents;
         // 从文件中 读取 这个 data block 内容
-        Status s = ReadBlock(table->rep_->file, options, handle, &contents);
+        s = ReadBlock(file, options, handle, &contents);
+        if (!s.ok()) {
+            return NewErrorIterator(s);
+        }
+
         // 解析 data block 中的 data + restarts_offset_
         Block *block = new Block(contents);
-        // data block 迭代器
-        return block->NewIterator(table->rep_->options.comparator);
+        // data block 迭代器, 迭代器销毁时一并释放 block
+        Iterator *iter = block->NewIterator(rep_->options.comparator, options.key_only);
+        iter->RegisterCleanup(&DeleteBlock, block, nullptr);
+        if (rep_->blob_values && !options.key_only) {
+            // 去掉 value 的类型标记，blob 延迟到取 value 时才读
+            iter = NewBlobValueIterator(iter, rep_->options.blob_source, options);
+        }
+        return iter;
+    }
+
+    Iterator *Table::BlockReader(void *arg, const ReadOptions &options, const Slice &index_value) {
+        auto *table = reinterpret_cast<Table *>(arg);
+        return table->ReadDataBlock(table->rep_->file, options, index_value);
+    }
+
+    Iterator *Table::ScanBlockReader(void *arg, const ReadOptions &options, const Slice &index_value) {
+        auto *state = reinterpret_cast<ScanState *>(arg);
+        return state->table->ReadDataBlock(&state->file, options, index_value);
+    }
+
+    namespace {
+
+        // 有界的表迭代器：定位前先问过滤器，[target, 上界) 里或者 target 的前缀下
+        // 没有 key 就不读任何块
+        class BoundedIterator : public Iterator {
+        public:
+            // Takes ownership of "iter".  Either bound may be null.
+            BoundedIterator(Iterator *iter, const Table *table, const Comparator *comparator, const Slice *upper,
+                            const SliceTransform *prefix_extractor)
+                    : iter_(iter), table_(table), comparator_(comparator), upper_(upper),
+                      prefix_extractor_(prefix_extractor), has_prefix_(false), valid_(false) {}
+
+            ~BoundedIterator() override { delete iter_; }
+
+            bool Valid() const override { return valid_; }
+
+            void SeekToFirst() override {
+                has_prefix_ = false;
+                if (upper_ != nullptr && !table_->RangeMayMatch(Slice(), *upper_)) {
+                    valid_ = false;
+                    return;
+                }
+                iter_->SeekToFirst();
+                Update();
+            }
+
+            void SeekToLast() override {
+                has_prefix_ = false;
+                if (upper_ == nullptr) {
+                    iter_->SeekToLast();
+                } else {
+                    iter_->Seek(*upper_);
+                    if (iter_->Valid()) {
+                        iter_->Prev();
+                    } else if (iter_->status().ok()) {
+                        iter_->SeekToLast();
+                    }
+                }
+                Update();
+            }
+
+            void Seek(const Slice &target) override {
+                has_prefix_ = prefix_extractor_ != nullptr && prefix_extractor_->InDomain(target);
+                if (has_prefix_) {
+                    const Slice prefix = prefix_extractor_->Transform(target);
+                    prefix_.assign(prefix.data(), prefix.size());
+                }
+                if ((upper_ != nullptr && !table_->RangeMayMatch(target, *upper_)) ||
+                    (has_prefix_ && !table_->PrefixMayMatch(target))) {
+                    valid_ = false;
+                    return;
+                }
+                iter_->Seek(target);
+                Update();
+            }
+
+            void Next() override {
+                iter_->Next();
+                Update();
+            }
+
+            void Prev() override {
+                iter_->Prev();
+                Update();
+            }
+
+            Slice key() const override { return iter_->key(); }
+
+            Slice value() const override { return iter_->value(); }
+
+            void GetLazyValue(LazyValue *value) const override { iter_->GetLazyValue(value); }
+
+            Status status() const override { return iter_->status(); }
+
+        private:
+            void Update() {
+                valid_ = iter_->Valid() && (upper_ == nullptr || comparator_->Compare(iter_->key(), *upper_) < 0) &&
+                         (!has_prefix_ || iter_->key().starts_with(prefix_));
+            }
+
+            Iterator *const iter_;
+            const Table *const table_;
+            const Comparator *const comparator_;
+            const Slice *const upper_;
+            const SliceTransform *const prefix_extractor_;
+            bool has_prefix_;     // Seek() limited the iterator to prefix_.
+            std::string prefix_;
+            bool valid_;
+        };
+
+    }  // namespace
+
+    Iterator *Table::NewIterator(const ReadOptions &options) const {
+        Iterator *index_iter = rep_->index_block->NewIterator(rep_->options.comparator);
+        Iterator *iter;
+        if (options.readahead_size == 0) {
+            iter = NewTwoLevelIterator(index_iter, &Table::BlockReader, const_cast<Table *>(this), options);
+        } else {
+            auto *state = new ScanState(this, options.readahead_size);
+            iter = NewTwoLevelIterator(index_iter, &Table::ScanBlockReader, state, options);
+            iter->RegisterCleanup([](void *arg, void *) { delete reinterpret_cast<ScanState *>(arg); },
+                                  state, nullptr);
+        }
+        const SliceTransform *const extractor = options.prefix_same_as_start ? rep_->options.prefix_extractor : nullptr;
+        if (options.iterate_upper_bound != nullptr || extractor != nullptr) {
+            iter = new BoundedIterator(iter, this, rep_->options.comparator, options.iterate_upper_bound, extractor);
+        }
+        return iter;
+    }
+
+    void Table::MultiGet(const ReadOptions &options, int n, const Slice *keys, std::string *values,
+                         Status *statuses) const {
+        RateLimiter *const rate_limiter = rep_->options.rate_limiter;
+        const uint64_t start_micros = (rate_limiter != nullptr) ? rep_->options.env->NowMicros() : 0;
+        const Comparator *const cmp = rep_->options.comparator;
+
+        // 先在 index block 里找到每个 key 的 data block，同一个块只读一次
+        std::vector<BlockHandle> handles;
+        std::vector<std::vector<int>> block_keys;
+        std::map<uint64_t, size_t> block_of_offset;
+        Iterator *iter = rep_->index_block->NewIterator(cmp);
+        for (int i = 0; i < n; i++) {
+            values[i].clear();
+            statuses[i] = Status::NotFound(Slice());
+            iter->Seek(keys[i]);
+            if (!iter->Valid()) {
+                // 比表里所有 key 都大
+                if (!iter->status().ok()) {
+                    statuses[i] = iter->status();
+                }
+                continue;
+            }
+            Slice input = iter->value();
+            BlockHandle handle;
+            Status s = handle.DecodeFrom(&input);
+            if (!s.ok()) {
+                statuses[i] = s;
+                continue;
+            }
+            if ((options.block_property_filter != nullptr &&
+                 !BlockPropertiesMayMatch(*options.block_property_filter, input)) ||
+                !FilterMayMatch(options, iter->key(), iter->value(), keys[i])) {
+                continue;
+            }
+            auto it = block_of_offset.find(handle.offset());
+            if (it == block_of_offset.end()) {
+                it = block_of_offset.insert(std::make_pair(handle.offset(), handles.size())).first;
+                handles.push_back(handle);
+                block_keys.emplace_back();
+            }
+            block_keys[it->second].push_back(i);
+        }
+        if (!iter->status().ok()) {
+            for (int i = 0; i < n; i++) {
+                if (statuses[i].IsNotFound()) statuses[i] = iter->status();
+            }
+        }
+        delete iter;
+
+        // 直接 I/O 的文件按对齐的范围读，块从读出来的数据中间开始
+        const size_t alignment = rep_->file->GetRequiredBufferAlignment();
+        std::vector<ReadRequest> requests(handles.size());
+        std::vector<size_t> prefixes(handles.size(), 0);
+        Status alloc_status;
+        for (size_t b = 0; b < handles.size(); b++) {
+            ReadRequest &req = requests[b];
+            req.offset = handles[b].offset();
+            req.n = static_cast<size_t>(handles[b].size()) + kBlockTrailerSize;
+            if (alignment > 0) {
+                prefixes[b] = static_cast<size_t>(req.offset % alignment);
+                req.offset -= prefixes[b];
+                req.n = (prefixes[b] + req.n + alignment - 1) / alignment * alignment;
+            }
+            void *buf = nullptr;
+            if (posix_memalign(&buf, std::max(alignment, sizeof(void *)), req.n) != 0) {
+                alloc_status = Status::IOError("out of memory for block reads");
+                requests.resize(b);
+                break;
+            }
+            req.scratch = static_cast<char *>(buf);
+        }
+        if (alloc_status.ok() && !requests.empty()) {
+            // 每个请求各自带着结果，出错的块只影响落在它里面的 key
+            rep_->file->MultiRead(requests.data(), requests.size());
+        }
+
+        for (size_t b = 0; b < handles.size(); b++) {
+            const std::vector<int> &members = block_keys[b];
+            Status s = alloc_status;
+            BlockContents contents;
+            if (s.ok()) {
+                const ReadRequest &req = requests[b];
+                const size_t size = static_cast<size_t>(handles[b].size()) + kBlockTrailerSize;
+                s = req.status;
+                if (s.ok() && req.result.size() < prefixes[b] + size) {
+                    s = Status::Corruption("truncated block read");
+                }
+                if (s.ok()) {
+                    s = DecodeBlockContents(options, Slice(req.result.data() + prefixes[b], size), &contents);
+                }
+            }
+            if (!s.ok()) {
+                for (int i: members) statuses[i] = s;
+                continue;
+            }
+            Block block(contents);
+            Iterator *block_iter = block.NewIterator(cmp);
+            if (rep_->blob_values) {
+                block_iter = NewBlobValueIterator(block_iter, rep_->options.blob_source, options);
+            }
+            for (int i: members) {
+                block_iter->Seek(keys[i]);
+                if (block_iter->Valid() && cmp->Compare(block_iter->key(), keys[i]) == 0) {
+                    const Slice value = block_iter->value();
+                    values[i].assign(value.data(), value.size());
+                    statuses[i] = block_iter->status();
+                } else if (!block_iter->status().ok()) {
+                    statuses[i] = block_iter->status();
+                }
+            }
+            delete block_iter;
+        }
+        for (ReadRequest &req: requests) {
+            free(req.scratch);
+        }
+
+        if (rate_limiter != nullptr) {
+            rate_limiter->ReportForegroundLatency(rep_->options.env->NowMicros() - start_micros);
+        }
+    }
+
+    void Table::GetIndexKeys(std::vector<std::string> *keys) const {
+        Iterator *iter = rep_->index_block->NewIterator(rep_->options.comparator);
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+            keys->push_back(iter->key().ToString());
+        }
+        delete iter;
     }
 
     // 读取数据,回调函数
     Status Table::InternalGet(const ReadOptions &options, const Slice &key,
                               void (*handle_result)(const Slice &, const Slice &)) {
         Status s;
+        // 点查延迟反馈给限速器，用于自动调节后台写的带宽
+        RateLimiter *const rate_limiter = rep_->options.rate_limiter;
+        const uint64_t start_micros = (rate_limiter != nullptr) ? rep_->options.env->NowMicros() : 0;
+
+        // 有完美哈希时只读 key 所在的那一个 data block
+        if (rep_->perfect_hash != nullptr && PerfectHashGet(options, key, handle_result, &s)) {
+            if (rate_limiter != nullptr) {
+                rate_limiter->ReportForegroundLatency(rep_->options.env->NowMicros() - start_micros);
+            }
+            return s;
+        }
 
         // 给 index block 建立迭代器
         Iterator *iterator = rep_->index_block->NewIterator(rep_->options.comparator);
@@ -69,7 +770,8 @@ namespace leveldb {
         // 在 index block 中定位到 key
         iterator->Seek(key);
         //
-        if (iterator->Valid()) {
+        // 过滤器排除了 key 就不读 data block
+        if (iterator->Valid() && FilterMayMatch(options, iterator->key(), iterator->value(), key)) {
             // 获得 data block 的 handle
             Slice handle_value = iterator->value();
             // handle 中有 data block 的 offset 和 size
@@ -80,7 +782,12 @@ namespace leveldb {
             //
             if (block_iter->Valid()) {
                 // 用 handle_result 函数处理 kv 对
-                (*handle_result)(block_iter->key(), block_iter->value());
+                // 落在别的 key 上时不值得去读它的 blob，只交给回调一个空 value
+                if (rep_->blob_values && rep_->options.comparator->Compare(block_iter->key(), key) != 0) {
+                    (*handle_result)(block_iter->key(), Slice());
+                } else {
+                    (*handle_result)(block_iter->key(), block_iter->value());
+                }
             }
             s = block_iter->status();
             delete block_iter;
@@ -91,6 +798,9 @@ namespace leveldb {
         }
 
         delete iterator;
+        if (rate_limiter != nullptr) {
+            rate_limiter->ReportForegroundLatency(rep_->options.env->NowMicros() - start_micros);
+        }
         return s;
     }
 }
\ No newline at end of file
@@ -8,6 +8,9 @@
 #include "format.h"
 #include "block.h"
 
+#include <string>
+#include <vector>
+
 namespace leveldb {
     struct Options;
 
@@ -21,13 +24,123 @@ namespace leveldb {
 
         Table(const Table &) = delete;
 
+        Table &operator=(const Table &) = delete;
+
+        // Does not close or delete the file passed to Open().
+        ~Table();
+
+        // Returns a new iterator over the table contents.
+        // The result of NewIterator() is initially invalid (caller must
+        // call one of the Seek methods on the iterator before using it).
+        Iterator *NewIterator(const ReadOptions &) const;
+
+        // Calls handle_result with the first entry at or after key, if any.
+        // In a table with blob references, the blob is only read when the
+        // entry's key equals "key"; otherwise the value passed is empty.
+        // In a table with a filter (see Options::filter_policy), nothing is
+        // reported when the filter of the key's data block rules it out.
+        // In a table with a perfect hash index (see
+        // Options::perfect_hash_index), only an entry equal to "key" is
+        // reported.
         Status InternalGet(const ReadOptions &, const Slice &key,
                            void (*handle_result)(const Slice &k, const Slice &v));
 
+        // Looks up keys[i] for every i in [0, n).  If the table has an entry
+        // whose key equals keys[i], stores its value in values[i] and sets
+        // statuses[i] to OK; otherwise statuses[i] is NotFound, or says why
+        // the lookup failed.  The data blocks the batch needs are read once
+        // each, together, with one RandomAccessFile::MultiRead(), so a file
+        // that overlaps reads fetches them in parallel.
+        void MultiGet(const ReadOptions &options, int n, const Slice *keys, std::string *values,
+                      Status *statuses) const;
+
+        // Appends the keys of the index block to *keys, in order.  Each one
+        // separates two adjacent data blocks, so they cut the table into key
+        // ranges of about one block each without reading any data block.
+        void GetIndexKeys(std::vector<std::string> *keys) const;
+
+        // Returns false if the table has a range filter (see
+        // Options::range_filter) and it rules out any key in [begin, end).
+        // Reads no data block.
+        bool RangeMayMatch(const Slice &begin, const Slice &end) const;
+
+        // Returns false if the table's filter rules out any key at or after
+        // "target" with the same prefix (see Options::prefix_extractor).
+        // Searches the index block but reads no data block; a partitioned
+        // filter reads the partitions it needs.
+        bool PrefixMayMatch(const Slice &target) const;
+
+        // Sets results[i] to false if InternalGet(keys[i]) would find nothing
+        // because the key is past the table or its data block's filter rules
+        // it out, for every i in [0, n).  Reads no data block; the filters of
+        // the whole batch are probed together (see
+        // FilterPolicy::KeysMayMatch()); with a partitioned filter, the keys
+        // of each partition are probed together after one read of it.
+        void KeysMayMatch(int n, const Slice *keys, bool *results) const;
+
     private:
         struct Rep;
 
-        Iterator *BlockReader(void *arg, const ReadOptions &options,const Slice &index_value);
+        struct ScanState;
+
+        struct PerfectHashIndex;
+
+        // Loads the meta blocks the table understands; ignores the rest and
+        // any that can not be read, which only make lookups slower.
+        void ReadMeta(const Footer &footer);
+
+        void ReadPerfectHashIndex(const Slice &handle_value);
+
+        void ReadRangeFilter(const Slice &handle_value);
+
+        void ReadFilter(const Slice &handle_value);
+
+        void ReadFilterIndex(const Slice &handle_value);
+
+        // Whether "filter" may match a data block whose index entry has the
+        // summaries "properties" after the handle.  True if the table has no
+        // summary of the filter's property.
+        bool BlockPropertiesMayMatch(const BlockPropertyFilter &filter, const Slice &properties) const;
+
+        // Whether the filter of the data block at the index entry
+        // "index_key" -> "index_value" may hold "key".
+        bool FilterMayMatch(const ReadOptions &options, const Slice &index_key,
+                            const Slice &index_value, const Slice &key) const;
+
+        // Whether the filter partition covering the data block with index
+        // key "index_key" may hold "key".  Reads the partition unless it is
+        // the one kept from the last read.  "key" itself also finds the
+        // partition of the block that would hold it.
+        bool PartitionMayMatch(const ReadOptions &options, const Slice &index_key, const Slice &key) const;
+
+        // Sets results[i] to whether the filter partition at "handle" may
+        // hold keys[i], for every i in [0, n).  Keeps the last partition it
+        // read for later calls; a partition that cannot be read may match.
+        void ProbePartition(const ReadOptions &options, const BlockHandle &handle, int n,
+                            const Slice *keys, bool *results) const;
+
+        // Looks "key" up in the one data block the perfect hash maps it to,
+        // calling handle_result if the block holds it and storing any read
+        // error in *s.  Returns false if the index must be searched instead:
+        // the hash maps the key nowhere (or to no block) and may have left
+        // keys out.  Otherwise a key missing from its block is not in the
+        // table.
+        bool PerfectHashGet(const ReadOptions &options, const Slice &key,
+                            void (*handle_result)(const Slice &k, const Slice &v), Status *s) const;
+
+        // Converts an index block entry into an iterator over the data block,
+        // reading it from the table's file.  "arg" is the Table.
+        static Iterator *BlockReader(void *arg, const ReadOptions &options, const Slice &index_value);
+
+        // Same as BlockReader, but "arg" is a ScanState whose file reads ahead.
+        static Iterator *ScanBlockReader(void *arg, const ReadOptions &options, const Slice &index_value);
+
+        Iterator *ReadDataBlock(RandomAccessFile *file, const ReadOptions &options,
+                                const Slice &index_value) const;
+
+        // Reads the data block at "handle".
+        Iterator *ReadDataBlock(RandomAccessFile *file, const ReadOptions &options,
+                                const BlockHandle &handle) const;
 
         explicit Table(Rep *rep) : rep_(rep) {};
 
@@ -1,5 +1,13 @@
 #include "table_builder.h"
 
+#include "blob_file.h"
+#include "block_property.h"
+#include "filter_block.h"
+#include "filter_policy.h"
+#include "perfect_hash.h"
+#include "range_filter.h"
+#include "slice_transform.h"
+
 namespace leveldb {
 
     // 这里之所以要特意用一个结构体来存储变量而不直接在类中定义变量
@@ -24,23 +32,93 @@ namespace leveldb {
 
         std::string last_key;
 
-        Rep(const Options &opt, WritableFile *f)
+        // 大 value 写入 blob 文件；非空时每个 value 前都带一个 ValueType
+        BlobFileBuilder *blob_file;
+        std::string tagged_value;
+
+        // options.perfect_hash_index: 每个 key 映射到它所在 data block 的编号
+        PerfectHashBuilder *perfect_hash;
+        uint32_t num_data_blocks;  // Data blocks written so far.
+
+        // options.filter_policy: 每 2KB 数据(或整张表)一个过滤器，除了 key 还放入它的前缀
+        FilterBlockBuilder *filter_block;
+        std::string last_prefix;  // Last prefix added for the data block being built.
+        bool has_last_prefix;
+
+        // kPartitionedFilter: filter_block 只收当前分区的 key，分区在 data block 边界切开
+        BlockBuilder *filter_index;  // Index key of a partition's last data block -> partition.
+        uint64_t partition_keys;     // Keys added to the partition being built.
+        bool cut_filter_partition;   // End the partition once its last index key is known.
+
+        // options.range_filter: 只在 key 按字节序排列时才能建
+        RangeFilterBuilder *range_filter;
+
+        // options.block_property_collectors: 每个 data block 的摘要跟在它的 handle 后面写进 index block
+        std::vector<BlockPropertyCollector *> collectors;
+        std::string pending_properties;  // Summaries of the data block at pending_handle.
+
+        Rep(const Options &opt, WritableFile *f, BlobFileBuilder *blob)
                 : options(opt),
                   index_block_options(opt),
+                  data_block(&options, std::string("data block")),
                   index_block(&index_block_options, std::string("index block")),
-                  data_block(&opt, std::string("data block")),
                   file(f),
+                  pending_index_entry(false),// 刚刚开始时，不向index block写入数据
                   offset(0),
-                  pending_index_entry(false)// 刚刚开始时，不向index block写入数据
-        {}
+                  blob_file(blob),
+                  perfect_hash(opt.perfect_hash_index ? new PerfectHashBuilder : nullptr),
+                  num_data_blocks(0),
+                  filter_block(opt.filter_policy == nullptr
+                               ? nullptr
+                               : new FilterBlockBuilder(opt.filter_policy,
+                                                        opt.filter_block_format != kDataRangeFilters)),
+                  has_last_prefix(false),
+                  filter_index(opt.filter_policy != nullptr && opt.filter_block_format == kPartitionedFilter
+                               ? new BlockBuilder(&index_block_options, std::string("filter index block"))
+                               : nullptr),
+                  partition_keys(0),
+                  cut_filter_partition(false),
+                  range_filter(nullptr) {
+            // index block 总是二分查找 key 并取出 handle，分开存放没有好处
+            index_block_options.data_block_format = kInterleavedBlock;
+            if (opt.range_filter && opt.comparator == BytewiseComparator()) {
+                range_filter = new RangeFilterBuilder;
+            }
+            if (filter_block != nullptr) {
+                filter_block->StartBlock(0);
+            }
+            for (const BlockPropertyCollectorFactory *factory: opt.block_property_collectors) {
+                collectors.push_back(factory->NewCollector());
+            }
+        }
+
+        ~Rep() {
+            delete perfect_hash;
+            delete filter_block;
+            delete filter_index;
+            delete range_filter;
+            for (BlockPropertyCollector *collector: collectors) {
+                delete collector;
+            }
+        }
     };
 
-    TableBuilder::TableBuilder(const Options &options, WritableFile *file) : rep_(new Rep(options, file)) {
+    TableBuilder::TableBuilder(const Options &options, WritableFile *file, BlobFileBuilder *blob_file)
+            : rep_(new Rep(options, file, blob_file)) {
     }
 
+    TableBuilder::~TableBuilder() { delete rep_; }
+
     // TableBuilder
     void TableBuilder::Add(const Slice &key, const Slice &value) {
         Rep *r = rep_;// db 实例
+        if (!ok()) return;
+        // 定长 key 格式只接受 fixed_key_size 字节的 key
+        if (r->options.data_block_format == kFixedKeyBlock &&
+            (key.size() != r->options.fixed_key_size || key.empty())) {
+            r->status = Status::InvalidArgument("key size differs from options.fixed_key_size", key);
+            return;
+        }
 
         // 如果之前 持久化了一个 data block，则准备向 index block 插入一条指向它的 kv 对
         if (r->pending_index_entry) {
@@ -53,6 +131,7 @@ namespace leveldb {
             std::string pre_data_handle_encoding;
             // pending_handle 存放的是 上一次 data block 刷盘的信息
             r->pending_handle.EncodeTo(&pre_data_handle_encoding);
+            pre_data_handle_encoding.append(r->pending_properties);
 
             // BlockBuilder 类型: 写入 index block
             // 此时的 r->last_key 可能会发生变化，然后将其所在的位移信息 加入到 index 块中
@@ -60,13 +139,57 @@ namespace leveldb {
             // 上一个 data block 块之后
             r->index_block.Add(r->last_key, Slice(pre_data_handle_encoding));
             r->pending_index_entry = false;
+            if (r->cut_filter_partition) {
+                WriteFilterPartition();
+                if (!ok()) return;
+            }
         }
 
         // 上一步 没有持久化
         // 更新全局 last_key ，由于不用前缀压缩，所以直接把key复制进来
         r->last_key.assign(key.data(), key.size());
         // BlockBuilder 类型 写入 data block
-        r->data_block.Add(key, value);
+        if (r->blob_file == nullptr) {
+            r->data_block.Add(key, value);
+        } else {
+            // 大 value 写入 blob 文件，data block 中只保留 (file, offset, size) 引用
+            r->tagged_value.clear();
+            if (value.size() >= r->options.min_blob_size) {
+                BlobIndex index;
+                r->status = r->blob_file->Add(value, &index);
+                if (!ok()) return;
+                r->tagged_value.push_back(static_cast<char>(kTypeBlobIndex));
+                index.EncodeTo(&r->tagged_value);
+            } else {
+                r->tagged_value.push_back(static_cast<char>(kTypeInlineValue));
+                r->tagged_value.append(value.data(), value.size());
+            }
+            r->data_block.Add(key, r->tagged_value);
+        }
+        if (r->perfect_hash != nullptr) {
+            r->perfect_hash->Add(key, r->num_data_blocks);
+        }
+        if (r->filter_block != nullptr) {
+            r->filter_block->AddKey(key);
+            r->partition_keys++;
+            // key 有序，同一前缀的 key 相邻，一个块里每个前缀只加一次
+            const SliceTransform *const extractor = r->options.prefix_extractor;
+            if (extractor != nullptr && extractor->InDomain(key)) {
+                const Slice prefix = extractor->Transform(key);
+                if (!r->has_last_prefix || prefix != Slice(r->last_prefix)) {
+                    r->filter_block->AddKey(prefix);
+                    r->partition_keys++;
+                    r->last_prefix.assign(prefix.data(), prefix.size());
+                    r->has_last_prefix = true;
+                }
+            }
+        }
+        if (r->range_filter != nullptr) {
+            r->range_filter->AddKey(key);
+        }
+        for (BlockPropertyCollector *collector: r->collectors) {
+            collector->Add(key, value);
+        }
 
         // 估计 data block 的大小
         const size_t estimated_block_size = r->data_block.CurrentSizeEstimate();
@@ -79,15 +202,35 @@ namespace leveldb {
 
     void TableBuilder::Flush() {
         Rep *r = rep_;
+        if (!ok()) return;
+        // 没有新数据就不写空块，否则会覆盖掉还没写进 index block 的 pending_handle
+        if (r->data_block.empty()) return;
 
         // 持久化到磁盘，并生成 BlockHandle 到 pending_handle,以供下次 写时,将这次的信息 组装成 index 来保存
         // 先用 snappy 压缩，后进行 crc 编码，最终持久化到磁盘,更新全局 offset
         WriteBlock(&r->data_block, &r->pending_handle);
 
         if (ok()) {
+            r->num_data_blocks++;
             // 此时 block 已经 刷盘了，并且 刷盘的位置 大小 赋值给了 &r->pending_handle 变量
             // 那么接下开怎么做？让下一次 key 参与这次刷盘后的 index block 的建设
             r->pending_index_entry = true;
+            if (!r->collectors.empty()) {
+                r->pending_properties.clear();
+                std::string summary;
+                for (BlockPropertyCollector *collector: r->collectors) {
+                    summary.clear();
+                    collector->FinishBlock(&summary);
+                    PutLengthPrefixedSlice(&r->pending_properties, summary);
+                }
+            }
+            if (r->filter_block != nullptr) {
+                r->filter_block->StartBlock(r->offset);
+                r->has_last_prefix = false;
+                // 分区的最后一个 index key 要等下一个 key 来了才能确定
+                r->cut_filter_partition =
+                        r->filter_index != nullptr && r->partition_keys >= r->options.filter_partition_keys;
+            }
             // 调用文件系统的刷新接口，实际上并没有真正地持久化到磁盘，还是有可能存储在文件系统的buffer pool
             // 甚至是FTL的cache里
             r->status = r->file->Flush();
@@ -188,40 +331,144 @@ namespace leveldb {
         }
     }
 
+    // The perfect hash index meta block is
+    //    perfect hash (see perfect_hash.h) | fixed32 index block restart interval
+    // A key's value in the perfect hash is the number of its data block,
+    // which is also the number of the block's entry in the index block; the
+    // restart interval lets a reader jump to that entry.
+    void TableBuilder::WritePerfectHashIndex(BlockBuilder *metaindex_block) {
+        Rep *r = rep_;
+        int value_bits = 1;
+        while (value_bits < 32 && (uint64_t{1} << value_bits) < r->num_data_blocks) {
+            value_bits++;
+        }
+
+        std::string contents;
+        r->perfect_hash->Finish(value_bits, &contents);
+        PutFixed32(&contents, static_cast<uint32_t>(r->index_block_options.block_restart_interval));
+
+        WriteMetaBlock(metaindex_block, kPerfectHashIndexBlockName, contents);
+    }
+
+    void TableBuilder::WriteRangeFilter(BlockBuilder *metaindex_block) {
+        std::string contents;
+        rep_->range_filter->Finish(&contents);
+        WriteMetaBlock(metaindex_block, kRangeFilterBlockName, contents);
+    }
+
+    void TableBuilder::WriteFilterPartition() {
+        Rep *r = rep_;
+        BlockHandle handle;
+        WriteRawBlock(r->filter_block->Finish(), kNoCompression, &handle);
+        if (!ok()) return;
+
+        std::string handle_encoding;
+        handle.EncodeTo(&handle_encoding);
+        r->filter_index->Add(r->last_key, handle_encoding);
+        delete r->filter_block;
+        r->filter_block = new FilterBlockBuilder(r->options.filter_policy, true);
+        r->partition_keys = 0;
+        r->cut_filter_partition = false;
+    }
+
+    void TableBuilder::WriteMetaBlock(BlockBuilder *metaindex_block, const char *name, const Slice &contents) {
+        // 元数据块本身不压缩，读取时直接使用
+        BlockHandle handle;
+        WriteRawBlock(contents, kNoCompression, &handle);
+        if (!ok()) return;
+
+        std::string handle_encoding;
+        handle.EncodeTo(&handle_encoding);
+        metaindex_block->Add(name, handle_encoding);
+    }
+
     Status TableBuilder::Finish() {
         Rep *r = rep_;
         // data_block 强制刷盘一波 , 因为 之前的写 data block 可能没有达到刷盘阈值 还在内存中
         Flush();
         // index 索引所写的位置位移处
         BlockHandle index_block_handle;
+        BlockHandle metaindex_block_handle;
+        bool has_metaindex = false;
 
-        if (ok()) {
+        if (ok() && r->pending_index_entry) {
             // 还有没达到阈值的 data block, 需要额外封装成一个 data block
-            if (r->pending_index_entry) {
-                // 找到一个比last_key大的短key
-                // 因为最后一个 data block 已经没有下一个 data block 了
-                // zzzzb -> zzzzc
-                r->options.comparator->FindShortSuccessor(&r->last_key);
-
-                // 编码成字符串
-                std::string handle_encoding;
-                // pending_handle 存放的是 pre data block 的刷盘信息
-                r->pending_handle.EncodeTo(&handle_encoding);
-
-                // 写入 index block
-                r->index_block.Add(r->last_key, Slice(handle_encoding));
-                r->pending_index_entry = false;
+            // 找到一个比last_key大的短key
+            // 因为最后一个 data block 已经没有下一个 data block 了
+            // zzzzb -> zzzzc
+            r->options.comparator->FindShortSuccessor(&r->last_key);
+
+            // 编码成字符串
+            std::string handle_encoding;
+            // pending_handle 存放的是 pre data block 的刷盘信息
+            r->pending_handle.EncodeTo(&handle_encoding);
+            handle_encoding.append(r->pending_properties);
+
+            // 写入 index block
+            r->index_block.Add(r->last_key, Slice(handle_encoding));
+            r->pending_index_entry = false;
+        }
+        if (ok() && r->filter_index != nullptr && r->partition_keys > 0) {
+            WriteFilterPartition();
+        }
+
+        // 元数据块按名字顺序加入 metaindex block
+        BlockBuilder metaindex_block(&r->index_block_options, std::string("metaindex block"));
+        if (ok() && r->filter_block != nullptr && r->filter_index == nullptr) {
+            std::string name = kFilterBlockNamePrefix;
+            name.append(r->options.filter_policy->Name());
+            WriteMetaBlock(&metaindex_block, name.c_str(), r->filter_block->Finish());
+        }
+        if (ok() && !r->collectors.empty()) {
+            std::string names;
+            for (const BlockPropertyCollectorFactory *factory: r->options.block_property_collectors) {
+                PutLengthPrefixedSlice(&names, factory->Name());
             }
+            metaindex_block.Add(kBlockPropertiesName, names);
+        }
+        if (ok() && r->perfect_hash != nullptr) {
+            WritePerfectHashIndex(&metaindex_block);
+        }
+        if (ok() && r->filter_block != nullptr && r->options.prefix_extractor != nullptr) {
+            metaindex_block.Add(kPrefixExtractorName, r->options.prefix_extractor->Name());
+        }
+        if (ok() && r->range_filter != nullptr) {
+            WriteRangeFilter(&metaindex_block);
+        }
+        if (ok() && r->filter_index != nullptr) {
+            BlockHandle filter_index_handle;
+            WriteBlock(r->filter_index, &filter_index_handle);
+            std::string handle_encoding;
+            filter_index_handle.EncodeTo(&handle_encoding);
+            std::string name = kPartitionedFilterBlockNamePrefix;
+            name.append(r->options.filter_policy->Name());
+            metaindex_block.Add(name, handle_encoding);
+        }
+        if (ok() && !metaindex_block.empty()) {
+            WriteBlock(&metaindex_block, &metaindex_block_handle);
+            has_metaindex = true;
+        }
+
+        if (ok()) {
             // 所有 data block 的 handler 都已经被写入到了 index block 了，持久化 index block
             // 获得 index block 的 index block handle
             WriteBlock(&r->index_block, &index_block_handle);
         }
 
+        // table 写完即可读，blob 也必须对读者可见
+        if (ok() && r->blob_file != nullptr) {
+            r->status = r->blob_file->Flush();
+        }
+
         if (ok()) {
             // 位移信息
             Footer footer{};
             // 将 index_block_handle : offset size 写入到 footer
             footer.set_index_handle(index_block_handle);
+            if (has_metaindex) {
+                footer.set_metaindex_handle(metaindex_block_handle);
+            }
+            footer.set_has_blob_values(r->blob_file != nullptr);
 
             // 给 footer 加入 padding 和 magic number
             // 把它编码为字符串
@@ -241,6 +488,13 @@ namespace leveldb {
 
     // 把内存的数据都写入到磁盘
     Status TableBuilder::Sync() {
+        // 先落盘 blob 文件，避免 table 中出现指向未持久化 blob 的引用
+        if (rep_->blob_file != nullptr) {
+            Status s = rep_->blob_file->Sync();
+            if (!s.ok()) {
+                return s;
+            }
+        }
         return rep_->file->Sync();
     }
 
@@ -257,4 +511,8 @@ namespace leveldb {
     uint64_t TableBuilder::FileSize() const {
         return rep_->offset;
     }
+
+    bool TableBuilder::AtBlockBoundary() const {
+        return rep_->data_block.empty();
+    }
 }
@@ -22,10 +22,23 @@ namespace leveldb {
     //
     class WritableFile;
 
+    //
+    class BlobFileBuilder;
+
     //
     class TableBuilder {
     public:
-        TableBuilder(const Options &options, WritableFile *file);
+        // If "blob_file" is non-null, values of at least options.min_blob_size
+        // bytes are appended to it and the data blocks only keep references
+        // to them.  Neither file is owned by the builder.
+        TableBuilder(const Options &options, WritableFile *file, BlobFileBuilder *blob_file = nullptr);
+
+        TableBuilder(const TableBuilder &) = delete;
+
+        TableBuilder &operator=(const TableBuilder &) = delete;
+
+        // Does not close or delete the file.
+        ~TableBuilder();
 
         void Add(const Slice &key, const Slice &value);
 
@@ -37,8 +50,15 @@ namespace leveldb {
 
         BlockHandle ReturnBlockHandle();
 
+        // Bytes written so far: data blocks and, with kPartitionedFilter,
+        // the filter partitions written between them.
         uint64_t FileSize() const;
 
+        // Whether every added entry is in a data block that was written out,
+        // i.e. the table could end here without a partial block.
+        bool AtBlockBoundary() const;
+
+        // Syncs the blob file, if any, before the table that refers to it.
         Status Sync();
 
     private:
@@ -46,6 +66,17 @@ namespace leveldb {
 
         void WriteRawBlock(const Slice &block_contents, CompressionType type, BlockHandle *handle);
 
+        // Writes "contents" uncompressed and adds it to the metaindex under "name".
+        void WriteMetaBlock(BlockBuilder *metaindex_block, const char *name, const Slice &contents);
+
+        void WritePerfectHashIndex(BlockBuilder *metaindex_block);
+
+        void WriteRangeFilter(BlockBuilder *metaindex_block);
+
+        // Writes the filter partition being built and adds it to the
+        // partition index under the index key of its last data block.
+        void WriteFilterPartition();
+
         bool ok() const { return status().ok(); }
 
         struct Rep;
@@ -0,0 +1,678 @@
+#include "table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "table_builder.h"
+#include "../include/block_property.h"
+#include "../include/filter_policy.h"
+#include "../include/slice_transform.h"
+#include "../util/testutil.h"
+
+namespace leveldb {
+
+    namespace {
+
+        std::string Key(int i) {
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "key%06d", i);
+            return std::string(buf);
+        }
+
+        std::string Value(int i) {
+            return "value" + std::to_string(i) + std::string(i % 50, 'v');
+        }
+
+        std::string found_key;
+        std::string found_value;
+
+        void SaveResult(const Slice &k, const Slice &v) {
+            found_key = k.ToString();
+            found_value = v.ToString();
+        }
+
+        // Key(i) 的编号 i；只有 i % 4 != 3 的 key 有这个字段
+        bool KeyNumber(const Slice &key, const Slice &, uint64_t *field) {
+            const int i = std::atoi(key.ToString().c_str() + 3);
+            if (i % 4 == 3) return false;
+            *field = static_cast<uint64_t>(i);
+            return true;
+        }
+
+        // 数一数读了几次文件
+        class CountingFile : public RandomAccessFile {
+        public:
+            explicit CountingFile(RandomAccessFile *target) : target_(target) {}
+
+            ~CountingFile() override { delete target_; }
+
+            Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override {
+                reads.fetch_add(1);
+                return target_->Read(offset, n, result, scratch);
+            }
+
+            mutable std::atomic<int> reads{0};
+
+        private:
+            RandomAccessFile *const target_;
+        };
+
+        // tenant|entity|seq 形式的 key，前缀是前两段
+        std::string PrefixedKey(int tenant, int entity, int seq) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "t%03d|e%03d|%04d", tenant, entity, seq);
+            return std::string(buf);
+        }
+
+    }  // namespace
+
+    // 每个测试写一张表再打开它；键是 Key(i)，i 为偶数，奇数留给不存在的键
+    class TableTest : public testing::Test {
+    public:
+        TableTest() : env_(Env::Default()), file_(nullptr), table_(nullptr) {
+            options_.block_size = 256;
+            EXPECT_TRUE(env_->GetTestDirectory(&fname_).ok());
+            fname_ += "/table_test.sst";
+        }
+
+        ~TableTest() override {
+            Close();
+            env_->RemoveFile(fname_);
+        }
+
+        void Build(int num_keys) {
+            WritableFile *file;
+            ASSERT_TRUE(env_->NewWritableFile(fname_, &file).ok());
+            {
+                TableBuilder builder(options_, file);
+                for (int i = 0; i < num_keys; i += 2) {
+                    builder.Add(Key(i), Value(i));
+                }
+                ASSERT_TRUE(builder.Finish().ok());
+            }
+            ASSERT_TRUE(file->Close().ok());
+            delete file;
+        }
+
+        void Open() {
+            Close();
+            uint64_t size;
+            ASSERT_TRUE(env_->GetFileSize(fname_, &size).ok());
+            ASSERT_TRUE(env_->NewRandomAccessFile(fname_, EnvOptions(options_), &file_).ok());
+            ASSERT_TRUE(Table::Open(options_, file_, size, &table_).ok());
+        }
+
+        void Close() {
+            delete table_;
+            table_ = nullptr;
+            delete file_;
+            file_ = nullptr;
+        }
+
+        // 把文件中 offset 处的一个字节取反
+        void CorruptByte(uint64_t offset) {
+            std::FILE *f = std::fopen(fname_.c_str(), "r+b");
+            ASSERT_TRUE(f != nullptr);
+            std::fseek(f, static_cast<long>(offset), SEEK_SET);
+            const int c = std::fgetc(f);
+            std::fseek(f, static_cast<long>(offset), SEEK_SET);
+            std::fputc(c ^ 0xff, f);
+            std::fclose(f);
+        }
+
+        Env *env_;
+        Options options_;
+        std::string fname_;
+        RandomAccessFile *file_;
+        Table *table_;
+    };
+
+    TEST_F(TableTest, MultiGetFindsExactKeys) {
+        Build(2000);
+        Open();
+
+        // 存在的、夹在两个键之间的、超过表尾的键，乱序且有重复
+        std::vector<int> ids;
+        for (int i = 0; i < 2100; i += 7) {
+            ids.push_back(i);
+        }
+        ids.push_back(14);
+        ids.push_back(14);
+        std::reverse(ids.begin(), ids.end());
+
+        std::vector<std::string> keys;
+        for (int i: ids) {
+            keys.push_back(Key(i));
+        }
+        std::vector<Slice> key_slices(keys.begin(), keys.end());
+        std::vector<std::string> values(keys.size(), "stale");
+        std::vector<Status> statuses(keys.size());
+        table_->MultiGet(ReadOptions(), static_cast<int>(keys.size()), key_slices.data(), values.data(),
+                         statuses.data());
+
+        for (size_t j = 0; j < ids.size(); j++) {
+            const int i = ids[j];
+            if (i % 2 == 0 && i < 2000) {
+                ASSERT_TRUE(statuses[j].ok()) << Key(i) << ": " << statuses[j].ToString();
+                ASSERT_EQ(Value(i), values[j]);
+            } else {
+                ASSERT_TRUE(statuses[j].IsNotFound()) << Key(i) << ": " << statuses[j].ToString();
+                ASSERT_EQ("", values[j]);
+            }
+        }
+    }
+
+    TEST_F(TableTest, MultiGetEmptyBatch) {
+        Build(100);
+        Open();
+        table_->MultiGet(ReadOptions(), 0, nullptr, nullptr, nullptr);
+    }
+
+    TEST_F(TableTest, MultiGetUncompressed) {
+        options_.compression = kNoCompression;
+        Build(500);
+        Open();
+        const std::string keys[] = {Key(0), Key(250), Key(498), Key(499)};
+        Slice key_slices[4];
+        std::copy(keys, keys + 4, key_slices);
+        std::string values[4];
+        Status statuses[4];
+        table_->MultiGet(ReadOptions(), 4, key_slices, values, statuses);
+        ASSERT_TRUE(statuses[0].ok());
+        ASSERT_EQ(Value(0), values[0]);
+        ASSERT_TRUE(statuses[1].ok());
+        ASSERT_EQ(Value(250), values[1]);
+        ASSERT_TRUE(statuses[2].ok());
+        ASSERT_EQ(Value(498), values[2]);
+        ASSERT_TRUE(statuses[3].IsNotFound());
+    }
+
+    TEST_F(TableTest, MultiGetReportsCorruptBlockOnly) {
+        options_.compression = kNoCompression;
+        Build(2000);
+        // 第一个 data block 从文件开头开始
+        CorruptByte(10);
+        Open();
+
+        const std::string keys[] = {Key(0), Key(1000)};
+        Slice key_slices[2] = {keys[0], keys[1]};
+        std::string values[2];
+        Status statuses[2];
+        ReadOptions options;
+        options.verify_checksums = true;
+        table_->MultiGet(options, 2, key_slices, values, statuses);
+        ASSERT_TRUE(statuses[0].IsCorruption()) << statuses[0].ToString();
+        ASSERT_TRUE(statuses[1].ok()) << statuses[1].ToString();
+        ASSERT_EQ(Value(1000), values[1]);
+    }
+
+    TEST_F(TableTest, DirectReads) {
+        options_.use_direct_reads = true;
+        for (const CompressionType compression: {kNoCompression, kSnappyCompression}) {
+            options_.compression = compression;
+            Build(2000);
+            RandomAccessFile *probe;
+            Status s = env_->NewRandomAccessFile(fname_, EnvOptions(options_), &probe);
+            if (!s.ok()) {
+                // 有的文件系统(比如 tmpfs)不支持 O_DIRECT
+                GTEST_SKIP() << s.ToString();
+            }
+            ASSERT_GT(probe->GetRequiredBufferAlignment(), 0u);
+            delete probe;
+            Open();
+
+            ReadOptions options;
+            options.verify_checksums = true;
+            Iterator *iter = table_->NewIterator(options);
+            int i = 0;
+            for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i += 2) {
+                ASSERT_EQ(Key(i), iter->key().ToString());
+                ASSERT_EQ(Value(i), iter->value().ToString());
+            }
+            ASSERT_TRUE(iter->status().ok()) << iter->status().ToString();
+            ASSERT_EQ(2000, i);
+            delete iter;
+
+            const std::string keys[] = {Key(1998), Key(2), Key(1001)};
+            Slice key_slices[3] = {keys[0], keys[1], keys[2]};
+            std::string values[3];
+            Status statuses[3];
+            table_->MultiGet(options, 3, key_slices, values, statuses);
+            ASSERT_TRUE(statuses[0].ok());
+            ASSERT_EQ(Value(1998), values[0]);
+            ASSERT_TRUE(statuses[1].ok());
+            ASSERT_EQ(Value(2), values[1]);
+            ASSERT_TRUE(statuses[2].IsNotFound());
+        }
+    }
+
+    // key 和 value 分开存放的块：整表读写、只读 key、点查都和默认格式一致
+    TEST_F(TableTest, SplitKeyValueBlocks) {
+        options_.data_block_format = kSplitKeyValueBlock;
+        Build(2000);
+        Open();
+
+        Iterator *iter = table_->NewIterator(ReadOptions());
+        int i = 0;
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i += 2) {
+            ASSERT_EQ(Key(i), iter->key().ToString());
+            ASSERT_EQ(Value(i), iter->value().ToString());
+        }
+        ASSERT_TRUE(iter->status().ok());
+        ASSERT_EQ(2000, i);
+        for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+            i -= 2;
+            ASSERT_EQ(Key(i), iter->key().ToString());
+            ASSERT_EQ(Value(i), iter->value().ToString());
+        }
+        ASSERT_EQ(0, i);
+        iter->Seek(Key(1001));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Key(1002), iter->key().ToString());
+        ASSERT_EQ(Value(1002), iter->value().ToString());
+        delete iter;
+
+        ReadOptions key_only;
+        key_only.key_only = true;
+        iter = table_->NewIterator(key_only);
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i += 2) {
+            ASSERT_EQ(Key(i), iter->key().ToString());
+            ASSERT_TRUE(iter->value().empty());
+        }
+        ASSERT_EQ(2000, i);
+        delete iter;
+
+        const std::string keys[] = {Key(1998), Key(1), Key(500)};
+        Slice key_slices[3] = {keys[0], keys[1], keys[2]};
+        std::string values[3];
+        Status statuses[3];
+        table_->MultiGet(ReadOptions(), 3, key_slices, values, statuses);
+        ASSERT_TRUE(statuses[0].ok());
+        ASSERT_EQ(Value(1998), values[0]);
+        ASSERT_TRUE(statuses[1].IsNotFound());
+        ASSERT_TRUE(statuses[2].ok());
+        ASSERT_EQ(Value(500), values[2]);
+    }
+
+    TEST_F(TableTest, SplitKeyValueBlockCorruption) {
+        options_.data_block_format = kSplitKeyValueBlock;
+        options_.compression = kNoCompression;
+        Build(2000);
+        CorruptByte(20);
+        Open();
+
+        ReadOptions options;
+        options.verify_checksums = true;
+        Iterator *iter = table_->NewIterator(options);
+        // 坏掉的第一个块被跳过，错误留在 status() 里
+        iter->SeekToFirst();
+        ASSERT_TRUE(iter->status().IsCorruption()) << iter->status().ToString();
+        ASSERT_TRUE(!iter->Valid() || iter->key() != Slice(Key(0)));
+        iter->Seek(Key(1000));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Value(1000), iter->value().ToString());
+        delete iter;
+    }
+
+    // 定长 key 块：Key(i) 都是 9 字节
+    TEST_F(TableTest, FixedKeyBlocks) {
+        options_.data_block_format = kFixedKeyBlock;
+        options_.fixed_key_size = 9;
+        Build(2000);
+        Open();
+
+        Iterator *iter = table_->NewIterator(ReadOptions());
+        int i = 0;
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i += 2) {
+            ASSERT_EQ(Key(i), iter->key().ToString());
+            ASSERT_EQ(Value(i), iter->value().ToString());
+        }
+        ASSERT_TRUE(iter->status().ok());
+        ASSERT_EQ(2000, i);
+        for (int j = 0; j < 2000; j += 37) {
+            iter->Seek(Key(j));
+            ASSERT_TRUE(iter->Valid());
+            ASSERT_EQ(Key(j + j % 2), iter->key().ToString());
+            ASSERT_EQ(Value(j + j % 2), iter->value().ToString());
+        }
+        delete iter;
+
+        const std::string keys[] = {Key(1998), Key(1)};
+        Slice key_slices[2] = {keys[0], keys[1]};
+        std::string values[2];
+        Status statuses[2];
+        table_->MultiGet(ReadOptions(), 2, key_slices, values, statuses);
+        ASSERT_TRUE(statuses[0].ok());
+        ASSERT_EQ(Value(1998), values[0]);
+        ASSERT_TRUE(statuses[1].IsNotFound());
+    }
+
+    TEST_F(TableTest, FixedKeyBlocksRejectOtherKeySizes) {
+        options_.data_block_format = kFixedKeyBlock;
+        options_.fixed_key_size = 8;
+        WritableFile *file;
+        ASSERT_TRUE(env_->NewWritableFile(fname_, &file).ok());
+        {
+            TableBuilder builder(options_, file);
+            builder.Add("12345678", "v");
+            ASSERT_TRUE(builder.status().ok());
+            builder.Add("123456789", "v");
+            ASSERT_TRUE(builder.status().IsInvalidArgument());
+            ASSERT_TRUE(builder.Finish().IsInvalidArgument());
+        }
+        delete file;
+    }
+
+    // 完美哈希索引只报告等于 key 的记录；写表时的 restart interval 和读表时的不同也不影响
+    TEST_F(TableTest, PerfectHashIndex) {
+        std::unique_ptr<const FilterPolicy> bloom(NewBloomFilterPolicy(10));
+        for (const FilterPolicy *policy: {static_cast<const FilterPolicy *>(nullptr), bloom.get()}) {
+            options_.perfect_hash_index = true;
+            options_.filter_policy = policy;
+            options_.block_restart_interval = 16;
+            Build(2000);
+            options_.block_restart_interval = 1;
+            Open();
+
+            for (int i = 0; i < 2100; i++) {
+                found_key.clear();
+                found_value.clear();
+                ASSERT_TRUE(table_->InternalGet(ReadOptions(), Key(i), SaveResult).ok());
+                if (i % 2 == 0 && i < 2000) {
+                    ASSERT_EQ(Key(i), found_key);
+                    ASSERT_EQ(Value(i), found_value);
+                } else {
+                    // 不在表里的键不会落到下一个键上
+                    ASSERT_EQ("", found_key) << Key(i);
+                }
+            }
+
+            // 迭代器不受影响
+            Iterator *iter = table_->NewIterator(ReadOptions());
+            test::KVList entries;
+            ASSERT_TRUE(test::ReadAll(iter, &entries).ok());
+            ASSERT_EQ(1000u, entries.size());
+            delete iter;
+            Close();
+        }
+    }
+
+    // 范围过滤器排除没有 key 的区间；有 key 的区间照常迭代
+    TEST_F(TableTest, RangeFilter) {
+        options_.range_filter = true;
+        Build(2000);
+        Open();
+        ASSERT_TRUE(table_->RangeMayMatch(Key(100), Key(101)));
+        ASSERT_TRUE(table_->RangeMayMatch(Key(99), Key(101)));
+        ASSERT_TRUE(table_->RangeMayMatch("", Key(1)));
+        ASSERT_FALSE(table_->RangeMayMatch("a", "key"));
+        ASSERT_FALSE(table_->RangeMayMatch("l", "z"));
+        ASSERT_FALSE(table_->RangeMayMatch(Key(101), Key(100)));
+
+        const std::string upper = Key(105);
+        const Slice upper_slice(upper);
+        ReadOptions options;
+        options.iterate_upper_bound = &upper_slice;
+        Iterator *iter = table_->NewIterator(options);
+        test::KVList entries;
+        ASSERT_TRUE(test::ReadAll(iter, &entries).ok());
+        ASSERT_EQ(53u, entries.size());
+        iter->Seek(Key(101));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(Key(102), iter->key().ToString());
+        iter->Next();
+        ASSERT_EQ(Key(104), iter->key().ToString());
+        iter->Next();
+        ASSERT_FALSE(iter->Valid());
+        iter->Seek(Key(105));
+        ASSERT_FALSE(iter->Valid());
+        ASSERT_TRUE(iter->status().ok());
+        delete iter;
+    }
+
+    // 偶数 tenant 的每个 entity 有 20 条，奇数 tenant 不在表里
+    TEST_F(TableTest, PrefixFilter) {
+        std::unique_ptr<const FilterPolicy> bloom(NewBloomFilterPolicy(10));
+        std::unique_ptr<const SliceTransform> extractor(NewDelimitedPrefixTransform('|', 2));
+        options_.filter_policy = bloom.get();
+        options_.prefix_extractor = extractor.get();
+        WritableFile *file;
+        ASSERT_TRUE(env_->NewWritableFile(fname_, &file).ok());
+        {
+            TableBuilder builder(options_, file);
+            for (int t = 0; t < 100; t += 2) {
+                for (int e = 0; e < 5; e++) {
+                    for (int seq = 0; seq < 20; seq++) {
+                        builder.Add(PrefixedKey(t, e, seq), Value(seq));
+                    }
+                }
+            }
+            ASSERT_TRUE(builder.Finish().ok());
+        }
+        ASSERT_TRUE(file->Close().ok());
+        delete file;
+        Open();
+
+        int false_positives = 0;
+        for (int t = 0; t < 100; t++) {
+            for (int e = 0; e < 5; e++) {
+                const bool present = t % 2 == 0;
+                const bool may_match = table_->PrefixMayMatch(PrefixedKey(t, e, 7));
+                if (present) {
+                    ASSERT_TRUE(may_match) << PrefixedKey(t, e, 7);
+                } else {
+                    false_positives += may_match;
+                }
+            }
+        }
+        ASSERT_LT(false_positives, 25);
+        // 不在前缀定义域内的 key 不做判断
+        ASSERT_TRUE(table_->PrefixMayMatch("t001"));
+
+        // 前缀扫描停在前缀末尾
+        ReadOptions options;
+        options.prefix_same_as_start = true;
+        Iterator *iter = table_->NewIterator(options);
+        int n = 0;
+        for (iter->Seek(PrefixedKey(42, 3, 5)); iter->Valid(); iter->Next(), n++) {
+            ASSERT_EQ(PrefixedKey(42, 3, 5 + n), iter->key().ToString());
+        }
+        ASSERT_EQ(15, n);
+        ASSERT_TRUE(iter->status().ok());
+        iter->Seek(PrefixedKey(43, 0, 0));
+        ASSERT_FALSE(iter->Valid());
+        delete iter;
+
+        // 读者的前缀提取器名字不同：过滤器里的前缀不能用
+        std::unique_ptr<const SliceTransform> other(NewDelimitedPrefixTransform('|', 1));
+        options_.prefix_extractor = other.get();
+        Open();
+        for (int t = 1; t < 100; t += 2) {
+            ASSERT_TRUE(table_->PrefixMayMatch(PrefixedKey(t, 0, 0)));
+        }
+    }
+
+    // 分块布隆过滤器：整批 key 一起探测，和 InternalGet 的结论一致
+    TEST_F(TableTest, BlockedBloomKeysMayMatch) {
+        std::unique_ptr<const FilterPolicy> policy(NewBlockedBloomFilterPolicy(10));
+        options_.filter_policy = policy.get();
+        Build(4000);
+        Open();
+
+        const int n = 4100;
+        std::vector<std::string> keys;
+        for (int i = 0; i < n; i++) {
+            keys.push_back(Key(i));
+        }
+        std::vector<Slice> key_slices(keys.begin(), keys.end());
+        std::unique_ptr<bool[]> results(new bool[n]);
+        table_->KeysMayMatch(n, key_slices.data(), results.get());
+        int false_positives = 0;
+        for (int i = 0; i < n; i++) {
+            if (i % 2 == 0 && i < 4000) {
+                ASSERT_TRUE(results[i]) << Key(i);
+            } else if (results[i]) {
+                false_positives++;
+                if (i < 4000) {
+                    // 过滤器放过的 key 照样要查，查不到
+                    found_key.clear();
+                    ASSERT_TRUE(table_->InternalGet(ReadOptions(), keys[i], SaveResult).ok());
+                    ASSERT_NE(keys[i], found_key);
+                }
+            }
+        }
+        ASSERT_LT(false_positives, 100);
+    }
+
+    // 整张表一个二元熔断过滤器：存在的 key 都能查到，不存在的大多不读 data block
+    TEST_F(TableTest, WholeTableBinaryFuseFilter) {
+        std::unique_ptr<const FilterPolicy> policy(NewBinaryFuseFilterPolicy(8));
+        options_.filter_policy = policy.get();
+        options_.filter_block_format = kWholeTableFilter;
+        Build(4000);
+        options_.filter_block_format = kDataRangeFilters;
+        Open();
+
+        const int n = 4000;
+        std::vector<std::string> keys;
+        for (int i = 0; i < n; i++) {
+            keys.push_back(Key(i));
+        }
+        std::vector<Slice> key_slices(keys.begin(), keys.end());
+        std::unique_ptr<bool[]> results(new bool[n]);
+        table_->KeysMayMatch(n, key_slices.data(), results.get());
+        int false_positives = 0;
+        for (int i = 0; i < n; i++) {
+            found_key.clear();
+            ASSERT_TRUE(table_->InternalGet(ReadOptions(), keys[i], SaveResult).ok());
+            if (i % 2 == 0) {
+                ASSERT_TRUE(results[i]) << Key(i);
+                ASSERT_EQ(keys[i], found_key);
+            } else {
+                ASSERT_NE(keys[i], found_key);
+                false_positives += results[i];
+            }
+        }
+        ASSERT_LT(false_positives, 30);
+    }
+
+    // 分区过滤器：留住最近读的分区，批量查找按分区分组，每个分区只读一次
+    TEST_F(TableTest, PartitionedFilter) {
+        std::unique_ptr<const FilterPolicy> bloom(NewBloomFilterPolicy(10));
+        options_.filter_policy = bloom.get();
+        options_.filter_block_format = kPartitionedFilter;
+        options_.filter_partition_keys = 200;
+        Build(8000);
+
+        uint64_t size;
+        ASSERT_TRUE(env_->GetFileSize(fname_, &size).ok());
+        RandomAccessFile *base;
+        ASSERT_TRUE(env_->NewRandomAccessFile(fname_, &base).ok());
+        auto *counting = new CountingFile(base);
+        file_ = counting;
+        ASSERT_TRUE(Table::Open(options_, file_, size, &table_).ok());
+
+        // 乱序的一批 key：约 20 个分区，每个只读一次
+        const int n = 8000;
+        std::vector<std::string> keys;
+        for (int i = 0; i < n; i++) {
+            keys.push_back(Key((i * 7919) % n));
+        }
+        std::vector<Slice> key_slices(keys.begin(), keys.end());
+        std::unique_ptr<bool[]> results(new bool[n]);
+        counting->reads = 0;
+        table_->KeysMayMatch(n, key_slices.data(), results.get());
+        const int partitions = counting->reads.load();
+        ASSERT_GT(partitions, 10);
+        ASSERT_LT(partitions, 40);
+        int false_positives = 0;
+        for (int i = 0; i < n; i++) {
+            const int k = (i * 7919) % n;
+            if (k % 2 == 0) {
+                ASSERT_TRUE(results[i]) << Key(k);
+            } else {
+                false_positives += results[i];
+            }
+        }
+        ASSERT_LT(false_positives, 200);
+
+        // 同一分区里接连查找：分区只读一次，之后每次只读 data block
+        table_->InternalGet(ReadOptions(), Key(5000), SaveResult);
+        counting->reads = 0;
+        for (int i = 5000; i < 5020; i += 2) {
+            found_key.clear();
+            ASSERT_TRUE(table_->InternalGet(ReadOptions(), Key(i), SaveResult).ok());
+            ASSERT_EQ(Key(i), found_key);
+        }
+        ASSERT_LE(counting->reads.load(), 10);
+
+        // 多个线程同时换分区
+        std::vector<std::thread> threads;
+        std::atomic<int> misses{0};
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&, t]() {
+                for (int i = t * 2; i < n; i += 8 * 7) {
+                    const std::string key = Key(i);
+                    const Slice slice(key);
+                    bool may_match;
+                    table_->KeysMayMatch(1, &slice, &may_match);
+                    if (!may_match) misses++;
+                }
+            });
+        }
+        for (std::thread &thread: threads) {
+            thread.join();
+        }
+        ASSERT_EQ(0, misses.load());
+    }
+
+    // 块属性：扫描和点查跳过摘要和谓词不相交的块，不读它们
+    TEST_F(TableTest, BlockProperties) {
+        std::unique_ptr<const BlockPropertyCollectorFactory> collectors(
+                NewMinMaxPropertyCollectorFactory("test.number", KeyNumber));
+        options_.block_property_collectors.push_back(collectors.get());
+        for (const bool perfect_hash: {false, true}) {
+            options_.perfect_hash_index = perfect_hash;
+            Build(2000);
+            Open();
+
+            std::unique_ptr<const BlockPropertyFilter> filter(NewMinMaxPropertyFilter("test.number", 500, 520));
+            ReadOptions options;
+            options.block_property_filter = filter.get();
+            Iterator *iter = table_->NewIterator(options);
+            test::KVList entries;
+            ASSERT_TRUE(test::ReadAll(iter, &entries).ok());
+            delete iter;
+            // 只读了和 [500, 520] 相交的几个块，其中包含区间内的所有 key
+            ASSERT_LT(entries.size(), 60u);
+            for (int i = 500; i <= 520; i += 2) {
+                ASSERT_TRUE(std::find(entries.begin(), entries.end(), std::make_pair(Key(i), Value(i))) !=
+                            entries.end()) << Key(i);
+            }
+
+            for (const int i: {100, 510, 1500}) {
+                found_key.clear();
+                ASSERT_TRUE(table_->InternalGet(options, Key(i), SaveResult).ok());
+                ASSERT_EQ(i == 510 ? Key(i) : "", found_key) << "perfect_hash=" << perfect_hash;
+            }
+
+            // 表里没有这个名字的属性：不跳过任何块
+            std::unique_ptr<const BlockPropertyFilter> other(NewMinMaxPropertyFilter("test.other", 500, 520));
+            options.block_property_filter = other.get();
+            iter = table_->NewIterator(options);
+            entries.clear();
+            ASSERT_TRUE(test::ReadAll(iter, &entries).ok());
+            delete iter;
+            ASSERT_EQ(1000u, entries.size());
+            Close();
+        }
+    }
+
+}  // namespace leveldb
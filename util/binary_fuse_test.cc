@@ -0,0 +1,117 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../include/filter_policy.h"
+#include "../include/slice.h"
+#include "coding.h"
+
+namespace leveldb {
+
+    namespace {
+
+        std::string Key(int i) {
+            std::string key;
+            PutFixed32(&key, static_cast<uint32_t>(i));
+            return key;
+        }
+
+        std::string BuildFilter(const FilterPolicy *policy, const std::vector<std::string> &keys) {
+            std::vector<Slice> slices(keys.begin(), keys.end());
+            std::string filter;
+            policy->CreateFilter(slices.data(), static_cast<int>(slices.size()), &filter);
+            return filter;
+        }
+
+        std::string BuildFilter(const FilterPolicy *policy, int n) {
+            std::vector<std::string> keys;
+            for (int i = 0; i < n; i++) {
+                keys.push_back(Key(i));
+            }
+            return BuildFilter(policy, keys);
+        }
+
+        double FalsePositiveRate(const FilterPolicy *policy, const std::string &filter) {
+            int result = 0;
+            for (int i = 0; i < 100000; i++) {
+                if (policy->KeyMayMatch(Key(i + 1000000000), filter)) {
+                    result++;
+                }
+            }
+            return result / 100000.0;
+        }
+
+    }  // namespace
+
+    // 参数是指纹位数：8 或 16
+    class BinaryFuseTest : public testing::TestWithParam<int> {
+    public:
+        BinaryFuseTest() : policy_(NewBinaryFuseFilterPolicy(GetParam())) {}
+
+        // 指纹位数对应的假阳性率上限，留一些余量
+        double MaxFalsePositiveRate() const { return GetParam() == 8 ? 0.006 : 0.0002; }
+
+        std::unique_ptr<const FilterPolicy> policy_;
+    };
+
+    TEST_P(BinaryFuseTest, Names) {
+        ASSERT_EQ(std::string(GetParam() == 8 ? "leveldb.BinaryFuse8Filter" : "leveldb.BinaryFuse16Filter"),
+                  policy_->Name());
+    }
+
+    TEST_P(BinaryFuseTest, EmptyFilter) {
+        const std::string filter = BuildFilter(policy_.get(), 0);
+        ASSERT_LE(FalsePositiveRate(policy_.get(), filter), MaxFalsePositiveRate());
+    }
+
+    // 小集合的放大系数大，大集合接近每个指纹 1.125 倍
+    TEST_P(BinaryFuseTest, VaryingLengths) {
+        for (int length = 1; length <= 100000; length += (length < 10 ? 1 : length < 1000 ? 97 : 9973)) {
+            const std::string filter = BuildFilter(policy_.get(), length);
+            for (int i = 0; i < length; i++) {
+                ASSERT_TRUE(policy_->KeyMayMatch(Key(i), filter)) << "length " << length << "; key " << i;
+            }
+            ASSERT_LE(FalsePositiveRate(policy_.get(), filter), MaxFalsePositiveRate()) << length;
+            if (length >= 50000) {
+                const double bits_per_key = filter.size() * 8.0 / length;
+                ASSERT_LT(bits_per_key, GetParam() * 1.25) << length;
+            }
+        }
+    }
+
+    // 重复的 key 不影响剥离
+    TEST_P(BinaryFuseTest, DuplicateKeys) {
+        std::vector<std::string> keys;
+        for (int i = 0; i < 1000; i++) {
+            keys.push_back(Key(i / 3));
+        }
+        const std::string filter = BuildFilter(policy_.get(), keys);
+        for (int i = 0; i < 334; i++) {
+            ASSERT_TRUE(policy_->KeyMayMatch(Key(i), filter)) << i;
+        }
+    }
+
+    // 认不出的过滤器当作可能存在
+    TEST_P(BinaryFuseTest, MalformedFilters) {
+        std::string filter = BuildFilter(policy_.get(), 1000);
+        ASSERT_TRUE(policy_->KeyMayMatch(Key(5000), ""));
+        ASSERT_TRUE(policy_->KeyMayMatch(Key(5000), Slice(filter.data(), 15)));
+        ASSERT_TRUE(policy_->KeyMayMatch(Key(5000), Slice(filter.data() + 1, filter.size() - 1)));
+        // 段长不是 2 的幂
+        EncodeFixed32(&filter[filter.size() - 8], 3);
+        ASSERT_TRUE(policy_->KeyMayMatch(Key(5000), filter));
+    }
+
+    TEST_P(BinaryFuseTest, AppendsToExistingContents) {
+        std::string dst = "existing";
+        const std::string key = Key(7);
+        const Slice slice(key);
+        policy_->CreateFilter(&slice, 1, &dst);
+        ASSERT_EQ("existing", dst.substr(0, 8));
+        ASSERT_TRUE(policy_->KeyMayMatch(key, Slice(dst.data() + 8, dst.size() - 8)));
+    }
+
+    INSTANTIATE_TEST_SUITE_P(FingerprintBits, BinaryFuseTest, testing::Values(8, 16));
+
+}  // namespace leveldb
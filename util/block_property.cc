@@ -0,0 +1,100 @@
+#include "../include/block_property.h"
+
+#include <algorithm>
+
+#include "coding.h"
+
+namespace leveldb {
+
+    BlockPropertyCollector::~BlockPropertyCollector() = default;
+
+    BlockPropertyCollectorFactory::~BlockPropertyCollectorFactory() = default;
+
+    BlockPropertyFilter::~BlockPropertyFilter() = default;
+
+    namespace {
+
+        // 摘要是 fixed64 最小值 | fixed64 最大值，块里没有这个字段时为空
+
+        class MinMaxPropertyCollector : public BlockPropertyCollector {
+        public:
+            explicit MinMaxPropertyCollector(BlockFieldExtractor extractor)
+                    : extractor_(extractor), empty_(true), smallest_(0), largest_(0) {}
+
+            void Add(const Slice &key, const Slice &value) override {
+                uint64_t field;
+                if (!(*extractor_)(key, value, &field)) return;
+                if (empty_) {
+                    smallest_ = largest_ = field;
+                    empty_ = false;
+                } else {
+                    smallest_ = std::min(smallest_, field);
+                    largest_ = std::max(largest_, field);
+                }
+            }
+
+            void FinishBlock(std::string *dst) override {
+                if (!empty_) {
+                    PutFixed64(dst, smallest_);
+                    PutFixed64(dst, largest_);
+                }
+                empty_ = true;
+            }
+
+        private:
+            const BlockFieldExtractor extractor_;
+            bool empty_;
+            uint64_t smallest_;
+            uint64_t largest_;
+        };
+
+        class MinMaxPropertyCollectorFactory : public BlockPropertyCollectorFactory {
+        public:
+            MinMaxPropertyCollectorFactory(const char *name, BlockFieldExtractor extractor)
+                    : name_(name), extractor_(extractor) {}
+
+            const char *Name() const override { return name_.c_str(); }
+
+            BlockPropertyCollector *NewCollector() const override {
+                return new MinMaxPropertyCollector(extractor_);
+            }
+
+        private:
+            const std::string name_;
+            const BlockFieldExtractor extractor_;
+        };
+
+        class MinMaxPropertyFilter : public BlockPropertyFilter {
+        public:
+            MinMaxPropertyFilter(const char *name, uint64_t smallest, uint64_t largest)
+                    : name_(name), smallest_(smallest), largest_(largest) {}
+
+            const char *Name() const override { return name_.c_str(); }
+
+            bool MayMatch(const Slice &property) const override {
+                if (property.empty()) return false;
+                // 认不出的摘要只能当作可能匹配
+                if (property.size() != 2 * sizeof(uint64_t)) return true;
+                const uint64_t smallest = DecodeFixed64(property.data());
+                const uint64_t largest = DecodeFixed64(property.data() + sizeof(uint64_t));
+                return smallest <= largest_ && smallest_ <= largest;
+            }
+
+        private:
+            const std::string name_;
+            const uint64_t smallest_;
+            const uint64_t largest_;
+        };
+
+    }  // namespace
+
+    const BlockPropertyCollectorFactory *NewMinMaxPropertyCollectorFactory(const char *name,
+                                                                           BlockFieldExtractor extractor) {
+        return new MinMaxPropertyCollectorFactory(name, extractor);
+    }
+
+    const BlockPropertyFilter *NewMinMaxPropertyFilter(const char *name, uint64_t smallest, uint64_t largest) {
+        return new MinMaxPropertyFilter(name, smallest, largest);
+    }
+
+}
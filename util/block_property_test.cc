@@ -0,0 +1,73 @@
+#include "../include/block_property.h"
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "coding.h"
+
+namespace leveldb {
+
+    namespace {
+
+        // 字段就是 value 的 fixed64；value 不是 8 字节时没有这个字段
+        bool ValueField(const Slice &, const Slice &value, uint64_t *field) {
+            if (value.size() != sizeof(uint64_t)) return false;
+            *field = DecodeFixed64(value.data());
+            return true;
+        }
+
+        std::string Field(uint64_t v) {
+            std::string value;
+            PutFixed64(&value, v);
+            return value;
+        }
+
+    }  // namespace
+
+    TEST(BlockPropertyTest, MinMaxSummaries) {
+        std::unique_ptr<const BlockPropertyCollectorFactory> factory(
+                NewMinMaxPropertyCollectorFactory("test.field", ValueField));
+        ASSERT_EQ(std::string("test.field"), factory->Name());
+        std::unique_ptr<BlockPropertyCollector> collector(factory->NewCollector());
+        std::unique_ptr<const BlockPropertyFilter> filter(NewMinMaxPropertyFilter("test.field", 100, 200));
+        ASSERT_EQ(std::string("test.field"), filter->Name());
+
+        // 第一个块 [150, 900]：和 [100, 200] 有交集
+        collector->Add("a", Field(900));
+        collector->Add("b", Field(150));
+        collector->Add("c", "none");
+        std::string first;
+        collector->FinishBlock(&first);
+        ASSERT_EQ(Field(150) + Field(900), first);
+        ASSERT_TRUE(filter->MayMatch(first));
+
+        // 每个块重新开始汇总
+        collector->Add("d", Field(201));
+        collector->Add("e", Field(300));
+        std::string second;
+        collector->FinishBlock(&second);
+        ASSERT_EQ(Field(201) + Field(300), second);
+        ASSERT_FALSE(filter->MayMatch(second));
+
+        // 没有字段的块摘要为空，被过滤器排除
+        collector->Add("f", "none");
+        std::string third;
+        collector->FinishBlock(&third);
+        ASSERT_TRUE(third.empty());
+        ASSERT_FALSE(filter->MayMatch(third));
+    }
+
+    TEST(BlockPropertyTest, FilterBounds) {
+        std::unique_ptr<const BlockPropertyFilter> filter(NewMinMaxPropertyFilter("test.field", 100, 200));
+        ASSERT_TRUE(filter->MayMatch(Field(200) + Field(250)));
+        ASSERT_TRUE(filter->MayMatch(Field(50) + Field(100)));
+        ASSERT_TRUE(filter->MayMatch(Field(0) + Field(1000)));
+        ASSERT_TRUE(filter->MayMatch(Field(120) + Field(130)));
+        ASSERT_FALSE(filter->MayMatch(Field(0) + Field(99)));
+        ASSERT_FALSE(filter->MayMatch(Field(201) + Field(~uint64_t{0})));
+        // 认不出的摘要当作可能匹配
+        ASSERT_TRUE(filter->MayMatch("garbage"));
+    }
+
+}  // namespace leveldb
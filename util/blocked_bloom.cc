@@ -0,0 +1,168 @@
+#include "../include/filter_policy.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../include/slice.h"
+#include "coding.h"
+#include "hash.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SSTABLE_HAVE_AVX2_BLOOM 1
+#else
+#define SSTABLE_HAVE_AVX2_BLOOM 0
+#endif
+
+namespace leveldb {
+
+    // 分块布隆过滤器：一个 key 的所有探测位都落在同一个 64 字节块里
+    //
+    // A filter is num_blocks 64-byte blocks followed by one byte holding
+    // kProbes.  A key's hash picks a block, and sets one bit in each of its
+    // eight 64-bit words, chosen by multiplying the hash with a per-word
+    // odd constant and keeping the top 6 bits ("split block" bloom filter).
+    // The eight bits are computed and tested in two AVX2 registers.
+
+    namespace {
+        const size_t kBlockSize = 64;
+        const int kProbes = 8;
+        const int kBatch = 32;  // KeysMayMatch() hashes and prefetches this many keys at a time.
+
+        const uint32_t kSalts[kProbes] = {0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+                                          0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u};
+
+        // 高 32 位选块，低 32 位定块内的位
+        inline uint64_t BlockedBloomHash(const Slice &key) {
+            uint64_t x = Hash(key.data(), key.size(), 0x5bd1e995);
+            // splitmix64 的混合函数
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+        }
+
+        inline const char *BlockFor(uint64_t h, const char *array, uint32_t num_blocks) {
+            return array + (((h >> 32) * num_blocks) >> 32) * kBlockSize;
+        }
+
+        inline bool ProbeScalar(uint32_t h, const char *block) {
+            for (int i = 0; i < kProbes; i++) {
+                const uint64_t bit = uint64_t{1} << ((h * kSalts[i]) >> 26);
+                if ((DecodeFixed64(block + i * 8) & bit) == 0) return false;
+            }
+            return true;
+        }
+
+#if SSTABLE_HAVE_AVX2_BLOOM
+        bool CpuHasAvx2() {
+            static const bool has_avx2 = __builtin_cpu_supports("avx2");
+            return has_avx2;
+        }
+
+        // 8 个 32 位乘法得到 8 个位号，再扩成 64 位做变长移位
+        __attribute__((target("avx2")))
+        bool ProbeAvx2(uint32_t h, const char *block) {
+            const __m256i salts = _mm256_setr_epi32(
+                    static_cast<int>(kSalts[0]), static_cast<int>(kSalts[1]), static_cast<int>(kSalts[2]),
+                    static_cast<int>(kSalts[3]), static_cast<int>(kSalts[4]), static_cast<int>(kSalts[5]),
+                    static_cast<int>(kSalts[6]), static_cast<int>(kSalts[7]));
+            const __m256i shifts = _mm256_srli_epi32(
+                    _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(h)), salts), 26);
+            const __m256i one = _mm256_set1_epi64x(1);
+            const __m256i lo = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shifts)));
+            const __m256i hi = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shifts, 1)));
+            const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+            const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+            // testc: (~block & mask) 全为 0 时返回 1
+            return _mm256_testc_si256(b0, lo) & _mm256_testc_si256(b1, hi);
+        }
+#endif
+
+        inline bool Probe(uint32_t h, const char *block) {
+#if SSTABLE_HAVE_AVX2_BLOOM
+            if (CpuHasAvx2()) return ProbeAvx2(h, block);
+#endif
+            return ProbeScalar(h, block);
+        }
+
+        // Number of blocks in a well-formed filter, or 0.
+        inline uint32_t NumBlocks(const Slice &filter) {
+            const size_t len = filter.size();
+            if (len < kBlockSize + 1 || (len - 1) % kBlockSize != 0 || filter[len - 1] != kProbes ||
+                (len - 1) / kBlockSize > 0xffffffffu) {
+                return 0;
+            }
+            return static_cast<uint32_t>((len - 1) / kBlockSize);
+        }
+
+        class BlockedBloomFilterPolicy : public FilterPolicy {
+        public:
+            explicit BlockedBloomFilterPolicy(int bits_per_key) : bits_per_key_(std::max(bits_per_key, 1)) {}
+
+            const char *Name() const override { return "leveldb.BlockedBloomFilter"; }
+
+            void CreateFilter(const Slice *keys, int n, std::string *dst) const override {
+                const uint64_t bits = static_cast<uint64_t>(n) * bits_per_key_;
+                const auto num_blocks = static_cast<uint32_t>(
+                        std::max<uint64_t>(1, (bits + kBlockSize * 8 - 1) / (kBlockSize * 8)));
+
+                const size_t init_size = dst->size();
+                dst->resize(init_size + num_blocks * kBlockSize, 0);
+                dst->push_back(static_cast<char>(kProbes));
+                char *array = &(*dst)[init_size];
+                for (int i = 0; i < n; i++) {
+                    const uint64_t h = BlockedBloomHash(keys[i]);
+                    char *block = array + (((h >> 32) * num_blocks) >> 32) * kBlockSize;
+                    for (int j = 0; j < kProbes; j++) {
+                        const uint32_t bit = (static_cast<uint32_t>(h) * kSalts[j]) >> 26;
+                        block[j * 8 + bit / 8] |= static_cast<char>(1 << (bit % 8));
+                    }
+                }
+            }
+
+            bool KeyMayMatch(const Slice &key, const Slice &filter) const override {
+                const uint32_t num_blocks = NumBlocks(filter);
+                if (num_blocks == 0) {
+                    // 格式不认识：当作可能存在
+                    return true;
+                }
+                const uint64_t h = BlockedBloomHash(key);
+                return Probe(static_cast<uint32_t>(h), BlockFor(h, filter.data(), num_blocks));
+            }
+
+            // 先把一批 key 的块都预取进来，再逐个探测，cache miss 彼此重叠
+            void KeysMayMatch(int n, const Slice *keys, const Slice *filters, bool *results) const override {
+                uint32_t hashes[kBatch];
+                const char *blocks[kBatch];
+                for (int start = 0; start < n; start += kBatch) {
+                    const int count = std::min(kBatch, n - start);
+                    for (int i = 0; i < count; i++) {
+                        const Slice &filter = filters[start + i];
+                        const uint32_t num_blocks = NumBlocks(filter);
+                        if (num_blocks == 0) {
+                            blocks[i] = nullptr;
+                            continue;
+                        }
+                        const uint64_t h = BlockedBloomHash(keys[start + i]);
+                        hashes[i] = static_cast<uint32_t>(h);
+                        blocks[i] = BlockFor(h, filter.data(), num_blocks);
+                        // 过滤器内的块不一定按 cache line 对齐
+                        __builtin_prefetch(blocks[i]);
+                        __builtin_prefetch(blocks[i] + kBlockSize - 1);
+                    }
+                    for (int i = 0; i < count; i++) {
+                        results[start + i] = blocks[i] == nullptr || Probe(hashes[i], blocks[i]);
+                    }
+                }
+            }
+
+        private:
+            const uint64_t bits_per_key_;
+        };
+    }  // namespace
+
+    const FilterPolicy *NewBlockedBloomFilterPolicy(int bits_per_key) {
+        return new BlockedBloomFilterPolicy(bits_per_key);
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,133 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../include/filter_policy.h"
+#include "../include/slice.h"
+#include "coding.h"
+
+namespace leveldb {
+
+    namespace {
+
+        std::string Key(int i) {
+            std::string key;
+            PutFixed32(&key, static_cast<uint32_t>(i));
+            return key;
+        }
+
+        std::string BuildFilter(const FilterPolicy *policy, int n, int first = 0) {
+            std::vector<std::string> keys;
+            for (int i = 0; i < n; i++) {
+                keys.push_back(Key(first + i));
+            }
+            std::vector<Slice> slices(keys.begin(), keys.end());
+            std::string filter;
+            policy->CreateFilter(slices.data(), n, &filter);
+            return filter;
+        }
+
+        double FalsePositiveRate(const FilterPolicy *policy, const std::string &filter) {
+            int result = 0;
+            for (int i = 0; i < 10000; i++) {
+                if (policy->KeyMayMatch(Key(i + 1000000000), filter)) {
+                    result++;
+                }
+            }
+            return result / 10000.0;
+        }
+
+    }  // namespace
+
+    class BlockedBloomTest : public testing::Test {
+    public:
+        BlockedBloomTest() : policy_(NewBlockedBloomFilterPolicy(10)) {}
+
+        std::unique_ptr<const FilterPolicy> policy_;
+    };
+
+    TEST_F(BlockedBloomTest, EmptyFilter) {
+        const std::string filter = BuildFilter(policy_.get(), 0);
+        ASSERT_FALSE(policy_->KeyMayMatch("hello", filter));
+        ASSERT_FALSE(policy_->KeyMayMatch("world", filter));
+    }
+
+    TEST_F(BlockedBloomTest, Small) {
+        const std::string filter = BuildFilter(policy_.get(), 2, 100);
+        ASSERT_TRUE(policy_->KeyMayMatch(Key(100), filter));
+        ASSERT_TRUE(policy_->KeyMayMatch(Key(101), filter));
+        ASSERT_FALSE(policy_->KeyMayMatch(Key(5), filter));
+    }
+
+    // 和 bloom 一样逐渐加大 key 数：不能有假阴性，假阳性率要接近 10 bit/key 的理论值
+    TEST_F(BlockedBloomTest, VaryingLengths) {
+        int mediocre_filters = 0;
+        int good_filters = 0;
+        for (int length = 1; length <= 10000; length += (length < 10 ? 1 : length < 100 ? 10 : 1000)) {
+            const std::string filter = BuildFilter(policy_.get(), length);
+            ASSERT_LE(filter.size(), static_cast<size_t>(length * 10 / 8) + 64 + 1) << length;
+            for (int i = 0; i < length; i++) {
+                ASSERT_TRUE(policy_->KeyMayMatch(Key(i), filter)) << "length " << length << "; key " << i;
+            }
+            const double rate = FalsePositiveRate(policy_.get(), filter);
+            ASSERT_LE(rate, 0.03) << length;
+            if (rate > 0.0125) {
+                mediocre_filters++;
+            } else {
+                good_filters++;
+            }
+        }
+        ASSERT_LE(mediocre_filters, good_filters / 4);
+    }
+
+    // CreateFilter 只能追加，不能动 dst 原有的内容
+    TEST_F(BlockedBloomTest, AppendsToExistingContents) {
+        std::string dst = "existing";
+        const std::string key = Key(7);
+        const Slice slice(key);
+        policy_->CreateFilter(&slice, 1, &dst);
+        ASSERT_EQ("existing", dst.substr(0, 8));
+        ASSERT_TRUE(policy_->KeyMayMatch(key, Slice(dst.data() + 8, dst.size() - 8)));
+    }
+
+    // 认不出的过滤器当作可能存在
+    TEST_F(BlockedBloomTest, MalformedFilters) {
+        std::string filter = BuildFilter(policy_.get(), 100);
+        ASSERT_TRUE(policy_->KeyMayMatch(Key(1000), ""));
+        ASSERT_TRUE(policy_->KeyMayMatch(Key(1000), Slice(filter.data(), filter.size() - 1)));
+        filter.back() = 3;
+        ASSERT_TRUE(policy_->KeyMayMatch(Key(1000), filter));
+    }
+
+    // 批量探测和逐个探测结果一致，批次大小跨过内部的分批长度
+    TEST_F(BlockedBloomTest, KeysMayMatchAgreesWithKeyMayMatch) {
+        std::vector<std::string> filters;
+        for (int f = 0; f < 5; f++) {
+            filters.push_back(BuildFilter(policy_.get(), 200 * (f + 1), f * 1000));
+        }
+        filters.push_back("bad");
+
+        const int n = 1000;
+        std::vector<std::string> keys;
+        std::vector<Slice> key_slices;
+        std::vector<Slice> filter_slices;
+        for (int i = 0; i < n; i++) {
+            keys.push_back(Key(i * 7));
+        }
+        for (int i = 0; i < n; i++) {
+            key_slices.emplace_back(keys[i]);
+            filter_slices.emplace_back(filters[i % filters.size()]);
+        }
+        std::unique_ptr<bool[]> results(new bool[n]);
+        policy_->KeysMayMatch(n, key_slices.data(), filter_slices.data(), results.get());
+        int matches = 0;
+        for (int i = 0; i < n; i++) {
+            ASSERT_EQ(policy_->KeyMayMatch(key_slices[i], filter_slices[i]), results[i]) << i;
+            matches += results[i];
+        }
+        ASSERT_GT(matches, 0);
+        ASSERT_LT(matches, n);
+    }
+
+}  // namespace leveldb
@@ -22,6 +22,15 @@ namespace leveldb {
         return Status::NotSupported("NewAppendableFile", fname);
     }
 
+    Status Env::NewRandomAccessFile(const std::string &fname, const EnvOptions & /*options*/,
+                                    RandomAccessFile **result) {
+        return NewRandomAccessFile(fname, result);
+    }
+
+    Status Env::NewWritableFile(const std::string &fname, const EnvOptions & /*options*/, WritableFile **result) {
+        return NewWritableFile(fname, result);
+    }
+
     Status Env::RemoveDir(const std::string &dirname) { return DeleteDir(dirname); }
 
     Status Env::DeleteDir(const std::string &dirname) { return RemoveDir(dirname); }
@@ -34,6 +43,18 @@ namespace leveldb {
 
     RandomAccessFile::~RandomAccessFile() = default;
 
+    Status RandomAccessFile::MultiRead(ReadRequest *requests, size_t num_requests) const {
+        Status status;
+        for (size_t i = 0; i < num_requests; i++) {
+            ReadRequest &req = requests[i];
+            req.status = Read(req.offset, req.n, &req.result, req.scratch);
+            if (status.ok() && !req.status.ok()) {
+                status = req.status;
+            }
+        }
+        return status;
+    }
+
     WritableFile::~WritableFile() = default;
 
     Logger::~Logger() = default;
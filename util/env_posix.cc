@@ -24,7 +24,9 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <limits>
+#include <memory>
 #include <queue>
 #include <set>
 #include <string>
@@ -33,6 +35,7 @@
 #include <utility>
 
 #include "../include/env.h"
+#include "../include/rate_limiter.h"
 #include "../include/slice.h"
 #include "../include/status.h"
 #include "../port/port.h"
@@ -41,6 +44,13 @@
 #include "posix_logger.h"
 #include "../port/port_stdcxx.h"
 
+#if HAVE_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+
+#endif  // HAVE_IO_URING
+
 namespace leveldb {
 
     namespace {
@@ -61,7 +71,16 @@ namespace leveldb {
         constexpr const int kOpenBaseFlags = 0;
 #endif  // defined(HAVE_O_CLOEXEC)
 
-        constexpr const size_t kWritableFileBufferSize = 65536;
+        // Alignment of offsets, lengths and buffers for O_DIRECT reads. 4KB covers
+        // the logical block size of practically all devices and file systems.
+        constexpr const size_t kDirectIOAlignment = 4096;
+
+// Flag that makes open() bypass the page cache, where the platform has one.
+#if defined(O_DIRECT)
+        constexpr const int kOpenDirectFlag = O_DIRECT;
+#else
+        constexpr const int kOpenDirectFlag = 0;
+#endif  // defined(O_DIRECT)
 
         Status PosixError(const std::string &context, int error_number) {
             if (error_number == ENOENT) {
@@ -71,6 +90,27 @@ namespace leveldb {
             }
         }
 
+        // Writes data[0, size - 1] to fd, retrying on EINTR and short writes.
+        // If |rate_limiter| is non-null, the write is charged against it first.
+        Status PosixWriteFully(int fd, const char *data, size_t size, const std::string &filename,
+                               RateLimiter *rate_limiter = nullptr) {
+            if (rate_limiter != nullptr) {
+                rate_limiter->Request(static_cast<int64_t>(size), kIOLow);
+            }
+            while (size > 0) {
+                ssize_t write_result = ::write(fd, data, size);
+                if (write_result < 0) {
+                    if (errno == EINTR) {
+                        continue;  // Retry
+                    }
+                    return PosixError(filename, errno);
+                }
+                data += write_result;
+                size -= write_result;
+            }
+            return Status::OK();
+        }
+
         // Helper class to limit resource usage to avoid exhaustion.
         // Currently, used to limit read-only file descriptors and mmap file usage
         // so that we do not run out of file descriptors or virtual memory, or run into
@@ -172,6 +212,205 @@ namespace leveldb {
             const std::string filename_;
         };
 
+#if HAVE_IO_URING
+
+        // A minimal io_uring instance driven directly through the
+        // io_uring_setup(2) / io_uring_enter(2) system calls, so that no
+        // liburing dependency is required.
+        //
+        // Instances are not thread-safe. PosixRandomAccessFile::MultiRead() uses
+        // one ring per thread, see ThreadLocalIoUring().
+        class PosixIoUring {
+        public:
+            // Number of reads kept in flight by MultiRead().
+            static constexpr unsigned kQueueDepth = 32;
+
+            PosixIoUring() {
+                struct io_uring_params params;
+                std::memset(&params, 0, sizeof(params));
+                int ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, kQueueDepth, &params));
+                if (ring_fd < 0) {
+                    return;  // Kernel without io_uring, or io_uring disabled.
+                }
+
+                sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+                single_mmap_ = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                if (single_mmap_) {
+                    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+                }
+                sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+
+                sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+                if (sq_ring_ == MAP_FAILED) {
+                    sq_ring_ = nullptr;
+                    ::close(ring_fd);
+                    return;
+                }
+                if (single_mmap_) {
+                    cq_ring_ = sq_ring_;
+                } else {
+                    cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+                    if (cq_ring_ == MAP_FAILED) {
+                        cq_ring_ = nullptr;
+                        Unmap();
+                        ::close(ring_fd);
+                        return;
+                    }
+                }
+                void *sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+                if (sqes == MAP_FAILED) {
+                    Unmap();
+                    ::close(ring_fd);
+                    return;
+                }
+                sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+
+                char *sq = static_cast<char *>(sq_ring_);
+                sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+                sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+                sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+                sq_entries_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_entries);
+                sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+                char *cq = static_cast<char *>(cq_ring_);
+                cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+                cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+                cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+                cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+                ring_fd_ = ring_fd;
+            }
+
+            ~PosixIoUring() { Close(); }
+
+            PosixIoUring(const PosixIoUring &) = delete;
+
+            PosixIoUring &operator=(const PosixIoUring &) = delete;
+
+            bool ok() const { return ring_fd_ >= 0; }
+
+            // Queues a read of buf[0..n-1] from fd at offset. Returns false if the
+            // submission queue is full.
+            bool PrepareRead(int fd, char *buf, size_t n, uint64_t offset, uint64_t user_data) {
+                unsigned tail = *sq_tail_;
+                unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+                if (tail - head >= sq_entries_) {
+                    return false;
+                }
+                unsigned index = tail & sq_mask_;
+                struct io_uring_sqe *sqe = &sqes_[index];
+                std::memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = fd;
+                sqe->addr = reinterpret_cast<uint64_t>(buf);
+                sqe->len = static_cast<uint32_t>(n);
+                sqe->off = offset;
+                sqe->user_data = user_data;
+                sq_array_[index] = index;
+                __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+                ++pending_submit_;
+                return true;
+            }
+
+            // Submits all queued reads and blocks until at least |wait_nr|
+            // completions are available. Returns 0 or a negative errno; see
+            // IsTransientError() for the ones worth retrying.
+            int SubmitAndWait(unsigned wait_nr) {
+                int ret = static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd_, pending_submit_,
+                                                     wait_nr, IORING_ENTER_GETEVENTS, nullptr, 0));
+                if (ret < 0) {
+                    return -errno;
+                }
+                pending_submit_ -= static_cast<unsigned>(ret);
+                return 0;
+            }
+
+            // True if SubmitAndWait() failed with an error that goes away by
+            // itself: a signal, or the kernel running short of resources or of
+            // completion queue space. Nothing was lost; call it again.
+            static bool IsTransientError(int err) {
+                return err == -EINTR || err == -EAGAIN || err == -EBUSY;
+            }
+
+            // Tears the ring down after an error it can not recover from.
+            // Closing the ring cancels the reads still on it. ok() is false
+            // afterwards, so later batches take the synchronous path.
+            void Close() {
+                if (ring_fd_ >= 0) {
+                    Unmap();
+                    ::close(ring_fd_);
+                    ring_fd_ = -1;
+                }
+                pending_submit_ = 0;
+            }
+
+            // Withdraws reads queued since the last successful SubmitAndWait().
+            // Returns how many were withdrawn.
+            unsigned DiscardPending() {
+                const unsigned discarded = pending_submit_;
+                __atomic_store_n(sq_tail_, *sq_tail_ - discarded, __ATOMIC_RELEASE);
+                pending_submit_ = 0;
+                return discarded;
+            }
+
+            // Pops one completion. Returns false if the completion queue is empty.
+            bool PopCompletion(uint64_t *user_data, int *res) {
+                unsigned head = *cq_head_;
+                if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+                    return false;
+                }
+                const struct io_uring_cqe *cqe = &cqes_[head & cq_mask_];
+                *user_data = cqe->user_data;
+                *res = cqe->res;
+                __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+
+        private:
+            void Unmap() {
+                if (sqes_ != nullptr) ::munmap(sqes_, sqes_size_);
+                if (cq_ring_ != nullptr && !single_mmap_) ::munmap(cq_ring_, cq_ring_size_);
+                if (sq_ring_ != nullptr) ::munmap(sq_ring_, sq_ring_size_);
+                sqes_ = nullptr;
+                cq_ring_ = sq_ring_ = nullptr;
+            }
+
+            int ring_fd_ = -1;
+            unsigned pending_submit_ = 0;  // Queued but not yet submitted entries.
+
+            bool single_mmap_ = false;
+            size_t sq_ring_size_ = 0;
+            size_t cq_ring_size_ = 0;
+            size_t sqes_size_ = 0;
+            void *sq_ring_ = nullptr;
+            void *cq_ring_ = nullptr;
+
+            unsigned *sq_head_ = nullptr;
+            unsigned *sq_tail_ = nullptr;
+            unsigned *sq_array_ = nullptr;
+            unsigned sq_mask_ = 0;
+            unsigned sq_entries_ = 0;
+            struct io_uring_sqe *sqes_ = nullptr;
+
+            unsigned *cq_head_ = nullptr;
+            unsigned *cq_tail_ = nullptr;
+            unsigned cq_mask_ = 0;
+            struct io_uring_cqe *cqes_ = nullptr;
+        };
+
+        // Returns the calling thread's ring, or nullptr if io_uring is not usable
+        // on this system. Setup is attempted once per thread.
+        PosixIoUring *ThreadLocalIoUring() {
+            static thread_local PosixIoUring ring;
+            return ring.ok() ? &ring : nullptr;
+        }
+
+#endif  // HAVE_IO_URING
+
         // Implements random read access in a file using pread().
         // 实现可随机读写，使用 pread();
         // Instances of this class are thread-safe, as required by the RandomAccessFile
@@ -180,9 +419,15 @@ namespace leveldb {
         public:
             // The new instance takes ownership of |fd|. |fd_limiter| must outlive this
             // instance, and will be used to determine if .
-            PosixRandomAccessFile(std::string filename, int fd, Limiter *fd_limiter)
+            //
+            // If |use_direct_io| is true, |fd| must have been opened with O_DIRECT.
+            // If |rate_limiter| is non-null, every read is charged against it.
+            PosixRandomAccessFile(std::string filename, int fd, Limiter *fd_limiter, bool use_direct_io = false,
+                                  RateLimiter *rate_limiter = nullptr)
                     : has_permanent_fd_(fd_limiter->Acquire()),
                       fd_(has_permanent_fd_ ? fd : -1),
+                      use_direct_io_(use_direct_io),
+                      rate_limiter_(rate_limiter),
                       fd_limiter_(fd_limiter),
                       filename_(std::move(filename)) {
                 if (!has_permanent_fd_) {
@@ -200,10 +445,13 @@ namespace leveldb {
             }
 
             Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override {
+                if (rate_limiter_ != nullptr) {
+                    rate_limiter_->Request(static_cast<int64_t>(n), kIOLow);
+                }
                 int fd = fd_;
                 //
                 if (!has_permanent_fd_) {
-                    fd = ::open(filename_.c_str(), O_RDONLY | kOpenBaseFlags);
+                    fd = ::open(filename_.c_str(), O_RDONLY | kOpenBaseFlags | (use_direct_io_ ? kOpenDirectFlag : 0));
                     if (fd < 0) {
                         return PosixError(filename_, errno);
                     }
@@ -212,13 +460,18 @@ namespace leveldb {
                 assert(fd != -1);
 
                 Status status;
-                // 先读到 scratch 中
-                ssize_t read_size = ::pread(fd, scratch, n, static_cast<off_t>(offset));
-                // 然后再构造到 Slice 类中
-                *result = Slice(scratch, (read_size < 0) ? 0 : read_size);
-                if (read_size < 0) {
-                    // An error: return a non-ok status.
-                    status = PosixError(filename_, errno);
+                if (use_direct_io_ && !IsDirectIOAligned(offset, n, scratch)) {
+                    // O_DIRECT 要求对齐，先读到对齐的临时缓冲区再拷贝
+                    status = ReadUnaligned(fd, offset, n, result, scratch);
+                } else {
+                    // 先读到 scratch 中
+                    ssize_t read_size = ::pread(fd, scratch, n, static_cast<off_t>(offset));
+                    // 然后再构造到 Slice 类中
+                    *result = Slice(scratch, (read_size < 0) ? 0 : read_size);
+                    if (read_size < 0) {
+                        // An error: return a non-ok status.
+                        status = PosixError(filename_, errno);
+                    }
                 }
                 if (!has_permanent_fd_) {
                     // Close the temporary file descriptor opened earlier.
@@ -228,9 +481,201 @@ namespace leveldb {
                 return status;
             }
 
+            size_t GetRequiredBufferAlignment() const override {
+                return use_direct_io_ ? kDirectIOAlignment : 0;
+            }
+
+            // 让内核提前把这段数据读进 page cache
+            void Prefetch(uint64_t offset, size_t n) const override {
+                if (!has_permanent_fd_ || use_direct_io_) {
+                    return;  // Nothing to warm up without a long-lived, cached fd.
+                }
+#if defined(POSIX_FADV_WILLNEED)
+                ::posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(n), POSIX_FADV_WILLNEED);
+#endif  // defined(POSIX_FADV_WILLNEED)
+            }
+
+            // 批量读：有 io_uring 时一次性提交，保持队列深度；否则退化为逐个 pread
+            Status MultiRead(ReadRequest *requests, size_t num_requests) const override {
+#if HAVE_IO_URING
+                if (has_permanent_fd_ && num_requests > 1 && AllDirectIOAligned(requests, num_requests)) {
+                    PosixIoUring *ring = ThreadLocalIoUring();
+                    if (ring != nullptr) {
+                        if (rate_limiter_ != nullptr) {
+                            int64_t total = 0;
+                            for (size_t i = 0; i < num_requests; i++) {
+                                total += static_cast<int64_t>(requests[i].n);
+                            }
+                            rate_limiter_->Request(total, kIOLow);
+                        }
+                        return IoUringMultiRead(ring, requests, num_requests);
+                    }
+                }
+#endif  // HAVE_IO_URING
+                return RandomAccessFile::MultiRead(requests, num_requests);
+            }
+
         private:
+            static bool IsDirectIOAligned(uint64_t offset, size_t n, const char *buf) {
+                return (offset % kDirectIOAlignment) == 0 && (n % kDirectIOAlignment) == 0 &&
+                       (reinterpret_cast<uintptr_t>(buf) % kDirectIOAlignment) == 0;
+            }
+
+            // True unless this is a direct I/O file and some request is unaligned.
+            bool AllDirectIOAligned(const ReadRequest *requests, size_t num_requests) const {
+                if (!use_direct_io_) {
+                    return true;
+                }
+                for (size_t i = 0; i < num_requests; i++) {
+                    if (!IsDirectIOAligned(requests[i].offset, requests[i].n, requests[i].scratch)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // Serves an unaligned read on an O_DIRECT descriptor: reads the enclosing
+            // aligned range into an aligned bounce buffer and copies the requested
+            // bytes into scratch.
+            Status ReadUnaligned(int fd, uint64_t offset, size_t n, Slice *result, char *scratch) const {
+                const uint64_t aligned_offset = offset - (offset % kDirectIOAlignment);
+                const size_t prefix = static_cast<size_t>(offset - aligned_offset);
+                const size_t aligned_size =
+                        (prefix + n + kDirectIOAlignment - 1) / kDirectIOAlignment * kDirectIOAlignment;
+
+                void *aligned_buf = nullptr;
+                if (posix_memalign(&aligned_buf, kDirectIOAlignment, aligned_size) != 0) {
+                    *result = Slice();
+                    return PosixError(filename_, ENOMEM);
+                }
+                char *buf = static_cast<char *>(aligned_buf);
+
+                Status status;
+                size_t filled = 0;
+                while (filled < aligned_size) {
+                    ssize_t read_size = ::pread(fd, buf + filled, aligned_size - filled,
+                                                static_cast<off_t>(aligned_offset + filled));
+                    if (read_size < 0) {
+                        if (errno == EINTR) {
+                            continue;  // Retry
+                        }
+                        status = PosixError(filename_, errno);
+                        break;
+                    }
+                    if (read_size == 0) {
+                        break;  // EOF
+                    }
+                    filled += read_size;
+                }
+
+                size_t copy_size = 0;
+                if (status.ok() && filled > prefix) {
+                    copy_size = std::min(n, filled - prefix);
+                    std::memcpy(scratch, buf + prefix, copy_size);
+                }
+                *result = Slice(scratch, copy_size);
+                free(buf);
+                return status;
+            }
+
+#if HAVE_IO_URING
+            // Keeps up to PosixIoUring::kQueueDepth reads in flight, refilling the
+            // submission queue as completions are reaped. Requests the ring can not
+            // serve completely (errors, short reads, unsupported opcode) are
+            // retried with a synchronous Read().
+            Status IoUringMultiRead(PosixIoUring *ring, ReadRequest *requests, size_t num_requests) const {
+                size_t next = 0;
+                size_t in_flight = 0;
+                while (next < num_requests || in_flight > 0) {
+                    while (next < num_requests && in_flight < PosixIoUring::kQueueDepth) {
+                        ReadRequest &req = requests[next];
+                        if (req.n > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+                            req.status = Read(req.offset, req.n, &req.result, req.scratch);
+                        } else if (ring->PrepareRead(fd_, req.scratch, req.n, req.offset, next)) {
+                            ++in_flight;
+                        } else {
+                            break;  // Submission queue full; reap first.
+                        }
+                        ++next;
+                    }
+                    if (in_flight == 0) {
+                        continue;
+                    }
+
+                    int err = ring->SubmitAndWait(1);
+                    uint64_t index;
+                    int res;
+                    if (PosixIoUring::IsTransientError(err)) {
+                        // 被信号打断、内核暂时没有资源或完成队列满了：先收掉已完成的读，再重新提交
+                        bool reaped = false;
+                        while (ring->PopCompletion(&index, &res)) {
+                            --in_flight;
+                            CompleteRead(&requests[index], res);
+                            reaped = true;
+                        }
+                        if (!reaped) {
+                            std::this_thread::yield();
+                        }
+                        continue;
+                    }
+                    if (err < 0) {
+                        // io_uring_enter() failed without consuming the queued
+                        // entries. Withdraw them so the ring stays reusable. Reads
+                        // already submitted still write into the callers' buffers:
+                        // wait for all of them, so that none completes after this
+                        // returns or is left on the ring for the next batch.
+                        // If even waiting fails, close the ring, which cancels
+                        // them, rather than spin on it.
+                        size_t submitted = in_flight - ring->DiscardPending();
+                        while (submitted > 0) {
+                            if (ring->PopCompletion(&index, &res)) {
+                                --submitted;
+                                continue;
+                            }
+                            const int wait_err = ring->SubmitAndWait(1);
+                            if (wait_err < 0 && !PosixIoUring::IsTransientError(wait_err)) {
+                                ring->Close();
+                                break;
+                            }
+                        }
+                        Status status = PosixError(filename_, -err);
+                        for (size_t i = 0; i < num_requests; i++) {
+                            requests[i].status = status;
+                        }
+                        return status;
+                    }
+
+                    while (ring->PopCompletion(&index, &res)) {
+                        --in_flight;
+                        CompleteRead(&requests[index], res);
+                    }
+                }
+
+                Status status;
+                for (size_t i = 0; i < num_requests; i++) {
+                    if (!requests[i].status.ok()) {
+                        status = requests[i].status;
+                        break;
+                    }
+                }
+                return status;
+            }
+
+            // Fills in a request from the result of its io_uring read.
+            void CompleteRead(ReadRequest *req, int res) const {
+                if (res >= 0 && static_cast<size_t>(res) == req->n) {
+                    req->result = Slice(req->scratch, req->n);
+                } else {
+                    // Short read at EOF, error or -EINVAL from an old kernel.
+                    req->status = Read(req->offset, req->n, &req->result, req->scratch);
+                }
+            }
+#endif  // HAVE_IO_URING
+
             const bool has_permanent_fd_;  // If false, the file is opened on every read. 如果为 false，则在每次读取时打开文件
             const int fd_;                 // -1 if has_permanent_fd_ is false.
+            const bool use_direct_io_;     // True if the file is read with O_DIRECT.
+            RateLimiter *const rate_limiter_;  // May be nullptr.
             Limiter *const fd_limiter_;
             const std::string filename_;
         };
@@ -269,6 +714,18 @@ namespace leveldb {
                 return Status::OK();
             }
 
+            void Prefetch(uint64_t offset, size_t n) const override {
+                if (offset >= length_) {
+                    return;
+                }
+                n = std::min<uint64_t>(n, length_ - offset);
+                // madvise() wants a page aligned address.
+                static const uintptr_t kPageSize = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+                uintptr_t start = reinterpret_cast<uintptr_t>(mmap_base_ + offset);
+                uintptr_t aligned_start = start - (start % kPageSize);
+                ::madvise(reinterpret_cast<void *>(aligned_start), n + (start - aligned_start), MADV_WILLNEED);
+            }
+
         private:
             char *const mmap_base_;
             const size_t length_;
@@ -276,15 +733,201 @@ namespace leveldb {
             const std::string filename_;
         };
 
+        // 增量刷盘：每写 bytes_per_sync 字节就让内核开始回写这段脏页
+        // Counts the bytes written to a file and, if |bytes_per_sync| is non-zero,
+        // starts asynchronous writeback of the dirty range every |bytes_per_sync|
+        // bytes with sync_file_range(SYNC_FILE_RANGE_WRITE). The final fdatasync()
+        // then only has the tail of the file left to flush.
+        //
+        // Not thread-safe: only the thread issuing write()s for the file uses it.
+        class PosixRangeSyncer {
+        public:
+            explicit PosixRangeSyncer(uint64_t bytes_per_sync)
+                    : bytes_per_sync_(bytes_per_sync), written_(0), synced_(0) {}
+
+            // Records that n more bytes were written to fd.
+            void Written(int fd, size_t n) {
+                written_ += n;
+                if (bytes_per_sync_ == 0 || written_ - synced_ < bytes_per_sync_) {
+                    return;
+                }
+#if defined(SYNC_FILE_RANGE_WRITE)
+                // Errors are ignored: this is only a hint, Sync() reports failures.
+                ::sync_file_range(fd, static_cast<off_t>(synced_), static_cast<off_t>(written_ - synced_),
+                                  SYNC_FILE_RANGE_WRITE);
+#endif  // defined(SYNC_FILE_RANGE_WRITE)
+                synced_ = written_;
+            }
+
+            uint64_t written() const { return written_; }
+
+        private:
+            const uint64_t bytes_per_sync_;
+            uint64_t written_;  // Bytes written so far.
+            uint64_t synced_;   // Bytes handed to sync_file_range() so far.
+        };
+
+        // 后台写线程：写满的缓冲区交给它写盘，前台继续填下一个缓冲区
+        // Writes the full buffers of a PosixWritableFile on a dedicated thread, so
+        // that the thread calling Append() only copies bytes.
+        //
+        // Owns |num_spare_buffers| buffers of |buffer_size| bytes in addition to the
+        // one the file is filling. Submit() trades a full buffer for an empty one and
+        // only blocks while every spare buffer is still waiting to be written.
+        //
+        // Instances are thread-safe because all member data is guarded by a mutex.
+        class PosixBackgroundWriter {
+        public:
+            //
+            // |range_syncer| is only used on the writer thread while it exists.
+            // |rate_limiter| may be nullptr.
+            PosixBackgroundWriter(int fd, const std::string *filename, PosixRangeSyncer *range_syncer,
+                                  RateLimiter *rate_limiter, size_t buffer_size, int num_spare_buffers)
+                    : fd_(fd),
+                      filename_(filename),
+                      range_syncer_(range_syncer),
+                      rate_limiter_(rate_limiter),
+                      cv_(&mu_),
+                      writing_(false),
+                      shutting_down_(false) {
+                assert(num_spare_buffers > 0);
+                for (int i = 0; i < num_spare_buffers; i++) {
+                    free_buffers_.push_back(new char[buffer_size]);
+                }
+                thread_ = std::thread(&PosixBackgroundWriter::ThreadMain, this);
+            }
+
+            PosixBackgroundWriter(const PosixBackgroundWriter &) = delete;
+
+            PosixBackgroundWriter &operator=(const PosixBackgroundWriter &) = delete;
+
+            // Writes everything still queued, then stops the thread.
+            ~PosixBackgroundWriter() {
+                mu_.Lock();
+                shutting_down_ = true;
+                cv_.SignalAll();
+                mu_.Unlock();
+                thread_.join();
+                for (char *buffer: free_buffers_) {
+                    delete[] buffer;
+                }
+            }
+
+            // Queues buffer[0, size - 1] for writing and returns an empty buffer in
+            // exchange. Ownership of |buffer| passes to the writer.
+            char *Submit(char *buffer, size_t size) LOCKS_EXCLUDED(mu_) {
+                mu_.Lock();
+                queue_.push_back(PendingWrite{buffer, size});
+                cv_.SignalAll();
+                while (free_buffers_.empty()) {
+                    cv_.Wait();
+                }
+                char *empty = free_buffers_.back();
+                free_buffers_.pop_back();
+                mu_.Unlock();
+                return empty;
+            }
+
+            // Waits until every submitted buffer has been written. Returns the
+            // first write error, which also makes all later writes no-ops.
+            Status Drain() LOCKS_EXCLUDED(mu_) {
+                mu_.Lock();
+                while (!queue_.empty() || writing_) {
+                    cv_.Wait();
+                }
+                Status status = status_;
+                mu_.Unlock();
+                return status;
+            }
+
+            Status status() LOCKS_EXCLUDED(mu_) {
+                mu_.Lock();
+                Status status = status_;
+                mu_.Unlock();
+                return status;
+            }
+
+        private:
+            struct PendingWrite {
+                char *buffer;
+                size_t size;
+            };
+
+            void ThreadMain() {
+                mu_.Lock();
+                while (true) {
+                    while (queue_.empty() && !shutting_down_) {
+                        cv_.Wait();
+                    }
+                    if (queue_.empty()) {
+                        break;  // Shutting down with nothing left to write.
+                    }
+                    PendingWrite write = queue_.front();
+                    queue_.pop_front();
+                    writing_ = true;
+                    const bool failed = !status_.ok();
+                    mu_.Unlock();
+
+                    Status status;
+                    if (!failed) {
+                        status = PosixWriteFully(fd_, write.buffer, write.size, *filename_, rate_limiter_);
+                        if (status.ok()) {
+                            range_syncer_->Written(fd_, write.size);
+                        }
+                    }
+
+                    mu_.Lock();
+                    if (status_.ok() && !status.ok()) {
+                        status_ = status;
+                    }
+                    writing_ = false;
+                    free_buffers_.push_back(write.buffer);
+                    cv_.SignalAll();
+                }
+                mu_.Unlock();
+            }
+
+            const int fd_;
+            const std::string *const filename_;
+            PosixRangeSyncer *const range_syncer_;
+            RateLimiter *const rate_limiter_;
+
+            port::Mutex mu_;
+            port::CondVar cv_ GUARDED_BY(mu_);
+            std::deque<PendingWrite> queue_ GUARDED_BY(mu_);
+            std::vector<char *> free_buffers_ GUARDED_BY(mu_);
+            bool writing_ GUARDED_BY(mu_);        // A buffer is being written.
+            bool shutting_down_ GUARDED_BY(mu_);
+            Status status_ GUARDED_BY(mu_);       // First write error.
+            std::thread thread_;
+        };
+
         // 顺序文件 可写 实现
         class PosixWritableFile final : public WritableFile {
         public:
-            PosixWritableFile(std::string filename, int fd)
-                    : pos_(0),
+            PosixWritableFile(std::string filename, int fd, const EnvOptions &options = EnvOptions())
+                    : buf_size_(std::max<size_t>(options.writable_file_buffer_size, 1)),
+                      buf_(new char[buf_size_]),
+                      pos_(0),
                       fd_(fd),
+                      preallocated_(false),
+                      range_syncer_(options.bytes_per_sync),
+                      rate_limiter_(options.rate_limiter),
                       is_manifest_(IsManifest(filename)),
                       filename_(std::move(filename)),
-                      dirname_(Dirname(filename_)) {}
+                      dirname_(Dirname(filename_)) {
+#if defined(FALLOC_FL_KEEP_SIZE)
+                // 预分配磁盘空间，失败（文件系统不支持）就算了
+                if (options.preallocation_size > 0) {
+                    preallocated_ = ::fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0,
+                                                static_cast<off_t>(options.preallocation_size)) == 0;
+                }
+#endif  // defined(FALLOC_FL_KEEP_SIZE)
+                if (options.writable_file_buffers > 1) {
+                    writer_.reset(new PosixBackgroundWriter(fd_, &filename_, &range_syncer_, rate_limiter_,
+                                                            buf_size_, options.writable_file_buffers - 1));
+                }
+            }
 
             ~PosixWritableFile() override {
                 if (fd_ >= 0) {
@@ -299,8 +942,8 @@ namespace leveldb {
                 const char *write_data = data.data();
 
                 // Fit as much as possible into buffer.
-                size_t copy_size = std::min(write_size, kWritableFileBufferSize - pos_);
-                std::memcpy(buf_ + pos_, write_data, copy_size);
+                size_t copy_size = std::min(write_size, buf_size_ - pos_);
+                std::memcpy(buf_.get() + pos_, write_data, copy_size);
                 write_data += copy_size;
                 write_size -= copy_size;
                 pos_ += copy_size;
@@ -314,9 +957,24 @@ namespace leveldb {
                     return status;
                 }
 
+                // 异步模式下一律拷进缓冲区，由后台线程写盘
+                if (writer_ != nullptr) {
+                    while (status.ok() && write_size > 0) {
+                        copy_size = std::min(write_size, buf_size_);
+                        std::memcpy(buf_.get(), write_data, copy_size);
+                        write_data += copy_size;
+                        write_size -= copy_size;
+                        pos_ = copy_size;
+                        if (pos_ == buf_size_) {
+                            status = FlushBuffer();
+                        }
+                    }
+                    return status;
+                }
+
                 // Small writes go to buffer, large writes are written directly. 小写直接写入缓冲区，大写直接写入
-                if (write_size < kWritableFileBufferSize) {
-                    std::memcpy(buf_, write_data, write_size);
+                if (write_size < buf_size_) {
+                    std::memcpy(buf_.get(), write_data, write_size);
                     pos_ = write_size;
                     return Status::OK();
                 }
@@ -325,6 +983,18 @@ namespace leveldb {
 
             Status Close() override {
                 Status status = FlushBuffer();
+                if (writer_ != nullptr) {
+                    Status drain_status = writer_->Drain();
+                    if (status.ok()) {
+                        status = drain_status;
+                    }
+                }
+                if (preallocated_ && status.ok()) {
+                    // Give back the reserved blocks past the end of the data.
+                    if (::ftruncate(fd_, static_cast<off_t>(range_syncer_.written())) != 0) {
+                        status = PosixError(filename_, errno);
+                    }
+                }
                 const int close_result = ::close(fd_);
                 if (close_result < 0 && status.ok()) {
                     status = PosixError(filename_, errno);
@@ -333,7 +1003,14 @@ namespace leveldb {
                 return status;
             }
 
-            Status Flush() override { return FlushBuffer(); }
+            Status Flush() override {
+                if (writer_ != nullptr) {
+                    // Keep filling the current buffer; a partial buffer would only
+                    // cost an extra write.
+                    return writer_->status();
+                }
+                return FlushBuffer();
+            }
 
             Status Sync() override {
                 // Ensure new files referred to by the manifest are in the filesystem.
@@ -347,6 +1024,9 @@ namespace leveldb {
                 }
 
                 status = FlushBuffer();
+                if (status.ok() && writer_ != nullptr) {
+                    status = writer_->Drain();
+                }
                 if (!status.ok()) {
                     return status;
                 }
@@ -356,25 +1036,24 @@ namespace leveldb {
 
         private:
             Status FlushBuffer() {
-                //
-                Status status = WriteUnbuffered(buf_, pos_);
+                if (writer_ != nullptr) {
+                    if (pos_ > 0) {
+                        buf_.reset(writer_->Submit(buf_.release(), pos_));
+                        pos_ = 0;
+                    }
+                    return writer_->status();
+                }
+                Status status = WriteUnbuffered(buf_.get(), pos_);
                 pos_ = 0;
                 return status;
             }
 
             Status WriteUnbuffered(const char *data, size_t size) {
-                while (size > 0) {
-                    ssize_t write_result = ::write(fd_, data, size);
-                    if (write_result < 0) {
-                        if (errno == EINTR) {
-                            continue;  // Retry
-                        }
-                        return PosixError(filename_, errno);
-                    }
-                    data += write_result;
-                    size -= write_result;
+                Status status = PosixWriteFully(fd_, data, size, filename_, rate_limiter_);
+                if (status.ok()) {
+                    range_syncer_.Written(fd_, size);
                 }
-                return Status::OK();
+                return status;
             }
 
             Status SyncDirIfManifest() {
@@ -459,13 +1138,24 @@ namespace leveldb {
             }
 
             // buf_[0, pos_ - 1] contains data to be written to fd_.
-            char buf_[kWritableFileBufferSize];
+            const size_t buf_size_;
+            std::unique_ptr<char[]> buf_;
             size_t pos_;
             int fd_;
 
+            bool preallocated_;  // True if fallocate() reserved space past the data.
+            // Used by the writer thread instead while writer_ exists.
+            PosixRangeSyncer range_syncer_;
+            RateLimiter *const rate_limiter_;  // May be nullptr.
+
             const bool is_manifest_;  // True if the file's name starts with MANIFEST.
             const std::string filename_;
             const std::string dirname_;  // The directory of filename_.
+
+            // Writes full buffers in the background; null unless the file was
+            // opened with more than one write buffer. Declared last so that it is
+            // destroyed before the members its thread refers to.
+            std::unique_ptr<PosixBackgroundWriter> writer_;
         };
 
         int LockOrUnlock(int fd, bool lock) {
@@ -574,6 +1264,28 @@ namespace leveldb {
                 return status;
             }
 
+            Status NewRandomAccessFile(const std::string &filename, const EnvOptions &options,
+                                       RandomAccessFile **result) override {
+                RateLimiter *read_limiter = options.rate_limit_reads ? options.rate_limiter : nullptr;
+                if (!options.use_direct_reads && read_limiter == nullptr) {
+                    return NewRandomAccessFile(filename, result);
+                }
+                *result = nullptr;
+                if (options.use_direct_reads && kOpenDirectFlag == 0) {
+                    return Status::NotSupported("direct reads", filename);
+                }
+                // Direct reads never go through mmap(), which would use the page cache;
+                // rate-limited reads avoid it because page faults can not be charged.
+                int fd = ::open(filename.c_str(),
+                                O_RDONLY | (options.use_direct_reads ? kOpenDirectFlag : 0) | kOpenBaseFlags);
+                if (fd < 0) {
+                    return PosixError(filename, errno);
+                }
+                *result = new PosixRandomAccessFile(filename, fd, &fd_limiter_, options.use_direct_reads,
+                                                    read_limiter);
+                return Status::OK();
+            }
+
             Status NewWritableFile(const std::string &filename, WritableFile **result) override {
                 // 清空文件 只写文件 创造文件
                 int fd = ::open(filename.c_str(), O_TRUNC | O_WRONLY | O_CREAT | kOpenBaseFlags, 0644);
@@ -586,6 +1298,17 @@ namespace leveldb {
                 return Status::OK();
             }
 
+            Status NewWritableFile(const std::string &filename, const EnvOptions &options,
+                                   WritableFile **result) override {
+                int fd = ::open(filename.c_str(), O_TRUNC | O_WRONLY | O_CREAT | kOpenBaseFlags, 0644);
+                if (fd < 0) {
+                    *result = nullptr;
+                    return PosixError(filename, errno);
+                }
+                *result = new PosixWritableFile(filename, fd, options);
+                return Status::OK();
+            }
+
             Status NewAppendableFile(const std::string &filename, WritableFile **result) override {
                 int fd = ::open(filename.c_str(),
                                 O_APPEND | O_WRONLY | O_CREAT | kOpenBaseFlags, 0644);
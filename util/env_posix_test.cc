@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "gtest/gtest.h"
+#include "../include/env.h"
+#include "../include/options.h"
+#include "../include/rate_limiter.h"
+
+namespace leveldb {
+
+    namespace {
+
+        // 文件第 i 个字节的内容
+        char ByteAt(uint64_t i) { return static_cast<char>('a' + (i * 7 + i / 251) % 26); }
+
+        struct AlignedFree {
+            void operator()(char *p) const { std::free(p); }
+        };
+
+        char *AlignedBuffer(size_t alignment, size_t n) {
+            void *buf = nullptr;
+            EXPECT_EQ(0, posix_memalign(&buf, alignment, n));
+            return static_cast<char *>(buf);
+        }
+
+    }  // namespace
+
+    class EnvPosixTest : public testing::Test {
+    public:
+        static const size_t kFileSize = 1 << 20;
+
+        EnvPosixTest() : env_(Env::Default()) {
+            EXPECT_TRUE(env_->GetTestDirectory(&fname_).ok());
+            fname_ += "/env_posix_test.data";
+            WritableFile *file;
+            EXPECT_TRUE(env_->NewWritableFile(fname_, &file).ok());
+            std::string data(kFileSize, '\0');
+            for (size_t i = 0; i < kFileSize; i++) {
+                data[i] = ByteAt(i);
+            }
+            EXPECT_TRUE(file->Append(data).ok());
+            EXPECT_TRUE(file->Close().ok());
+            delete file;
+        }
+
+        ~EnvPosixTest() override { env_->RemoveFile(fname_); }
+
+        // 逐个检查 MultiRead() 的结果
+        static void CheckRequests(const std::vector<ReadRequest> &requests) {
+            for (const ReadRequest &req: requests) {
+                ASSERT_TRUE(req.status.ok()) << req.status.ToString();
+                const size_t expected = (req.offset >= kFileSize) ? 0 : std::min<uint64_t>(req.n, kFileSize - req.offset);
+                ASSERT_EQ(expected, req.result.size()) << "offset " << req.offset;
+                for (size_t i = 0; i < req.result.size(); i++) {
+                    ASSERT_EQ(ByteAt(req.offset + i), req.result[i]) << "offset " << req.offset + i;
+                }
+            }
+        }
+
+        Env *env_;
+        std::string fname_;
+    };
+
+    const size_t EnvPosixTest::kFileSize;
+
+    // 限速读取的文件不走 mmap，MultiRead() 用 io_uring 批量提交
+    TEST_F(EnvPosixTest, MultiReadManyRequests) {
+        std::unique_ptr<RateLimiter> limiter(NewGenericRateLimiter(int64_t{1} << 40));
+        EnvOptions options;
+        options.rate_limiter = limiter.get();
+        options.rate_limit_reads = true;
+        RandomAccessFile *file;
+        ASSERT_TRUE(env_->NewRandomAccessFile(fname_, options, &file).ok());
+
+        // 请求数比队列深度多，有的越过文件末尾
+        std::vector<ReadRequest> requests(100);
+        std::vector<std::string> scratch(requests.size());
+        for (size_t i = 0; i < requests.size(); i++) {
+            requests[i].offset = (i * 10007 * 13) % (kFileSize + 4096);
+            requests[i].n = 1 + (i * 997) % 8192;
+            scratch[i].resize(requests[i].n);
+            requests[i].scratch = &scratch[i][0];
+        }
+        ASSERT_TRUE(file->MultiRead(requests.data(), requests.size()).ok());
+        CheckRequests(requests);
+        delete file;
+    }
+
+    TEST_F(EnvPosixTest, MultiReadDirect) {
+        EnvOptions options;
+        options.use_direct_reads = true;
+        RandomAccessFile *file;
+        Status s = env_->NewRandomAccessFile(fname_, options, &file);
+        if (!s.ok()) {
+            // 有的文件系统(比如 tmpfs)不支持 O_DIRECT
+            GTEST_SKIP() << s.ToString();
+        }
+        const size_t alignment = file->GetRequiredBufferAlignment();
+        ASSERT_GT(alignment, 0u);
+
+        // 对齐的请求一起提交，不对齐的请求逐个经过对齐的缓冲区读
+        for (const bool aligned: {true, false}) {
+            std::vector<ReadRequest> requests(40);
+            std::vector<std::unique_ptr<char, AlignedFree>> buffers;
+            for (size_t i = 0; i < requests.size(); i++) {
+                ReadRequest &req = requests[i];
+                req.offset = (i * 37 % 256) * alignment;
+                req.n = (1 + i % 4) * alignment;
+                if (!aligned) {
+                    req.offset += i + 1;
+                    req.n -= 1;
+                }
+                buffers.emplace_back(AlignedBuffer(alignment, req.n + alignment));
+                req.scratch = buffers.back().get();
+            }
+            ASSERT_TRUE(file->MultiRead(requests.data(), requests.size()).ok());
+            CheckRequests(requests);
+        }
+        delete file;
+    }
+
+    // 多个缓冲区时后台线程写满的缓冲区，读回来的内容和写的顺序一致
+    TEST_F(EnvPosixTest, BackgroundWrites) {
+        Options table_options;
+        table_options.writable_file_buffer_size = 4096;
+        table_options.writable_file_buffers = 3;
+        const EnvOptions options(table_options);
+        ASSERT_EQ(4096u, options.writable_file_buffer_size);
+        ASSERT_EQ(3, options.writable_file_buffers);
+
+        WritableFile *file;
+        ASSERT_TRUE(env_->NewWritableFile(fname_, options, &file).ok());
+        std::string expected;
+        for (int i = 0; i < 2000; i++) {
+            // 大小不一的写，有的比一个缓冲区还大
+            const std::string piece(1 + (i * 131) % ((i % 97 == 0) ? 10000 : 700), static_cast<char>('a' + i % 26));
+            ASSERT_TRUE(file->Append(piece).ok());
+            expected += piece;
+            if (i % 100 == 0) {
+                ASSERT_TRUE(file->Flush().ok());
+            }
+        }
+        ASSERT_TRUE(file->Sync().ok());
+        ASSERT_TRUE(file->Close().ok());
+        delete file;
+
+        uint64_t size;
+        ASSERT_TRUE(env_->GetFileSize(fname_, &size).ok());
+        ASSERT_EQ(expected.size(), size);
+        RandomAccessFile *reader;
+        ASSERT_TRUE(env_->NewRandomAccessFile(fname_, &reader).ok());
+        std::string scratch(expected.size(), '\0');
+        Slice result;
+        ASSERT_TRUE(reader->Read(0, expected.size(), &result, &scratch[0]).ok());
+        ASSERT_TRUE(result == Slice(expected));
+        delete reader;
+    }
+
+    // 增量刷盘和预分配都不改变写出来的内容；没用完的预分配空间在 Close() 时还回去
+    TEST_F(EnvPosixTest, RangeSyncAndPreallocation) {
+        for (const int buffers: {1, 2}) {
+            Options table_options;
+            table_options.writable_file_buffer_size = 8192;
+            table_options.writable_file_buffers = buffers;
+            table_options.bytes_per_sync = 16 * 1024;
+            EnvOptions options(table_options);
+            ASSERT_EQ(16 * 1024u, options.bytes_per_sync);
+            options.preallocation_size = 8 << 20;
+
+            WritableFile *file;
+            ASSERT_TRUE(env_->NewWritableFile(fname_, options, &file).ok());
+            std::string expected;
+            for (int i = 0; i < 100; i++) {
+                const std::string piece(1000 + i, static_cast<char>('a' + i % 26));
+                ASSERT_TRUE(file->Append(piece).ok());
+                ASSERT_TRUE(file->Flush().ok());
+                expected += piece;
+            }
+            ASSERT_TRUE(file->Sync().ok());
+            ASSERT_TRUE(file->Close().ok());
+            delete file;
+
+            struct ::stat st;
+            ASSERT_EQ(0, ::stat(fname_.c_str(), &st));
+            ASSERT_EQ(expected.size(), static_cast<uint64_t>(st.st_size));
+            ASSERT_LT(static_cast<uint64_t>(st.st_blocks) * 512, options.preallocation_size);
+
+            RandomAccessFile *reader;
+            ASSERT_TRUE(env_->NewRandomAccessFile(fname_, &reader).ok());
+            std::string scratch(expected.size(), '\0');
+            Slice result;
+            ASSERT_TRUE(reader->Read(0, expected.size(), &result, &scratch[0]).ok());
+            ASSERT_TRUE(result == Slice(expected));
+            delete reader;
+        }
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,60 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "hash.h"
+
+#include <cstring>
+
+#include "coding.h"
+
+// The FALLTHROUGH_INTENDED macro can be used to annotate implicit fall-through
+// between switch labels. Clang and GCC 7+ understand the attribute in C++11
+// mode; other compilers get an empty statement.
+#ifndef FALLTHROUGH_INTENDED
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 7)
+#define FALLTHROUGH_INTENDED __attribute__((fallthrough))
+#else
+#define FALLTHROUGH_INTENDED \
+  do {                       \
+  } while (0)
+#endif
+#endif
+
+namespace leveldb {
+
+    // 类似 murmur hash
+    uint32_t Hash(const char *data, size_t n, uint32_t seed) {
+        // Similar to murmur hash
+        const uint32_t m = 0xc6a4a793;
+        const uint32_t r = 24;
+        const char *limit = data + n;
+        uint32_t h = seed ^ (n * m);
+
+        // Pick up four bytes at a time
+        while (data + 4 <= limit) {
+            uint32_t w = DecodeFixed32(data);
+            data += 4;
+            h += w;
+            h *= m;
+            h ^= (h >> 16);
+        }
+
+        // Pick up remaining bytes
+        switch (limit - data) {
+            case 3:
+                h += static_cast<uint8_t>(data[2]) << 16;
+                FALLTHROUGH_INTENDED;
+            case 2:
+                h += static_cast<uint8_t>(data[1]) << 8;
+                FALLTHROUGH_INTENDED;
+            case 1:
+                h += static_cast<uint8_t>(data[0]);
+                h *= m;
+                h ^= (h >> r);
+                break;
+        }
+        return h;
+    }
+
+}  // namespace leveldb
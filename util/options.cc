@@ -11,4 +11,11 @@ namespace leveldb {
 
     Options::Options() : comparator(BytewiseComparator()), env(Env::Default()) {}
 
+    EnvOptions::EnvOptions(const Options &options)
+            : use_direct_reads(options.use_direct_reads),
+              writable_file_buffer_size(options.writable_file_buffer_size),
+              writable_file_buffers(options.writable_file_buffers),
+              bytes_per_sync(options.bytes_per_sync),
+              rate_limiter(options.rate_limiter) {}
+
 }  // namespace leveldb
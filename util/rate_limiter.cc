@@ -0,0 +1,199 @@
+#include "../include/rate_limiter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+
+#include "../include/env.h"
+#include "../port/port_stdcxx.h"
+#include "../port/thread_annotations.h"
+
+namespace leveldb {
+
+    RateLimiter::~RateLimiter() = default;
+
+    namespace {
+
+        // 令牌桶限速器
+        // A token bucket refilled every refill_period_us.  A request that does not
+        // fit in the bucket joins the queue of its priority.  One waiter at a time
+        // (the "leader") sleeps until the next refill, refills the bucket and
+        // grants queued requests in order; every other waiter sleeps on its own
+        // condition variable until it is granted or asked to lead.
+        class GenericRateLimiter : public RateLimiter {
+        public:
+            GenericRateLimiter(int64_t bytes_per_second, int64_t refill_period_us, int32_t fairness,
+                               uint64_t target_latency_us, Env *env)
+                    : env_(env),
+                      refill_period_us_(std::max<int64_t>(refill_period_us, 1)),
+                      fairness_(fairness),
+                      target_latency_us_(target_latency_us),
+                      bytes_per_second_(bytes_per_second),
+                      latency_ewma_us_(0),
+                      max_bytes_per_second_(bytes_per_second),
+                      available_bytes_(0),
+                      next_refill_us_(env->NowMicros()),
+                      next_tune_us_(next_refill_us_ + kTuneIntervalUs),
+                      refill_count_(0),
+                      leader_waiting_(false) {
+                assert(bytes_per_second > 0);
+            }
+
+            // REQUIRES: no thread is inside Request().
+            ~GenericRateLimiter() override = default;
+
+            void Request(int64_t bytes, IOPriority priority) override {
+                while (bytes > 0) {
+                    const int64_t chunk = std::min(bytes, RefillBytes());
+                    RequestChunk(chunk, priority);
+                    bytes -= chunk;
+                }
+            }
+
+            void ReportForegroundLatency(uint64_t micros) override {
+                if (target_latency_us_ == 0) {
+                    return;
+                }
+                // Lossy under contention, which is fine for a smoothed signal and
+                // keeps the foreground path lock-free.
+                uint64_t old_ewma = latency_ewma_us_.load(std::memory_order_relaxed);
+                uint64_t new_ewma = (old_ewma == 0) ? micros : old_ewma - old_ewma / 8 + micros / 8;
+                latency_ewma_us_.store(new_ewma, std::memory_order_relaxed);
+            }
+
+            int64_t GetBytesPerSecond() const override {
+                return bytes_per_second_.load(std::memory_order_relaxed);
+            }
+
+            void SetBytesPerSecond(int64_t bytes_per_second) override {
+                assert(bytes_per_second > 0);
+                mu_.Lock();
+                max_bytes_per_second_ = bytes_per_second;
+                bytes_per_second_.store(bytes_per_second, std::memory_order_relaxed);
+                mu_.Unlock();
+            }
+
+        private:
+            // How often the auto-tuner looks at the latency signal.
+            static constexpr uint64_t kTuneIntervalUs = 1000 * 1000;
+
+            struct Req {
+                Req(int64_t b, port::Mutex *mu) : bytes(b), cv(mu), granted(false) {}
+
+                const int64_t bytes;
+                port::CondVar cv;
+                bool granted;
+            };
+
+            int64_t RefillBytes() const {
+                return std::max<int64_t>(1, GetBytesPerSecond() * refill_period_us_ / 1000000);
+            }
+
+            void RequestChunk(int64_t bytes, IOPriority priority) LOCKS_EXCLUDED(mu_) {
+                mu_.Lock();
+                if (queues_[kIOLow].empty() && queues_[kIOHigh].empty() && available_bytes_ >= bytes) {
+                    available_bytes_ -= bytes;
+                    mu_.Unlock();
+                    return;
+                }
+
+                Req req(bytes, &mu_);
+                queues_[priority].push_back(&req);
+                while (!req.granted) {
+                    if (leader_waiting_) {
+                        req.cv.Wait();
+                        continue;
+                    }
+
+                    // Lead: sleep until the next refill, then hand out the bytes.
+                    leader_waiting_ = true;
+                    uint64_t now = env_->NowMicros();
+                    if (now < next_refill_us_) {
+                        req.cv.TimedWait(next_refill_us_ - now);
+                        now = env_->NowMicros();
+                    }
+                    leader_waiting_ = false;
+                    if (now >= next_refill_us_) {
+                        RefillAndGrant(now);
+                    }
+                }
+
+                // Someone still waiting has to take over the refills.
+                if (!leader_waiting_) {
+                    std::deque<Req *> &next = queues_[kIOHigh].empty() ? queues_[kIOLow] : queues_[kIOHigh];
+                    if (!next.empty()) {
+                        next.front()->cv.Signal();
+                    }
+                }
+                mu_.Unlock();
+            }
+
+            void RefillAndGrant(uint64_t now) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+                next_refill_us_ = now + refill_period_us_;
+                if (target_latency_us_ > 0 && now >= next_tune_us_) {
+                    AutoTune();
+                    next_tune_us_ = now + kTuneIntervalUs;
+                }
+                available_bytes_ += RefillBytes();
+                ++refill_count_;
+
+                // One refill out of fairness_ serves low priority first.
+                const bool low_first = fairness_ > 0 && refill_count_ % fairness_ == 0;
+                const IOPriority order[2] = {low_first ? kIOLow : kIOHigh, low_first ? kIOHigh : kIOLow};
+                for (IOPriority priority: order) {
+                    std::deque<Req *> &queue = queues_[priority];
+                    while (!queue.empty()) {
+                        Req *next = queue.front();
+                        if (next->bytes > available_bytes_) {
+                            return;  // Keep FIFO order: nobody overtakes the head.
+                        }
+                        available_bytes_ -= next->bytes;
+                        next->granted = true;
+                        queue.pop_front();
+                        next->cv.Signal();
+                    }
+                }
+                // Nothing is waiting: do not let an idle period build up a burst.
+                available_bytes_ = std::min(available_bytes_, RefillBytes());
+            }
+
+            // 前台延迟高于目标就降速，明显低于目标就慢慢恢复
+            void AutoTune() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+                const uint64_t latency = latency_ewma_us_.load(std::memory_order_relaxed);
+                const int64_t floor = std::max<int64_t>(1, max_bytes_per_second_ / 20);
+                int64_t rate = GetBytesPerSecond();
+                if (latency > target_latency_us_) {
+                    rate = std::max(floor, rate - rate / 4);
+                } else if (latency < target_latency_us_ - target_latency_us_ / 5) {
+                    rate = std::min(max_bytes_per_second_, rate + std::max<int64_t>(rate / 10, 1));
+                }
+                bytes_per_second_.store(rate, std::memory_order_relaxed);
+            }
+
+            Env *const env_;
+            const int64_t refill_period_us_;
+            const int32_t fairness_;
+            const uint64_t target_latency_us_;
+
+            std::atomic<int64_t> bytes_per_second_;   // Current budget.
+            std::atomic<uint64_t> latency_ewma_us_;   // Smoothed foreground latency.
+
+            port::Mutex mu_;
+            int64_t max_bytes_per_second_ GUARDED_BY(mu_);
+            int64_t available_bytes_ GUARDED_BY(mu_);
+            uint64_t next_refill_us_ GUARDED_BY(mu_);
+            uint64_t next_tune_us_ GUARDED_BY(mu_);
+            uint64_t refill_count_ GUARDED_BY(mu_);
+            bool leader_waiting_ GUARDED_BY(mu_);
+            std::deque<Req *> queues_[2] GUARDED_BY(mu_);  // Indexed by IOPriority.
+        };
+
+    }  // namespace
+
+    RateLimiter *NewGenericRateLimiter(int64_t bytes_per_second, int64_t refill_period_us, int32_t fairness,
+                                       uint64_t target_latency_us, Env *env) {
+        return new GenericRateLimiter(bytes_per_second, refill_period_us, fairness, target_latency_us,
+                                      env != nullptr ? env : Env::Default());
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,88 @@
+#include "../include/rate_limiter.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "../include/env.h"
+#include "../include/options.h"
+
+namespace leveldb {
+
+    namespace {
+
+        // 只记账、不限速的限速器
+        class CountingRateLimiter : public RateLimiter {
+        public:
+            CountingRateLimiter() : low_bytes_(0), high_bytes_(0) {}
+
+            void Request(int64_t bytes, IOPriority priority) override {
+                (priority == kIOLow ? low_bytes_ : high_bytes_) += bytes;
+            }
+
+            void ReportForegroundLatency(uint64_t /*micros*/) override {}
+
+            int64_t GetBytesPerSecond() const override { return 1 << 30; }
+
+            void SetBytesPerSecond(int64_t /*bytes_per_second*/) override {}
+
+            std::atomic<int64_t> low_bytes_;
+            std::atomic<int64_t> high_bytes_;
+        };
+
+    }  // namespace
+
+    TEST(RateLimiterTest, GrantsAtMostBudget) {
+        Env *env = Env::Default();
+        const int64_t kBytesPerSecond = 1 << 20;
+        std::unique_ptr<RateLimiter> limiter(NewGenericRateLimiter(kBytesPerSecond, 10 * 1000));
+        ASSERT_EQ(kBytesPerSecond, limiter->GetBytesPerSecond());
+
+        // 300KB 至少要等将近 0.3 秒，留足余量只检查下限
+        const uint64_t start = env->NowMicros();
+        for (int i = 0; i < 100; i++) {
+            limiter->Request(3 * 1024, kIOLow);
+        }
+        ASSERT_GE(env->NowMicros() - start, 200 * 1000u);
+    }
+
+    TEST(RateLimiterTest, LargeRequestsAreSplit) {
+        Env *env = Env::Default();
+        std::unique_ptr<RateLimiter> limiter(NewGenericRateLimiter(10 << 20, 10 * 1000));
+        // 比每次补充的量大得多的请求也能完成
+        const uint64_t start = env->NowMicros();
+        limiter->Request(2 << 20, kIOHigh);
+        ASSERT_GE(env->NowMicros() - start, 100 * 1000u);
+    }
+
+    TEST(RateLimiterTest, TableFilesAreCharged) {
+        Env *env = Env::Default();
+        std::string fname;
+        ASSERT_TRUE(env->GetTestDirectory(&fname).ok());
+        fname += "/rate_limiter_test.data";
+
+        CountingRateLimiter limiter;
+        Options options;
+        options.rate_limiter = &limiter;
+        for (const int buffers: {1, 3}) {
+            limiter.low_bytes_ = 0;
+            options.writable_file_buffers = buffers;
+            WritableFile *file;
+            ASSERT_TRUE(env->NewWritableFile(fname, EnvOptions(options), &file).ok());
+            int64_t written = 0;
+            for (int i = 0; i < 500; i++) {
+                const std::string piece(100 + i * 3, 'x');
+                ASSERT_TRUE(file->Append(piece).ok());
+                written += static_cast<int64_t>(piece.size());
+            }
+            ASSERT_TRUE(file->Close().ok());
+            delete file;
+            // 每个写出去的字节都按低优先级记账
+            ASSERT_EQ(written, limiter.low_bytes_.load());
+            ASSERT_EQ(0, limiter.high_bytes_.load());
+        }
+        env->RemoveFile(fname);
+    }
+
+}  // namespace leveldb
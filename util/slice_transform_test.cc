@@ -0,0 +1,48 @@
+#include "../include/slice_transform.h"
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace leveldb {
+
+    TEST(SliceTransformTest, FixedPrefix) {
+        std::unique_ptr<const SliceTransform> transform(NewFixedPrefixTransform(4));
+        ASSERT_EQ(std::string("leveldb.FixedPrefix.4"), transform->Name());
+        ASSERT_FALSE(transform->InDomain(""));
+        ASSERT_FALSE(transform->InDomain("abc"));
+        ASSERT_TRUE(transform->InDomain("abcd"));
+        ASSERT_EQ("abcd", transform->Transform("abcd").ToString());
+        ASSERT_EQ("abcd", transform->Transform("abcdefg").ToString());
+
+        // 前缀指向 key 本身
+        const std::string key("wxyz0123");
+        ASSERT_EQ(key.data(), transform->Transform(key).data());
+    }
+
+    TEST(SliceTransformTest, DelimitedPrefix) {
+        std::unique_ptr<const SliceTransform> transform(NewDelimitedPrefixTransform('|', 2));
+        ASSERT_EQ(std::string("leveldb.DelimitedPrefix.124.2"), transform->Name());
+        ASSERT_FALSE(transform->InDomain(""));
+        ASSERT_FALSE(transform->InDomain("tenant"));
+        ASSERT_FALSE(transform->InDomain("tenant|entity"));
+        ASSERT_TRUE(transform->InDomain("tenant|entity|"));
+        ASSERT_EQ("tenant|entity|", transform->Transform("tenant|entity|").ToString());
+        ASSERT_EQ("tenant|entity|", transform->Transform("tenant|entity|20261019|x").ToString());
+        ASSERT_EQ("||", transform->Transform("|||").ToString());
+    }
+
+    // 名字随参数变化，换了参数的读者不会误用表里的前缀过滤器
+    TEST(SliceTransformTest, NamesDependOnParameters) {
+        std::unique_ptr<const SliceTransform> fixed4(NewFixedPrefixTransform(4));
+        std::unique_ptr<const SliceTransform> fixed5(NewFixedPrefixTransform(5));
+        std::unique_ptr<const SliceTransform> pipe1(NewDelimitedPrefixTransform('|', 1));
+        std::unique_ptr<const SliceTransform> pipe2(NewDelimitedPrefixTransform('|', 2));
+        std::unique_ptr<const SliceTransform> colon2(NewDelimitedPrefixTransform(':', 2));
+        ASSERT_NE(std::string(fixed4->Name()), fixed5->Name());
+        ASSERT_NE(std::string(pipe1->Name()), pipe2->Name());
+        ASSERT_NE(std::string(pipe2->Name()), colon2->Name());
+    }
+
+}  // namespace leveldb
@@ -0,0 +1,69 @@
+#include "testutil.h"
+
+#include "../include/env.h"
+#include "../include/iterator.h"
+#include "../src/table.h"
+#include "../src/table_builder.h"
+
+namespace leveldb {
+
+    namespace test {
+
+        std::string TempFileName(const std::string &name) {
+            std::string dir;
+            Env::Default()->GetTestDirectory(&dir);
+            return dir + "/" + name;
+        }
+
+        Status BuildTableFile(const Options &options, const std::string &fname, const KVList &entries) {
+            WritableFile *file;
+            Status s = options.env->NewWritableFile(fname, EnvOptions(options), &file);
+            if (!s.ok()) {
+                return s;
+            }
+            {
+                TableBuilder builder(options, file);
+                for (const auto &entry: entries) {
+                    builder.Add(entry.first, entry.second);
+                }
+                s = builder.Finish();
+            }
+            Status close_status = file->Close();
+            if (s.ok()) {
+                s = close_status;
+            }
+            delete file;
+            return s;
+        }
+
+        Status ReadTableFile(const Options &options, const std::string &fname, KVList *entries) {
+            uint64_t size;
+            Status s = options.env->GetFileSize(fname, &size);
+            RandomAccessFile *file = nullptr;
+            if (s.ok()) {
+                s = options.env->NewRandomAccessFile(fname, EnvOptions(options), &file);
+            }
+            Table *table = nullptr;
+            if (s.ok()) {
+                s = Table::Open(options, file, size, &table);
+            }
+            if (s.ok()) {
+                Iterator *iter = table->NewIterator(ReadOptions());
+                s = ReadAll(iter, entries);
+                delete iter;
+            }
+            delete table;
+            delete file;
+            return s;
+        }
+
+        Status ReadAll(Iterator *iter, KVList *entries) {
+            for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+                entries->push_back(std::make_pair(iter->key().ToString(), iter->value().ToString()));
+            }
+            return iter->status();
+        }
+
+    }  // namespace test
+
+}  // namespace leveldb
@@ -0,0 +1,37 @@
+#ifndef STORAGE_LEVELDB_UTIL_TESTUTIL_H_
+#define STORAGE_LEVELDB_UTIL_TESTUTIL_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/options.h"
+#include "../include/status.h"
+
+namespace leveldb {
+
+    class Env;
+
+    class Iterator;
+
+    namespace test {
+
+        typedef std::vector<std::pair<std::string, std::string>> KVList;
+
+        // Returns "<test directory>/<name>", creating the directory if needed.
+        std::string TempFileName(const std::string &name);
+
+        // Builds a table file "fname" holding "entries", which must be sorted.
+        Status BuildTableFile(const Options &options, const std::string &fname, const KVList &entries);
+
+        // Appends every entry of the table file "fname" to *entries, in order.
+        Status ReadTableFile(const Options &options, const std::string &fname, KVList *entries);
+
+        // Appends every entry "iter" yields from SeekToFirst() to *entries.
+        Status ReadAll(Iterator *iter, KVList *entries);
+
+    }  // namespace test
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_TESTUTIL_H_